@@ -1,10 +1,10 @@
 
 
 
+#include "SharedConstants.hlsli"
+
 cbuffer Data : register(b0)
 {
-	float pixelWidth;
-	float pixelHeight;
 	int blurAmount, Bleft, Bright, Bup, Bdown;
 }
 
@@ -35,7 +35,7 @@ float4 main(VertexToPixel input) : SV_TARGET
 	{
 		for (int x = Bleft; x <= Bright; x++)
 		{
-			float2 uv = input.uv + float2(x * pixelWidth, y * pixelHeight);
+			float2 uv = input.uv + float2(x, y) * inverseTargetSize;
 			totalColor += Pixels.Sample(Sampler, uv);
 
 			numSamples++;
@@ -0,0 +1,97 @@
+#include "CommandRecorder.h"
+
+CommandRecorder::CommandRecorder(ID3D11Device* device, ID3D11DeviceContext* immediateContext, WorkerPool* workers)
+{
+	this->device = device;
+	this->immediateContext = immediateContext;
+	this->workers = workers;
+
+	// Deferred contexts are emulated by the runtime when the driver
+	// doesn't support command lists natively, so the only real failure
+	// case is a device created with D3D11_CREATE_DEVICE_SINGLETHREADED
+	deferredSupported = EnsureDeferredContexts(1);
+	parallel = deferredSupported;
+}
+
+CommandRecorder::~CommandRecorder()
+{
+	for (unsigned int i = 0; i < passes.GetListCount(); i++)
+		if (*passes.GetList(i)) (*passes.GetList(i))->Release();
+
+	for (unsigned int i = 0; i < deferredContexts.size(); i++)
+		deferredContexts[i]->Release();
+}
+
+// --------------------------------------------------------
+// Makes sure we have at least one deferred context per pass
+// --------------------------------------------------------
+bool CommandRecorder::EnsureDeferredContexts(unsigned int count)
+{
+	while (deferredContexts.size() < count)
+	{
+		ID3D11DeviceContext* deferred = 0;
+		if (device->CreateDeferredContext(0, &deferred) != S_OK)
+			return false;
+
+		deferredContexts.push_back(deferred);
+	}
+	return true;
+}
+
+// --------------------------------------------------------
+// Wraps the pass so it records into its slot's deferred
+// context - or, in serial mode, straight to the immediate
+// context, leaving its command list empty
+// --------------------------------------------------------
+void CommandRecorder::AddPass(std::string /*name*/, std::function<void(ID3D11DeviceContext*)> record)
+{
+	passes.AddPass([this, record](unsigned int slot, ID3D11CommandList** commands) {
+		if (!parallel)
+		{
+			record(immediateContext);
+			return;
+		}
+
+		record(deferredContexts[slot]);
+		deferredContexts[slot]->FinishCommandList(FALSE, commands);
+	});
+
+	// Find out now (rather than mid-record) if we have to go serial
+	if (parallel && !EnsureDeferredContexts(passes.GetPassCount()))
+		parallel = false;
+}
+
+// --------------------------------------------------------
+// Records every pass (in parallel if possible) and executes
+// them on the immediate context in the order they were added
+// --------------------------------------------------------
+void CommandRecorder::Submit()
+{
+	Record();
+	Execute();
+}
+
+// --------------------------------------------------------
+// Records every pass into its deferred context.  In serial
+// mode this draws straight to the immediate context instead.
+// --------------------------------------------------------
+void CommandRecorder::Record()
+{
+	// Serial fallback - same order, on this thread
+	passes.Record(parallel ? workers : 0);
+}
+
+// --------------------------------------------------------
+// Executes the recorded command lists, strictly in pass
+// order, then clears the pass list for the next frame
+// --------------------------------------------------------
+void CommandRecorder::Execute()
+{
+	passes.Execute([this](unsigned int /*slot*/, ID3D11CommandList** commands) {
+		if (!*commands) return;
+
+		immediateContext->ExecuteCommandList(*commands, FALSE);
+		(*commands)->Release();
+		*commands = 0;
+	});
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <d3d11.h>
+#include <functional>
+#include <string>
+#include <vector>
+#include "PassRecorder.h"
+#include "WorkerPool.h"
+
+// --------------------------------------------------------
+// Records each render pass into its own deferred context on
+// a worker thread, then executes the resulting command lists
+// on the immediate context in the order the passes were added.
+//
+// The slots and their ordering are PassRecorder's, with one
+// command list per slot; this adds the deferred contexts
+// and the serial fallback.
+//
+// Deferred contexts start each pass with cleared state, so
+// a pass must set its own targets, viewport, topology, etc.
+// --------------------------------------------------------
+class CommandRecorder
+{
+public:
+	CommandRecorder(ID3D11Device* device, ID3D11DeviceContext* immediateContext, WorkerPool* workers);
+	~CommandRecorder();
+
+	// Adds a pass to this frame's list (passes run in the order they're added)
+	void AddPass(std::string name, std::function<void(ID3D11DeviceContext*)> record);
+
+	// Records all passes, executes them in order, then clears the list
+	void Submit();
+
+	// The two halves of Submit(), for when something (like uploading
+	// the frame's constant data) has to happen in between
+	void Record();
+	void Execute();
+
+	// Turns off threading (all passes record straight to the immediate context)
+	void SetParallel(bool parallel) { this->parallel = parallel && deferredSupported; }
+	bool IsParallel() { return parallel; }
+
+private:
+	ID3D11Device* device;
+	ID3D11DeviceContext* immediateContext;
+	WorkerPool* workers;
+
+	bool deferredSupported;
+	bool parallel;
+
+	// One deferred context per pass slot, reused across frames
+	std::vector<ID3D11DeviceContext*> deferredContexts;
+	PassRecorder<ID3D11CommandList*> passes;
+
+	bool EnsureDeferredContexts(unsigned int count);
+};
@@ -0,0 +1,252 @@
+#include "ConstantBufferGenerator.h"
+#include <sstream>
+
+// --------------------------------------------------------
+// Builds the complete header: one struct per distinct
+// cbuffer layout, typedefs for repeats, then the table
+// shaders are checked against when they load
+// --------------------------------------------------------
+std::string ConstantBufferGenerator::GenerateHeader(const std::vector<GeneratorShader>& shaders)
+{
+	std::ostringstream out;
+	out << "#pragma once\n";
+	out << "#include <cstddef>\n";
+	out << "#include <DirectXMath.h>\n";
+	out << "#include \"ConstantBufferGenerator.h\"\n";
+	out << "#include \"Lights.h\"\n";
+	out << "\n";
+	out << "// --------------------------------------------------------\n";
+	out << "// GENERATED by ConstantBufferGenerator from shader\n";
+	out << "// reflection - regenerate (see Game::Init) after changing\n";
+	out << "// a cbuffer instead of editing by hand\n";
+	out << "// --------------------------------------------------------\n";
+
+	// Every struct generated so far, to spot repeated layouts
+	std::vector<const ReflectedConstantBuffer*> generated;
+	std::vector<std::string> generatedNames;
+
+	// Registry entries, written at the end
+	std::vector<std::string> entries;
+
+	for (unsigned int s = 0; s < shaders.size(); s++)
+	{
+		const GeneratorShader& shader = shaders[s];
+		for (unsigned int b = 0; b < shader.Reflection.ConstantBuffers.size(); b++)
+		{
+			const ReflectedConstantBuffer& buffer = shader.Reflection.ConstantBuffers[b];
+			std::string structName = GetStructName(shader.ShaderFile, buffer.Name);
+
+			// Same layout as one we already wrote?
+			int existing = -1;
+			for (unsigned int g = 0; g < generated.size(); g++)
+			{
+				if (SameLayout(*generated[g], buffer))
+				{
+					existing = (int)g;
+					break;
+				}
+			}
+
+			out << "\n";
+			if (existing >= 0)
+			{
+				out << "// " << buffer.Name << " in " << shader.ShaderFile << " (same layout)\n";
+				out << "typedef " << generatedNames[existing] << " " << structName << ";\n";
+			}
+			else
+			{
+				out << GenerateStruct(structName, shader.ShaderFile, buffer);
+				generated.push_back(&buffer);
+				generatedNames.push_back(structName);
+			}
+
+			std::ostringstream entry;
+			entry << "\t\t{ L\"" << shader.ShaderFile << "\", " <<
+				structName << "::BufferName(), " <<
+				structName << "::Fields(), " <<
+				structName << "::FieldCount, sizeof(" << structName << ") },\n";
+			entries.push_back(entry.str());
+		}
+	}
+
+	// The table (a function, so every file can include this header)
+	out << "\n";
+	out << "// Every struct above, for ISimpleShader::RegisterConstantBufferLayouts()\n";
+	out << "inline const ConstantBufferLayout* GetGeneratedConstantBufferLayouts(unsigned int* count)\n";
+	out << "{\n";
+	if (entries.empty())
+	{
+		out << "\t*count = 0;\n";
+		out << "\treturn 0;\n";
+	}
+	else
+	{
+		out << "\tstatic const ConstantBufferLayout layouts[] =\n";
+		out << "\t{\n";
+		for (unsigned int e = 0; e < entries.size(); e++)
+			out << entries[e];
+		out << "\t};\n";
+		out << "\t*count = sizeof(layouts) / sizeof(layouts[0]);\n";
+		out << "\treturn layouts;\n";
+	}
+	out << "}\n";
+
+	return out.str();
+}
+
+// --------------------------------------------------------
+// One struct: members at their reflected offsets (with
+// explicit padding for HLSL's 16 byte packing), a field
+// table, and static_asserts on every offset and size
+// --------------------------------------------------------
+std::string ConstantBufferGenerator::GenerateStruct(const std::string& structName, const std::string& shaderFile, const ReflectedConstantBuffer& buffer)
+{
+	std::ostringstream out;
+	unsigned int position = 0;
+	unsigned int paddingCount = 0;
+
+	out << "// " << buffer.Name << " (register b" << buffer.BindIndex << ", " << buffer.Size << " bytes) in " << shaderFile << "\n";
+	out << "struct " << structName << "\n";
+	out << "{\n";
+
+	for (unsigned int v = 0; v < buffer.Variables.size(); v++)
+	{
+		const ReflectedVariable& var = buffer.Variables[v];
+
+		// Fill any gap HLSL's packing left before this one
+		if (var.ByteOffset > position)
+			out << "\tunsigned char padding" << paddingCount++ << "[" << (var.ByteOffset - position) << "];\n";
+
+		std::string cppType = GetCppType(var.TypeName);
+		if (var.Elements == 0)
+		{
+			out << "\t" << cppType << " " << var.Name << ";\n";
+		}
+		else if (var.Size == var.Elements * (var.Size / var.Elements) && (var.Size / var.Elements) % 16 == 0)
+		{
+			// Elements are already 16 byte multiples, so C++ packs them the same way
+			out << "\t" << cppType << " " << var.Name << "[" << var.Elements << "];\n";
+		}
+		else
+		{
+			// HLSL pads every element but the last to 16 bytes - no C++ type does that
+			out << "\tunsigned char " << var.Name << "[" << var.Size << "]; // " << var.TypeName << "[" << var.Elements << "], 16 byte stride\n";
+		}
+
+		position = var.ByteOffset + var.Size;
+	}
+
+	if (buffer.Size > position)
+		out << "\tunsigned char padding" << paddingCount++ << "[" << (buffer.Size - position) << "];\n";
+
+	// Field table for load time checks
+	out << "\n";
+	out << "\tstatic const char* BufferName() { return \"" << buffer.Name << "\"; }\n";
+	out << "\tstatic const unsigned int FieldCount = " << buffer.Variables.size() << ";\n";
+	out << "\tstatic const ConstantBufferField* Fields()\n";
+	out << "\t{\n";
+	if (buffer.Variables.empty())
+	{
+		out << "\t\treturn 0;\n";
+	}
+	else
+	{
+		out << "\t\tstatic const ConstantBufferField fields[] =\n";
+		out << "\t\t{\n";
+		for (unsigned int v = 0; v < buffer.Variables.size(); v++)
+		{
+			const ReflectedVariable& var = buffer.Variables[v];
+			out << "\t\t\t{ \"" << var.Name << "\", " << var.ByteOffset << ", " << var.Size << " },\n";
+		}
+		out << "\t\t};\n";
+		out << "\t\treturn fields;\n";
+	}
+	out << "\t}\n";
+	out << "};\n";
+
+	// Compile time checks
+	for (unsigned int v = 0; v < buffer.Variables.size(); v++)
+	{
+		const ReflectedVariable& var = buffer.Variables[v];
+		out << "static_assert(offsetof(" << structName << ", " << var.Name << ") == " << var.ByteOffset <<
+			" && sizeof(" << structName << "::" << var.Name << ") == " << var.Size <<
+			", \"" << structName << "::" << var.Name << " doesn't match the shader\");\n";
+	}
+	out << "static_assert(sizeof(" << structName << ") == " << buffer.Size <<
+		", \"" << structName << " doesn't match the shader's size\");\n";
+
+	return out.str();
+}
+
+// --------------------------------------------------------
+// File stem (as an identifier) + capitalized buffer name
+// --------------------------------------------------------
+std::string ConstantBufferGenerator::GetStructName(const std::string& shaderFile, const std::string& bufferName)
+{
+	// Strip any directory and the extension
+	size_t start = shaderFile.find_last_of("/\\");
+	start = (start == std::string::npos) ? 0 : start + 1;
+	size_t end = shaderFile.find_last_of('.');
+	if (end == std::string::npos || end < start)
+		end = shaderFile.size();
+
+	std::string name;
+	for (size_t i = start; i < end; i++)
+	{
+		char c = shaderFile[i];
+		bool valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+		name.push_back(valid ? c : '_');
+	}
+
+	std::string buffer = bufferName;
+	if (!buffer.empty() && buffer[0] >= 'a' && buffer[0] <= 'z')
+		buffer[0] = buffer[0] - 'a' + 'A';
+
+	return name + buffer;
+}
+
+// --------------------------------------------------------
+// HLSL type name -> C++ type
+// --------------------------------------------------------
+std::string ConstantBufferGenerator::GetCppType(const std::string& hlslType)
+{
+	if (hlslType == "float") return "float";
+	if (hlslType == "float2") return "DirectX::XMFLOAT2";
+	if (hlslType == "float3") return "DirectX::XMFLOAT3";
+	if (hlslType == "float4") return "DirectX::XMFLOAT4";
+	if (hlslType == "float4x4") return "DirectX::XMFLOAT4X4";
+	if (hlslType == "int" || hlslType == "bool") return "int";
+	if (hlslType == "int2") return "DirectX::XMINT2";
+	if (hlslType == "int3") return "DirectX::XMINT3";
+	if (hlslType == "int4") return "DirectX::XMINT4";
+	if (hlslType == "uint" || hlslType == "dword") return "unsigned int";
+	if (hlslType == "uint2") return "DirectX::XMUINT2";
+	if (hlslType == "uint3") return "DirectX::XMUINT3";
+	if (hlslType == "uint4") return "DirectX::XMUINT4";
+
+	// A struct - expected to exist in C++ with the same name
+	return hlslType;
+}
+
+// --------------------------------------------------------
+// Layouts match if the buffers have the same name and
+// every member matches by name, type, offset and size
+// --------------------------------------------------------
+bool ConstantBufferGenerator::SameLayout(const ReflectedConstantBuffer& a, const ReflectedConstantBuffer& b)
+{
+	if (a.Name != b.Name || a.Size != b.Size || a.Variables.size() != b.Variables.size())
+		return false;
+
+	for (unsigned int v = 0; v < a.Variables.size(); v++)
+	{
+		const ReflectedVariable& va = a.Variables[v];
+		const ReflectedVariable& vb = b.Variables[v];
+		if (va.Name != vb.Name ||
+			va.TypeName != vb.TypeName ||
+			va.Elements != vb.Elements ||
+			va.ByteOffset != vb.ByteOffset ||
+			va.Size != vb.Size)
+			return false;
+	}
+	return true;
+}
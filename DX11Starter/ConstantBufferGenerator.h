@@ -0,0 +1,75 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "ReflectionSidecar.h"
+
+// --------------------------------------------------------
+// One member of a C++ constant buffer struct, as the struct
+// expects the shader to lay it out
+// --------------------------------------------------------
+struct ConstantBufferField
+{
+	const char* Name;
+	unsigned int ByteOffset;
+	unsigned int Size;
+};
+
+// --------------------------------------------------------
+// The C++ struct expected for one cbuffer in one shader
+// file.  Shaders check these when they load (see
+// ISimpleShader::RegisterConstantBufferLayouts).
+// --------------------------------------------------------
+struct ConstantBufferLayout
+{
+	const wchar_t* ShaderFile;	// Like L"VertexShader.cso"
+	const char* BufferName;
+	const ConstantBufferField* Fields;
+	unsigned int FieldCount;
+	unsigned int Size;			// sizeof the struct (= the cbuffer's size)
+};
+
+// --------------------------------------------------------
+// A shader file's reflection, as input to the generator
+// --------------------------------------------------------
+struct GeneratorShader
+{
+	std::string ShaderFile;		// Like "VertexShader.cso"
+	ShaderReflectionData Reflection;
+};
+
+// --------------------------------------------------------
+// Writes C++ structs that mirror each shader's cbuffers,
+// straight from reflection data.
+//
+// Every struct is padded out to its cbuffer's full size and
+// followed by static_asserts on each member's offset and the
+// total size, so a struct that drifts from its shader won't
+// compile.  Shaders whose cbuffers have identical layouts
+// share one struct (the others get typedefs).  The header
+// ends with the table of layouts to register at startup.
+//
+// HLSL types map to DirectXMath types; struct types keep
+// their HLSL name and must exist in C++ with the same layout
+// (like DirectionalLight in Lights.h).
+//
+// Doesn't touch D3D, so it runs anywhere.
+// --------------------------------------------------------
+class ConstantBufferGenerator
+{
+public:
+	// The whole header for a set of shaders
+	static std::string GenerateHeader(const std::vector<GeneratorShader>& shaders);
+
+	// Just one struct (with its asserts)
+	static std::string GenerateStruct(const std::string& structName, const std::string& shaderFile, const ReflectedConstantBuffer& buffer);
+
+	// "VertexShader.cso" + "externalData" -> "VertexShaderExternalData"
+	static std::string GetStructName(const std::string& shaderFile, const std::string& bufferName);
+
+	// "float4x4" -> "DirectX::XMFLOAT4X4", etc.
+	static std::string GetCppType(const std::string& hlslType);
+
+private:
+	// Identical layouts get one struct
+	static bool SameLayout(const ReflectedConstantBuffer& a, const ReflectedConstantBuffer& b);
+};
@@ -0,0 +1,161 @@
+#pragma once
+#include <cstddef>
+#include <DirectXMath.h>
+#include "ConstantBufferGenerator.h"
+#include "Lights.h"
+
+// --------------------------------------------------------
+// GENERATED by ConstantBufferGenerator from shader
+// reflection - regenerate (see Game::Init) after changing
+// a cbuffer instead of editing by hand
+// --------------------------------------------------------
+
+// Data (register b0, 32 bytes) in BlurPixelShader.cso
+struct BlurPixelShaderData
+{
+	int blurAmount;
+	int Bleft;
+	int Bright;
+	int Bup;
+	int Bdown;
+	unsigned char padding0[12];
+
+	static const char* BufferName() { return "Data"; }
+	static const unsigned int FieldCount = 5;
+	static const ConstantBufferField* Fields()
+	{
+		static const ConstantBufferField fields[] =
+		{
+			{ "blurAmount", 0, 4 },
+			{ "Bleft", 4, 4 },
+			{ "Bright", 8, 4 },
+			{ "Bup", 12, 4 },
+			{ "Bdown", 16, 4 },
+		};
+		return fields;
+	}
+};
+static_assert(offsetof(BlurPixelShaderData, blurAmount) == 0 && sizeof(BlurPixelShaderData::blurAmount) == 4, "BlurPixelShaderData::blurAmount doesn't match the shader");
+static_assert(offsetof(BlurPixelShaderData, Bleft) == 4 && sizeof(BlurPixelShaderData::Bleft) == 4, "BlurPixelShaderData::Bleft doesn't match the shader");
+static_assert(offsetof(BlurPixelShaderData, Bright) == 8 && sizeof(BlurPixelShaderData::Bright) == 4, "BlurPixelShaderData::Bright doesn't match the shader");
+static_assert(offsetof(BlurPixelShaderData, Bup) == 12 && sizeof(BlurPixelShaderData::Bup) == 4, "BlurPixelShaderData::Bup doesn't match the shader");
+static_assert(offsetof(BlurPixelShaderData, Bdown) == 16 && sizeof(BlurPixelShaderData::Bdown) == 4, "BlurPixelShaderData::Bdown doesn't match the shader");
+static_assert(sizeof(BlurPixelShaderData) == 32, "BlurPixelShaderData doesn't match the shader's size");
+
+// externalData (register b0, 48 bytes) in PixelShader.cso
+struct PixelShaderExternalData
+{
+	DirectionalLight dLight1;
+	unsigned char padding0[4];
+
+	static const char* BufferName() { return "externalData"; }
+	static const unsigned int FieldCount = 1;
+	static const ConstantBufferField* Fields()
+	{
+		static const ConstantBufferField fields[] =
+		{
+			{ "dLight1", 0, 44 },
+		};
+		return fields;
+	}
+};
+static_assert(offsetof(PixelShaderExternalData, dLight1) == 0 && sizeof(PixelShaderExternalData::dLight1) == 44, "PixelShaderExternalData::dLight1 doesn't match the shader");
+static_assert(sizeof(PixelShaderExternalData) == 48, "PixelShaderExternalData doesn't match the shader's size");
+
+// externalData (register b0, 64 bytes) in RefractVS.cso
+struct RefractVSExternalData
+{
+	DirectX::XMFLOAT4X4 world;
+
+	static const char* BufferName() { return "externalData"; }
+	static const unsigned int FieldCount = 1;
+	static const ConstantBufferField* Fields()
+	{
+		static const ConstantBufferField fields[] =
+		{
+			{ "world", 0, 64 },
+		};
+		return fields;
+	}
+};
+static_assert(offsetof(RefractVSExternalData, world) == 0 && sizeof(RefractVSExternalData::world) == 64, "RefractVSExternalData::world doesn't match the shader");
+static_assert(sizeof(RefractVSExternalData) == 64, "RefractVSExternalData doesn't match the shader's size");
+
+// externalData in ToonAngryEyesPixelShader.cso (same layout)
+typedef PixelShaderExternalData ToonAngryEyesPixelShaderExternalData;
+
+// externalData in ToonEyesPixelShader.cso (same layout)
+typedef PixelShaderExternalData ToonEyesPixelShaderExternalData;
+
+// externalData in ToonPixelShader.cso (same layout)
+typedef PixelShaderExternalData ToonPixelShaderExternalData;
+
+// externalData (register b0, 128 bytes) in UI_VS.cso
+struct UI_VSExternalData
+{
+	DirectX::XMFLOAT4X4 view;
+	DirectX::XMFLOAT4X4 projection;
+
+	static const char* BufferName() { return "externalData"; }
+	static const unsigned int FieldCount = 2;
+	static const ConstantBufferField* Fields()
+	{
+		static const ConstantBufferField fields[] =
+		{
+			{ "view", 0, 64 },
+			{ "projection", 64, 64 },
+		};
+		return fields;
+	}
+};
+static_assert(offsetof(UI_VSExternalData, view) == 0 && sizeof(UI_VSExternalData::view) == 64, "UI_VSExternalData::view doesn't match the shader");
+static_assert(offsetof(UI_VSExternalData, projection) == 64 && sizeof(UI_VSExternalData::projection) == 64, "UI_VSExternalData::projection doesn't match the shader");
+static_assert(sizeof(UI_VSExternalData) == 128, "UI_VSExternalData doesn't match the shader's size");
+
+// externalData (register b0, 80 bytes) in VertexShader.cso
+struct VertexShaderExternalData
+{
+	DirectX::XMFLOAT4X4 world;
+	DirectX::XMFLOAT4 color;
+
+	static const char* BufferName() { return "externalData"; }
+	static const unsigned int FieldCount = 2;
+	static const ConstantBufferField* Fields()
+	{
+		static const ConstantBufferField fields[] =
+		{
+			{ "world", 0, 64 },
+			{ "color", 64, 16 },
+		};
+		return fields;
+	}
+};
+static_assert(offsetof(VertexShaderExternalData, world) == 0 && sizeof(VertexShaderExternalData::world) == 64, "VertexShaderExternalData::world doesn't match the shader");
+static_assert(offsetof(VertexShaderExternalData, color) == 64 && sizeof(VertexShaderExternalData::color) == 16, "VertexShaderExternalData::color doesn't match the shader");
+static_assert(sizeof(VertexShaderExternalData) == 80, "VertexShaderExternalData doesn't match the shader's size");
+
+// externalData in WaterPixelShader.cso (same layout)
+typedef PixelShaderExternalData WaterPixelShaderExternalData;
+
+// externalData in WaterVertexShader.cso (same layout)
+typedef VertexShaderExternalData WaterVertexShaderExternalData;
+
+// Every struct above, for ISimpleShader::RegisterConstantBufferLayouts()
+inline const ConstantBufferLayout* GetGeneratedConstantBufferLayouts(unsigned int* count)
+{
+	static const ConstantBufferLayout layouts[] =
+	{
+		{ L"BlurPixelShader.cso", BlurPixelShaderData::BufferName(), BlurPixelShaderData::Fields(), BlurPixelShaderData::FieldCount, sizeof(BlurPixelShaderData) },
+		{ L"PixelShader.cso", PixelShaderExternalData::BufferName(), PixelShaderExternalData::Fields(), PixelShaderExternalData::FieldCount, sizeof(PixelShaderExternalData) },
+		{ L"RefractVS.cso", RefractVSExternalData::BufferName(), RefractVSExternalData::Fields(), RefractVSExternalData::FieldCount, sizeof(RefractVSExternalData) },
+		{ L"ToonAngryEyesPixelShader.cso", ToonAngryEyesPixelShaderExternalData::BufferName(), ToonAngryEyesPixelShaderExternalData::Fields(), ToonAngryEyesPixelShaderExternalData::FieldCount, sizeof(ToonAngryEyesPixelShaderExternalData) },
+		{ L"ToonEyesPixelShader.cso", ToonEyesPixelShaderExternalData::BufferName(), ToonEyesPixelShaderExternalData::Fields(), ToonEyesPixelShaderExternalData::FieldCount, sizeof(ToonEyesPixelShaderExternalData) },
+		{ L"ToonPixelShader.cso", ToonPixelShaderExternalData::BufferName(), ToonPixelShaderExternalData::Fields(), ToonPixelShaderExternalData::FieldCount, sizeof(ToonPixelShaderExternalData) },
+		{ L"UI_VS.cso", UI_VSExternalData::BufferName(), UI_VSExternalData::Fields(), UI_VSExternalData::FieldCount, sizeof(UI_VSExternalData) },
+		{ L"VertexShader.cso", VertexShaderExternalData::BufferName(), VertexShaderExternalData::Fields(), VertexShaderExternalData::FieldCount, sizeof(VertexShaderExternalData) },
+		{ L"WaterPixelShader.cso", WaterPixelShaderExternalData::BufferName(), WaterPixelShaderExternalData::Fields(), WaterPixelShaderExternalData::FieldCount, sizeof(WaterPixelShaderExternalData) },
+		{ L"WaterVertexShader.cso", WaterVertexShaderExternalData::BufferName(), WaterVertexShaderExternalData::Fields(), WaterVertexShaderExternalData::FieldCount, sizeof(WaterVertexShaderExternalData) },
+	};
+	*count = sizeof(layouts) / sizeof(layouts[0]);
+	return layouts;
+}
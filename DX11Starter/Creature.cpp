@@ -1,4 +1,5 @@
 #include "Creature.h"
+#include "ConstantBuffers.h"
 // For the DirectX Math library
 using namespace DirectX;
 
@@ -203,7 +204,6 @@ void Creature::Update(float deltaTime, float totalTime)
 
 	for (std::vector<GameEntity*>::iterator it = gameEntities.begin(); it != gameEntities.end(); ++it) {
 		(*it)->CalculateWorldMatrix();
-		(*it)->GetMaterial()->GetPixelShader()->SetData("Time", &totalTime, sizeof(float));
 	}
 }
 
@@ -254,22 +254,27 @@ void Creature::Draw(ID3D11DeviceContext * context, Camera * cam, DirectionalLigh
 	//draw all entities
 	for (std::vector<GameEntity*>::iterator it = gameEntities.begin(); it != gameEntities.end(); ++it) {
 
+		//shader resources below are set right away, so target this pass's context first
+		Material* mat = (*it)->GetMaterial();
+		const MaterialHandles& handles = mat->GetHandles();
+		mat->SetDeviceContext(context);
+
 		if (guyState == Angry) {
-			(*it)->GetMaterial()->GetPixelShader()->SetShaderResourceView("AlphaTexture", eyeTxt_angry_alpha);
+			mat->GetPixelShader()->SetShaderResourceView(handles.AlphaTexture, eyeTxt_angry_alpha);
 		}
 
-		(*it)->GetMaterial()->GetPixelShader()->SetData("dLight1", &dLight1, sizeof(DirectionalLight));
+		PixelShaderExternalData lightData = {};
+		lightData.dLight1 = dLight1;
+		mat->GetPixelShader()->SetConstantBufferData(handles.LightConstants, lightData);
 
 		
-		(*it)->GetMaterial()->GetPixelShader()->SetShaderResourceView("SkyTexture", skyBoxTexture);
-		(*it)->GetMaterial()->GetPixelShader()->SetShaderResourceView("ProjectionTexture", caustics->projectionTexture);
-		(*it)->GetMaterial()->GetVertexShader()->SetMatrix4x4("causticView", caustics->viewMatrix);
-		(*it)->GetMaterial()->GetVertexShader()->SetMatrix4x4("causticProjection", caustics->projectionMatrix);
+		mat->GetPixelShader()->SetShaderResourceView(handles.SkyTexture, skyBoxTexture);
+		mat->GetPixelShader()->SetShaderResourceView(handles.ProjectionTexture, caustics->projectionTexture);
 		
 		//(*it)->GetMaterial()->GetPixelShader()->SetData("dLight2", &dLight2, sizeof(DirectionalLight));
 		//(*it)->GetMaterial()->GetPixelShader()->SetData("pLight1", &pLight1, sizeof(PointLight));
 
-		(*it)->GetMaterial()->GetVertexShader()->SetData("color", &color, sizeof(XMFLOAT4));
+		(*it)->SetColor(color);
 		(*it)->Draw(context, cam);
 	}
 	
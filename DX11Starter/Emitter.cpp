@@ -1,7 +1,18 @@
 #include "Emitter.h"
+#include <string.h>
+#include <math.h>
 
 using namespace DirectX;
 
+// Each axis of a particle's start velocity is off by up to this much
+static const float velocityJitter = 0.2f;
+
+// Analytic ages are the emitter's time less a spawn time, and
+// both lose precision as they grow (by a day in, a float can't
+// even count frames), so once the emitter's time reaches this
+// they're all moved back to start from zero
+static const float rebaseTime = 256.0f;
+
 Emitter::Emitter(
 	int maxParticles,
 	float particlesPerSecond,
@@ -13,109 +24,155 @@ Emitter::Emitter(
 	DirectX::XMFLOAT3 startVelocity,
 	DirectX::XMFLOAT3 emitterPosition,
 	DirectX::XMFLOAT3 emitterAcceleration,
-	ID3D11Device* device,
-	SimpleVertexShader* vs,
-	SimplePixelShader* ps,
-	ID3D11ShaderResourceView* texture
+	EmitterMode mode,
+	unsigned int seed
 )
+	: random(seed)
 {
 	// Save params
-	this->vs = vs;
-	this->ps = ps;
-	this->texture = texture;
-
 	this->maxParticles = maxParticles;
 	this->lifetime = lifetime;
-	this->startColor = startColor;
-	this->endColor = endColor;
 	this->startVelocity = startVelocity;
-	this->startSize = startSize;
-	this->endSize = endSize;
 	this->particlesPerSecond = particlesPerSecond;
 	this->secondsPerParticle = 1.0f / particlesPerSecond;
+	this->emissionRate = particlesPerSecond;
+	this->liveLimit = maxParticles;
 
 	this->emitterPosition = emitterPosition;
 	this->emitterAcceleration = emitterAcceleration;
 
+	this->mode = mode;
+
+	SetCurves(ParticleCurves::MakeLinear(startColor, endColor, startSize, endSize));
+
 	timeSinceEmit = 0;
+	emitterTime = 0;
+	stepTime = 0;
+	sleptTime = 0;
 	livingParticleCount = 0;
 	firstAliveIndex = 0;
 	firstDeadIndex = 0;
 
-	// Make the particle array
-	particles = new Particle[maxParticles];
+	particleData = 0;
+	memset(&particles, 0, sizeof(particles));
+	spawnTimes = 0;
+	seeds = 0;
 
-	// Create local particle vertices (easier to update)
-	// Do UV's here, as those will never change
-	localParticleVertices = new ParticleVertex[4 * maxParticles];
-	for (int i = 0; i < maxParticles * 4; i += 4)
+	if (mode == EMITTER_ANALYTIC)
+	{
+		// Spawn time and seed are all we keep
+		spawnTimes = new float[maxParticles];
+		seeds = new unsigned int[maxParticles];
+	}
+	else
 	{
-		localParticleVertices[i + 0].UV = XMFLOAT2(0, 0);
-		localParticleVertices[i + 1].UV = XMFLOAT2(1, 0);
-		localParticleVertices[i + 2].UV = XMFLOAT2(1, 1);
-		localParticleVertices[i + 3].UV = XMFLOAT2(0, 1);
+		// Make the particle streams - one allocation, carved into
+		// arrays padded out to whole blocks of four
+		const int streamCount = 12;
+		particles.Capacity = (maxParticles + 3) & ~3;
+		particleData = new float[streamCount * particles.Capacity];
+		float** streams[streamCount] = {
+			&particles.Age,
+			&particles.VelocityX, &particles.VelocityY, &particles.VelocityZ,
+			&particles.PositionX, &particles.PositionY, &particles.PositionZ,
+			&particles.ColorR, &particles.ColorG, &particles.ColorB, &particles.ColorA,
+			&particles.Size };
+		for (int s = 0; s < streamCount; s++)
+			*streams[s] = particleData + s * particles.Capacity;
+
+		// Everything starts out dead
+		memset(particleData, 0, sizeof(float) * streamCount * particles.Capacity);
+		for (int i = 0; i < particles.Capacity; i++)
+			particles.Age[i] = lifetime;
 	}
+}
 
 
-	// Create buffers for drawing particles
+Emitter::~Emitter()
+{
+	delete[] particleData;
+	delete[] spawnTimes;
+	delete[] seeds;
+}
 
-	// DYNAMIC vertex buffer (no initial data necessary)
-	D3D11_BUFFER_DESC vbDesc = {};
-	vbDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	vbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	vbDesc.Usage = D3D11_USAGE_DYNAMIC;
-	vbDesc.ByteWidth = sizeof(ParticleVertex) * 4 * maxParticles;
-	device->CreateBuffer(&vbDesc, 0, &vertexBuffer);
+void Emitter::Update(float dt)
+{
+	BeginUpdate(dt);
+
+	int deaths = 0;
+	int chunks = GetChunkCount();
+	for (int c = 0; c < chunks; c++)
+		deaths += UpdateChunk(c);
 
-	// Index buffer data
-	unsigned int* indices = new unsigned int[maxParticles * 6];
-	int indexCount = 0;
-	for (int i = 0; i < maxParticles * 4; i += 4)
+	EndUpdate(deaths);
+}
+
+void Emitter::BeginUpdate(float dt)
+{
+	// Any time spent asleep goes into this one step
+	stepTime = dt + sleptTime;
+	sleptTime = 0;
+	emitterTime += stepTime;
+
+	if (emitterTime >= rebaseTime)
+		Rebase();
+}
+
+// --------------------------------------------------------
+// Makes the emitter's time zero again, moving every living
+// particle's spawn time by the same amount so its age stays
+// the same
+// --------------------------------------------------------
+void Emitter::Rebase()
+{
+	if (mode == EMITTER_ANALYTIC)
 	{
-		indices[indexCount++] = i;
-		indices[indexCount++] = i + 1;
-		indices[indexCount++] = i + 2;
-		indices[indexCount++] = i;
-		indices[indexCount++] = i + 2;
-		indices[indexCount++] = i + 3;
+		int index = firstAliveIndex;
+		for (int i = 0; i < livingParticleCount; i++)
+		{
+			spawnTimes[index] -= emitterTime;
+			index = (index + 1) % maxParticles;
+		}
 	}
-	D3D11_SUBRESOURCE_DATA indexData = {};
-	indexData.pSysMem = indices;
-
-	// Regular index buffer
-	D3D11_BUFFER_DESC ibDesc = {};
-	ibDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	ibDesc.CPUAccessFlags = 0;
-	ibDesc.Usage = D3D11_USAGE_DEFAULT;
-	ibDesc.ByteWidth = sizeof(unsigned int) * maxParticles * 6;
-	device->CreateBuffer(&ibDesc, &indexData, &indexBuffer);
-
-	delete[] indices;
-}
 
+	emitterTime = 0;
+}
 
-Emitter::~Emitter()
+// --------------------------------------------------------
+// Chunks split the particle array into fixed, block-aligned
+// pieces, so no two chunks ever share a block of four
+// --------------------------------------------------------
+int Emitter::GetChunkCount()
 {
-	delete[] particles;
-	delete[] localParticleVertices;
-	vertexBuffer->Release();
-	indexBuffer->Release();
+	// Analytic particles have nothing to step
+	if (mode == EMITTER_ANALYTIC || livingParticleCount == 0)
+		return 0;
 
+	return (maxParticles + ChunkSize - 1) / ChunkSize;
 }
 
-void Emitter::Update(float dt)
+// --------------------------------------------------------
+// Steps the living particles inside one chunk, and returns
+// how many of them died.  Only reads the ring's indices, so
+// every chunk can run at once.
+// --------------------------------------------------------
+int Emitter::UpdateChunk(int chunk)
 {
-	// Update all particles - Check cyclic buffer first
+	int chunkStart = chunk * ChunkSize;
+	int chunkEnd = chunkStart + ChunkSize < maxParticles ? chunkStart + ChunkSize : maxParticles;
+
+	// The living particles, as one or two ranges of the ring
+	int rangeStarts[2];
+	int rangeEnds[2];
+	int rangeCount = 0;
 	if (firstAliveIndex < firstDeadIndex)
 	{
 		// First alive is BEFORE first dead, so the "living" particles are contiguous
 		// 
 		// 0 -------- FIRST ALIVE ----------- FIRST DEAD -------- MAX
 		// |    dead    |            alive       |         dead    |
-
-		// First alive is before first dead, so no wrapping
-		for (int i = firstAliveIndex; i < firstDeadIndex; i++)
-			UpdateSingleParticle(dt, i);
+		rangeStarts[rangeCount] = firstAliveIndex;
+		rangeEnds[rangeCount++] = firstDeadIndex;
 	}
 	else
 	{
@@ -123,176 +180,373 @@ void Emitter::Update(float dt)
 		// 
 		// 0 -------- FIRST DEAD ----------- FIRST ALIVE -------- MAX
 		// |    alive    |            dead       |         alive   |
+		rangeStarts[rangeCount] = firstAliveIndex;
+		rangeEnds[rangeCount++] = maxParticles;
+		rangeStarts[rangeCount] = 0;
+		rangeEnds[rangeCount++] = firstDeadIndex;
+	}
 
-		// Update first half (from firstAlive to max particles)
-		for (int i = firstAliveIndex; i < maxParticles; i++)
-			UpdateSingleParticle(dt, i);
-
-		// Update second half (from 0 to first dead)
-		for (int i = 0; i < firstDeadIndex; i++)
-			UpdateSingleParticle(dt, i);
+	int deaths = 0;
+	for (int r = 0; r < rangeCount; r++)
+	{
+		int start = rangeStarts[r] > chunkStart ? rangeStarts[r] : chunkStart;
+		int end = rangeEnds[r] < chunkEnd ? rangeEnds[r] : chunkEnd;
+		if (start < end)
+			deaths += (this->*updateKernel)(stepTime, start, end);
 	}
 
-	// Add to the time
-	timeSinceEmit += dt;
+	return deaths;
+}
 
-	// Enough time to emit?
-	while (timeSinceEmit > secondsPerParticle)
+void Emitter::EndUpdate(int deaths)
+{
+	// Analytic particles die when their time is up
+	if (mode == EMITTER_ANALYTIC)
+		deaths = RetireExpired();
+
+	// Every particle lives equally long, so they die in the order they
+	// were born - retire them all by moving the alive index
+	firstAliveIndex = (firstAliveIndex + deaths) % maxParticles;
+	livingParticleCount -= deaths;
+
+	// Add to the time - anything emitted more than a lifetime
+	// ago would be dead already, so a long sleep never owes
+	// more than a lifetime's worth.  Only whole emissions are
+	// dropped, so the ones that are left land on the same
+	// ages they'd have had if the emitter never slept.
+	timeSinceEmit += stepTime;
+	if (timeSinceEmit > lifetime + secondsPerParticle)
+		timeSinceEmit = lifetime + fmodf(timeSinceEmit - lifetime, secondsPerParticle);
+
+	// Everything due this frame, in one go - what's left over
+	// is how long ago the newest of them was emitted
+	int due = (int)(timeSinceEmit * emissionRate);
+	if (emissionRate <= 0)
+	{
+		// Not emitting, so nothing builds up either
+		timeSinceEmit = 0;
+	}
+	else if (due > 0)
 	{
-		SpawnParticle();
-		timeSinceEmit -= secondsPerParticle;
+		timeSinceEmit -= due * secondsPerParticle;
+		if (timeSinceEmit < 0)
+			timeSinceEmit = 0;
+
+		SpawnParticles(due, timeSinceEmit);
 	}
 }
 
-void Emitter::UpdateSingleParticle(float dt, int index)
+// --------------------------------------------------------
+// Ages, kills and moves particles four at a time.  Lanes
+// outside [start, end) or already dead are masked out, and
+// every store selects between old and new values, so a
+// block shared with the other half of a wrapped ring (or
+// with dead particles) is never disturbed.
+// --------------------------------------------------------
+int Emitter::UpdateRange(float dt, int start, int end)
 {
-	// Check for valid particle age before doing anything
-	if (particles[index].Age >= lifetime)
-		return;
+	return UpdateKernel<BallisticMotion, CurveAppearance>(dt, start, end);
+}
 
-	// Update and check for death
-	particles[index].Age += dt;
-	if (particles[index].Age >= lifetime)
+template<typename Motion, typename Appearance>
+int Emitter::UpdateKernel(float dt, int start, int end)
+{
+	int deaths = 0;
+
+	XMVECTOR life = XMVectorReplicate(lifetime);
+	XMVECTOR invLife = XMVectorReplicate(1.0f / lifetime);
+	XMVECTOR delta = XMVectorReplicate(dt);
+
+	XMVECTOR halfAccel[3] = {
+		XMVectorReplicate(emitterAcceleration.x * 0.5f),
+		XMVectorReplicate(emitterAcceleration.y * 0.5f),
+		XMVectorReplicate(emitterAcceleration.z * 0.5f) };
+	XMVECTOR origin[3] = {
+		XMVectorReplicate(emitterPosition.x),
+		XMVectorReplicate(emitterPosition.y),
+		XMVectorReplicate(emitterPosition.z) };
+
+	float* colors[4] = { particles.ColorR, particles.ColorG, particles.ColorB, particles.ColorA };
+	float* velocities[3] = { particles.VelocityX, particles.VelocityY, particles.VelocityZ };
+	float* positions[3] = { particles.PositionX, particles.PositionY, particles.PositionZ };
+
+	for (int block = start & ~3; block < end; block += 4)
 	{
-		// Recent death, so retire by moving alive count
-		firstAliveIndex++;
-		firstAliveIndex %= maxParticles;
-		livingParticleCount--;
-		return;
+		XMVECTOR inRange = XMVectorSelectControl(
+			block + 0 >= start && block + 0 < end,
+			block + 1 >= start && block + 1 < end,
+			block + 2 >= start && block + 2 < end,
+			block + 3 >= start && block + 3 < end);
+
+		// Age the ones that are alive, and see who just died
+		XMVECTOR age = XMLoadFloat4((const XMFLOAT4*)&particles.Age[block]);
+		XMVECTOR alive = XMVectorAndInt(inRange, XMVectorLess(age, life));
+		age = XMVectorSelect(age, XMVectorAdd(age, delta), alive);
+		XMStoreFloat4((XMFLOAT4*)&particles.Age[block], age);
+
+		XMVECTOR died = XMVectorAndInt(alive, XMVectorGreaterOrEqual(age, life));
+		XMVECTOR living = XMVectorAndCInt(alive, died);
+
+		XMUINT4 diedBits;
+		XMStoreUInt4(&diedBits, died);
+		deaths += (diedBits.x != 0) + (diedBits.y != 0) + (diedBits.z != 0) + (diedBits.w != 0);
+
+		// Color and size (if they change), then position
+		float* const blockColors[4] = { &colors[0][block], &colors[1][block], &colors[2][block], &colors[3][block] };
+		XMVECTOR agePercent = XMVectorMultiply(age, invLife);
+		XMVECTOR travel = Appearance::Apply(curves, agePercent, age, living, blockColors, &particles.Size[block]);
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			XMVECTOR velocity = XMLoadFloat4((const XMFLOAT4*)&velocities[axis][block]);
+			XMVECTOR old = XMLoadFloat4((const XMFLOAT4*)&positions[axis][block]);
+			XMVECTOR position = Motion::Position(halfAccel[axis], age, velocity, travel, origin[axis]);
+			XMStoreFloat4((XMFLOAT4*)&positions[axis][block], XMVectorSelect(old, position, living));
+		}
 	}
 
-	// Calculate age percentage for lerp
-	float agePercent = particles[index].Age / lifetime;
+	return deaths;
+}
 
-	// Interpolate the color
-	XMStoreFloat4(
-		&particles[index].Color,
-		XMVectorLerp(
-			XMLoadFloat4(&startColor),
-			XMLoadFloat4(&endColor),
-			agePercent));
+void Emitter::SetCurves(const ParticleCurves& curves)
+{
+	this->curves = curves;
+	this->curves.Bake(lifetime);
 
-	// Lerp size
-	particles[index].Size = startSize + agePercent * (endSize - startSize);
+	bool accelerates = emitterAcceleration.x != 0 || emitterAcceleration.y != 0 || emitterAcceleration.z != 0;
+	updateKernel = SelectKernel(accelerates, !this->curves.IsConstant());
 
+	UpdateBounds();
+}
 
-	// Adjust the position
-	XMVECTOR startPos = XMLoadFloat3(&emitterPosition);
-	XMVECTOR startVel = XMLoadFloat3(&particles[index].StartVelocity);
-	XMVECTOR accel = XMLoadFloat3(&emitterAcceleration);
-	float t = particles[index].Age;
+// --------------------------------------------------------
+// Position is start + velocity * travel + acceleration *
+// age^2 / 2, so each axis is bounded by the extremes of the
+// two terms on their own: velocity's jitter range times the
+// curve's travel range, and the acceleration term at age 0
+// and at the end of a lifetime.  Loose, but never wrong.
+// --------------------------------------------------------
+void Emitter::UpdateBounds()
+{
+	const float* start = &emitterPosition.x;
+	const float* velocity = &startVelocity.x;
+	const float* acceleration = &emitterAcceleration.x;
+	float* min = &boundsMin.x;
+	float* max = &boundsMax.x;
+
+	float travel[2] = { curves.GetMinTravel(), curves.GetMaxTravel() };
 
-	// Use constant acceleration function
-	XMStoreFloat3(
-		&particles[index].Position,
-		accel * t * t / 2.0f + startVel * t + startPos);
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float speeds[2] = { velocity[axis] - velocityJitter, velocity[axis] + velocityJitter };
+		float low = speeds[0] * travel[0];
+		float high = low;
+		for (int s = 0; s < 2; s++)
+		{
+			for (int t = 0; t < 2; t++)
+			{
+				float reach = speeds[s] * travel[t];
+				if (reach < low) low = reach;
+				if (reach > high) high = reach;
+			}
+		}
+
+		float fall = acceleration[axis] * lifetime * lifetime * 0.5f;
+		if (fall < 0) low += fall;
+		else high += fall;
+
+		min[axis] = start[axis] + low;
+		max[axis] = start[axis] + high;
+	}
 }
 
-void Emitter::SpawnParticle()
+// --------------------------------------------------------
+// The runtime side of the kernel templates - every
+// combination is instantiated here
+// --------------------------------------------------------
+Emitter::UpdateFunction Emitter::SelectKernel(bool accelerates, bool animated)
 {
-	// Any left to spawn?
-	if (livingParticleCount == maxParticles)
-		return;
+	if (accelerates)
+	{
+		return animated ?
+			&Emitter::UpdateKernel<BallisticMotion, CurveAppearance> :
+			&Emitter::UpdateKernel<BallisticMotion, FixedAppearance>;
+	}
 
-	// Reset the first dead particle
-	particles[firstDeadIndex].Age = 0;
-	particles[firstDeadIndex].Size = startSize;
-	particles[firstDeadIndex].Color = startColor;
-	particles[firstDeadIndex].Position = emitterPosition;
-	particles[firstDeadIndex].StartVelocity = startVelocity;
-	particles[firstDeadIndex].StartVelocity.x += ((float)rand() / RAND_MAX) * 0.4f - 0.2f;
-	particles[firstDeadIndex].StartVelocity.y += ((float)rand() / RAND_MAX) * 0.4f - 0.2f;
-	particles[firstDeadIndex].StartVelocity.z += ((float)rand() / RAND_MAX) * 0.4f - 0.2f;
+	return animated ?
+		&Emitter::UpdateKernel<DriftMotion, CurveAppearance> :
+		&Emitter::UpdateKernel<DriftMotion, FixedAppearance>;
+}
 
-	// Increment and wrap
-	firstDeadIndex++;
-	firstDeadIndex %= maxParticles;
+void Emitter::SetBudget(float rateScale, int liveLimit)
+{
+	if (rateScale < 0) rateScale = 0;
+	if (rateScale > 1) rateScale = 1;
+	if (liveLimit < 0) liveLimit = 0;
+	if (liveLimit > maxParticles) liveLimit = maxParticles;
+
+	emissionRate = particlesPerSecond * rateScale;
+	secondsPerParticle = 1.0f / (rateScale > 0 ? emissionRate : particlesPerSecond);
+	this->liveLimit = liveLimit;
+}
 
-	livingParticleCount++;
+void Emitter::SpawnParticle()
+{
+	SpawnParticles(1, 0);
 }
 
-void Emitter::CopyParticlesToGPU(ID3D11DeviceContext* context)
+// --------------------------------------------------------
+// New particles go in at the first dead index, oldest first,
+// so the ring stays in spawn order (and dies in that order)
+// --------------------------------------------------------
+int Emitter::SpawnParticles(int count, float newestAge)
 {
-	// Update local buffer (living particles only as a speed up)
+	// Ones emitted more than a lifetime ago never show up
+	int skipped = 0;
+	float oldestAge = newestAge + (count - 1) * secondsPerParticle;
+	while (skipped < count && oldestAge >= lifetime)
+	{
+		skipped++;
+		oldestAge -= secondsPerParticle;
+	}
 
-	// Check cyclic buffer status
-	if (firstAliveIndex < firstDeadIndex)
+	// Any left to spawn?  Over the live limit, the oldest of
+	// them are dropped too, so the ones that make it have the
+	// same ages they'd have had with room for everything.
+	// They're dropped, not owed - the caller has already taken
+	// all of them out of timeSinceEmit.
+	int spawning = count - skipped;
+	if (spawning > liveLimit - livingParticleCount)
 	{
-		for (int i = firstAliveIndex; i < firstDeadIndex; i++)
-			CopyOneParticle(i);
+		int dropped = spawning - (liveLimit - livingParticleCount);
+		spawning -= dropped;
+		oldestAge -= dropped * secondsPerParticle;
 	}
-	else
+	if (spawning <= 0)
+		return 0;
+
+	// Up to the end of the array, then wrap around
+	int firstRun = maxParticles - firstDeadIndex;
+	if (firstRun > spawning)
+		firstRun = spawning;
+
+	InitializeRange(firstDeadIndex, firstRun, oldestAge);
+	if (spawning > firstRun)
+		InitializeRange(0, spawning - firstRun, oldestAge - firstRun * secondsPerParticle);
+
+	// Increment and wrap
+	firstDeadIndex = (firstDeadIndex + spawning) % maxParticles;
+	livingParticleCount += spawning;
+	return spawning;
+}
+
+void Emitter::InitializeRange(int start, int count, float oldestAge)
+{
+	if (mode == EMITTER_ANALYTIC)
 	{
-		// Update first half (from firstAlive to max particles)
-		for (int i = firstAliveIndex; i < maxParticles; i++)
-			CopyOneParticle(i);
+		// Everything else follows from these two
+		for (int i = 0; i < count; i++)
+			spawnTimes[start + i] = emitterTime - (oldestAge - i * secondsPerParticle);
 
-		// Update second half (from 0 to first dead)
-		for (int i = 0; i < firstDeadIndex; i++)
-			CopyOneParticle(i);
+		random.Fill(&seeds[start], count);
+		return;
 	}
 
-	// All particles copied locally - send whole buffer to GPU
-	D3D11_MAPPED_SUBRESOURCE mapped = {};
-	context->Map(vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+	for (int i = 0; i < count; i++)
+		particles.Age[start + i] = oldestAge - i * secondsPerParticle;
 
-	memcpy(mapped.pData, localParticleVertices, sizeof(ParticleVertex) * 4 * maxParticles);
+	random.Fill(&particles.VelocityX[start], count, startVelocity.x - velocityJitter, startVelocity.x + velocityJitter);
+	random.Fill(&particles.VelocityY[start], count, startVelocity.y - velocityJitter, startVelocity.y + velocityJitter);
+	random.Fill(&particles.VelocityZ[start], count, startVelocity.z - velocityJitter, startVelocity.z + velocityJitter);
 
-	context->Unmap(vertexBuffer, 0);
+	// A zero step works position, color and size out from
+	// each particle's age (and none of them are old enough
+	// to die)
+	UpdateRange(0, start, start + count);
 }
 
-void Emitter::CopyOneParticle(int index)
+// --------------------------------------------------------
+// Analytic particles die in spawn order too, so expired
+// ones are always at the front of the ring
+// --------------------------------------------------------
+int Emitter::RetireExpired()
 {
-	int i = index * 4;
-
-	localParticleVertices[i + 0].Position = particles[index].Position;
-	localParticleVertices[i + 1].Position = particles[index].Position;
-	localParticleVertices[i + 2].Position = particles[index].Position;
-	localParticleVertices[i + 3].Position = particles[index].Position;
-
-	localParticleVertices[i + 0].Size = particles[index].Size;
-	localParticleVertices[i + 1].Size = particles[index].Size;
-	localParticleVertices[i + 2].Size = particles[index].Size;
-	localParticleVertices[i + 3].Size = particles[index].Size;
-
-	localParticleVertices[i + 0].Color = particles[index].Color;
-	localParticleVertices[i + 1].Color = particles[index].Color;
-	localParticleVertices[i + 2].Color = particles[index].Color;
-	localParticleVertices[i + 3].Color = particles[index].Color;
+	int deaths = 0;
+	int index = firstAliveIndex;
+	while (deaths < livingParticleCount && emitterTime - spawnTimes[index] >= lifetime)
+	{
+		deaths++;
+		index = (index + 1) % maxParticles;
+	}
+	return deaths;
 }
 
-void Emitter::Draw(ID3D11DeviceContext* context, Camera* camera)
+// --------------------------------------------------------
+// The same closed form the simulated path steps through,
+// evaluated directly at the particle's current age
+// --------------------------------------------------------
+void Emitter::EvaluateParticle(int index, XMFLOAT3* position, XMFLOAT4* color, float* size)
 {
-	// Copy to dynamic buffer
-	CopyParticlesToGPU(context);
+	float age = emitterTime - spawnTimes[index];
+	float agePercent = age / lifetime;
 
-	// Set up buffers
-	UINT stride = sizeof(ParticleVertex);
-	UINT offset = 0;
-	context->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
-	context->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+	ParticleCurveSample sample = curves.Sample(agePercent);
+	*color = sample.Color;
+	*size = sample.Size;
 
-	vs->SetMatrix4x4("view", camera->GetViewMatrix());
-	vs->SetMatrix4x4("projection", camera->GetProjectionMatrix());
-	vs->SetShader();
-	vs->CopyAllBufferData();
+	XMFLOAT3 velocity(
+		startVelocity.x + SeedJitter(seeds[index], 0),
+		startVelocity.y + SeedJitter(seeds[index], 1),
+		startVelocity.z + SeedJitter(seeds[index], 2));
 
-	ps->SetShaderResourceView("particle", texture);
-	ps->SetShader();
-	ps->CopyAllBufferData();
+	XMVECTOR startPos = XMLoadFloat3(&emitterPosition);
+	XMVECTOR startVel = XMLoadFloat3(&velocity);
+	XMVECTOR accel = XMLoadFloat3(&emitterAcceleration);
+	XMStoreFloat3(position, accel * age * age / 2.0f + startVel * sample.Travel + startPos);
+}
 
-	// Draw the correct parts of the buffer
-	if (firstAliveIndex < firstDeadIndex)
+// --------------------------------------------------------
+// Velocity jitter in [-velocityJitter, velocityJitter] for one axis, hashed from
+// the seed so it's the same every time it's asked for
+// --------------------------------------------------------
+float Emitter::SeedJitter(unsigned int seed, unsigned int axis)
+{
+	unsigned int h = seed * 3u + axis;
+	h ^= h >> 16;
+	h *= 0x7feb352du;
+	h ^= h >> 15;
+	h *= 0x846ca68bu;
+	h ^= h >> 16;
+	return (h >> 8) * (1.0f / 16777216.0f) * (2 * velocityJitter) - velocityJitter;
+}
+
+// --------------------------------------------------------
+// Writes one record per living particle, oldest first, so
+// the caller can pack several emitters into one buffer and
+// upload only what's alive
+// --------------------------------------------------------
+int Emitter::WriteParticles(ParticleInstance* instances)
+{
+	int index = firstAliveIndex;
+	for (int i = 0; i < livingParticleCount; i++)
 	{
-		context->DrawIndexed(livingParticleCount * 6, firstAliveIndex * 6, 0);
+		WriteParticle(index, &instances[i]);
+		index = (index + 1) % maxParticles;
+	}
+
+	return livingParticleCount;
+}
+
+void Emitter::WriteParticle(int index, ParticleInstance* instance)
+{
+	if (mode == EMITTER_ANALYTIC)
+	{
+		EvaluateParticle(index, &instance->Position, &instance->Color, &instance->Size);
 	}
 	else
 	{
-		// Draw first half (0 -> dead)
-		context->DrawIndexed(firstDeadIndex * 6, 0, 0);
-
-		// Draw second half (alive -> max)
-		context->DrawIndexed((maxParticles - firstAliveIndex) * 6, firstAliveIndex * 6, 0);
+		instance->Position = XMFLOAT3(particles.PositionX[index], particles.PositionY[index], particles.PositionZ[index]);
+		instance->Color = XMFLOAT4(particles.ColorR[index], particles.ColorG[index], particles.ColorB[index], particles.ColorA[index]);
+		instance->Size = particles.Size[index];
 	}
-
 }
@@ -1,23 +1,58 @@
 #pragma once
 #include <DirectXMath.h>
-#include "SimpleShader.h"
-#include "Camera.h"
+#include "ParticleRandom.h"
+#include "ParticleCurves.h"
+#include "EmitterPolicies.h"
 
 using namespace DirectX;
 
-struct Particle {
-	XMFLOAT3 Position;
-	XMFLOAT4 Color;
-	XMFLOAT3 StartVelocity;
-	float Size;
-	float Age;
+// --------------------------------------------------------
+// Particle state as one array per value (structure of
+// arrays), so four particles' worth of any value loads
+// straight into a single XMVECTOR.  Every stream is padded
+// to a multiple of four, so whole blocks are always safe
+// to load and store.
+// --------------------------------------------------------
+struct ParticleStreams {
+	float* Age;
+	float* VelocityX;
+	float* VelocityY;
+	float* VelocityZ;
+	float* PositionX;
+	float* PositionY;
+	float* PositionZ;
+	float* ColorR;
+	float* ColorG;
+	float* ColorB;
+	float* ColorA;
+	float* Size;
+	int Capacity;		// maxParticles rounded up to a multiple of 4
 };
 
-struct ParticleVertex {
+// --------------------------------------------------------
+// How an emitter gets its particles' current state
+//
+// SIMULATED - every particle's position, color and size are
+//   stored and stepped forward each Update()
+// ANALYTIC - only each particle's spawn time and seed are
+//   stored, and everything else is worked out from them (in
+//   closed form) when the particle is drawn.  Only works for
+//   effects that are pure functions of age, like ballistic
+//   motion with color, size and speed on curves.
+// --------------------------------------------------------
+enum EmitterMode {
+	EMITTER_SIMULATED,
+	EMITTER_ANALYTIC
+};
+
+// --------------------------------------------------------
+// One live particle as the vertex shader sees it (one per
+// instance - the shader builds the quad's corners itself)
+// --------------------------------------------------------
+struct ParticleInstance {
 	XMFLOAT3 Position;
-	XMFLOAT2 UV;
-	XMFLOAT4 Color;
 	float Size;
+	XMFLOAT4 Color;
 };
 
 class Emitter
@@ -34,51 +69,129 @@ public:
 		DirectX::XMFLOAT3 startVelocity,
 		DirectX::XMFLOAT3 emitterPosition,
 		DirectX::XMFLOAT3 emitterAcceleration,
-		ID3D11Device* device,
-		SimpleVertexShader* vs,
-		SimplePixelShader* ps,
-		ID3D11ShaderResourceView* texture
+		EmitterMode mode = EMITTER_SIMULATED,
+		unsigned int seed = 0
 	);
 	~Emitter();
 	void Update(float dt);
 
-	void UpdateSingleParticle(float dt, int index);
+	// Update() in pieces, so big emitters can be spread over
+	// threads: BeginUpdate(), then UpdateChunk() for every
+	// chunk in [0, GetChunkCount()) - in any order, at the same
+	// time if you like - then EndUpdate() with the total of
+	// their returned deaths.  Only EndUpdate() moves the ring
+	// or spawns.
+	void BeginUpdate(float dt);
+	int GetChunkCount();
+	int UpdateChunk(int chunk);
+	void EndUpdate(int deaths);
+
+	// Particles per chunk (a multiple of four)
+	static const int ChunkSize = 1024;
+
+	// Skips an update, but remembers the time.  The next
+	// BeginUpdate() catches up on all of it in one step -
+	// positions, colors and sizes are closed forms of age, so
+	// that costs the same as any other frame, however long
+	// the emitter slept.
+	void Sleep(float dt) { sleptTime += dt; }
+	float GetSleptTime() { return sleptTime; }
+
 	void SpawnParticle();
 
-	void CopyParticlesToGPU(ID3D11DeviceContext* context);
-	void CopyOneParticle(int index);
-	void Draw(ID3D11DeviceContext* context, Camera* camera);
+	// Spawns count particles emitted secondsPerParticle apart,
+	// the newest of them newestAge ago.  Skips any that would
+	// already be dead, and returns how many fit.
+	int SpawnParticles(int count, float newestAge);
+
+	// Writes every living particle, oldest first, and returns
+	// how many were written (never more than GetMaxParticles())
+	int WriteParticles(ParticleInstance* instances);
+	void WriteParticle(int index, ParticleInstance* instance);
+
+	int GetLivingCount() { return livingParticleCount; }
+	int GetMaxParticles() { return maxParticles; }
+
+	// World space box every particle's center stays inside over
+	// its whole life (alive now or not), and the largest size
+	// (in clip space, like the shader) one can be drawn at
+	void GetBounds(XMFLOAT3* min, XMFLOAT3* max) { *min = boundsMin; *max = boundsMax; }
+	float GetMaxSize() { return curves.GetMaxSize(); }
+
+	// Replaces the linear color and size given to the
+	// constructor (bakes a copy for this emitter's lifetime)
+	void SetCurves(const ParticleCurves& curves);
+
+	// Scales the emission rate (0 stops emitting) and caps how
+	// many particles can be alive at once - what's already
+	// alive over the cap just dies off naturally
+	void SetBudget(float rateScale, int liveLimit);
 
 private:
 	// Emission properties
 	float particlesPerSecond;
-	float secondsPerParticle;
+	float emissionRate;			// particlesPerSecond after the budget
+	float secondsPerParticle;	// Between emissions, at emissionRate
 	float timeSinceEmit;
+	int liveLimit;
 
 	int livingParticleCount;
 	float lifetime;
 
+	EmitterMode mode;
+	float emitterTime;			// Time updated for since the last Rebase()
+	float stepTime;				// dt of the update in progress
+	float sleptTime;			// Skipped by Sleep(), added to the next update
+
+	// Velocity jitter (and analytic seeds) - the same seed always
+	// gives the same particles
+	ParticleRandom random;
+
 	DirectX::XMFLOAT3 emitterAcceleration;
 	DirectX::XMFLOAT3 emitterPosition;
 	DirectX::XMFLOAT3 startVelocity;
-	DirectX::XMFLOAT4 startColor;
-	DirectX::XMFLOAT4 endColor;
-	float startSize;
-	float endSize;
 
-	// Particle array
-	Particle* particles;
+	// Color, size and speed over each particle's life, baked
+	ParticleCurves curves;
+
+	// Worked out from the curves, velocity and acceleration
+	DirectX::XMFLOAT3 boundsMin;
+	DirectX::XMFLOAT3 boundsMax;
+	void UpdateBounds();
+
+	// Particle data (one block of memory split into streams)
+	float* particleData;
+	ParticleStreams particles;
+
+	// Analytic mode's entire per-particle state
+	float* spawnTimes;
+	unsigned int* seeds;
 	int maxParticles;
 	int firstDeadIndex;
 	int firstAliveIndex;
 
-	// Rendering
-	ParticleVertex* localParticleVertices;
-	ID3D11Buffer* vertexBuffer;
-	ID3D11Buffer* indexBuffer;
+	// Sets up count just-spawned particles from start (no wrapping),
+	// the first oldestAge old and each after it one emission younger
+	void InitializeRange(int start, int count, float oldestAge);
+
+	// Updates particles [start, end) four at a time, returning how many
+	// died.  UpdateRange() does everything; per-frame updates go through
+	// updateKernel, which skips whatever this emitter doesn't need.
+	typedef int (Emitter::*UpdateFunction)(float dt, int start, int end);
+	UpdateFunction updateKernel;
+
+	int UpdateRange(float dt, int start, int end);
+	template<typename Motion, typename Appearance>
+	int UpdateKernel(float dt, int start, int end);
+
+	// Maps what an emitter does to the kernel built for it
+	static UpdateFunction SelectKernel(bool accelerates, bool animated);
 
-	ID3D11ShaderResourceView* texture;
-	SimpleVertexShader* vs;
-	SimplePixelShader* ps;
+	// Analytic mode: retires expired particles, and works out one
+	// particle's current state from its spawn time and seed
+	int RetireExpired();
+	void Rebase();
+	void EvaluateParticle(int index, XMFLOAT3* position, XMFLOAT4* color, float* size);
+	static float SeedJitter(unsigned int seed, unsigned int axis);
 };
 
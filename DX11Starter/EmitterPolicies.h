@@ -0,0 +1,83 @@
+#pragma once
+#include <DirectXMath.h>
+#include "ParticleCurves.h"
+
+// --------------------------------------------------------
+// Pieces of the emitter's four-wide update, picked at
+// compile time.  Emitter::UpdateKernel<Motion, Appearance>
+// is built from one of each, so every combination compiles
+// to its own loop with nothing it doesn't need - no curve
+// lookups for an effect that never changes, no
+// acceleration terms for one that just drifts.
+// --------------------------------------------------------
+
+// --------------------------------------------------------
+// Motion: where four particles are, given their age, start
+// velocity and travel (see ParticleCurves)
+// --------------------------------------------------------
+struct BallisticMotion
+{
+	static DirectX::XMVECTOR Position(DirectX::FXMVECTOR halfAccel, DirectX::FXMVECTOR age, DirectX::FXMVECTOR velocity, DirectX::GXMVECTOR travel, DirectX::HXMVECTOR origin)
+	{
+		using namespace DirectX;
+		return XMVectorMultiplyAdd(XMVectorMultiply(halfAccel, age), age, XMVectorMultiplyAdd(velocity, travel, origin));
+	}
+};
+
+// No acceleration at all
+struct DriftMotion
+{
+	static DirectX::XMVECTOR Position(DirectX::FXMVECTOR /*halfAccel*/, DirectX::FXMVECTOR /*age*/, DirectX::FXMVECTOR velocity, DirectX::GXMVECTOR travel, DirectX::HXMVECTOR origin)
+	{
+		using namespace DirectX;
+		return XMVectorMultiplyAdd(velocity, travel, origin);
+	}
+};
+
+// --------------------------------------------------------
+// Appearance: writes the color and size of the living lanes
+// of one block, and returns their travel
+// --------------------------------------------------------
+struct CurveAppearance
+{
+	static DirectX::XMVECTOR Apply(const ParticleCurves& curves, DirectX::FXMVECTOR agePercent, DirectX::FXMVECTOR /*age*/, DirectX::FXMVECTOR living, float* const colors[4], float* size)
+	{
+		using namespace DirectX;
+
+		// Each lane's spot on the baked curves, turned back into
+		// one vector per value
+		XMFLOAT4 agePercents;
+		XMStoreFloat4(&agePercents, agePercent);
+		ParticleCurveSample s[4] = {
+			curves.Sample(agePercents.x), curves.Sample(agePercents.y),
+			curves.Sample(agePercents.z), curves.Sample(agePercents.w) };
+
+		XMVECTOR laneColors[4] = {
+			XMVectorSet(s[0].Color.x, s[1].Color.x, s[2].Color.x, s[3].Color.x),
+			XMVectorSet(s[0].Color.y, s[1].Color.y, s[2].Color.y, s[3].Color.y),
+			XMVectorSet(s[0].Color.z, s[1].Color.z, s[2].Color.z, s[3].Color.z),
+			XMVectorSet(s[0].Color.w, s[1].Color.w, s[2].Color.w, s[3].Color.w) };
+		for (int c = 0; c < 4; c++)
+		{
+			XMVECTOR old = XMLoadFloat4((const XMFLOAT4*)colors[c]);
+			XMStoreFloat4((XMFLOAT4*)colors[c], XMVectorSelect(old, laneColors[c], living));
+		}
+
+		XMVECTOR oldSize = XMLoadFloat4((const XMFLOAT4*)size);
+		XMVECTOR newSize = XMVectorSet(s[0].Size, s[1].Size, s[2].Size, s[3].Size);
+		XMStoreFloat4((XMFLOAT4*)size, XMVectorSelect(oldSize, newSize, living));
+
+		return XMVectorSet(s[0].Travel, s[1].Travel, s[2].Travel, s[3].Travel);
+	}
+};
+
+// Curves that never change: color and size stay as they were
+// spawned, and travel is just age at a constant speed
+struct FixedAppearance
+{
+	static DirectX::XMVECTOR Apply(const ParticleCurves& curves, DirectX::FXMVECTOR /*agePercent*/, DirectX::FXMVECTOR age, DirectX::FXMVECTOR /*living*/, float* const /*colors*/[4], float* /*size*/)
+	{
+		using namespace DirectX;
+		return XMVectorScale(age, curves.GetConstantSpeed());
+	}
+};
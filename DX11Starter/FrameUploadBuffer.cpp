@@ -0,0 +1,178 @@
+#include "FrameUploadBuffer.h"
+#include <string.h>
+
+FrameUploadBuffer::FrameUploadBuffer(ID3D11Device* device, ID3D11DeviceContext* immediateContext, unsigned int capacity, unsigned int framesInFlight)
+{
+	this->immediateContext = immediateContext;
+	this->framesInFlight = framesInFlight;
+
+	buffer = 0;
+	staging = 0;
+	fences = 0;
+	everMapped = false;
+	frameIndex = 0;
+	frameActive = false;
+	frameStarted = false;
+
+	ring = new UploadRing(capacity, SliceAlignment, framesInFlight);
+
+	// We need to bind at offsets AND map constant buffers with NO_OVERWRITE
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+	device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options));
+
+	ID3D11DeviceContext1* context1 = 0;
+	immediateContext->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)&context1);
+
+	supported =
+		context1 != 0 &&
+		options.ConstantBufferOffsetting &&
+		options.MapNoOverwriteOnDynamicConstantBuffer;
+
+	if (context1) context1->Release();
+	if (!supported)
+		return;
+
+	// The big dynamic buffer itself
+	D3D11_BUFFER_DESC desc = {};
+	desc.ByteWidth = ring->GetCapacity();
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	if (device->CreateBuffer(&desc, 0, &buffer) != S_OK)
+	{
+		supported = false;
+		return;
+	}
+
+	// CPU side copy that shaders write into while recording
+	staging = new unsigned char[ring->GetCapacity()];
+
+	// One fence per frame that can be in flight
+	D3D11_QUERY_DESC queryDesc = {};
+	queryDesc.Query = D3D11_QUERY_EVENT;
+	fences = new ID3D11Query*[framesInFlight];
+	for (unsigned int i = 0; i < framesInFlight; i++)
+		device->CreateQuery(&queryDesc, &fences[i]);
+}
+
+FrameUploadBuffer::~FrameUploadBuffer()
+{
+	if (fences)
+	{
+		for (unsigned int i = 0; i < framesInFlight; i++)
+			if (fences[i]) fences[i]->Release();
+		delete[] fences;
+	}
+
+	if (buffer) buffer->Release();
+	delete[] staging;
+	delete ring;
+}
+
+// --------------------------------------------------------
+// Frees ring space from frames the GPU has finished.
+//
+// wait - block until at least the oldest frame is done
+// --------------------------------------------------------
+void FrameUploadBuffer::RetireFinishedFrames(bool wait)
+{
+	while (ring->GetFramesInFlight() > 0)
+	{
+		unsigned long long oldest = ring->GetOldestFrameInFlight();
+		ID3D11Query* fence = fences[oldest % framesInFlight];
+
+		if (wait)
+		{
+			// Poll until the GPU catches up (GetData only stops returning
+			// S_FALSE once the query is done or the device is lost),
+			// giving the core away between polls
+			while (immediateContext->GetData(fence, 0, 0, 0) == S_FALSE)
+				SwitchToThread();
+			wait = false;
+		}
+		else if (immediateContext->GetData(fence, 0, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_FALSE)
+		{
+			return;
+		}
+
+		ring->RetireFrame(oldest);
+	}
+}
+
+void FrameUploadBuffer::BeginFrame()
+{
+	if (!supported || frameStarted)
+		return;
+
+	RetireFinishedFrames(false);
+
+	// Too many frames still in flight - wait on the oldest
+	if (!ring->BeginFrame(frameIndex))
+	{
+		RetireFinishedFrames(true);
+		ring->BeginFrame(frameIndex);
+	}
+
+	frameActive = ring->IsFrameOpen();
+	frameStarted = frameActive;
+}
+
+bool FrameUploadBuffer::Allocate(const void* data, unsigned int size, unsigned int* offset)
+{
+	if (!frameActive)
+		return false;
+
+	if (!ring->Allocate(size, offset))
+		return false;
+
+	memcpy(staging + *offset, data, size);
+	return true;
+}
+
+// --------------------------------------------------------
+// Sends everything allocated this frame to the GPU in one
+// map, and closes the frame to further allocations.  Must
+// happen on the immediate context BEFORE any command that
+// reads these slices is executed.
+// --------------------------------------------------------
+void FrameUploadBuffer::Upload()
+{
+	if (!frameActive)
+		return;
+
+	unsigned int start = ring->GetWindowStart();
+	unsigned int used = ring->GetFrameBytesUsed();
+	if (used > 0)
+	{
+		// The very first map of a dynamic buffer has to be a discard
+		D3D11_MAPPED_SUBRESOURCE mapped = {};
+		D3D11_MAP mapType = everMapped ? D3D11_MAP_WRITE_NO_OVERWRITE : D3D11_MAP_WRITE_DISCARD;
+		if (immediateContext->Map(buffer, 0, mapType, 0, &mapped) == S_OK)
+		{
+			memcpy((unsigned char*)mapped.pData + start, staging + start, used);
+			immediateContext->Unmap(buffer, 0);
+			everMapped = true;
+		}
+	}
+
+	ring->EndFrame();
+	frameActive = false;
+}
+
+// --------------------------------------------------------
+// Drops the fence for this frame, after all of its draws
+// have been submitted
+// --------------------------------------------------------
+void FrameUploadBuffer::EndFrame()
+{
+	if (!frameStarted)
+		return;
+
+	// Upload() was skipped somehow - still close the frame
+	if (frameActive)
+		Upload();
+
+	immediateContext->End(fences[frameIndex % framesInFlight]);
+	frameIndex++;
+	frameStarted = false;
+}
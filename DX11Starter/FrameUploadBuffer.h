@@ -0,0 +1,65 @@
+#pragma once
+#include <d3d11_1.h>
+#include "UploadRing.h"
+
+// --------------------------------------------------------
+// One large dynamic constant buffer that every shader
+// sub-allocates its per-draw data from, instead of each
+// shader doing an UpdateSubresource per buffer per draw.
+//
+// Shaders copy their data into a CPU-side staging copy
+// (from any thread), and the whole frame is sent to the GPU
+// with a single MAP_WRITE_NO_OVERWRITE before the frame's
+// command lists are executed.  Draws bind their slice with
+// *SetConstantBuffers1, so slices are 256 byte aligned.
+//
+// An event query per frame tells us when the GPU is done,
+// so a frame's slice is never reused while still in flight.
+//
+// Requires D3D 11.1 constant buffer offsetting - check
+// IsSupported() and fall back to per-shader buffers if not.
+// --------------------------------------------------------
+class FrameUploadBuffer
+{
+public:
+	FrameUploadBuffer(ID3D11Device* device, ID3D11DeviceContext* immediateContext, unsigned int capacity, unsigned int framesInFlight);
+	~FrameUploadBuffer();
+
+	bool IsSupported() { return supported; }
+
+	// Frame flow: BeginFrame, (shaders Allocate), Upload, submit draws, EndFrame
+	void BeginFrame();
+	void Upload();
+	void EndFrame();
+
+	// Reserves a slice for this frame and copies data into it.
+	// Thread safe.  Returns false if the frame is out of space.
+	bool Allocate(const void* data, unsigned int size, unsigned int* offset);
+
+	// Is a slice handed out during the given frame still usable?
+	bool IsCurrentFrame(unsigned long long frame) { return frameActive && frame == frameIndex; }
+
+	ID3D11Buffer* GetBuffer() { return buffer; }
+	unsigned long long GetFrameIndex() { return frameIndex; }
+	unsigned int GetFrameBytesUsed() { return ring->GetFrameBytesUsed(); }
+
+	// Alignment required by *SetConstantBuffers1 (16 constants of 16 bytes)
+	static const unsigned int SliceAlignment = 256;
+
+private:
+	ID3D11DeviceContext* immediateContext;
+	ID3D11Buffer* buffer;
+	unsigned char* staging;
+	UploadRing* ring;
+	bool supported;
+	bool everMapped;
+
+	// Frame fences (one event query per frame slot)
+	ID3D11Query** fences;
+	unsigned int framesInFlight;
+	unsigned long long frameIndex;
+	bool frameActive;	// Open for allocations
+	bool frameStarted;	// Between BeginFrame and EndFrame
+
+	void RetireFinishedFrames(bool wait);
+};
@@ -1,4 +1,6 @@
 #include "Game.h"
+#include "InputLayoutCache.h"
+#include "ConstantBuffers.h"
 #include "Vertex.h"
 #include "DirectXCollision.h"
 #include "WICTextureLoader.h"
@@ -25,6 +27,14 @@ Game::Game(HINSTANCE hInstance)
 	// Initialize fields
 	vertexShader = 0;
 	pixelShader = 0;
+	workers = 0;
+	commandRecorder = 0;
+	frameUploadBuffer = 0;
+	sharedConstants = 0;
+	renderTargets = 0;
+	renderGraph = 0;
+	stateCache = 0;
+	particles = 0;
 
 #if defined(DEBUG) || defined(_DEBUG)
 	// Do we want a console window?  Probably only in debug mode
@@ -45,11 +55,8 @@ Game::~Game()
 	// Delete our simple shader objects, which
 	// will clean up their own internal DirectX stuff
 
-	sampler->Release();
 	wallTexture->Release();
 	wallNormal->Release();
-	skyBoxRastState->Release();
-	skyBoxDepthState->Release();
 	skyBoxSRV->Release();
 
 	delete vertexShader;
@@ -75,8 +82,6 @@ Game::~Game()
 	}
 	gameEntities.clear();	
 
-	alphaPostRTV->Release();
-	alphaPostSRV->Release();	
 	delete alphaPostVertexShader;
 	delete alphaPostPixelShader;
 
@@ -108,9 +113,7 @@ Game::~Game()
 	buttonSRV->Release();
 
 	// Clean up refraction resources
-	refractSampler->Release();
-	refractionRTV->Release();
-	refractionSRV->Release();
+	delete renderTargets;
 
 	//reflectionSRV->Release();
 
@@ -129,17 +132,24 @@ Game::~Game()
 	//clean up particle stuff
 	bubbleTxt->Release();
 	heartTxt->Release();
-	delete bubbleEmitter;
-	delete bubbleEmitter2;
-	delete heartEmitter;
+	delete particles;
 	delete particlePS;
 	delete particleVS;
-	particleDepthState->Release();
-	particleBlendState->Release();
 
-	waterBlendState->Release();
 	waterNormalMap->Release();
 
+	// Graph feeds the recorder, which uses the workers
+	delete renderGraph;
+	delete commandRecorder;
+	delete workers;
+
+	ISimpleShader::SetFrameUploadBuffer(0);
+	delete frameUploadBuffer;
+	delete sharedConstants;
+
+	// Every vertex shader is gone, so nothing else is using these
+	InputLayoutCache::Clear();
+	delete stateCache;
 }
 
 // --------------------------------------------------------
@@ -148,6 +158,22 @@ Game::~Game()
 // --------------------------------------------------------
 void Game::Init()
 {
+	// Shaders look for the shared buffers by name as they load,
+	// so these need to exist first
+	sharedConstants = new SharedConstants(device);
+
+	// Every blend, depth, raster and sampler state comes from here
+	stateCache = new StateCache(device);
+
+	// Every shader's cbuffers get checked against their generated C++
+	// structs as they load.  Building with GENERATE_CONSTANT_BUFFERS skips
+	// the check and rewrites ConstantBuffers.h from the shaders instead.
+#ifndef GENERATE_CONSTANT_BUFFERS
+	unsigned int layoutCount = 0;
+	const ConstantBufferLayout* layouts = GetGeneratedConstantBufferLayouts(&layoutCount);
+	ISimpleShader::RegisterConstantBufferLayouts(layouts, layoutCount);
+#endif
+
 	// Helper methods for loading shaders, creating some basic
 	// geometry to draw and some simple camera matrices.
 	//  - You'll be expanding and/or replacing these later
@@ -162,92 +188,17 @@ void Game::Init()
 	D3D11_RASTERIZER_DESC rasterDesc = {};
 	rasterDesc.FillMode = D3D11_FILL_SOLID;
 	rasterDesc.CullMode = D3D11_CULL_FRONT;
-	device->CreateRasterizerState(&rasterDesc, &skyBoxRastState);
 
 	D3D11_DEPTH_STENCIL_DESC depthScript = {};
 	depthScript.DepthEnable = true;
 	depthScript.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
 	depthScript.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
-	device->CreateDepthStencilState(&depthScript, &skyBoxDepthState);
-
-
-	//set Post-process effects
-	//Alpha pass
-	D3D11_TEXTURE2D_DESC textureDesc = {};
-	textureDesc.Width = width;
-	textureDesc.Height = height;
-	textureDesc.ArraySize = 1;
-	textureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
-	textureDesc.CPUAccessFlags = 0;
-	textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-	textureDesc.MipLevels = 1;
-	textureDesc.MiscFlags = 0;
-	textureDesc.SampleDesc.Count = 1;
-	textureDesc.SampleDesc.Quality = 0;
-	textureDesc.Usage = D3D11_USAGE_DEFAULT;
-
-	ID3D11Texture2D* ppTexture;
-	device->CreateTexture2D(&textureDesc, 0, &ppTexture);
+	skyBoxState = stateCache->GetRenderState(0, &depthScript, &rasterDesc);
 
-	// Create the Render Target View
-	D3D11_RENDER_TARGET_VIEW_DESC JPrtvDesc = {};
-	JPrtvDesc.Format = textureDesc.Format;
-	JPrtvDesc.Texture2D.MipSlice = 0;
-	JPrtvDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
 
-	device->CreateRenderTargetView(ppTexture, &JPrtvDesc, &alphaPostRTV);
-
-	// Create the Shader Resource View
-	D3D11_SHADER_RESOURCE_VIEW_DESC JPsrvDesc = {};
-	JPsrvDesc.Format = textureDesc.Format;
-	JPsrvDesc.Texture2D.MipLevels = 1;
-	JPsrvDesc.Texture2D.MostDetailedMip = 0;
-	JPsrvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-
-	device->CreateShaderResourceView(ppTexture, &JPsrvDesc, &alphaPostSRV);
-
-	// We don't need the texture reference itself no mo'
-	ppTexture->Release();
-
-
-
-
-	// Refraction setup ------------------------
-	ID3D11Texture2D* refractionRenderTexture;
-	
-	// Set up render texture
-	D3D11_TEXTURE2D_DESC rtDesc = {};
-	rtDesc.Width = width;
-	rtDesc.Height = height;
-	rtDesc.MipLevels = 1;
-	rtDesc.ArraySize = 1;
-	rtDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-	rtDesc.Usage = D3D11_USAGE_DEFAULT;
-	rtDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
-	rtDesc.CPUAccessFlags = 0;
-	rtDesc.MiscFlags = 0;
-	rtDesc.SampleDesc.Count = 1;
-	rtDesc.SampleDesc.Quality = 0;
-	device->CreateTexture2D(&rtDesc, 0, &refractionRenderTexture);
-
-
-	// Set up render target view
-	D3D11_RENDER_TARGET_VIEW_DESC rtvDesc = {};
-	rtvDesc.Format = rtDesc.Format;
-	rtvDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
-	rtvDesc.Texture2D.MipSlice = 0;
-	device->CreateRenderTargetView(refractionRenderTexture, &rtvDesc, &refractionRTV);
-
-	// Set up shader resource view for same texture
-	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-	srvDesc.Format = rtDesc.Format;
-	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-	srvDesc.Texture2D.MipLevels = 1;
-	srvDesc.Texture2D.MostDetailedMip = 0;
-	device->CreateShaderResourceView(refractionRenderTexture, &srvDesc, &refractionSRV);
-
-	// All done with this texture ref
-	refractionRenderTexture->Release();
+	// Off-screen targets are requested each frame at the window's
+	// current size, so there's nothing to create up front
+	renderTargets = new RenderTargetPool(device);
 
 	// Set up a sampler that uses clamp addressing
 	// for use when doing refration - this is useful so 
@@ -262,7 +213,7 @@ void Game::Init()
 	rSamp.MaxLOD = D3D11_FLOAT32_MAX;
 
 	// Ask DirectX for the actual object
-	device->CreateSamplerState(&rSamp, &refractSampler);
+	refractSampler = stateCache->GetSamplerState(rSamp);
 
 
 	//particle setup--------------------------------------------------------
@@ -275,7 +226,6 @@ void Game::Init()
 	pDesc.DepthEnable = true;
 	pDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO; //turns off depth writing
 	pDesc.DepthFunc = D3D11_COMPARISON_LESS;
-	device->CreateDepthStencilState(&pDesc, &particleDepthState);
 
 	//blend for particles
 	D3D11_BLEND_DESC blend = {};
@@ -289,7 +239,7 @@ void Game::Init()
 	blend.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
 	blend.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ONE;
 	blend.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
-	device->CreateBlendState(&blend, &particleBlendState);
+	particleState = stateCache->GetRenderState(&blend, &pDesc, 0);
 
 	D3D11_BLEND_DESC waterBlendDesc = {};
 	waterBlendDesc.AlphaToCoverageEnable = false;
@@ -302,10 +252,11 @@ void Game::Init()
 	waterBlendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
 	waterBlendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ONE;
 	waterBlendDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
-	device->CreateBlendState(&waterBlendDesc, &waterBlendState);
+	waterState = stateCache->GetRenderState(&waterBlendDesc, 0, 0);
 
 	// Set up particles
-	bubbleEmitter = new Emitter(
+	particles = new ParticleSystem(device, particleVS, particlePS);
+	particles->AddEmitter(new Emitter(
 		11,							// Max particles
 		.8f,							// Particles per second
 		20,								// Particle lifetime
@@ -316,12 +267,12 @@ void Game::Init()
 		XMFLOAT3(0, .15f, 0),				// Start velocity
 		XMFLOAT3(4, -2.5f, 0),				// Start position
 		XMFLOAT3(0, .1f, 0),				// Start acceleration
-		device,
-		particleVS,
-		particlePS,
-		bubbleTxt);
+		EMITTER_ANALYTIC,				// Ballistic, so nothing to simulate
+		1),							// Seed
+		bubbleTxt,
+		particleState);
 
-	bubbleEmitter2 = new Emitter(
+	particles->AddEmitter(new Emitter(
 		11,							// Max particles
 		.8f,							// Particles per second
 		20,								// Particle lifetime
@@ -332,12 +283,12 @@ void Game::Init()
 		XMFLOAT3(0, .15f, 0),				// Start velocity
 		XMFLOAT3(-4, -2.5f, 0),				// Start position
 		XMFLOAT3(0, .1f, 0),				// Start acceleration
-		device,
-		particleVS,
-		particlePS,
-		bubbleTxt);
+		EMITTER_ANALYTIC,				// Ballistic, so nothing to simulate
+		2),							// Seed
+		bubbleTxt,
+		particleState);
 
-	heartEmitter = new Emitter(
+	heartEmitter = particles->AddEmitter(new Emitter(
 		5,							// Max particles
 		1.0f,							// Particles per second
 		3,								// Particle lifetime
@@ -348,11 +299,13 @@ void Game::Init()
 		XMFLOAT3(0, .3f, 0),				// Start velocity
 		XMFLOAT3(0, 4.5, 0),				// Start position
 		XMFLOAT3(0, 1.0f, 0),				// Start acceleration
-		device,
-		particleVS,
-		particlePS,
-		heartTxt);
+		EMITTER_ANALYTIC,				// Ballistic, so nothing to simulate
+		3),							// Seed
+		heartTxt,
+		particleState);
 
+	// Three emitters with 27 particles between them never come
+	// near a budget, so it's left at its defaults
 
 	// Tell the input assembler stage of the pipeline what kind of
 	// geometric primitives (points, lines or triangles) we want to draw.  
@@ -373,6 +326,40 @@ void Game::Init()
 	gameEntities.back()->Translate(XMFLOAT3(0, 1200.0f, 0));
 	gameEntities.back()->Scale(XMFLOAT3(500.0f, 1.0f, 500.0f));*/
 
+	// Render passes get recorded on these threads each frame
+	workers = new WorkerPool(WorkerPool::DefaultThreadCount());
+	commandRecorder = new CommandRecorder(device, context, workers);
+
+	// Every scheduled pass starts with its targets bound by BeginPass()
+	renderGraph = new RenderGraphExecutor(commandRecorder, renderTargets);
+	renderGraph->SetBeginPass([this](ID3D11DeviceContext* passContext, ID3D11RenderTargetView* target, ID3D11DepthStencilView* depth) {
+		BeginPass(passContext, target, depth);
+	});
+
+	// 1MB is plenty for a frame's worth of constant data, and three
+	// frames in flight keeps us from ever waiting on the GPU
+	frameUploadBuffer = new FrameUploadBuffer(device, context, 1024 * 1024, 3);
+
+	// How much shader loading the program cache and sidecars saved us
+	SimpleShaderProgramStats programStats = ISimpleShader::GetProgramStats();
+	printf("\nShader loads: %u  created: %u  shared: %u (%llu KB saved)  sidecars read: %u written: %u  %.1f ms",
+		programStats.Loads, programStats.ProgramsCreated, programStats.ProgramsShared,
+		programStats.BytesShared / 1024, programStats.SidecarsLoaded, programStats.SidecarsWritten,
+		programStats.LoadMilliseconds);
+
+	InputLayoutCacheStats layoutStats = InputLayoutCache::GetStats();
+	printf("\nInput layouts created: %u  shared: %u", layoutStats.LayoutsCreated, layoutStats.LayoutsShared);
+	printf("\nPipeline states created: %u", stateCache->GetStateCount());
+
+#ifdef GENERATE_CONSTANT_BUFFERS
+	std::string header = ISimpleShader::GenerateConstantBufferHeader();
+	FILE* headerFile = 0;
+	if (fopen_s(&headerFile, "ConstantBuffers.h", "wb") == 0) {
+		fwrite(header.c_str(), 1, header.size(), headerFile);
+		fclose(headerFile);
+		printf("\nWrote ConstantBuffers.h");
+	}
+#endif
 }
 
 // --------------------------------------------------------
@@ -397,7 +384,7 @@ void Game::LoadShaders()
 	sd.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
 	sd.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
 	sd.MaxLOD = D3D11_FLOAT32_MAX;
-	device->CreateSamplerState(&sd, &sampler);
+	sampler = stateCache->GetSamplerState(sd);
 
 
 	//Material 1
@@ -441,6 +428,9 @@ void Game::LoadShaders()
 	alphaPostPixelShader = new SimplePixelShader(device, context);
 	alphaPostVertexShader->LoadShaderFile(L"BlurVertexShader.cso");
 	alphaPostPixelShader->LoadShaderFile(L"BlurPixelShader.cso");
+	blurConstants = alphaPostPixelShader->GetConstantBufferHandle<BlurPixelShaderData>();
+	blurPixels = alphaPostPixelShader->GetShaderResourceViewHandle(SimpleShaderHash("Pixels"));
+	blurSampler = alphaPostPixelShader->GetSamplerHandle(SimpleShaderHash("Sampler"));
 
 	//particle shader loading
 	particleVS = new SimpleVertexShader(device, context);
@@ -530,12 +520,35 @@ void Game::CreateUIButtons()
 	CreateWICTextureFromFile(device, context, L"../Assets/Textures/feedButton.png", 0, &buttonSRV);
 }
 
-void Game::DrawScene()
+// --------------------------------------------------------
+// Sets up the state every pass needs, since a deferred
+// context starts each pass with nothing bound
+// --------------------------------------------------------
+void Game::BeginPass(ID3D11DeviceContext* passContext, ID3D11RenderTargetView* target, ID3D11DepthStencilView* depth)
 {
-	guy->Draw(context, cam, &dLight1, &dLight2, &pLight1, skyBoxSRV, causticLights);
+	D3D11_VIEWPORT viewport = {};
+	viewport.Width = (float)width;
+	viewport.Height = (float)height;
+	viewport.MinDepth = 0.0f;
+	viewport.MaxDepth = 1.0f;
+	passContext->RSSetViewports(1, &viewport);
+
+	passContext->OMSetRenderTargets(1, &target, depth);
+	passContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	// Every pass currently renders at the window's size
+	PerPassConstants perPass;
+	perPass.TargetSize = XMFLOAT2((float)width, (float)height);
+	perPass.InverseTargetSize = XMFLOAT2(1.0f / width, 1.0f / height);
+	sharedConstants->BeginPass(passContext, perPass);
 }
 
-void Game::DrawSky()
+void Game::DrawScene(ID3D11DeviceContext* passContext)
+{
+	guy->Draw(passContext, cam, &dLight1, &dLight2, &pLight1, skyBoxSRV, causticLights);
+}
+
+void Game::DrawSky(ID3D11DeviceContext* passContext)
 {
 	ID3D11Buffer* skyVB = m4->GetVertexBuffer();
 	ID3D11Buffer* skyIB = m4->GetIndexBuffer();
@@ -543,13 +556,12 @@ void Game::DrawSky()
 	// Set the buffers
 	UINT stride = sizeof(Vertex);
 	UINT offset = 0;
-	context->IASetVertexBuffers(0, 1, &skyVB, &stride, &offset);
-	context->IASetIndexBuffer(skyIB, DXGI_FORMAT_R32_UINT, 0);
+	passContext->IASetVertexBuffers(0, 1, &skyVB, &stride, &offset);
+	passContext->IASetIndexBuffer(skyIB, DXGI_FORMAT_R32_UINT, 0);
 
 	// Set up the sky shaders
-	SkyBoxVertexShader->SetMatrix4x4("view", cam->GetViewMatrix());
-	SkyBoxVertexShader->SetMatrix4x4("projection", cam->GetProjectionMatrix());
-	SkyBoxVertexShader->CopyAllBufferData();
+	SkyBoxVertexShader->SetDeviceContext(passContext);
+	SkyBoxPixelShader->SetDeviceContext(passContext);
 	SkyBoxVertexShader->SetShader();
 
 
@@ -558,50 +570,45 @@ void Game::DrawSky()
 	SkyBoxPixelShader->SetShader();
 
 	// Set up the render state options
-	context->RSSetState(skyBoxRastState);
-	context->OMSetDepthStencilState(skyBoxDepthState, 0);
+	StateCache::Apply(passContext, skyBoxState);
 
 	// Do the actual drawing 
 	int test = m4->GetIndexCount();
-	context->DrawIndexed(test, 0, 0);
+	passContext->DrawIndexed(test, 0, 0);
 
 	// At the end of the frame, reset render states
-	context->RSSetState(0);
-	context->OMSetDepthStencilState(0, 0);
+	StateCache::Apply(passContext, StateCache::GetDefaultState());
 }
 
-void Game::DrawRefraction()
+void Game::DrawRefraction(ID3D11DeviceContext* passContext, ID3D11ShaderResourceView* scenePixels)
 {
 	ID3D11Buffer* vb = refractionEntity->GetMesh()->GetVertexBuffer();
 	ID3D11Buffer* ib = refractionEntity->GetMesh()->GetIndexBuffer();
 
 	UINT stride = sizeof(Vertex);
 	UINT offset = 0;
-	context->IASetVertexBuffers(0, 1, &vb, &stride, &offset);
-	context->IASetIndexBuffer(ib, DXGI_FORMAT_R32_UINT, 0);
+	passContext->IASetVertexBuffers(0, 1, &vb, &stride, &offset);
+	passContext->IASetIndexBuffer(ib, DXGI_FORMAT_R32_UINT, 0);
 
 	// Setup vertex shader
+	refractVS->SetDeviceContext(passContext);
+	refractPS->SetDeviceContext(passContext);
 	refractVS->SetMatrix4x4("world", refractionEntity->GetWorldMatrix());
-	refractVS->SetMatrix4x4("view", cam->GetViewMatrix());
-	refractVS->SetMatrix4x4("projection", cam->GetProjectionMatrix());
 	refractVS->CopyAllBufferData();
 	refractVS->SetShader();
 
 	// Setup pixel shader
-	refractPS->SetShaderResourceView("ScenePixels", refractionSRV);	// Pixels of the screen
+	refractPS->SetShaderResourceView("ScenePixels", scenePixels);	// Pixels of the screen
 	refractPS->SetShaderResourceView("NormalMap", refractionNormalMap);	// Normal map for the object itself
 	refractPS->SetSamplerState("BasicSampler", sampler);			// Sampler for the normal map
 	refractPS->SetSamplerState("RefractSampler", refractSampler);	// Uses CLAMP on the edges
-	refractPS->SetFloat3("CameraPosition", cam->GetPosition());
-	refractPS->SetMatrix4x4("view", cam->GetViewMatrix());				// View matrix, so we can put normals into view space
-	refractPS->CopyAllBufferData();
 	refractPS->SetShader();
 
 	// Finally do the actual drawing
-	context->DrawIndexed(refractionEntity->GetMesh()->GetIndexCount(), 0, 0);
+	passContext->DrawIndexed(refractionEntity->GetMesh()->GetIndexCount(), 0, 0);
 }
 
-void Game::DrawBlurEffect()
+void Game::DrawBlurEffect(ID3D11DeviceContext* passContext, ID3D11ShaderResourceView* scenePixels)
 {
 	//Switch to post Process mode
 	//First Pass
@@ -619,31 +626,29 @@ void Game::DrawBlurEffect()
 		left = -5;
 	}
 
+	alphaPostVertexShader->SetDeviceContext(passContext);
+	alphaPostPixelShader->SetDeviceContext(passContext);
 	alphaPostVertexShader->SetShader();
 	alphaPostPixelShader->SetShader();
-	alphaPostPixelShader->SetShaderResourceView("Pixels", refractionSRV);
-	alphaPostPixelShader->SetSamplerState("Sampler", sampler);
-	alphaPostPixelShader->SetInt("Bleft", left);
-	alphaPostPixelShader->SetInt("Bright", right);
-	alphaPostPixelShader->SetInt("Bup", up);
-	alphaPostPixelShader->SetInt("Bdown", down);
-
-	alphaPostPixelShader->SetFloat("pixelWidth", 1.0f / width);
-	alphaPostPixelShader->SetFloat("pixelHeight", 1.0f / height);
+	alphaPostPixelShader->SetShaderResourceView(blurPixels, scenePixels);
+	alphaPostPixelShader->SetSamplerState(blurSampler, sampler);
+	BlurPixelShaderData blurData = {};
+	blurData.Bleft = left;
+	blurData.Bright = right;
+	blurData.Bup = up;
+	blurData.Bdown = down;
+	alphaPostPixelShader->SetConstantBufferData(blurConstants, blurData);
 	alphaPostPixelShader->CopyAllBufferData();
 
 	// Unbind vert/index buffers
 	UINT stride = sizeof(Vertex);
 	UINT offset = 0;
 	ID3D11Buffer* nothing = 0;
-	context->IASetVertexBuffers(0, 1, &nothing, &stride, &offset);
-	context->IASetIndexBuffer(0, DXGI_FORMAT_R32_UINT, 0);
+	passContext->IASetVertexBuffers(0, 1, &nothing, &stride, &offset);
+	passContext->IASetIndexBuffer(0, DXGI_FORMAT_R32_UINT, 0);
 
 	// Draw a triangle that will hopefully fill the screen
-	context->Draw(3, 0);
-
-	// Unbind this particular register
-	alphaPostPixelShader->SetShaderResourceView("Pixels", 0);
+	passContext->Draw(3, 0);
 }
 
 void Game::DrawFullscreenQuad(ID3D11ShaderResourceView * texture)
@@ -675,6 +680,10 @@ void Game::OnResize()
 
 	cam->UpdateProjectionMatrix(width, height);
 
+	// Old-sized targets are no use now - next frame asks for new ones
+	if (renderTargets)
+		renderTargets->ReleaseAll();
+
 	//feedButton->x = width / 2 - width / 27 - width / 3;
 	//feedButton->width = width / 2 + width / 27 - width / 3;
 	//feedButton->y = height / 2 - height / 16 - height / 3.3;
@@ -722,9 +731,10 @@ void Game::Update(float deltaTime, float totalTime)
 	refractionEntity->Rotate(XMFLOAT3(0, deltaTime * 0.05f, 0));
 	refractionEntity->CalculateWorldMatrix();
 
-	bubbleEmitter->Update(deltaTime);
-	bubbleEmitter2->Update(deltaTime);
-	if (guy->guyState == Happy) { heartEmitter->Update(deltaTime); }
+	// Hearts only while he's happy - off-screen or disabled
+	// emitters sleep, and catch up when they come back
+	particles->SetEnabled(heartEmitter, guy->guyState == Happy);
+	particles->Update(deltaTime, cam, workers);
 }
 
 // --------------------------------------------------------
@@ -739,82 +749,138 @@ void Game::Draw(float deltaTime, float totalTime)
 	//  - Do this ONCE PER FRAME
 	//  - At the beginning of Draw (before drawing *anything*)
 	context->ClearRenderTargetView(backBufferRTV, color);
-	context->ClearRenderTargetView(refractionRTV, color);
-	context->ClearRenderTargetView(alphaPostRTV, color);
 	context->ClearDepthStencilView(
 		depthStencilView,
 		D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL,
 		1.0f,
 		0);
 
-	// Use our refraction render target and our regular depth buffer
-	context->OMSetRenderTargets(1, &refractionRTV, depthStencilView);
-
-	XMFLOAT4 white = XMFLOAT4(1.00, 1.0, 1.0, 1.0);
-
-
+	frameUploadBuffer->BeginFrame();
+
+	// Everything that's the same for every draw this frame goes up once,
+	// before any pass runs (the view matrix also puts the refraction's
+	// normals into view space)
+	PerFrameConstants perFrame;
+	perFrame.View = cam->GetViewMatrix();
+	perFrame.Projection = cam->GetProjectionMatrix();
+	perFrame.CausticView = causticLights->viewMatrix;
+	perFrame.CausticProjection = causticLights->projectionMatrix;
+	perFrame.CameraPosition = cam->GetPosition();
+	perFrame.Time = totalTime;
+	sharedConstants->UpdatePerFrame(context, perFrame);
+
+	// Each pass below declares what it reads and writes, and the graph
+	// drops any pass whose results never reach the back buffer.  The
+	// survivors record into their own contexts (on worker threads when
+	// possible) and the recorder replays them in this order.
+	// Entities these passes draw keep their default (white) color.
+	PixelShaderExternalData lightData = {};
+	lightData.dLight1 = dLight1;
+
+	renderGraph->BeginFrame();
+	int backBuffer = renderGraph->ImportTarget("back buffer", backBufferRTV);
+	int depth = renderGraph->ImportDepth("depth", depthStencilView);
+	renderGraph->MarkOutput(backBuffer);
+
+	// The scene is drawn off-screen first, then blurred and refracted
+	// onto the back buffer.  A pooled target's old contents are
+	// undefined, so the first pass to use it clears it.
+	int sceneColor = renderGraph->CreateTarget("scene color", width, height, DXGI_FORMAT_R8G8B8A8_UNORM);
+
+	int pass = renderGraph->AddPass("clear", [this, sceneColor, color](ID3D11DeviceContext* passContext) {
+		passContext->ClearRenderTargetView(renderGraph->GetRenderTargetView(sceneColor), color);
+	});
+	renderGraph->Write(pass, sceneColor);
 
 	if (debugMode) {
-		for (std::vector<GameEntity*>::iterator it = debugCubes.begin(); it != debugCubes.end(); ++it) {
-			(*it)->GetMaterial()->GetPixelShader()->SetData("dLight1", &dLight1, sizeof(DirectionalLight));
-			(*it)->GetMaterial()->GetVertexShader()->SetData("color", &white, sizeof(XMFLOAT4));
-			(*it)->Draw(context, cam);
-		}
-		for (std::vector<GameEntity*>::iterator it = rayEntities.begin(); it != rayEntities.end(); ++it) {
-			(*it)->GetMaterial()->GetPixelShader()->SetData("dLight1", &dLight1, sizeof(DirectionalLight));
-			(*it)->GetMaterial()->GetVertexShader()->SetData("color", &white, sizeof(XMFLOAT4));
-			(*it)->Draw(context, cam);
-		}
+		pass = renderGraph->AddPass("debug", [this, lightData](ID3D11DeviceContext* passContext) {
+			for (std::vector<GameEntity*>::iterator it = debugCubes.begin(); it != debugCubes.end(); ++it) {
+				(*it)->GetMaterial()->GetPixelShader()->SetConstantBufferData((*it)->GetMaterial()->GetHandles().LightConstants, lightData);
+				(*it)->Draw(passContext, cam);
+			}
+			for (std::vector<GameEntity*>::iterator it = rayEntities.begin(); it != rayEntities.end(); ++it) {
+				(*it)->GetMaterial()->GetPixelShader()->SetConstantBufferData((*it)->GetMaterial()->GetHandles().LightConstants, lightData);
+				(*it)->Draw(passContext, cam);
+			}
+		});
+		renderGraph->Write(pass, sceneColor);
+		renderGraph->Write(pass, depth);
 	}
 
-	// Draw the scene (WITHOUT the refracting object)
-	DrawScene();
-
-	DrawSky();
-
-
-	context->OMSetBlendState(waterBlendState, 0, 0xffffffff);
-	for (std::vector<GameEntity*>::iterator it = gameEntities.begin(); it != gameEntities.end(); ++it) {
-		(*it)->GetMaterial()->GetPixelShader()->SetData("dLight1", &dLight1, sizeof(DirectionalLight));
-		(*it)->GetMaterial()->GetVertexShader()->SetData("color", &white, sizeof(XMFLOAT4));
-		(*it)->Draw(context, cam);
-	}
-	context->OMSetBlendState(0, 0, 0xffffffff);
-	
-	float blend[4] = { 1,1,1,1 };
-	context->OMSetBlendState(particleBlendState, blend, 0xffffffff);
-	context->OMSetDepthStencilState(particleDepthState, 0);
+	// Draw the scene (WITHOUT the refracting object) into our refraction
+	// render target, using our regular depth buffer
+	pass = renderGraph->AddPass("scene", [this](ID3D11DeviceContext* passContext) {
+		DrawScene(passContext);
+	});
+	renderGraph->Write(pass, sceneColor);
+	renderGraph->Write(pass, depth);
+
+	pass = renderGraph->AddPass("sky", [this](ID3D11DeviceContext* passContext) {
+		DrawSky(passContext);
+	});
+	renderGraph->Write(pass, sceneColor);
+	renderGraph->Write(pass, depth);
+
+	pass = renderGraph->AddPass("water", [this, lightData](ID3D11DeviceContext* passContext) {
+		StateCache::Apply(passContext, waterState);
+		for (std::vector<GameEntity*>::iterator it = gameEntities.begin(); it != gameEntities.end(); ++it) {
+			(*it)->GetMaterial()->GetPixelShader()->SetConstantBufferData((*it)->GetMaterial()->GetHandles().LightConstants, lightData);
+			(*it)->Draw(passContext, cam);
+		}
+		StateCache::Apply(passContext, StateCache::GetDefaultState());
+	});
+	renderGraph->Write(pass, sceneColor);
+	renderGraph->Write(pass, depth);
 
-	bubbleEmitter->Draw(context, cam);
-	bubbleEmitter2->Draw(context, cam);
-	if (guy->guyState == Happy) { heartEmitter->Draw(context, cam); }
+	pass = renderGraph->AddPass("particles", [this](ID3D11DeviceContext* passContext) {
+		particles->Draw(passContext, cam);
 
-	// reset to default states
-	context->OMSetBlendState(0, blend, 0xffffffff);
-	context->OMSetDepthStencilState(0, 0);
+		// reset to default states
+		float blend[4] = { 1,1,1,1 };
+		StateCache::Apply(passContext, StateCache::GetDefaultState(), blend);
+	});
+	renderGraph->Write(pass, sceneColor);
+	renderGraph->Write(pass, depth);
 
 	// Back to the screen, but NO depth buffer for now!
 	// We just need to plaster the pixels from the render target onto the 
 	// screen without affecting (or respecting) the existing depth buffer
-	context->OMSetRenderTargets(1, &backBufferRTV, 0);
-
-	// Do blur effect
-	DrawBlurEffect(); // can't use DrawFullscreenQuad() fxn with blur effect D:
+	pass = renderGraph->AddPass("blur", [this, sceneColor](ID3D11DeviceContext* passContext) {
+		DrawBlurEffect(passContext, renderGraph->GetShaderResourceView(sceneColor)); // can't use DrawFullscreenQuad() fxn with blur effect D:
+	});
+	renderGraph->Read(pass, sceneColor);
+	renderGraph->Write(pass, backBuffer);
 
 	// Turn the depth buffer back on, so we can still
 	// used the depths from our earlier scene render
-	context->OMSetRenderTargets(1, &backBufferRTV, depthStencilView);
-
-	// Draw the refraction object
-	DrawRefraction();
-
-	// Unbind all textures at the end of the frame
-	// This is a good idea any time we're using extra render targets
-	// that we intend to sample from on the next frame
-	ID3D11ShaderResourceView* nullSRV[16] = {};
-	context->PSSetShaderResources(0, 16, nullSRV);
-
-	// Draw Feed Button
+	pass = renderGraph->AddPass("refraction", [this, sceneColor](ID3D11DeviceContext* passContext) {
+		DrawRefraction(passContext, renderGraph->GetShaderResourceView(sceneColor));
+	});
+	renderGraph->Read(pass, sceneColor);
+	renderGraph->Write(pass, backBuffer);
+	renderGraph->Write(pass, depth);
+
+	// Culls, sizes the pooled targets to the surviving passes and queues
+	// those passes (the graph unbinds sampled targets after each one)
+	renderGraph->Schedule();
+
+	// Constant data is only written to the GPU once recording is done, so
+	// it's only safe to use when passes aren't drawing immediately (checked
+	// here, after AddPass had its chance to fall back to serial)
+	bool useFrameUpload = frameUploadBuffer->IsSupported() && commandRecorder->IsParallel();
+	ISimpleShader::SetFrameUploadBuffer(useFrameUpload ? frameUploadBuffer : 0);
+
+	// Record everything, send the frame's constant data up in a single
+	// map, and only then let the GPU see the recorded commands
+	commandRecorder->Record();
+	frameUploadBuffer->Upload();
+	commandRecorder->Execute();
+
+	// Executing command lists leaves the immediate context with default
+	// state, and the sprite batch needs our targets and viewport back
+	BeginPass(context, backBufferRTV, depthStencilView);
+
+	// Draw Feed Button (the sprite batch is tied to the immediate context)
 	spriteBatch->Begin();
 	spriteBatch->Draw(buttonSRV, feedButton2);
 	spriteBatch->End();
@@ -829,6 +895,19 @@ void Game::Draw(float deltaTime, float totalTime)
 	//  - Puts the final frame we're drawing into the window so the user can see it
 	//  - Do this exactly ONCE PER FRAME (always at the very end of the frame)
 	swapChain->Present(0, 0);
+
+	// Fence off this frame's slice of the upload buffer
+	frameUploadBuffer->EndFrame();
+
+	// Once a second, show how much constant buffer traffic we avoided
+	if (debugMode && totalTime - uploadStatsTime >= 1.0f)
+	{
+		SimpleShaderUploadStats stats = ISimpleShader::GetUploadStats();
+		printf("\nCB uploads: %llu (%llu bytes)  skipped: %llu (%llu bytes saved)",
+			stats.Uploads, stats.BytesUploaded, stats.UploadsSkipped, stats.BytesSaved);
+		ISimpleShader::ResetUploadStats();
+		uploadStatsTime = totalTime;
+	}
 }
 
 
@@ -12,7 +12,14 @@
 #include "Creature.h"
 //#include "UIButton.h"
 //#include "UIButton.h"
-#include "Emitter.h"
+#include "ParticleSystem.h"
+#include "WorkerPool.h"
+#include "CommandRecorder.h"
+#include "FrameUploadBuffer.h"
+#include "SharedConstants.h"
+#include "StateCache.h"
+#include "RenderTargetPool.h"
+#include "RenderGraphExecutor.h"
 
 class Game 
 	: public DXCore
@@ -44,13 +51,33 @@ private:
 	void TestInteraction(int pMouseX, int pMouseY);
 	void CreateUIButtons();
 
-	// Render helper methods
-	void DrawScene();
-	void DrawSky();
-	void DrawRefraction();
-	void DrawBlurEffect();
+	// Render helper methods - each records into the context of the pass it belongs to
+	void BeginPass(ID3D11DeviceContext* passContext, ID3D11RenderTargetView* target, ID3D11DepthStencilView* depth);
+	void DrawScene(ID3D11DeviceContext* passContext);
+	void DrawSky(ID3D11DeviceContext* passContext);
+	void DrawRefraction(ID3D11DeviceContext* passContext, ID3D11ShaderResourceView* scenePixels);
+	void DrawBlurEffect(ID3D11DeviceContext* passContext, ID3D11ShaderResourceView* scenePixels);
 	void DrawFullscreenQuad(ID3D11ShaderResourceView* texture);
 
+	// Multithreaded pass recording
+	WorkerPool* workers;
+	CommandRecorder* commandRecorder;
+
+	// Per-frame constant data for every shader, uploaded in one go
+	FrameUploadBuffer* frameUploadBuffer;
+
+	// Camera, time, etc. that every shader reads from fixed registers
+	SharedConstants* sharedConstants;
+
+	// Owns every blend/depth/raster/sampler state below
+	StateCache* stateCache;
+
+	// Off-screen targets, handed out (and shared) per frame
+	RenderTargetPool* renderTargets;
+
+	// Each frame's passes, culled and scheduled onto the recorder
+	RenderGraphExecutor* renderGraph;
+
 	// Wrappers for DirectX shaders to provide simplified functionality
 	SimpleVertexShader* vertexShader;
 	SimpleVertexShader* SkyBoxVertexShader;
@@ -58,15 +85,15 @@ private:
 	//Skybox Stuff
 	SimplePixelShader* pixelShader;
 	SimplePixelShader* SkyBoxPixelShader;
-	ID3D11RasterizerState* skyBoxRastState;
-	ID3D11DepthStencilState* skyBoxDepthState;
+	RenderState skyBoxState;
 	ID3D11ShaderResourceView* skyBoxSRV;
 
 	//Post-Process stuff
-	ID3D11RenderTargetView* alphaPostRTV;		// Allows us to render to a texture
-	ID3D11ShaderResourceView* alphaPostSRV;	// Allows us to sample from the same texture
 	SimpleVertexShader* alphaPostVertexShader;
 	SimplePixelShader* alphaPostPixelShader;
+	int blurConstants;		// BlurPixelShaderData's buffer, resolved once in LoadShaders()
+	int blurPixels;			// "Pixels" and "Sampler", also resolved there
+	int blurSampler;
 
 	// The matrices to go from model space to screen space
 	DirectX::XMFLOAT4X4 worldMatrix;
@@ -122,11 +149,10 @@ private:
 	ID3D11ShaderResourceView* buttonSRV;
 
 	bool debugMode = false;
+	float uploadStatsTime = 0.0f;
 
 	// Refraction-related variables
 	ID3D11SamplerState* refractSampler;
-	ID3D11RenderTargetView* refractionRTV;
-	ID3D11ShaderResourceView* refractionSRV;
 	SimpleVertexShader* refractVS;
 	SimplePixelShader* refractPS;
 	SimpleVertexShader* quadVS;
@@ -139,15 +165,13 @@ private:
 	//bubble particle stuff
 	ID3D11ShaderResourceView* bubbleTxt;
 	ID3D11ShaderResourceView* heartTxt;
-	Emitter* bubbleEmitter;
-	Emitter* bubbleEmitter2;
-	Emitter* heartEmitter;
+	ParticleSystem* particles;
+	int heartEmitter;
 	SimpleVertexShader* particleVS;
 	SimplePixelShader* particlePS;
-	ID3D11DepthStencilState* particleDepthState;
-	ID3D11BlendState* particleBlendState;
+	RenderState particleState;
 
-	ID3D11BlendState* waterBlendState;
+	RenderState waterState;
 	ID3D11ShaderResourceView* waterNormalMap;
 };
 
@@ -1,4 +1,5 @@
 #include "GameEntity.h"
+#include "ConstantBuffers.h"
 
 
 using namespace DirectX;
@@ -11,6 +12,7 @@ GameEntity::GameEntity(Mesh* pMeshPointer, Material* pMaterial, std::string pNam
 	rotation = XMFLOAT3(0, 0, 0);
 	scale = XMFLOAT3(1, 1, 1);
 	forward = XMFLOAT3(0, 0, -1);
+	color = XMFLOAT4(1, 1, 1, 1);
 
 	box = new BoundingBox();
 	box->Center = position;
@@ -56,6 +58,10 @@ BoundingBox* GameEntity::GetBoundingBox() {
 	return box;
 }
 
+XMFLOAT4 GameEntity::GetColor() {
+	return color;
+}
+
 std::string GameEntity::GetName() {
 	return name;
 }
@@ -143,6 +149,10 @@ void GameEntity::SetScale(XMFLOAT3 pScale) {
 	scale = pScale;
 }
 
+void GameEntity::SetColor(XMFLOAT4 pColor) {
+	color = pColor;
+}
+
 //Adds the given XMFLOAT3 to the current position
 void GameEntity::Translate(XMFLOAT3 pTranslate) {
 	XMVECTOR newPosition = XMVectorAdd(XMLoadFloat3(&position), XMLoadFloat3(&pTranslate));
@@ -199,7 +209,9 @@ void GameEntity::Draw(ID3D11DeviceContext* pContext, Camera* pCam) {
 	pContext->IASetVertexBuffers(0, 1, &vb, &stride, &offset);
 	pContext->IASetIndexBuffer(meshPointer->GetIndexBuffer(), DXGI_FORMAT_R32_UINT, 0);
 
-	PrepareMaterial(pCam->GetViewMatrix(), pCam->GetProjectionMatrix(), pCam->GetPosition());
+	// Make sure the material's shaders record into the same context we're drawing with
+	material->SetDeviceContext(pContext);
+	PrepareMaterial();
 
 	// Finally do the actual drawing
 	//  - DrawIndexed() uses the currently set INDEX BUFFER to look up corresponding
@@ -210,24 +222,31 @@ void GameEntity::Draw(ID3D11DeviceContext* pContext, Camera* pCam) {
 		0);    // Offset to add to each index when looking up vertices
 }
 
-void GameEntity::PrepareMaterial(XMFLOAT4X4 pView, XMFLOAT4X4 pProjection, XMFLOAT3 pCamPosition) {
+void GameEntity::PrepareMaterial() {
 
 	// Send data to shader variables
 	//  - Do this ONCE PER OBJECT you're drawing
 	//  - This is actually a complex process of copying data to a local buffer
 	//    and then copying that entire buffer to the GPU.  
 	//  - The "SimpleShader" class handles all of that for you.
-	material->GetVertexShader()->SetMatrix4x4("world", worldMatrix);
-	material->GetVertexShader()->SetMatrix4x4("view", pView);
-	material->GetVertexShader()->SetMatrix4x4("projection", pProjection);
-	material->GetVertexShader()->SetFloat("time", globalTotalTime);
+	//  - Handles are resolved once per material, so there are no string lookups here
+	//  - Camera and time live in the shared per-frame buffer, so only per-object data is set here
+	const MaterialHandles& handles = material->GetHandles();
+	if (handles.EntityConstants != ISimpleShader::InvalidHandle) {
+		// The whole buffer in one write, laid out by the generated struct
+		VertexShaderExternalData entityData;
+		entityData.world = worldMatrix;
+		entityData.color = color;
+		material->GetVertexShader()->SetConstantBufferData(handles.EntityConstants, entityData);
+	}
+	else {
+		material->GetVertexShader()->SetMatrix4x4(handles.WorldMatrix, worldMatrix);
+	}
 	material->GetVertexShader()->CopyAllBufferData();
 
-	material->GetPixelShader()->SetFloat3("CameraPosition", pCamPosition);
-	material->GetPixelShader()->SetFloat("time", globalTotalTime);
-	material->GetPixelShader()->SetSamplerState("Sampler", material->GetSampler());
-	material->GetPixelShader()->SetShaderResourceView("DiffuseTexture", material->GetTexture());
-	material->GetPixelShader()->SetShaderResourceView("NormalTexture", material->GetNormal());
+	material->GetPixelShader()->SetSamplerState(handles.Sampler, material->GetSampler());
+	material->GetPixelShader()->SetShaderResourceView(handles.DiffuseTexture, material->GetTexture());
+	material->GetPixelShader()->SetShaderResourceView(handles.NormalTexture, material->GetNormal());
 	material->GetPixelShader()->CopyAllBufferData();
 
 
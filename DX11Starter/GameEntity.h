@@ -18,11 +18,13 @@ public:
 	DirectX::XMFLOAT3 GetRotation();
 	DirectX::XMFLOAT3 GetScale();
 	DirectX::BoundingBox* GetBoundingBox();	
+	DirectX::XMFLOAT4 GetColor();
 
 	void SetWorldMatrix(DirectX::XMFLOAT4X4 pWorldMatrix);
 	void SetPosition(DirectX::XMFLOAT3 pPosition);
 	void SetRotation(DirectX::XMFLOAT3 pRotation);
 	void SetScale(DirectX::XMFLOAT3 pScale);
+	void SetColor(DirectX::XMFLOAT4 pColor);
 
 	void Translate(DirectX::XMFLOAT3 pTranslate);
 	void Rotate(DirectX::XMFLOAT3 pRotate);
@@ -34,7 +36,7 @@ public:
 
 	void CalculateWorldMatrix();
 	void Draw(ID3D11DeviceContext* pContext, Camera* pCam);
-	void PrepareMaterial(DirectX::XMFLOAT4X4 pView, DirectX::XMFLOAT4X4 pProjection, DirectX::XMFLOAT3 pCamPosition);
+	void PrepareMaterial();
 private:
 	Mesh* meshPointer;
 	Material* material;
@@ -43,6 +45,7 @@ private:
 	DirectX::XMFLOAT3 rotation;
 	DirectX::XMFLOAT3 scale;
 	DirectX::XMFLOAT3 forward;
+	DirectX::XMFLOAT4 color;	// Tint sent with the world matrix
 	DirectX::BoundingBox* box;
 	std::string name;
 	void RecalculateBox();
@@ -0,0 +1,64 @@
+#include "InputLayoutCache.h"
+
+InputLayoutTable<ID3D11InputLayout*> InputLayoutCache::layouts;
+InputLayoutCacheStats InputLayoutCache::stats = {};
+
+// --------------------------------------------------------
+// Finds or creates the layout for these elements.  Shaders
+// with identical elements have identical input signatures,
+// so a layout made against one shader's code works for all
+// of them.
+// --------------------------------------------------------
+ID3D11InputLayout* InputLayoutCache::GetInputLayout(
+	ID3D11Device* device,
+	const InputElement* elements,
+	unsigned int count,
+	const void* shaderCode,
+	size_t shaderCodeSize)
+{
+	unsigned long long hash = InputSignature::Hash(elements, count);
+
+	// Already have it?
+	ID3D11InputLayout* layout = layouts.Find(device, hash, elements, count);
+	if (layout)
+	{
+		stats.LayoutsShared++;
+		layout->AddRef();
+		return layout;
+	}
+
+	// Nope, make it (the neutral formats and slot classes
+	// have the same values as D3D's)
+	std::vector<D3D11_INPUT_ELEMENT_DESC> descs(count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		descs[i].SemanticName = elements[i].SemanticName;
+		descs[i].SemanticIndex = elements[i].SemanticIndex;
+		descs[i].Format = (DXGI_FORMAT)elements[i].Format;
+		descs[i].InputSlot = elements[i].InputSlot;
+		descs[i].AlignedByteOffset = elements[i].AlignedByteOffset;
+		descs[i].InputSlotClass = elements[i].PerInstance ? D3D11_INPUT_PER_INSTANCE_DATA : D3D11_INPUT_PER_VERTEX_DATA;
+		descs[i].InstanceDataStepRate = elements[i].InstanceDataStepRate;
+	}
+
+	if (device->CreateInputLayout(&descs[0], count, shaderCode, shaderCodeSize, &layout) != S_OK)
+		return 0;
+
+	layouts.Add(device, hash, elements, count, layout);
+	stats.LayoutsCreated++;
+
+	// One reference for the cache, one for the caller
+	layout->AddRef();
+	return layout;
+}
+
+// --------------------------------------------------------
+// Lets go of every cached layout
+// --------------------------------------------------------
+void InputLayoutCache::Clear()
+{
+	for (unsigned int i = 0; i < layouts.GetCount(); i++)
+		layouts.GetLayout(i)->Release();
+
+	layouts.Clear();
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <d3d11.h>
+#include "InputSignature.h"
+
+// --------------------------------------------------------
+// Totals for the input layout cache
+// --------------------------------------------------------
+struct InputLayoutCacheStats
+{
+	unsigned int LayoutsCreated;	// CreateInputLayout calls
+	unsigned int LayoutsShared;		// Requests answered from the cache
+};
+
+// --------------------------------------------------------
+// One shared input layout per distinct element description.
+//
+// Most vertex shaders take the same Vertex struct, so they
+// all end up with the same layout object - which also means
+// two layouts can be compared by pointer.
+//
+// The lookup itself (hash, then full compare) is the
+// API-neutral InputLayoutTable; this just creates layouts on
+// a miss.  The cache keeps a reference to every layout until
+// Clear() is called.
+// --------------------------------------------------------
+class InputLayoutCache
+{
+public:
+	// Returns a layout for these elements (with a reference for
+	// the caller), creating it against the given shader code if
+	// it isn't cached yet.  Returns null if creation fails.
+	static ID3D11InputLayout* GetInputLayout(
+		ID3D11Device* device,
+		const InputElement* elements,
+		unsigned int count,
+		const void* shaderCode,
+		size_t shaderCodeSize);
+
+	// Releases the cache's references (call at shutdown)
+	static void Clear();
+
+	static InputLayoutCacheStats GetStats() { return stats; }
+
+private:
+	static InputLayoutTable<ID3D11InputLayout*> layouts;
+	static InputLayoutCacheStats stats;
+};
@@ -0,0 +1,152 @@
+#include "InputSignature.h"
+#include <cstring>
+
+// --------------------------------------------------------
+// Turns a vertex shader's input signature into the elements
+// of a matching input layout.  Adapted from:
+// https://takinginitiative.wordpress.com/2011/12/11/directx-1011-basic-shader-reflection-automatic-input-layout-creation/
+// --------------------------------------------------------
+bool InputSignature::BuildElements(
+	const std::vector<SignatureParameter>& parameters,
+	std::vector<InputElement>* elements)
+{
+	bool anyPerInstance = false;
+	elements->clear();
+
+	for (unsigned int i = 0; i < parameters.size(); i++)
+	{
+		const SignatureParameter& param = parameters[i];
+
+		// System values (like SV_VertexID) come from the input
+		// assembler itself, not from a vertex buffer
+		if (param.SystemValue)
+			continue;
+
+		// Check the semantic name for "_PER_INSTANCE"
+		std::string perInstanceStr = "_PER_INSTANCE";
+		std::string sem = param.SemanticName;
+		int lenDiff = (int)sem.size() - (int)perInstanceStr.size();
+		bool isPerInstance =
+			lenDiff >= 0 &&
+			sem.compare(lenDiff, perInstanceStr.size(), perInstanceStr) == 0;
+
+		// Fill out input element
+		InputElement element;
+		element.SemanticName = param.SemanticName;
+		element.SemanticIndex = param.SemanticIndex;
+		element.Format = GetElementFormat(param);
+		element.InputSlot = 0;
+		element.AlignedByteOffset = InputAppendAligned;
+		element.PerInstance = false;
+		element.InstanceDataStepRate = 0;
+
+		// Replace anything affected by "per instance" data
+		if (isPerInstance)
+		{
+			element.InputSlot = 1; // Assume per instance data comes from another input slot!
+			element.PerInstance = true;
+			element.InstanceDataStepRate = 1;
+
+			anyPerInstance = true;
+		}
+
+		// Save element
+		elements->push_back(element);
+	}
+
+	return anyPerInstance;
+}
+
+// --------------------------------------------------------
+// Component count comes from the mask, type from the
+// component type
+// --------------------------------------------------------
+InputElementFormat InputSignature::GetElementFormat(const SignatureParameter& param)
+{
+	if (param.Mask == 1)
+	{
+		if (param.ComponentType == SIGNATURE_COMPONENT_UINT32) return INPUT_FORMAT_R32_UINT;
+		else if (param.ComponentType == SIGNATURE_COMPONENT_SINT32) return INPUT_FORMAT_R32_SINT;
+		else if (param.ComponentType == SIGNATURE_COMPONENT_FLOAT32) return INPUT_FORMAT_R32_FLOAT;
+	}
+	else if (param.Mask <= 3)
+	{
+		if (param.ComponentType == SIGNATURE_COMPONENT_UINT32) return INPUT_FORMAT_R32G32_UINT;
+		else if (param.ComponentType == SIGNATURE_COMPONENT_SINT32) return INPUT_FORMAT_R32G32_SINT;
+		else if (param.ComponentType == SIGNATURE_COMPONENT_FLOAT32) return INPUT_FORMAT_R32G32_FLOAT;
+	}
+	else if (param.Mask <= 7)
+	{
+		if (param.ComponentType == SIGNATURE_COMPONENT_UINT32) return INPUT_FORMAT_R32G32B32_UINT;
+		else if (param.ComponentType == SIGNATURE_COMPONENT_SINT32) return INPUT_FORMAT_R32G32B32_SINT;
+		else if (param.ComponentType == SIGNATURE_COMPONENT_FLOAT32) return INPUT_FORMAT_R32G32B32_FLOAT;
+	}
+	else if (param.Mask <= 15)
+	{
+		if (param.ComponentType == SIGNATURE_COMPONENT_UINT32) return INPUT_FORMAT_R32G32B32A32_UINT;
+		else if (param.ComponentType == SIGNATURE_COMPONENT_SINT32) return INPUT_FORMAT_R32G32B32A32_SINT;
+		else if (param.ComponentType == SIGNATURE_COMPONENT_FLOAT32) return INPUT_FORMAT_R32G32B32A32_FLOAT;
+	}
+
+	return INPUT_FORMAT_UNKNOWN;
+}
+
+// --------------------------------------------------------
+// 64 bit FNV-1a over each element's fields and semantic name
+// --------------------------------------------------------
+static void HashBytes(unsigned long long* hash, const void* data, size_t size)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; i++)
+	{
+		*hash ^= bytes[i];
+		*hash *= 1099511628211ull;
+	}
+}
+
+unsigned long long InputSignature::Hash(const InputElement* elements, unsigned int count)
+{
+	unsigned long long hash = 14695981039346656037ull;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const InputElement& e = elements[i];
+		unsigned int format = e.Format;
+		unsigned int perInstance = e.PerInstance ? 1 : 0;
+		HashBytes(&hash, e.SemanticName, strlen(e.SemanticName) + 1);
+		HashBytes(&hash, &e.SemanticIndex, sizeof(e.SemanticIndex));
+		HashBytes(&hash, &format, sizeof(format));
+		HashBytes(&hash, &e.InputSlot, sizeof(e.InputSlot));
+		HashBytes(&hash, &e.AlignedByteOffset, sizeof(e.AlignedByteOffset));
+		HashBytes(&hash, &perInstance, sizeof(perInstance));
+		HashBytes(&hash, &e.InstanceDataStepRate, sizeof(e.InstanceDataStepRate));
+	}
+	return hash;
+}
+
+// --------------------------------------------------------
+// Compares names by content and every other field exactly
+// --------------------------------------------------------
+bool InputSignature::Matches(
+	const std::vector<InputElement>& elements,
+	const std::vector<std::string>& names,
+	const InputElement* other,
+	unsigned int count)
+{
+	if (elements.size() != count)
+		return false;
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const InputElement& a = elements[i];
+		const InputElement& b = other[i];
+		if (names[i] != b.SemanticName ||
+			a.SemanticIndex != b.SemanticIndex ||
+			a.Format != b.Format ||
+			a.InputSlot != b.InputSlot ||
+			a.AlignedByteOffset != b.AlignedByteOffset ||
+			a.PerInstance != b.PerInstance ||
+			a.InstanceDataStepRate != b.InstanceDataStepRate)
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,169 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// --------------------------------------------------------
+// Register component types a signature parameter can have.
+// The values match D3D_REGISTER_COMPONENT_TYPE, so a
+// reflected parameter's type can be cast straight across.
+// --------------------------------------------------------
+enum SignatureComponentType
+{
+	SIGNATURE_COMPONENT_UNKNOWN = 0,
+	SIGNATURE_COMPONENT_UINT32 = 1,
+	SIGNATURE_COMPONENT_SINT32 = 2,
+	SIGNATURE_COMPONENT_FLOAT32 = 3
+};
+
+// --------------------------------------------------------
+// The formats an input element can end up with.  The
+// values match DXGI_FORMAT.
+// --------------------------------------------------------
+enum InputElementFormat
+{
+	INPUT_FORMAT_UNKNOWN = 0,
+	INPUT_FORMAT_R32G32B32A32_FLOAT = 2,
+	INPUT_FORMAT_R32G32B32A32_UINT = 3,
+	INPUT_FORMAT_R32G32B32A32_SINT = 4,
+	INPUT_FORMAT_R32G32B32_FLOAT = 6,
+	INPUT_FORMAT_R32G32B32_UINT = 7,
+	INPUT_FORMAT_R32G32B32_SINT = 8,
+	INPUT_FORMAT_R32G32_FLOAT = 16,
+	INPUT_FORMAT_R32G32_UINT = 17,
+	INPUT_FORMAT_R32G32_SINT = 18,
+	INPUT_FORMAT_R32_FLOAT = 41,
+	INPUT_FORMAT_R32_UINT = 42,
+	INPUT_FORMAT_R32_SINT = 43
+};
+
+// Same value as D3D11_APPEND_ALIGNED_ELEMENT
+static const unsigned int InputAppendAligned = 0xffffffff;
+
+// --------------------------------------------------------
+// One parameter of a vertex shader's input signature - the
+// parts of a reflected parameter desc that decide its
+// input element
+// --------------------------------------------------------
+struct SignatureParameter
+{
+	const char* SemanticName;
+	unsigned int SemanticIndex;
+	unsigned int Mask;						// One bit per component used (x = 1, y = 2, ...)
+	SignatureComponentType ComponentType;
+	bool SystemValue;						// SV_VertexID and such
+};
+
+// --------------------------------------------------------
+// One element of an input layout, field for field the same
+// as a D3D11_INPUT_ELEMENT_DESC
+// --------------------------------------------------------
+struct InputElement
+{
+	const char* SemanticName;
+	unsigned int SemanticIndex;
+	InputElementFormat Format;
+	unsigned int InputSlot;
+	unsigned int AlignedByteOffset;
+	bool PerInstance;
+	unsigned int InstanceDataStepRate;
+};
+
+// --------------------------------------------------------
+// Turns input signatures into input elements, and hashes
+// and compares element arrays for the layout cache
+// --------------------------------------------------------
+class InputSignature
+{
+public:
+	// Builds input elements from a vertex shader's input
+	// signature.  Semantics ending in "_PER_INSTANCE" come from
+	// slot 1, per instance; system values are skipped and
+	// everything else comes from slot 0.  The elements point
+	// at the parameters' semantic name strings.
+	//
+	// Returns true if any element is per instance.
+	static bool BuildElements(
+		const std::vector<SignatureParameter>& parameters,
+		std::vector<InputElement>* elements);
+
+	// Picks the format for a signature parameter
+	static InputElementFormat GetElementFormat(const SignatureParameter& parameter);
+
+	// Hash of an element array (including semantic name text)
+	static unsigned long long Hash(const InputElement* elements, unsigned int count);
+
+	// Full comparison of two element arrays.  The first one's
+	// semantic names are in names, not its elements.
+	static bool Matches(
+		const std::vector<InputElement>& elements,
+		const std::vector<std::string>& names,
+		const InputElement* other,
+		unsigned int count);
+};
+
+// --------------------------------------------------------
+// Input layouts by device and element array.
+//
+// Entries are found by a hash of their elements and then
+// compared in full, so two arrays that share a hash still
+// get their own layouts.  The table keeps its own copies of
+// the semantic names.  Layout is whatever the API calls an
+// input layout; the table doesn't own it.
+// --------------------------------------------------------
+template<typename Layout>
+class InputLayoutTable
+{
+public:
+	// The layout stored for exactly these elements on this
+	// device, or a default Layout if there isn't one
+	Layout Find(const void* device, unsigned long long hash, const InputElement* elements, unsigned int count) const
+	{
+		typedef typename std::unordered_multimap<unsigned long long, unsigned int>::const_iterator Iterator;
+		std::pair<Iterator, Iterator> range = hashes.equal_range(hash);
+		for (Iterator it = range.first; it != range.second; ++it)
+		{
+			const Entry& entry = entries[it->second];
+			if (entry.Device == device && InputSignature::Matches(entry.Elements, entry.Names, elements, count))
+				return entry.Value;
+		}
+		return Layout();
+	}
+
+	void Add(const void* device, unsigned long long hash, const InputElement* elements, unsigned int count, Layout layout)
+	{
+		Entry entry;
+		entry.Device = device;
+		entry.Value = layout;
+		entry.Elements.assign(elements, elements + count);
+		for (unsigned int i = 0; i < count; i++)
+		{
+			entry.Names.push_back(elements[i].SemanticName);
+			entry.Elements[i].SemanticName = 0;
+		}
+
+		hashes.insert(std::pair<unsigned long long, unsigned int>(hash, (unsigned int)entries.size()));
+		entries.push_back(entry);
+	}
+
+	unsigned int GetCount() const { return (unsigned int)entries.size(); }
+	Layout GetLayout(unsigned int index) const { return entries[index].Value; }
+
+	void Clear()
+	{
+		entries.clear();
+		hashes.clear();
+	}
+
+private:
+	struct Entry
+	{
+		const void* Device;
+		std::vector<InputElement> Elements;	// SemanticName is null - see Names
+		std::vector<std::string> Names;
+		Layout Value;
+	};
+
+	std::vector<Entry> entries;
+	std::unordered_multimap<unsigned long long, unsigned int> hashes;
+};
@@ -1,4 +1,5 @@
 #include "Material.h"
+#include "ConstantBuffers.h"
 
 
 
@@ -9,7 +10,7 @@ Material::Material(SimpleVertexShader* pVertexShader, SimplePixelShader* pPixelS
 	texture = pTexture;
 	normal = pNormal;
 	sampler = pSampler;
-
+	handlesResolved = false;
 }
 
 
@@ -41,4 +42,31 @@ ID3D11ShaderResourceView* Material::GetNormal() {
 
 ID3D11SamplerState* Material::GetSampler() {
 	return sampler;
+}
+
+//Points both shaders at the context the current pass is recording into
+void Material::SetDeviceContext(ID3D11DeviceContext* context) {
+	vertexShader->SetDeviceContext(context);
+	pixelShader->SetDeviceContext(context);
+}
+
+//Resolves every handle once, so drawing never has to look anything up by name
+const MaterialHandles& Material::GetHandles() {
+	if (!handlesResolved) {
+		handles.WorldMatrix = vertexShader->GetVariableHandle(SimpleShaderHash("world"));
+		handles.Color = vertexShader->GetVariableHandle(SimpleShaderHash("color"));
+		handles.EntityConstants = vertexShader->GetConstantBufferHandle<VertexShaderExternalData>();
+
+		handles.DirectionalLight1 = pixelShader->GetVariableHandle(SimpleShaderHash("dLight1"));
+		handles.LightConstants = pixelShader->GetConstantBufferHandle<PixelShaderExternalData>();
+		handles.Sampler = pixelShader->GetSamplerHandle(SimpleShaderHash("Sampler"));
+		handles.DiffuseTexture = pixelShader->GetShaderResourceViewHandle(SimpleShaderHash("DiffuseTexture"));
+		handles.NormalTexture = pixelShader->GetShaderResourceViewHandle(SimpleShaderHash("NormalTexture"));
+		handles.AlphaTexture = pixelShader->GetShaderResourceViewHandle(SimpleShaderHash("AlphaTexture"));
+		handles.SkyTexture = pixelShader->GetShaderResourceViewHandle(SimpleShaderHash("SkyTexture"));
+		handles.ProjectionTexture = pixelShader->GetShaderResourceViewHandle(SimpleShaderHash("ProjectionTexture"));
+
+		handlesResolved = true;
+	}
+	return handles;
 }
\ No newline at end of file
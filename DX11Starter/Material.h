@@ -1,5 +1,27 @@
 #pragma once
 #include "SimpleShader.h"
+
+//Handles for the shader variables and resources set on every draw
+//(InvalidHandle if the material's shaders don't use that name)
+struct MaterialHandles
+{
+	//vertex shader
+	int WorldMatrix;
+	int Color;
+	int EntityConstants;	// Whole buffer, as a VertexShaderExternalData
+
+
+	//pixel shader
+	int DirectionalLight1;
+	int LightConstants;		// Whole buffer, as a PixelShaderExternalData
+	int Sampler;
+	int DiffuseTexture;
+	int NormalTexture;
+	int AlphaTexture;
+	int SkyTexture;
+	int ProjectionTexture;
+};
+
 class Material
 {
 public:
@@ -12,11 +34,19 @@ public:
 	ID3D11ShaderResourceView* GetNormal();
 	ID3D11SamplerState* GetSampler();
 
+	void SetDeviceContext(ID3D11DeviceContext* context);
+
+	//Looked up the first time they're needed (the shaders are loaded after the material is made)
+	const MaterialHandles& GetHandles();
+
 private:
 	SimpleVertexShader * vertexShader;
 	SimplePixelShader* pixelShader;
 	ID3D11ShaderResourceView* texture;
 	ID3D11ShaderResourceView* normal;
 	ID3D11SamplerState* sampler;
+
+	MaterialHandles handles;
+	bool handlesResolved;
 };
 
@@ -0,0 +1,85 @@
+#include "ParticleBatcher.h"
+
+ParticleBatcher::ParticleBatcher()
+{
+	capacity = 0;
+}
+
+// --------------------------------------------------------
+// Inserts after every emitter of the same or an earlier
+// group, so emitters within a group keep the order they
+// were added in
+// --------------------------------------------------------
+int ParticleBatcher::Add(Emitter* emitter, unsigned int group)
+{
+	unsigned int position = (unsigned int)entries.size();
+	while (position > 0 && entries[position - 1].Group > group)
+		position--;
+
+	Entry entry;
+	entry.Source = emitter;
+	entry.Group = group;
+	entry.Handle = (int)handleEntries.size();
+	entry.Enabled = true;
+	entries.insert(entries.begin() + position, entry);
+
+	// Everything after it moved up one
+	handleEntries.push_back(0);
+	for (unsigned int e = position; e < entries.size(); e++)
+		handleEntries[entries[e].Handle] = (int)e;
+
+	capacity += (unsigned int)emitter->GetMaxParticles();
+	return entry.Handle;
+}
+
+void ParticleBatcher::SetEnabled(int handle, bool enabled)
+{
+	if (handle >= 0 && handle < (int)handleEntries.size())
+		entries[handleEntries[handle]].Enabled = enabled;
+}
+
+bool ParticleBatcher::IsEnabled(int handle)
+{
+	return handle >= 0 && handle < (int)handleEntries.size() && entries[handleEntries[handle]].Enabled;
+}
+
+Emitter* ParticleBatcher::GetEmitter(int handle)
+{
+	return (handle < 0 || handle >= (int)handleEntries.size()) ? 0 : entries[handleEntries[handle]].Source;
+}
+
+unsigned int ParticleBatcher::Pack(ParticleInstance* instances)
+{
+	batches.clear();
+
+	unsigned int total = 0;
+	for (unsigned int e = 0; e < entries.size(); e++)
+	{
+		const Entry& entry = entries[e];
+		if (!entry.Enabled)
+			continue;
+
+		unsigned int written = (unsigned int)entry.Source->WriteParticles(instances + total);
+		if (written == 0)
+			continue;
+
+		// Same group as the run we're in (and contiguous, since
+		// nothing else was written in between)?  Extend it.
+		if (!batches.empty() && batches.back().Group == entry.Group)
+		{
+			batches.back().Count += written;
+		}
+		else
+		{
+			ParticleBatch batch;
+			batch.Group = entry.Group;
+			batch.Start = total;
+			batch.Count = written;
+			batches.push_back(batch);
+		}
+
+		total += written;
+	}
+
+	return total;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <vector>
+#include "Emitter.h"
+
+// --------------------------------------------------------
+// A run of packed particles that all draw together
+// --------------------------------------------------------
+struct ParticleBatch
+{
+	unsigned int Group;		// Whatever the caller uses to tell draws apart
+	unsigned int Start;		// First instance in the packed buffer
+	unsigned int Count;
+};
+
+// --------------------------------------------------------
+// Packs the living particles of many emitters into one
+// buffer, so that emitters drawn the same way end up next
+// to each other.
+//
+// Each emitter is added with a group number - emitters that
+// share a group (same texture and states, say) can be drawn
+// with one call.  Emitters are kept sorted by group as
+// they're added, so Pack() is a single walk over them that
+// writes each one's particles and starts a new batch
+// whenever the group changes.  Groups with nothing alive
+// produce no batch.
+//
+// Doesn't own the emitters, and nothing here touches D3D.
+// --------------------------------------------------------
+class ParticleBatcher
+{
+public:
+	ParticleBatcher();
+
+	// Returns a handle for the emitter
+	int Add(Emitter* emitter, unsigned int group);
+
+	// Disabled emitters are skipped when packing
+	void SetEnabled(int handle, bool enabled);
+	bool IsEnabled(int handle);
+
+	// Writes every enabled emitter's particles to instances,
+	// which must hold GetCapacity() of them, and returns how
+	// many were written
+	unsigned int Pack(ParticleInstance* instances);
+
+	// From the last Pack(), in buffer order
+	const std::vector<ParticleBatch>& GetBatches() { return batches; }
+
+	// Most particles a Pack() can write (every emitter full)
+	unsigned int GetCapacity() { return capacity; }
+
+	unsigned int GetEmitterCount() { return (unsigned int)entries.size(); }
+	Emitter* GetEmitter(int handle);
+
+private:
+	struct Entry
+	{
+		Emitter* Source;
+		unsigned int Group;
+		int Handle;
+		bool Enabled;
+	};
+
+	std::vector<Entry> entries;		// Sorted by group
+	std::vector<int> handleEntries;	// Entry index of each handle
+	std::vector<ParticleBatch> batches;
+	unsigned int capacity;
+};
@@ -0,0 +1,128 @@
+#include "ParticleBudget.h"
+#include <algorithm>
+#include <chrono>
+
+ParticleBudget::ParticleBudget(Clock clock)
+{
+	this->clock = clock;
+	if (!this->clock)
+	{
+		this->clock = []() {
+			return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		};
+	}
+
+	particleTarget = 0;
+	timeTarget = 0;
+	frameCost = 0;
+	lastFrameCost = 0;
+	costPerParticle = 0;
+	allowance = 0;
+}
+
+int ParticleBudget::Add(unsigned int capacity, float priority)
+{
+	Entry entry = { capacity, priority, 0, capacity };
+	entries.push_back(entry);
+	allowance += capacity;
+
+	int handle = (int)entries.size() - 1;
+	order.push_back(handle);
+	SortByPriority();
+	return handle;
+}
+
+void ParticleBudget::SetPriority(int handle, float priority)
+{
+	if (handle < 0 || handle >= (int)entries.size())
+		return;
+
+	entries[handle].Priority = priority;
+	SortByPriority();
+}
+
+// --------------------------------------------------------
+// Works out this frame's allowance, then deals it out from
+// the highest priority down
+// --------------------------------------------------------
+void ParticleBudget::Rebalance(const unsigned int* liveCounts)
+{
+	unsigned int totalLive = 0;
+	unsigned int totalCapacity = 0;
+	for (unsigned int e = 0; e < entries.size(); e++)
+	{
+		entries[e].Live = liveCounts[e];
+		totalLive += liveCounts[e];
+		totalCapacity += entries[e].Capacity;
+	}
+
+	// Cost per particle moves gradually, so one slow frame
+	// doesn't wipe everything out
+	lastFrameCost = frameCost;
+	frameCost = 0;
+	if (totalLive > 0 && lastFrameCost > 0)
+	{
+		double measured = lastFrameCost / totalLive;
+		costPerParticle = costPerParticle > 0 ? costPerParticle + (measured - costPerParticle) * 0.1 : measured;
+	}
+
+	allowance = totalCapacity;
+	if (particleTarget > 0 && particleTarget < allowance)
+		allowance = particleTarget;
+
+	if (timeTarget > 0 && costPerParticle > 0)
+	{
+		double affordable = timeTarget / costPerParticle;
+		if (affordable < allowance)
+			allowance = (unsigned int)affordable;
+	}
+
+	unsigned int remaining = allowance;
+	unsigned int first = 0;
+	while (first < order.size())
+	{
+		// Everyone tied on this priority
+		unsigned int last = first;
+		unsigned int tiedCapacity = 0;
+		while (last < order.size() && entries[order[last]].Priority == entries[order[first]].Priority)
+			tiedCapacity += entries[order[last++]].Capacity;
+
+		bool enough = remaining >= tiedCapacity;
+		unsigned int given = 0;
+		for (unsigned int o = first; o < last; o++)
+		{
+			Entry& entry = entries[order[o]];
+			entry.Limit = enough ? entry.Capacity :
+				(unsigned int)((unsigned long long)entry.Capacity * remaining / tiedCapacity);
+			given += entry.Limit;
+		}
+
+		remaining -= given;
+		first = last;
+	}
+}
+
+unsigned int ParticleBudget::GetLimit(int handle)
+{
+	return (handle < 0 || handle >= (int)entries.size()) ? 0 : entries[handle].Limit;
+}
+
+float ParticleBudget::GetRateScale(int handle)
+{
+	if (handle < 0 || handle >= (int)entries.size() || entries[handle].Capacity == 0)
+		return 0;
+
+	return (float)entries[handle].Limit / entries[handle].Capacity;
+}
+
+double ParticleBudget::GetLoad(int handle)
+{
+	return (handle < 0 || handle >= (int)entries.size()) ? 0 : entries[handle].Live * costPerParticle;
+}
+
+void ParticleBudget::SortByPriority()
+{
+	std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+		return entries[a].Priority > entries[b].Priority;
+	});
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <functional>
+#include <vector>
+
+// --------------------------------------------------------
+// Keeps the cost of every emitter together under a target.
+//
+// Each emitter is added with its capacity and a priority.
+// Once a frame, Rebalance() takes every emitter's live
+// count and the time spent on particles since the last
+// call, and works out how many particles that frame could
+// afford - the particle target, or as many as the time
+// target allows at the (smoothed) measured cost per
+// particle, whichever is lower.  That allowance goes to the
+// highest priorities first, each emitter getting up to its
+// capacity; emitters tied on priority split what's left in
+// proportion to their capacities.
+//
+// Each emitter's share is handed back as a live limit and
+// a matching emission rate scale (share / capacity), so a
+// squeezed emitter both spawns less and never grows past
+// its share.
+//
+// Time comes from the clock given to the constructor (a
+// steady clock, in seconds, by default), so a fake clock
+// can drive it in a test.  Nothing here touches D3D.
+// --------------------------------------------------------
+class ParticleBudget
+{
+public:
+	typedef std::function<double()> Clock;
+
+	ParticleBudget(Clock clock = Clock());
+
+	// 0 turns a target off (both are off to begin with)
+	void SetParticleTarget(unsigned int particles) { particleTarget = particles; }
+	void SetTimeTarget(double seconds) { timeTarget = seconds; }
+
+	// Returns a handle for the emitter.  Higher priorities are
+	// served first.
+	int Add(unsigned int capacity, float priority = 1.0f);
+	void SetPriority(int handle, float priority);
+
+	// Measuring: time passed from a Now() to a later Now(),
+	// added up until the next Rebalance()
+	double Now() { return clock(); }
+	void AddCost(double seconds) { frameCost += seconds; }
+
+	// liveCounts holds one count per handle
+	void Rebalance(const unsigned int* liveCounts);
+
+	// Results of the last Rebalance()
+	unsigned int GetLimit(int handle);
+	float GetRateScale(int handle);
+	unsigned int GetAllowance() { return allowance; }
+	double GetLastFrameCost() { return lastFrameCost; }
+
+	// An emitter's share of the last frame's cost (its live
+	// count times the measured cost per particle) in seconds
+	double GetLoad(int handle);
+
+private:
+	struct Entry
+	{
+		unsigned int Capacity;
+		float Priority;
+		unsigned int Live;
+		unsigned int Limit;
+	};
+
+	Clock clock;
+	std::vector<Entry> entries;			// Indexed by handle
+	std::vector<int> order;				// Handles, highest priority first
+
+	unsigned int particleTarget;
+	double timeTarget;
+
+	double frameCost;
+	double lastFrameCost;
+	double costPerParticle;				// Smoothed, 0 until first measured
+	unsigned int allowance;
+
+	void SortByPriority();
+};
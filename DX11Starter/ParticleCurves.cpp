@@ -0,0 +1,147 @@
+#include "ParticleCurves.h"
+
+using namespace DirectX;
+
+ParticleCurves::ParticleCurves()
+{
+	Bake(1.0f);
+}
+
+void ParticleCurves::SetColor(const ParticleColorKey* keys, int count)
+{
+	colorKeys.assign(keys, keys + count);
+}
+
+void ParticleCurves::SetAlpha(const ParticleCurveKey* keys, int count)
+{
+	alphaKeys.assign(keys, keys + count);
+}
+
+void ParticleCurves::SetSize(const ParticleCurveKey* keys, int count)
+{
+	sizeKeys.assign(keys, keys + count);
+}
+
+void ParticleCurves::SetSpeed(const ParticleCurveKey* keys, int count)
+{
+	speedKeys.assign(keys, keys + count);
+}
+
+// --------------------------------------------------------
+// Travel is the running integral of speed, summed one
+// table step at a time (exact for speed that's linear
+// between entries)
+// --------------------------------------------------------
+void ParticleCurves::Bake(float lifetime)
+{
+	float step = lifetime / (Resolution - 1);
+	float previousSpeed = 0;
+	constant = true;
+
+	for (int i = 0; i < Resolution; i++)
+	{
+		float age = (float)i / (Resolution - 1);
+		ParticleCurveSample& sample = table[i];
+
+		sample.Color = Evaluate(colorKeys, age);
+		sample.Color.w *= Evaluate(alphaKeys, age, 1.0f);
+		sample.Size = Evaluate(sizeKeys, age, 1.0f);
+
+		float speed = Evaluate(speedKeys, age, 1.0f);
+		sample.Travel = i == 0 ? 0 : table[i - 1].Travel + (previousSpeed + speed) * 0.5f * step;
+
+		if (i == 0)
+		{
+			constantSpeed = speed;
+		}
+		else if (speed != previousSpeed || sample.Size != table[0].Size ||
+			sample.Color.x != table[0].Color.x || sample.Color.y != table[0].Color.y ||
+			sample.Color.z != table[0].Color.z || sample.Color.w != table[0].Color.w)
+		{
+			constant = false;
+		}
+
+		previousSpeed = speed;
+
+		if (i == 0 || sample.Travel < minTravel) minTravel = sample.Travel;
+		if (i == 0 || sample.Travel > maxTravel) maxTravel = sample.Travel;
+		if (i == 0 || sample.Size > maxSize) maxSize = sample.Size;
+	}
+}
+
+ParticleCurves ParticleCurves::MakeLinear(XMFLOAT4 startColor, XMFLOAT4 endColor, float startSize, float endSize)
+{
+	ParticleColorKey colors[2] = { { 0, startColor }, { 1, endColor } };
+	ParticleCurveKey sizes[2] = { { 0, startSize }, { 1, endSize } };
+
+	ParticleCurves curves;
+	curves.SetColor(colors, 2);
+	curves.SetSize(sizes, 2);
+	return curves;
+}
+
+ParticleCurveSample ParticleCurves::Sample(float normalizedAge) const
+{
+	if (normalizedAge < 0) normalizedAge = 0;
+	if (normalizedAge > 1) normalizedAge = 1;
+
+	float position = normalizedAge * (Resolution - 1);
+	int index = (int)position;
+	if (index > Resolution - 2)
+		index = Resolution - 2;
+
+	float t = position - index;
+	const ParticleCurveSample& a = table[index];
+	const ParticleCurveSample& b = table[index + 1];
+
+	ParticleCurveSample result;
+	XMStoreFloat4(&result.Color, XMVectorLerp(XMLoadFloat4(&a.Color), XMLoadFloat4(&b.Color), t));
+	result.Size = a.Size + (b.Size - a.Size) * t;
+	result.Travel = a.Travel + (b.Travel - a.Travel) * t;
+	return result;
+}
+
+float ParticleCurves::Evaluate(const std::vector<ParticleCurveKey>& keys, float age, float defaultValue)
+{
+	if (keys.empty())
+		return defaultValue;
+
+	if (age <= keys.front().Age)
+		return keys.front().Value;
+
+	for (unsigned int k = 1; k < keys.size(); k++)
+	{
+		if (age <= keys[k].Age)
+		{
+			float span = keys[k].Age - keys[k - 1].Age;
+			float t = span > 0 ? (age - keys[k - 1].Age) / span : 1.0f;
+			return keys[k - 1].Value + (keys[k].Value - keys[k - 1].Value) * t;
+		}
+	}
+
+	return keys.back().Value;
+}
+
+XMFLOAT4 ParticleCurves::Evaluate(const std::vector<ParticleColorKey>& keys, float age)
+{
+	if (keys.empty())
+		return XMFLOAT4(1, 1, 1, 1);
+
+	if (age <= keys.front().Age)
+		return keys.front().Color;
+
+	for (unsigned int k = 1; k < keys.size(); k++)
+	{
+		if (age <= keys[k].Age)
+		{
+			float span = keys[k].Age - keys[k - 1].Age;
+			float t = span > 0 ? (age - keys[k - 1].Age) / span : 1.0f;
+
+			XMFLOAT4 color;
+			XMStoreFloat4(&color, XMVectorLerp(XMLoadFloat4(&keys[k - 1].Color), XMLoadFloat4(&keys[k].Color), t));
+			return color;
+		}
+	}
+
+	return keys.back().Color;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+
+// --------------------------------------------------------
+// A key on a curve: a value at a normalized age (0 = just
+// spawned, 1 = about to die)
+// --------------------------------------------------------
+struct ParticleCurveKey
+{
+	float Age;
+	float Value;
+};
+
+struct ParticleColorKey
+{
+	float Age;
+	DirectX::XMFLOAT4 Color;
+};
+
+// --------------------------------------------------------
+// Everything the curves say about a particle at one age
+// --------------------------------------------------------
+struct ParticleCurveSample
+{
+	DirectX::XMFLOAT4 Color;	// Color track times the alpha track
+	float Size;
+	float Travel;				// Seconds of start velocity covered so far
+};
+
+// --------------------------------------------------------
+// How a particle's color, alpha, size and speed change over
+// its life, baked into a small table.
+//
+// Each track is a list of keys, linear in between and held
+// flat before the first and after the last (an empty track
+// keeps its default: white, alpha 1, size 1, speed 1).
+// Bake() evaluates every track at Resolution evenly spaced
+// ages, so sampling costs two neighbouring table entries
+// and a lerp no matter how many keys there are.
+//
+// Speed scales the start velocity.  Its running integral is
+// baked as Travel, so position stays a closed form of age:
+// start + velocity * Travel + acceleration * age^2 / 2.
+// --------------------------------------------------------
+class ParticleCurves
+{
+public:
+	static const int Resolution = 64;
+
+	ParticleCurves();
+
+	// Keys must be in age order
+	void SetColor(const ParticleColorKey* keys, int count);
+	void SetAlpha(const ParticleCurveKey* keys, int count);
+	void SetSize(const ParticleCurveKey* keys, int count);
+	void SetSpeed(const ParticleCurveKey* keys, int count);
+
+	// Fills the table; lifetime (in seconds) scales Travel
+	void Bake(float lifetime);
+
+	// Linear color and size, the way emitters always worked
+	static ParticleCurves MakeLinear(DirectX::XMFLOAT4 startColor, DirectX::XMFLOAT4 endColor, float startSize, float endSize);
+
+	// normalizedAge is clamped to [0, 1]
+	ParticleCurveSample Sample(float normalizedAge) const;
+
+	// True if the last Bake() found every track flat (nothing
+	// changes with age, and speed is GetConstantSpeed())
+	bool IsConstant() const { return constant; }
+	float GetConstantSpeed() const { return constantSpeed; }
+
+	// Extremes of the baked table, for working out how far
+	// particles can get (and how big they can be)
+	float GetMinTravel() const { return minTravel; }
+	float GetMaxTravel() const { return maxTravel; }
+	float GetMaxSize() const { return maxSize; }
+
+private:
+	std::vector<ParticleColorKey> colorKeys;
+	std::vector<ParticleCurveKey> alphaKeys;
+	std::vector<ParticleCurveKey> sizeKeys;
+	std::vector<ParticleCurveKey> speedKeys;
+
+	ParticleCurveSample table[Resolution];
+	bool constant;
+	float constantSpeed;
+	float minTravel;
+	float maxTravel;
+	float maxSize;
+
+	static float Evaluate(const std::vector<ParticleCurveKey>& keys, float age, float defaultValue);
+	static DirectX::XMFLOAT4 Evaluate(const std::vector<ParticleColorKey>& keys, float age);
+};
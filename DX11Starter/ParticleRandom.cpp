@@ -0,0 +1,88 @@
+#include "ParticleRandom.h"
+
+using namespace DirectX;
+
+ParticleRandom::ParticleRandom(unsigned int seed)
+{
+	Seed(seed);
+}
+
+// --------------------------------------------------------
+// Spreads one 32-bit seed over all sixteen state words with
+// splitmix32, which never leaves a lane all zero (the one
+// state xoshiro can't get out of)
+// --------------------------------------------------------
+void ParticleRandom::Seed(unsigned int seed)
+{
+	unsigned int mix = seed;
+	for (int lane = 0; lane < 4; lane++)
+	{
+		for (int word = 0; word < 4; word++)
+		{
+			mix += 0x9e3779b9u;
+			unsigned int z = mix;
+			z = (z ^ (z >> 16)) * 0x85ebca6bu;
+			z = (z ^ (z >> 13)) * 0xc2b2ae35u;
+			state[word][lane] = z ^ (z >> 16);
+		}
+	}
+}
+
+// --------------------------------------------------------
+// One xoshiro128+ step in every lane
+// --------------------------------------------------------
+void ParticleRandom::Next(unsigned int values[4])
+{
+	for (int lane = 0; lane < 4; lane++)
+	{
+		values[lane] = state[0][lane] + state[3][lane];
+
+		unsigned int t = state[1][lane] << 9;
+		state[2][lane] ^= state[0][lane];
+		state[3][lane] ^= state[1][lane];
+		state[1][lane] ^= state[2][lane];
+		state[0][lane] ^= state[3][lane];
+		state[2][lane] ^= t;
+		state[3][lane] = (state[3][lane] << 11) | (state[3][lane] >> 21);
+	}
+}
+
+XMVECTOR ParticleRandom::NextFloat4(float min, float max)
+{
+	// The top 24 bits are the best ones (and fit a float exactly)
+	unsigned int bits[4];
+	Next(bits);
+
+	XMFLOAT4 unit(
+		(bits[0] >> 8) * (1.0f / 16777216.0f),
+		(bits[1] >> 8) * (1.0f / 16777216.0f),
+		(bits[2] >> 8) * (1.0f / 16777216.0f),
+		(bits[3] >> 8) * (1.0f / 16777216.0f));
+
+	return XMVectorMultiplyAdd(XMLoadFloat4(&unit), XMVectorReplicate(max - min), XMVectorReplicate(min));
+}
+
+void ParticleRandom::Fill(float* values, int count, float min, float max)
+{
+	for (int i = 0; i < count; i += 4)
+	{
+		XMFLOAT4 block;
+		XMStoreFloat4(&block, NextFloat4(min, max));
+
+		const float* lanes = &block.x;
+		for (int lane = 0; lane < 4 && i + lane < count; lane++)
+			values[i + lane] = lanes[lane];
+	}
+}
+
+void ParticleRandom::Fill(unsigned int* values, int count)
+{
+	for (int i = 0; i < count; i += 4)
+	{
+		unsigned int block[4];
+		Next(block);
+
+		for (int lane = 0; lane < 4 && i + lane < count; lane++)
+			values[i + lane] = block[lane];
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// A small, fast random number generator for particles.
+//
+// Four independent xoshiro128+ streams run side by side
+// (one per lane), so every call produces four numbers at
+// once - exactly what a velocity jitter or a block of four
+// particles wants - and the lane loops are plain 32-bit
+// shifts and xors the compiler can vectorize.
+//
+// Output depends only on the seed, never on the platform,
+// the CRT or which thread calls it, so two generators with
+// the same seed give identical sequences.  Not shared:
+// each emitter owns its own.
+// --------------------------------------------------------
+class ParticleRandom
+{
+public:
+	ParticleRandom(unsigned int seed = 0);
+
+	// Restarts the sequence
+	void Seed(unsigned int seed);
+
+	// Four raw 32-bit numbers, one from each lane
+	void Next(unsigned int values[4]);
+
+	// Four floats in [min, max)
+	DirectX::XMVECTOR NextFloat4(float min, float max);
+
+	// count floats in [min, max), four at a time (a partial
+	// last block still uses up all four lanes)
+	void Fill(float* values, int count, float min, float max);
+	void Fill(unsigned int* values, int count);
+
+private:
+	unsigned int state[4][4];	// [word][lane]
+};
@@ -0,0 +1,124 @@
+#include "ParticleSorter.h"
+#include <string.h>
+
+using namespace DirectX;
+
+void ParticleSorter::SortBackToFront(const ParticleInstance* source, ParticleInstance* destination, unsigned int count, const XMFLOAT4& depthPlane, bool wideKeys)
+{
+	if (count == 0)
+		return;
+
+	if (depths.size() < count)
+	{
+		depths.resize(count);
+		entries.resize(count);
+		scratch.resize(count);
+	}
+
+	float nearest = 0;
+	float farthest = 0;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const XMFLOAT3& p = source[i].Position;
+		float depth = depthPlane.x * p.x + depthPlane.y * p.y + depthPlane.z * p.z + depthPlane.w;
+		depths[i] = depth;
+
+		if (i == 0 || depth < nearest) nearest = depth;
+		if (i == 0 || depth > farthest) farthest = depth;
+	}
+
+	unsigned long long* sorted;
+	if (wideKeys)
+	{
+		MakeWideKeys(count);
+		sorted = RadixSort(count, 4);
+	}
+	else
+	{
+		MakeNarrowKeys(count, nearest, farthest);
+		sorted = RadixSort(count, 2);
+	}
+
+	for (unsigned int i = 0; i < count; i++)
+		destination[i] = source[(unsigned int)sorted[i]];
+}
+
+// --------------------------------------------------------
+// 0 for the farthest particle up to 65535 for the nearest
+// --------------------------------------------------------
+void ParticleSorter::MakeNarrowKeys(unsigned int count, float nearest, float farthest)
+{
+	float scale = farthest > nearest ? 65535.0f / (farthest - nearest) : 0.0f;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		unsigned long long key = (unsigned int)((farthest - depths[i]) * scale);
+		entries[i] = (key << 32) | i;
+	}
+}
+
+// --------------------------------------------------------
+// Float bits flipped so they sort like the floats do (all
+// bits for negatives, just the sign for positives), then
+// inverted so larger depths come first
+// --------------------------------------------------------
+void ParticleSorter::MakeWideKeys(unsigned int count)
+{
+	for (unsigned int i = 0; i < count; i++)
+	{
+		unsigned int bits;
+		memcpy(&bits, &depths[i], sizeof(bits));
+
+		unsigned int flip = (bits & 0x80000000u) ? 0xFFFFFFFFu : 0x80000000u;
+		unsigned long long key = ~(bits ^ flip);
+		entries[i] = (key << 32) | i;
+	}
+}
+
+// --------------------------------------------------------
+// Counts every pass's digits in one read, then scatters
+// back and forth between the two arrays (stable, so equal
+// keys keep their order).  Returns whichever array ended
+// up holding the result.
+// --------------------------------------------------------
+unsigned long long* ParticleSorter::RadixSort(unsigned int count, unsigned int passes)
+{
+	unsigned int counts[4][256];
+	memset(counts, 0, sizeof(counts));
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		unsigned int key = (unsigned int)(entries[i] >> 32);
+		for (unsigned int pass = 0; pass < passes; pass++)
+			counts[pass][(key >> (pass * 8)) & 0xFF]++;
+	}
+
+	unsigned long long* from = &entries[0];
+	unsigned long long* to = &scratch[0];
+
+	for (unsigned int pass = 0; pass < passes; pass++)
+	{
+		unsigned int shift = 32 + pass * 8;
+
+		// Every key has the same digit here - nothing would move
+		if (counts[pass][(from[0] >> shift) & 0xFF] == count)
+			continue;
+
+		// Where each digit's run starts
+		unsigned int offsets[256];
+		unsigned int total = 0;
+		for (unsigned int d = 0; d < 256; d++)
+		{
+			offsets[d] = total;
+			total += counts[pass][d];
+		}
+
+		for (unsigned int i = 0; i < count; i++)
+			to[offsets[(from[i] >> shift) & 0xFF]++] = from[i];
+
+		unsigned long long* swap = from;
+		from = to;
+		to = swap;
+	}
+
+	return from;
+}
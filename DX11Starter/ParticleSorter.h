@@ -0,0 +1,40 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+#include "Emitter.h"
+
+// --------------------------------------------------------
+// Puts particles in back-to-front order for alpha blending.
+//
+// Each particle gets an integer key from its view depth,
+// packed above its index into one 64-bit value, and an LSD
+// radix sort (eight bits per pass) orders those; particles
+// are then gathered from the source in that order.  Two
+// key widths:
+//
+//  - 16 bit (default) - depth relative to this batch's
+//    nearest and farthest particle, two passes
+//  - 32 bit - the depth's own float bits, four passes, for
+//    batches spread over a huge depth range
+//
+// Passes where every key has the same digit are skipped.
+// Scratch memory only ever grows, so a steady particle
+// count sorts without allocating.  Nothing here touches D3D.
+// --------------------------------------------------------
+class ParticleSorter
+{
+public:
+	// Writes source's particles to destination (which must not
+	// overlap it) farthest first, where depth is
+	// dot(depthPlane.xyz, position) + depthPlane.w (view z)
+	void SortBackToFront(const ParticleInstance* source, ParticleInstance* destination, unsigned int count, const DirectX::XMFLOAT4& depthPlane, bool wideKeys = false);
+
+private:
+	std::vector<float> depths;
+	std::vector<unsigned long long> entries;	// Key in the top 32 bits, index below
+	std::vector<unsigned long long> scratch;
+
+	void MakeNarrowKeys(unsigned int count, float nearest, float farthest);
+	void MakeWideKeys(unsigned int count);
+	unsigned long long* RadixSort(unsigned int count, unsigned int passes);
+};
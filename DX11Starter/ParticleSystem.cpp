@@ -0,0 +1,289 @@
+#include "ParticleSystem.h"
+#include <string.h>
+
+ParticleSystem::ParticleSystem(ID3D11Device* device, SimpleVertexShader* vs, SimplePixelShader* ps)
+{
+	this->device = device;
+	this->vs = vs;
+	this->ps = ps;
+	textureHandle = ps->GetShaderResourceViewHandle(SimpleShaderHash("particle"));
+
+	instanceBuffer = 0;
+	bufferCapacity = 0;
+	sortedGroupCount = 0;
+	sleepingCount = 0;
+}
+
+ParticleSystem::~ParticleSystem()
+{
+	for (unsigned int e = 0; e < emitters.size(); e++)
+		delete emitters[e];
+
+	if (instanceBuffer) { instanceBuffer->Release(); }
+}
+
+int ParticleSystem::AddEmitter(Emitter* emitter, ID3D11ShaderResourceView* texture, const RenderState& state, bool depthSorted)
+{
+	int handle = batcher.Add(emitter, FindGroup(texture, state, depthSorted));
+	emitters.push_back(emitter);
+	enabled.push_back(true);
+	budget.Add((unsigned int)emitter->GetMaxParticles());
+
+	// Room for every emitter at once, so packing never has to
+	// check for space
+	if (batcher.GetCapacity() > bufferCapacity)
+		GrowBuffer(batcher.GetCapacity());
+
+	return handle;
+}
+
+// --------------------------------------------------------
+// Chunks only write their own particles (and their own job's
+// death count), so they can all run at once; the ring
+// bookkeeping waits until every chunk is done
+// --------------------------------------------------------
+void ParticleSystem::Update(float dt, Camera* camera, WorkerPool* workers)
+{
+	// Only what's enabled and on screen runs this frame - the
+	// rest sleep, and catch up whenever they next wake
+	if (camera)
+		SetFrustum(camera);
+
+	sleepingCount = 0;
+	for (unsigned int e = 0; e < emitters.size(); e++)
+	{
+		bool awake = enabled[e] && (!camera || InFrustum(emitters[e]));
+		batcher.SetEnabled((int)e, awake);
+		if (!awake)
+		{
+			emitters[e]->Sleep(dt);
+			sleepingCount++;
+		}
+	}
+
+	// Share out what the last frame says we can afford (only
+	// what's drawn costs anything)
+	liveCounts.resize(emitters.size());
+	for (unsigned int e = 0; e < emitters.size(); e++)
+		liveCounts[e] = batcher.IsEnabled((int)e) ? (unsigned int)emitters[e]->GetLivingCount() : 0;
+
+	if (!liveCounts.empty())
+		budget.Rebalance(&liveCounts[0]);
+
+	for (unsigned int e = 0; e < emitters.size(); e++)
+		emitters[e]->SetBudget(budget.GetRateScale((int)e), (int)budget.GetLimit((int)e));
+
+	double start = budget.Now();
+
+	jobs.clear();
+	for (unsigned int e = 0; e < emitters.size(); e++)
+	{
+		if (!batcher.IsEnabled((int)e))
+			continue;
+
+		emitters[e]->BeginUpdate(dt);
+
+		int chunks = emitters[e]->GetChunkCount();
+		for (int c = 0; c < chunks; c++)
+		{
+			ChunkJob job = { e, c, 0 };
+			jobs.push_back(job);
+		}
+	}
+
+	std::function<void(unsigned int)> runJob = [this](unsigned int j) {
+		jobs[j].Deaths = emitters[jobs[j].Emitter]->UpdateChunk(jobs[j].Chunk);
+	};
+
+	if (workers && jobs.size() > 1)
+	{
+		workers->ParallelFor((unsigned int)jobs.size(), runJob);
+	}
+	else
+	{
+		for (unsigned int j = 0; j < jobs.size(); j++)
+			runJob(j);
+	}
+
+	emitterDeaths.assign(emitters.size(), 0);
+	for (unsigned int j = 0; j < jobs.size(); j++)
+		emitterDeaths[jobs[j].Emitter] += jobs[j].Deaths;
+
+	// Each emitter spawns from its own generator, so finishing
+	// them off is independent too
+	std::function<void(unsigned int)> finishEmitter = [this](unsigned int e) {
+		if (batcher.IsEnabled((int)e))
+			emitters[e]->EndUpdate(emitterDeaths[e]);
+	};
+
+	if (workers && emitters.size() > 1)
+	{
+		workers->ParallelFor((unsigned int)emitters.size(), finishEmitter);
+	}
+	else
+	{
+		for (unsigned int e = 0; e < emitters.size(); e++)
+			finishEmitter(e);
+	}
+
+	budget.AddCost(budget.Now() - start);
+}
+
+// --------------------------------------------------------
+// One map for every emitter, then one draw per group
+// --------------------------------------------------------
+void ParticleSystem::Draw(ID3D11DeviceContext* context, Camera* camera)
+{
+	// Skip it all if the buffer couldn't grow to fit
+	if (!instanceBuffer || bufferCapacity < batcher.GetCapacity())
+		return;
+
+	double start = budget.Now();
+
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	if (context->Map(instanceBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped) != S_OK)
+		return;
+
+	unsigned int total = 0;
+	if (sortedGroupCount == 0)
+	{
+		total = batcher.Pack((ParticleInstance*)mapped.pData);
+	}
+	else
+	{
+		if (staging.size() < batcher.GetCapacity())
+			staging.resize(batcher.GetCapacity());
+
+		total = batcher.Pack(&staging[0]);
+
+		// View z is the third row of the (transposed) view matrix
+		XMFLOAT4X4 view = camera->GetViewMatrix();
+		XMFLOAT4 depthPlane(view._31, view._32, view._33, view._34);
+
+		// Sorted batches are gathered straight into the buffer
+		ParticleInstance* instances = (ParticleInstance*)mapped.pData;
+		const std::vector<ParticleBatch>& batches = batcher.GetBatches();
+		for (unsigned int b = 0; b < batches.size(); b++)
+		{
+			const ParticleBatch& batch = batches[b];
+			if (groups[batch.Group].DepthSorted)
+				sorter.SortBackToFront(&staging[batch.Start], &instances[batch.Start], batch.Count, depthPlane);
+			else
+				memcpy(&instances[batch.Start], &staging[batch.Start], sizeof(ParticleInstance) * batch.Count);
+		}
+	}
+	context->Unmap(instanceBuffer, 0);
+	budget.AddCost(budget.Now() - start);
+
+	if (total == 0)
+		return;
+
+	// One instance per living particle - the shader makes the
+	// quad's six corners from the vertex ID, so slot 0 is empty
+	UINT stride = sizeof(ParticleInstance);
+	UINT offset = 0;
+	context->IASetVertexBuffers(1, 1, &instanceBuffer, &stride, &offset);
+	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	vs->SetDeviceContext(context);
+	ps->SetDeviceContext(context);
+
+	// View and projection come from the shared per-frame buffer
+	vs->SetShader();
+	ps->SetShader();
+	ps->CopyAllBufferData();
+
+	float blend[4] = { 1,1,1,1 };
+	unsigned long long currentState = ~0ull;
+	const std::vector<ParticleBatch>& batches = batcher.GetBatches();
+	for (unsigned int b = 0; b < batches.size(); b++)
+	{
+		const Group& group = groups[batches[b].Group];
+		StateCache::Apply(context, group.State, &currentState, blend);
+		ps->SetShaderResourceView(textureHandle, group.Texture);
+
+		context->DrawInstanced(6, batches[b].Count, 0, batches[b].Start);
+	}
+}
+
+// --------------------------------------------------------
+// The camera's matrices are stored transposed (for HLSL),
+// so projection * view is already the column-vector form,
+// and its rows combine into the clip planes
+// --------------------------------------------------------
+void ParticleSystem::SetFrustum(Camera* camera)
+{
+	XMFLOAT4X4 view = camera->GetViewMatrix();
+	XMFLOAT4X4 projection = camera->GetProjectionMatrix();
+	XMMATRIX clip = XMMatrixMultiply(XMLoadFloat4x4(&projection), XMLoadFloat4x4(&view));
+
+	XMStoreFloat4(&frustum[0], XMVectorAdd(clip.r[3], clip.r[0]));
+	XMStoreFloat4(&frustum[1], XMVectorSubtract(clip.r[3], clip.r[0]));
+	XMStoreFloat4(&frustum[2], XMVectorAdd(clip.r[3], clip.r[1]));
+	XMStoreFloat4(&frustum[3], XMVectorSubtract(clip.r[3], clip.r[1]));
+	XMStoreFloat4(&frustum[4], clip.r[2]);
+	XMStoreFloat4(&frustum[5], XMVectorSubtract(clip.r[3], clip.r[2]));
+}
+
+// --------------------------------------------------------
+// Tests the corner of the emitter's bounds furthest inside
+// each plane.  The shader grows each quad by its size in
+// clip space, so the side planes are pushed out by the
+// biggest size first.
+// --------------------------------------------------------
+bool ParticleSystem::InFrustum(Emitter* emitter)
+{
+	XMFLOAT3 min, max;
+	emitter->GetBounds(&min, &max);
+	float size = emitter->GetMaxSize();
+
+	for (int p = 0; p < 6; p++)
+	{
+		const XMFLOAT4& plane = frustum[p];
+		float distance =
+			plane.x * (plane.x > 0 ? max.x : min.x) +
+			plane.y * (plane.y > 0 ? max.y : min.y) +
+			plane.z * (plane.z > 0 ? max.z : min.z) +
+			plane.w;
+
+		if (p < 4)
+			distance += size;
+		if (distance < 0)
+			return false;
+	}
+	return true;
+}
+
+unsigned int ParticleSystem::FindGroup(ID3D11ShaderResourceView* texture, const RenderState& state, bool depthSorted)
+{
+	for (unsigned int g = 0; g < groups.size(); g++)
+	{
+		if (groups[g].Texture == texture && groups[g].State.Key == state.Key && groups[g].DepthSorted == depthSorted)
+			return g;
+	}
+
+	Group group = { texture, state, depthSorted };
+	groups.push_back(group);
+	if (depthSorted)
+		sortedGroupCount++;
+
+	return (unsigned int)groups.size() - 1;
+}
+
+bool ParticleSystem::GrowBuffer(unsigned int capacity)
+{
+	D3D11_BUFFER_DESC desc = {};
+	desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.ByteWidth = sizeof(ParticleInstance) * capacity;
+
+	ID3D11Buffer* buffer = 0;
+	if (device->CreateBuffer(&desc, 0, &buffer) != S_OK)
+		return false;
+
+	if (instanceBuffer) { instanceBuffer->Release(); }
+	instanceBuffer = buffer;
+	bufferCapacity = capacity;
+	return true;
+}
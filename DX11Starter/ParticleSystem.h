@@ -0,0 +1,127 @@
+#pragma once
+#include <d3d11.h>
+#include <vector>
+#include "Emitter.h"
+#include "ParticleBatcher.h"
+#include "ParticleBudget.h"
+#include "ParticleSorter.h"
+#include "Camera.h"
+#include "SimpleShader.h"
+#include "StateCache.h"
+#include "WorkerPool.h"
+
+// --------------------------------------------------------
+// Every emitter in the scene, drawn from one buffer.
+//
+// Emitters are added with the texture and render states
+// they draw with (and are owned from then on).  Each
+// frame, Draw() packs every enabled emitter's living
+// particles into a single instance buffer - emitters with
+// the same texture and states side by side - and issues
+// one instanced draw per texture/state group, rather than
+// one (or two) per emitter.
+//
+// Additive particles look the same in any order, but
+// alpha-blended ones don't - add those with depthSorted,
+// and their groups are sorted back to front (within each
+// draw) before being uploaded.
+//
+// Update() can spread the simulation over a WorkerPool:
+// every chunk of every enabled emitter is its own job, so
+// many small emitters and one huge one both fill the
+// threads.  Each emitter then retires and spawns on its
+// own, once all of its chunks are done.
+//
+// Emitters that are disabled, or (given a camera) whose
+// bounds are entirely off screen, sleep: they're neither
+// simulated nor drawn, and the time they miss is made up
+// in one step once they wake (see Emitter::Sleep()).
+//
+// Every emitter is also in a ParticleBudget (under the same
+// handle), which is rebalanced at the start of each
+// Update() from the time the last Update() and Draw()
+// spent - set its targets and priorities through
+// GetBudget().
+//
+// Draw() leaves the last group's states set; put the
+// defaults back afterwards.
+// --------------------------------------------------------
+class ParticleSystem
+{
+public:
+	ParticleSystem(ID3D11Device* device, SimpleVertexShader* vs, SimplePixelShader* ps);
+	~ParticleSystem();
+
+	// Takes ownership of the emitter and returns a handle for it
+	int AddEmitter(Emitter* emitter, ID3D11ShaderResourceView* texture, const RenderState& state, bool depthSorted = false);
+
+	// Disabled emitters sleep until they're enabled again
+	void SetEnabled(int emitter, bool enabled) { this->enabled[emitter] = enabled; }
+	bool IsEnabled(int emitter) { return enabled[emitter]; }
+	Emitter* GetEmitter(int emitter) { return batcher.GetEmitter(emitter); }
+
+	// Culls against camera if given, and runs on workers if
+	// given, otherwise on the caller
+	void Update(float dt, Camera* camera = 0, WorkerPool* workers = 0);
+	void Draw(ID3D11DeviceContext* context, Camera* camera);
+
+	// Draw calls made by the last Draw()
+	unsigned int GetBatchCount() { return (unsigned int)batcher.GetBatches().size(); }
+
+	// Emitters left asleep by the last Update()
+	unsigned int GetSleepingCount() { return sleepingCount; }
+
+	ParticleBudget* GetBudget() { return &budget; }
+
+private:
+	struct Group
+	{
+		ID3D11ShaderResourceView* Texture;
+		RenderState State;
+		bool DepthSorted;
+	};
+
+	ID3D11Device* device;
+	SimpleVertexShader* vs;
+	SimplePixelShader* ps;
+	int textureHandle;				// The pixel shader's "particle" texture
+
+	ParticleBatcher batcher;
+	std::vector<Emitter*> emitters;		// Indexed by handle
+	std::vector<bool> enabled;			// Indexed by handle - awake ones are enabled in the batcher
+	unsigned int sleepingCount;
+
+	// Clip space planes of the camera's frustum, in world space
+	// (left, right, bottom, top, near, far)
+	XMFLOAT4 frustum[6];
+	void SetFrustum(Camera* camera);
+	bool InFrustum(Emitter* emitter);
+	std::vector<Group> groups;			// Indexed by batcher group
+	unsigned int sortedGroupCount;
+
+	// With sorted groups, particles are packed here first -
+	// reading back from a mapped buffer is very slow
+	ParticleSorter sorter;
+	std::vector<ParticleInstance> staging;
+
+	// One per emitter chunk being updated this frame
+	struct ChunkJob
+	{
+		unsigned int Emitter;
+		int Chunk;
+		int Deaths;
+	};
+	std::vector<ChunkJob> jobs;
+	std::vector<int> emitterDeaths;		// Indexed by handle
+
+	ParticleBudget budget;
+	std::vector<unsigned int> liveCounts;	// Indexed by handle
+
+	// Shared DYNAMIC instance buffer, big enough for every
+	// emitter to be full at once
+	ID3D11Buffer* instanceBuffer;
+	unsigned int bufferCapacity;
+
+	unsigned int FindGroup(ID3D11ShaderResourceView* texture, const RenderState& state, bool depthSorted);
+	bool GrowBuffer(unsigned int capacity);
+};
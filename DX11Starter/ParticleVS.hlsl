@@ -1,18 +1,13 @@
+#include "SharedConstants.hlsli"
 
-// Constant buffer for C++ data being passed in
-cbuffer externalData : register(b0)
-{
-	matrix view;
-	matrix projection;
-};
-
-// Describes individual vertex data
+// Describes one particle (per instance data) - the quad's
+// corners come from the vertex ID instead of a vertex buffer
 struct VertexShaderInput
 {
-	float3 position		: POSITION;
-	float2 uv			: TEXCOORD;
-	float4 color		: COLOR;
-	float size : SIZE;
+	float3 position		: POSITION_PER_INSTANCE;
+	float size			: SIZE_PER_INSTANCE;
+	float4 color		: COLOR_PER_INSTANCE;
+	uint vertexID		: SV_VertexID;
 };
 
 // Defines the output data of our vertex shader
@@ -23,6 +18,13 @@ struct VertexToPixel
 	float4 color		: TEXCOORD1;
 };
 
+// UVs of the quad's two triangles, in draw order
+static const float2 cornerUVs[6] =
+{
+	float2(0, 0), float2(1, 0), float2(1, 1),
+	float2(0, 0), float2(1, 1), float2(0, 1)
+};
+
 // The entry point for our vertex shader
 VertexToPixel main(VertexShaderInput input)
 {
@@ -34,14 +36,15 @@ VertexToPixel main(VertexShaderInput input)
 	output.position = mul(float4(input.position, 1.0f), viewProj);
 
 	// Use UV to offset position (billboarding)
-	float2 offset = input.uv * 2 - 1;
+	float2 uv = cornerUVs[input.vertexID];
+	float2 offset = uv * 2 - 1;
 	offset *= input.size;
 	offset.y *= -1;
 	output.position.xy += offset;
 
 	// Pass uv through
-	output.uv = input.uv;
+	output.uv = uv;
 	output.color = input.color;
 
 	return output;
-}
\ No newline at end of file
+}
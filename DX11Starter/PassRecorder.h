@@ -0,0 +1,74 @@
+#pragma once
+#include <functional>
+#include <vector>
+#include "WorkerPool.h"
+
+// --------------------------------------------------------
+// The API-neutral half of parallel pass recording.  Each
+// pass records into a List of its own (a command list, a
+// plain vector of commands, ...) and Execute() hands the
+// lists back strictly in the order the passes were added.
+//
+// Recording order across threads doesn't matter: every pass
+// owns a fixed slot, so whatever order the workers finish
+// in, the merged stream is always the same.
+//
+// Lists are kept between frames (only the passes are
+// cleared), so a List that holds on to memory or API
+// objects gets to reuse them.
+// --------------------------------------------------------
+template<typename List>
+class PassRecorder
+{
+public:
+	typedef std::function<void(unsigned int pass, List* list)> RecordFunction;
+	typedef std::function<void(unsigned int pass, List* list)> ExecuteFunction;
+
+	// Adds a pass to this frame's list, and returns its slot
+	unsigned int AddPass(RecordFunction record)
+	{
+		passes.push_back(record);
+		if (lists.size() < passes.size())
+			lists.resize(passes.size());
+
+		return (unsigned int)passes.size() - 1;
+	}
+
+	// Records every pass into its own list - across the
+	// workers if there are any, in order on the caller if not
+	void Record(WorkerPool* workers)
+	{
+		if (workers && passes.size() > 1)
+		{
+			workers->ParallelFor((unsigned int)passes.size(), [this](unsigned int p) {
+				passes[p](p, &lists[p]);
+			});
+		}
+		else
+		{
+			for (unsigned int p = 0; p < passes.size(); p++)
+				passes[p](p, &lists[p]);
+		}
+	}
+
+	// Hands every pass's list over in pass order, then
+	// clears the passes for the next frame
+	void Execute(const ExecuteFunction& execute)
+	{
+		for (unsigned int p = 0; p < passes.size(); p++)
+			execute(p, &lists[p]);
+
+		passes.clear();
+	}
+
+	unsigned int GetPassCount() const { return (unsigned int)passes.size(); }
+
+	// Every list made so far, including ones no pass is using
+	// this frame
+	unsigned int GetListCount() const { return (unsigned int)lists.size(); }
+	List* GetList(unsigned int slot) { return &lists[slot]; }
+
+private:
+	std::vector<RecordFunction> passes;
+	std::vector<List> lists;
+};
@@ -1,3 +1,4 @@
+#include "SharedConstants.hlsli"
 
 // Struct representing the data we expect to receive from earlier pipeline stages
 // - Should match the output of our corresponding vertex shader
@@ -37,7 +38,6 @@ cbuffer externalData : register(b0) {
 	DirectionalLight dLight1;
 	//DirectionalLight dLight2;
 	//PointLight pLight1;
-	float3 CameraPosition;
 };
 
 Texture2D DiffuseTexture : register(t0);
@@ -0,0 +1,299 @@
+#include "ReflectionSidecar.h"
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const wchar_t* ReflectionSidecar::Extension = L".refl";
+
+// --------------------------------------------------------
+// Platform helpers for getting at files by wide path
+// --------------------------------------------------------
+#ifndef _WIN32
+static std::string NarrowPath(const std::wstring& path)
+{
+	std::string narrow(path.size() * 4 + 1, '\0');
+	size_t length = wcstombs(&narrow[0], path.c_str(), narrow.size());
+	if (length == (size_t)-1)
+		return std::string();
+
+	narrow.resize(length);
+	return narrow;
+}
+#endif
+
+static FILE* OpenFile(const std::wstring& path, const char* mode)
+{
+#ifdef _WIN32
+	std::wstring wideMode(mode, mode + strlen(mode));
+	FILE* file = 0;
+	if (_wfopen_s(&file, path.c_str(), wideMode.c_str()) != 0)
+		return 0;
+	return file;
+#else
+	return fopen(NarrowPath(path).c_str(), mode);
+#endif
+}
+
+// --------------------------------------------------------
+// 64 bit FNV-1a
+// --------------------------------------------------------
+unsigned long long ReflectionSidecar::Hash(const void* data, size_t size)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	unsigned long long hash = 14695981039346656037ull;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+// --------------------------------------------------------
+// Maps the whole sidecar (read only) and parses it in place
+// --------------------------------------------------------
+bool ReflectionSidecar::Read(const std::wstring& path, unsigned long long contentHash, ShaderReflectionData* reflection)
+{
+	bool result = false;
+
+#ifdef _WIN32
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+	{
+		HANDLE mapping = CreateFileMappingW(file, 0, PAGE_READONLY, 0, 0, 0);
+		if (mapping)
+		{
+			void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			if (view)
+			{
+				result = Parse(view, (size_t)fileSize.QuadPart, contentHash, reflection);
+				UnmapViewOfFile(view);
+			}
+			CloseHandle(mapping);
+		}
+	}
+	CloseHandle(file);
+#else
+	int file = open(NarrowPath(path).c_str(), O_RDONLY);
+	if (file < 0)
+		return false;
+
+	struct stat fileInfo;
+	if (fstat(file, &fileInfo) == 0 && fileInfo.st_size > 0)
+	{
+		void* view = mmap(0, (size_t)fileInfo.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (view != MAP_FAILED)
+		{
+			result = Parse(view, (size_t)fileInfo.st_size, contentHash, reflection);
+			munmap(view, (size_t)fileInfo.st_size);
+		}
+	}
+	close(file);
+#endif
+
+	return result;
+}
+
+// --------------------------------------------------------
+// Writes the sidecar in one go
+// --------------------------------------------------------
+bool ReflectionSidecar::Write(const std::wstring& path, unsigned long long contentHash, const ShaderReflectionData& reflection)
+{
+	std::vector<unsigned char> data;
+	Serialize(contentHash, reflection, &data);
+
+	FILE* file = OpenFile(path, "wb");
+	if (!file)
+		return false;
+
+	bool result = fwrite(&data[0], 1, data.size(), file) == data.size();
+	result = (fclose(file) == 0) && result;
+	return result;
+}
+
+// --------------------------------------------------------
+// Checks the header and every offset and count against the
+// size before copying anything out, so a truncated or stale
+// file is rejected rather than read past its end
+// --------------------------------------------------------
+bool ReflectionSidecar::Parse(const void* data, size_t size, unsigned long long contentHash, ShaderReflectionData* reflection)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	if (size < sizeof(FileHeader))
+		return false;
+
+	FileHeader header;
+	memcpy(&header, bytes, sizeof(FileHeader));
+	if (header.Magic != Magic || header.Version != Version || header.ContentHash != contentHash)
+		return false;
+
+	// Work out where each block starts and make sure it all fits
+	unsigned long long cbStart = sizeof(FileHeader);
+	unsigned long long varStart = cbStart + (unsigned long long)header.ConstantBufferCount * sizeof(FileConstantBuffer);
+	unsigned long long texStart = varStart + (unsigned long long)header.VariableCount * sizeof(FileVariable);
+	unsigned long long sampStart = texStart + (unsigned long long)header.TextureCount * sizeof(FileResource);
+	unsigned long long stringStart = sampStart + (unsigned long long)header.SamplerCount * sizeof(FileResource);
+	if (stringStart + header.StringBytes != size)
+		return false;
+
+	// Strings must end in a terminator so every name stays in bounds
+	const char* strings = (const char*)(bytes + stringStart);
+	if (header.StringBytes == 0 || strings[header.StringBytes - 1] != '\0')
+		return false;
+
+	ShaderReflectionData parsed;
+
+	// Constant buffers, with their variables stored back to back
+	unsigned int variablesUsed = 0;
+	parsed.ConstantBuffers.resize(header.ConstantBufferCount);
+	for (unsigned int b = 0; b < header.ConstantBufferCount; b++)
+	{
+		FileConstantBuffer fileCB;
+		memcpy(&fileCB, bytes + cbStart + b * sizeof(FileConstantBuffer), sizeof(FileConstantBuffer));
+		if (fileCB.NameOffset >= header.StringBytes || fileCB.VariableCount > header.VariableCount - variablesUsed)
+			return false;
+
+		ReflectedConstantBuffer& cb = parsed.ConstantBuffers[b];
+		cb.Name = strings + fileCB.NameOffset;
+		cb.Size = fileCB.Size;
+		cb.BindIndex = fileCB.BindIndex;
+		cb.Variables.resize(fileCB.VariableCount);
+
+		for (unsigned int v = 0; v < fileCB.VariableCount; v++)
+		{
+			FileVariable fileVar;
+			memcpy(&fileVar, bytes + varStart + (variablesUsed + v) * sizeof(FileVariable), sizeof(FileVariable));
+			if (fileVar.NameOffset >= header.StringBytes ||
+				fileVar.TypeNameOffset >= header.StringBytes ||
+				fileVar.ByteOffset + fileVar.Size > fileCB.Size)
+				return false;
+
+			cb.Variables[v].Name = strings + fileVar.NameOffset;
+			cb.Variables[v].TypeName = strings + fileVar.TypeNameOffset;
+			cb.Variables[v].Elements = fileVar.Elements;
+			cb.Variables[v].ByteOffset = fileVar.ByteOffset;
+			cb.Variables[v].Size = fileVar.Size;
+		}
+		variablesUsed += fileCB.VariableCount;
+	}
+	if (variablesUsed != header.VariableCount)
+		return false;
+
+	// Textures, then samplers
+	unsigned int counts[2] = { header.TextureCount, header.SamplerCount };
+	unsigned long long starts[2] = { texStart, sampStart };
+	std::vector<ReflectedResource>* lists[2] = { &parsed.Textures, &parsed.Samplers };
+	for (unsigned int l = 0; l < 2; l++)
+	{
+		lists[l]->resize(counts[l]);
+		for (unsigned int r = 0; r < counts[l]; r++)
+		{
+			FileResource fileRes;
+			memcpy(&fileRes, bytes + starts[l] + r * sizeof(FileResource), sizeof(FileResource));
+			if (fileRes.NameOffset >= header.StringBytes)
+				return false;
+
+			(*lists[l])[r].Name = strings + fileRes.NameOffset;
+			(*lists[l])[r].BindIndex = fileRes.BindIndex;
+		}
+	}
+
+	*reflection = parsed;
+	return true;
+}
+
+// --------------------------------------------------------
+// Builds the file image: header, fixed size records, then
+// the names they point to
+// --------------------------------------------------------
+void ReflectionSidecar::Serialize(unsigned long long contentHash, const ShaderReflectionData& reflection, std::vector<unsigned char>* data)
+{
+	std::vector<FileConstantBuffer> fileCBs;
+	std::vector<FileVariable> fileVars;
+	std::vector<FileResource> fileResources;
+	std::string strings;
+
+	for (unsigned int b = 0; b < reflection.ConstantBuffers.size(); b++)
+	{
+		const ReflectedConstantBuffer& cb = reflection.ConstantBuffers[b];
+
+		FileConstantBuffer fileCB;
+		fileCB.NameOffset = (unsigned int)strings.size();
+		fileCB.Size = cb.Size;
+		fileCB.BindIndex = cb.BindIndex;
+		fileCB.VariableCount = (unsigned int)cb.Variables.size();
+		fileCBs.push_back(fileCB);
+		strings.append(cb.Name.c_str(), cb.Name.size() + 1);
+
+		for (unsigned int v = 0; v < cb.Variables.size(); v++)
+		{
+			FileVariable fileVar;
+			fileVar.NameOffset = (unsigned int)strings.size();
+			strings.append(cb.Variables[v].Name.c_str(), cb.Variables[v].Name.size() + 1);
+			fileVar.TypeNameOffset = (unsigned int)strings.size();
+			strings.append(cb.Variables[v].TypeName.c_str(), cb.Variables[v].TypeName.size() + 1);
+			fileVar.Elements = cb.Variables[v].Elements;
+			fileVar.ByteOffset = cb.Variables[v].ByteOffset;
+			fileVar.Size = cb.Variables[v].Size;
+			fileVars.push_back(fileVar);
+		}
+	}
+
+	const std::vector<ReflectedResource>* lists[2] = { &reflection.Textures, &reflection.Samplers };
+	for (unsigned int l = 0; l < 2; l++)
+	{
+		for (unsigned int r = 0; r < lists[l]->size(); r++)
+		{
+			FileResource fileRes;
+			fileRes.NameOffset = (unsigned int)strings.size();
+			fileRes.BindIndex = (*lists[l])[r].BindIndex;
+			fileResources.push_back(fileRes);
+			strings.append((*lists[l])[r].Name.c_str(), (*lists[l])[r].Name.size() + 1);
+		}
+	}
+
+	// Always at least one terminator, so the string block is never empty
+	if (strings.empty())
+		strings.push_back('\0');
+
+	FileHeader header;
+	header.Magic = Magic;
+	header.Version = Version;
+	header.ContentHash = contentHash;
+	header.ConstantBufferCount = (unsigned int)fileCBs.size();
+	header.VariableCount = (unsigned int)fileVars.size();
+	header.TextureCount = (unsigned int)reflection.Textures.size();
+	header.SamplerCount = (unsigned int)reflection.Samplers.size();
+	header.StringBytes = (unsigned int)strings.size();
+	header.Padding = 0;
+
+	data->clear();
+	data->reserve(sizeof(FileHeader) +
+		fileCBs.size() * sizeof(FileConstantBuffer) +
+		fileVars.size() * sizeof(FileVariable) +
+		fileResources.size() * sizeof(FileResource) +
+		strings.size());
+
+	const unsigned char* headerBytes = (const unsigned char*)&header;
+	data->insert(data->end(), headerBytes, headerBytes + sizeof(FileHeader));
+	if (!fileCBs.empty())
+		data->insert(data->end(), (const unsigned char*)&fileCBs[0], (const unsigned char*)(&fileCBs[0] + fileCBs.size()));
+	if (!fileVars.empty())
+		data->insert(data->end(), (const unsigned char*)&fileVars[0], (const unsigned char*)(&fileVars[0] + fileVars.size()));
+	if (!fileResources.empty())
+		data->insert(data->end(), (const unsigned char*)&fileResources[0], (const unsigned char*)(&fileResources[0] + fileResources.size()));
+	data->insert(data->end(), strings.begin(), strings.end());
+}
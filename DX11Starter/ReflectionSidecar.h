@@ -0,0 +1,113 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// The parts of a shader's reflection that SimpleShader
+// builds its tables from, in plain (API neutral) types
+// --------------------------------------------------------
+struct ReflectedVariable
+{
+	std::string Name;
+	std::string TypeName;	// HLSL type, like "float4x4" or a struct's name
+	unsigned int Elements;	// Array length, or 0 if not an array
+	unsigned int ByteOffset;
+	unsigned int Size;
+};
+
+struct ReflectedConstantBuffer
+{
+	std::string Name;
+	unsigned int Size;
+	unsigned int BindIndex;
+	std::vector<ReflectedVariable> Variables;
+};
+
+struct ReflectedResource
+{
+	std::string Name;
+	unsigned int BindIndex;
+};
+
+struct ShaderReflectionData
+{
+	std::vector<ReflectedConstantBuffer> ConstantBuffers;
+	std::vector<ReflectedResource> Textures;
+	std::vector<ReflectedResource> Samplers;
+};
+
+// --------------------------------------------------------
+// Reads and writes reflection data as a small binary file
+// next to each compiled shader ("Shader.cso.refl"), so later
+// runs can skip D3DReflect entirely.
+//
+// The file holds a hash of the compiled code it was made
+// from, and is ignored if it doesn't match the .cso.
+//
+// Layout (all values 32 bit, native byte order):
+//   header, constant buffers, variables, resources, strings
+// Names are offsets into the string block.
+//
+// Nothing here touches D3D, so it works (and can be tested)
+// on any platform.
+// --------------------------------------------------------
+class ReflectionSidecar
+{
+public:
+	// Appended to the shader's path to get the sidecar's path
+	static const wchar_t* Extension;
+
+	// 64 bit FNV-1a hash used to tie a sidecar to its shader
+	static unsigned long long Hash(const void* data, size_t size);
+
+	// Maps the sidecar and parses it.  Returns false if it's
+	// missing, damaged or was made from different code.
+	static bool Read(const std::wstring& path, unsigned long long contentHash, ShaderReflectionData* reflection);
+
+	// Writes (or replaces) a sidecar.  Returns false on failure.
+	static bool Write(const std::wstring& path, unsigned long long contentHash, const ShaderReflectionData& reflection);
+
+	// In-memory halves of Read() and Write()
+	static bool Parse(const void* data, size_t size, unsigned long long contentHash, ShaderReflectionData* reflection);
+	static void Serialize(unsigned long long contentHash, const ShaderReflectionData& reflection, std::vector<unsigned char>* data);
+
+private:
+	static const unsigned int Magic = 0x4C464552; // "REFL"
+	static const unsigned int Version = 2;
+
+	struct FileHeader
+	{
+		unsigned int Magic;
+		unsigned int Version;
+		unsigned long long ContentHash;
+		unsigned int ConstantBufferCount;
+		unsigned int VariableCount;
+		unsigned int TextureCount;
+		unsigned int SamplerCount;
+		unsigned int StringBytes;
+		unsigned int Padding;
+	};
+
+	struct FileConstantBuffer
+	{
+		unsigned int NameOffset;
+		unsigned int Size;
+		unsigned int BindIndex;
+		unsigned int VariableCount;
+	};
+
+	struct FileVariable
+	{
+		unsigned int NameOffset;
+		unsigned int TypeNameOffset;
+		unsigned int Elements;
+		unsigned int ByteOffset;
+		unsigned int Size;
+	};
+
+	struct FileResource
+	{
+		unsigned int NameOffset;
+		unsigned int BindIndex;
+	};
+};
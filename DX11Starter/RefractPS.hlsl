@@ -1,9 +1,4 @@
-
-cbuffer externalData : register(b0)
-{
-	matrix view;
-	float3 CameraPosition;
-};
+#include "SharedConstants.hlsli"
 
 
 // Defines the input to this pixel shader
@@ -1,10 +1,9 @@
+#include "SharedConstants.hlsli"
 
 // Constant Buffer for external (C++) data
 cbuffer externalData : register(b0)
 {
 	matrix world;
-	matrix view;
-	matrix projection;
 };
 
 // Struct representing a single vertex worth of data
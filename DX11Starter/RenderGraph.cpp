@@ -0,0 +1,186 @@
+#include "RenderGraph.h"
+
+RenderGraph::RenderGraph()
+{
+	culledCount = 0;
+}
+
+void RenderGraph::Reset()
+{
+	resources.clear();
+	passes.clear();
+	order.clear();
+	culledCount = 0;
+}
+
+int RenderGraph::AddResource(const std::string& name, bool imported, bool depth)
+{
+	RenderGraphResource resource;
+	resource.Name = name;
+	resource.Imported = imported;
+	resource.Depth = depth;
+	resource.Output = false;
+	resource.Desc.Width = 0;
+	resource.Desc.Height = 0;
+	resource.Desc.Format = 0;
+	resource.Desc.BindFlags = 0;
+	resource.FirstUse = -1;
+	resource.LastUse = -1;
+	resources.push_back(resource);
+	return (int)resources.size() - 1;
+}
+
+int RenderGraph::ImportResource(const std::string& name, bool depth)
+{
+	return AddResource(name, true, depth);
+}
+
+int RenderGraph::CreateResource(const std::string& name, const RenderTargetDesc& desc)
+{
+	int resource = AddResource(name, false, false);
+	resources[resource].Desc = desc;
+	return resource;
+}
+
+void RenderGraph::MarkOutput(int resource)
+{
+	if (resource >= 0 && resource < (int)resources.size())
+		resources[resource].Output = true;
+}
+
+int RenderGraph::AddPass(const std::string& name, bool sideEffects)
+{
+	RenderGraphPass pass;
+	pass.Name = name;
+	pass.SideEffects = sideEffects;
+	pass.Live = false;
+	pass.UnbindReads = false;
+	passes.push_back(pass);
+	return (int)passes.size() - 1;
+}
+
+void RenderGraph::Read(int pass, int resource)
+{
+	if (pass >= 0 && pass < (int)passes.size() && resource >= 0 && resource < (int)resources.size())
+		passes[pass].Reads.push_back(resource);
+}
+
+void RenderGraph::Write(int pass, int resource)
+{
+	if (pass >= 0 && pass < (int)passes.size() && resource >= 0 && resource < (int)resources.size())
+		passes[pass].Writes.push_back(resource);
+}
+
+// --------------------------------------------------------
+// Links passes to the writes they depend on, then walks
+// back from the outputs to find which passes are needed
+// --------------------------------------------------------
+void RenderGraph::Compile()
+{
+	order.clear();
+	culledCount = 0;
+
+	// Most recent pass to write each resource, as we go
+	std::vector<int> lastWriter(resources.size(), -1);
+	for (unsigned int p = 0; p < passes.size(); p++)
+	{
+		RenderGraphPass& pass = passes[p];
+		pass.Live = false;
+		pass.UnbindReads = false;
+		pass.Dependencies.clear();
+
+		for (unsigned int r = 0; r < pass.Reads.size(); r++)
+		{
+			if (lastWriter[pass.Reads[r]] >= 0)
+				pass.Dependencies.push_back(lastWriter[pass.Reads[r]]);
+		}
+
+		for (unsigned int w = 0; w < pass.Writes.size(); w++)
+		{
+			if (lastWriter[pass.Writes[w]] >= 0)
+				pass.Dependencies.push_back(lastWriter[pass.Writes[w]]);
+		}
+
+		for (unsigned int w = 0; w < pass.Writes.size(); w++)
+			lastWriter[pass.Writes[w]] = (int)p;
+	}
+
+	// Whatever finally writes an output is needed, and so is
+	// anything it depends on
+	for (unsigned int r = 0; r < resources.size(); r++)
+	{
+		if (resources[r].Output && lastWriter[r] >= 0)
+			MarkLive((unsigned int)lastWriter[r]);
+	}
+
+	for (unsigned int p = 0; p < passes.size(); p++)
+	{
+		if (passes[p].SideEffects)
+			MarkLive(p);
+	}
+
+	// Surviving passes keep their declared order
+	for (unsigned int p = 0; p < passes.size(); p++)
+	{
+		if (passes[p].Live)
+			order.push_back(p);
+		else
+			culledCount++;
+	}
+
+	// Lifetimes, as positions in that order
+	for (unsigned int r = 0; r < resources.size(); r++)
+	{
+		resources[r].FirstUse = -1;
+		resources[r].LastUse = -1;
+	}
+
+	for (unsigned int i = 0; i < order.size(); i++)
+	{
+		const RenderGraphPass& pass = passes[order[i]];
+		for (unsigned int list = 0; list < 2; list++)
+		{
+			const std::vector<int>& used = list == 0 ? pass.Reads : pass.Writes;
+			for (unsigned int u = 0; u < used.size(); u++)
+			{
+				RenderGraphResource& resource = resources[used[u]];
+				if (resource.FirstUse < 0) resource.FirstUse = (int)i;
+				resource.LastUse = (int)i;
+			}
+		}
+	}
+
+	// A texture read here that's bound as a target later (by this
+	// frame's passes, or - for pooled textures - whoever gets its
+	// memory next) has to be unbound once the pass is done
+	for (unsigned int i = 0; i < order.size(); i++)
+	{
+		RenderGraphPass& pass = passes[order[i]];
+		for (unsigned int r = 0; r < pass.Reads.size() && !pass.UnbindReads; r++)
+		{
+			const RenderGraphResource& resource = resources[pass.Reads[r]];
+			if (!resource.Imported)
+				pass.UnbindReads = true;
+
+			for (unsigned int later = i + 1; later < order.size() && !pass.UnbindReads; later++)
+			{
+				const std::vector<int>& writes = passes[order[later]].Writes;
+				for (unsigned int w = 0; w < writes.size(); w++)
+				{
+					if (writes[w] == pass.Reads[r])
+						pass.UnbindReads = true;
+				}
+			}
+		}
+	}
+}
+
+void RenderGraph::MarkLive(unsigned int pass)
+{
+	if (passes[pass].Live)
+		return;
+
+	passes[pass].Live = true;
+	for (unsigned int d = 0; d < passes[pass].Dependencies.size(); d++)
+		MarkLive((unsigned int)passes[pass].Dependencies[d]);
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "RenderTargetAllocator.h"
+
+// --------------------------------------------------------
+// A texture the graph knows about: either imported (owned
+// elsewhere, like the back buffer) or transient (comes from
+// the render target pool for just this frame)
+// --------------------------------------------------------
+struct RenderGraphResource
+{
+	std::string Name;
+	bool Imported;
+	bool Depth;				// Bound as the depth buffer rather than a color target
+	bool Output;			// Must be produced even if nothing reads it
+	RenderTargetDesc Desc;	// Transient only
+	int FirstUse;			// Positions in the compiled order (-1 if unused)
+	int LastUse;
+};
+
+// --------------------------------------------------------
+// A pass and what it touches.  Reads are sampled as
+// textures; writes are bound as targets (and drawn on top
+// of, so a write also depends on the previous write).
+// --------------------------------------------------------
+struct RenderGraphPass
+{
+	std::string Name;
+	std::vector<int> Reads;
+	std::vector<int> Writes;
+	bool SideEffects;		// Never culled
+	bool Live;
+	bool UnbindReads;		// Its textures must come off the pipeline once it's done
+	std::vector<int> Dependencies;
+};
+
+// --------------------------------------------------------
+// Works out which of a frame's passes actually matter and
+// how long each texture has to live.
+//
+// Passes are declared in the order they should run, with
+// the resources they read and write.  Compile() links each
+// read (and write) to the most recent earlier write of the
+// same resource, keeps only passes that lead to an output
+// (or have side effects), and records the first and last
+// surviving pass to use each resource - exactly what the
+// render target pool wants for sharing memory.
+//
+// Because a read always binds to an earlier write, the
+// declared order is already a valid schedule, so culled
+// passes simply drop out of it.
+//
+// Nothing here touches D3D, so it works (and can be tested
+// with made-up passes) on any platform.
+// --------------------------------------------------------
+class RenderGraph
+{
+public:
+	RenderGraph();
+
+	// Forgets every pass and resource
+	void Reset();
+
+	int ImportResource(const std::string& name, bool depth = false);
+	int CreateResource(const std::string& name, const RenderTargetDesc& desc);
+	void MarkOutput(int resource);
+
+	int AddPass(const std::string& name, bool sideEffects = false);
+	void Read(int pass, int resource);
+	void Write(int pass, int resource);
+
+	// Culls, orders and works out lifetimes
+	void Compile();
+
+	// Surviving passes, in the order to run them
+	const std::vector<unsigned int>& GetOrder() { return order; }
+	unsigned int GetCulledCount() { return culledCount; }
+
+	unsigned int GetPassCount() { return (unsigned int)passes.size(); }
+	unsigned int GetResourceCount() { return (unsigned int)resources.size(); }
+	const RenderGraphPass& GetPass(unsigned int pass) { return passes[pass]; }
+	const RenderGraphResource& GetResource(unsigned int resource) { return resources[resource]; }
+
+private:
+	std::vector<RenderGraphResource> resources;
+	std::vector<RenderGraphPass> passes;
+	std::vector<unsigned int> order;
+	unsigned int culledCount;
+
+	int AddResource(const std::string& name, bool imported, bool depth);
+	void MarkLive(unsigned int pass);
+};
@@ -0,0 +1,139 @@
+#include "RenderGraphExecutor.h"
+
+RenderGraphExecutor::RenderGraphExecutor(CommandRecorder* recorder, RenderTargetPool* pool)
+{
+	this->recorder = recorder;
+	this->pool = pool;
+}
+
+void RenderGraphExecutor::BeginFrame()
+{
+	graph.Reset();
+	views.clear();
+	functions.clear();
+	pool->BeginFrame();
+}
+
+int RenderGraphExecutor::ImportTarget(const std::string& name, ID3D11RenderTargetView* rtv, ID3D11ShaderResourceView* srv)
+{
+	ResourceViews resourceViews = { rtv, srv, 0, -1 };
+	views.push_back(resourceViews);
+	return graph.ImportResource(name);
+}
+
+int RenderGraphExecutor::ImportDepth(const std::string& name, ID3D11DepthStencilView* dsv)
+{
+	ResourceViews resourceViews = { 0, 0, dsv, -1 };
+	views.push_back(resourceViews);
+	return graph.ImportResource(name, true);
+}
+
+int RenderGraphExecutor::CreateTarget(const std::string& name, unsigned int width, unsigned int height, DXGI_FORMAT format)
+{
+	RenderTargetDesc desc;
+	desc.Width = width;
+	desc.Height = height;
+	desc.Format = (unsigned int)format;
+	desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+
+	// Only asked for from the pool if a surviving pass uses it
+	ResourceViews resourceViews = { 0, 0, 0, -1 };
+	views.push_back(resourceViews);
+	return graph.CreateResource(name, desc);
+}
+
+int RenderGraphExecutor::AddPass(const std::string& name, PassFunction record, bool sideEffects)
+{
+	functions.push_back(record);
+	return graph.AddPass(name, sideEffects);
+}
+
+// --------------------------------------------------------
+// Compiles, gives the pool each used target's lifetime,
+// then queues the surviving passes in order
+// --------------------------------------------------------
+bool RenderGraphExecutor::Schedule()
+{
+	graph.Compile();
+
+	// Pool passes are numbered by position in the compiled order
+	for (unsigned int r = 0; r < graph.GetResourceCount(); r++)
+	{
+		const RenderGraphResource& resource = graph.GetResource(r);
+		if (resource.Imported || resource.FirstUse < 0)
+			continue;
+
+		int request = pool->Request(resource.Desc.Width, resource.Desc.Height, (DXGI_FORMAT)resource.Desc.Format, resource.Desc.BindFlags);
+		pool->Use(request, (unsigned int)resource.FirstUse);
+		pool->Use(request, (unsigned int)resource.LastUse);
+		views[r].PoolRequest = request;
+	}
+
+	bool result = pool->Allocate();
+
+	for (unsigned int r = 0; r < views.size(); r++)
+	{
+		if (views[r].PoolRequest < 0)
+			continue;
+
+		views[r].RTV = pool->GetRenderTargetView(views[r].PoolRequest);
+		views[r].SRV = pool->GetShaderResourceView(views[r].PoolRequest);
+	}
+
+	const std::vector<unsigned int>& order = graph.GetOrder();
+	for (unsigned int i = 0; i < order.size(); i++)
+	{
+		unsigned int pass = order[i];
+		recorder->AddPass(graph.GetPass(pass).Name, [this, pass](ID3D11DeviceContext* context) {
+			RecordPass(pass, context);
+		});
+	}
+
+	return result;
+}
+
+// --------------------------------------------------------
+// Binds what the pass writes, runs it, then takes its
+// textures back off the pipeline if they're targeted later
+// --------------------------------------------------------
+void RenderGraphExecutor::RecordPass(unsigned int pass, ID3D11DeviceContext* context)
+{
+	const RenderGraphPass& graphPass = graph.GetPass(pass);
+
+	ID3D11RenderTargetView* target = 0;
+	ID3D11DepthStencilView* depth = 0;
+	for (unsigned int w = 0; w < graphPass.Writes.size(); w++)
+	{
+		const ResourceViews& written = views[graphPass.Writes[w]];
+		if (graph.GetResource(graphPass.Writes[w]).Depth)
+			depth = written.DSV;
+		else if (!target)
+			target = written.RTV;
+	}
+
+	if (beginPass)
+		beginPass(context, target, depth);
+
+	functions[pass](context);
+
+	if (graphPass.UnbindReads)
+	{
+		ID3D11ShaderResourceView* nullSRV[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT] = {};
+		context->PSSetShaderResources(0, D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT, nullSRV);
+	}
+}
+
+ID3D11RenderTargetView* RenderGraphExecutor::GetRenderTargetView(int resource)
+{
+	return (resource < 0 || resource >= (int)views.size()) ? 0 : views[resource].RTV;
+}
+
+ID3D11ShaderResourceView* RenderGraphExecutor::GetShaderResourceView(int resource)
+{
+	return (resource < 0 || resource >= (int)views.size()) ? 0 : views[resource].SRV;
+}
+
+ID3D11DepthStencilView* RenderGraphExecutor::GetDepthStencilView(int resource)
+{
+	return (resource < 0 || resource >= (int)views.size()) ? 0 : views[resource].DSV;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <d3d11.h>
+#include <functional>
+#include <string>
+#include <vector>
+#include "RenderGraph.h"
+#include "RenderTargetPool.h"
+#include "CommandRecorder.h"
+
+// --------------------------------------------------------
+// Builds a frame's RenderGraph with D3D attached, then hands
+// the surviving passes to the CommandRecorder.
+//
+// Each frame: BeginFrame(), import the views that live
+// elsewhere, create transient targets, add passes (with the
+// resources they read and write), then Schedule().  Every
+// scheduled pass starts with its written color target and
+// depth buffer bound (through the begin-pass hook, which
+// also sets the viewport etc.), and has its textures
+// unbound when it's done if something else will target
+// them.  Views of transient targets are valid from
+// Schedule() until the next BeginFrame().
+// --------------------------------------------------------
+class RenderGraphExecutor
+{
+public:
+	typedef std::function<void(ID3D11DeviceContext*)> PassFunction;
+	typedef std::function<void(ID3D11DeviceContext*, ID3D11RenderTargetView*, ID3D11DepthStencilView*)> BeginPassFunction;
+
+	RenderGraphExecutor(CommandRecorder* recorder, RenderTargetPool* pool);
+
+	// Called at the start of every scheduled pass with its targets
+	void SetBeginPass(BeginPassFunction beginPass) { this->beginPass = beginPass; }
+
+	void BeginFrame();
+
+	int ImportTarget(const std::string& name, ID3D11RenderTargetView* rtv, ID3D11ShaderResourceView* srv = 0);
+	int ImportDepth(const std::string& name, ID3D11DepthStencilView* dsv);
+	int CreateTarget(const std::string& name, unsigned int width, unsigned int height, DXGI_FORMAT format);
+	void MarkOutput(int resource) { graph.MarkOutput(resource); }
+
+	int AddPass(const std::string& name, PassFunction record, bool sideEffects = false);
+	void Read(int pass, int resource) { graph.Read(pass, resource); }
+	void Write(int pass, int resource) { graph.Write(pass, resource); }
+
+	// Compiles the graph, allocates transient targets and adds
+	// the surviving passes to the recorder.  Returns false if a
+	// target couldn't be created.
+	bool Schedule();
+
+	// Views of a resource (transient ones only after Schedule())
+	ID3D11RenderTargetView* GetRenderTargetView(int resource);
+	ID3D11ShaderResourceView* GetShaderResourceView(int resource);
+	ID3D11DepthStencilView* GetDepthStencilView(int resource);
+
+	RenderGraph* GetGraph() { return &graph; }
+
+private:
+	struct ResourceViews
+	{
+		ID3D11RenderTargetView* RTV;
+		ID3D11ShaderResourceView* SRV;
+		ID3D11DepthStencilView* DSV;
+		int PoolRequest;	// -1 if imported
+	};
+
+	CommandRecorder* recorder;
+	RenderTargetPool* pool;
+	BeginPassFunction beginPass;
+
+	RenderGraph graph;
+	std::vector<ResourceViews> views;		// Indexed by resource
+	std::vector<PassFunction> functions;	// Indexed by pass
+
+	void RecordPass(unsigned int pass, ID3D11DeviceContext* context);
+};
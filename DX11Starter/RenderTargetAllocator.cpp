@@ -0,0 +1,150 @@
+#include "RenderTargetAllocator.h"
+#include <algorithm>
+
+RenderTargetAllocator::RenderTargetAllocator(unsigned int maxIdleFrames)
+{
+	this->maxIdleFrames = maxIdleFrames;
+	stats.SlotsCreated = 0;
+	stats.SlotsReleased = 0;
+	stats.RequestsAliased = 0;
+}
+
+void RenderTargetAllocator::BeginFrame()
+{
+	requests.clear();
+}
+
+int RenderTargetAllocator::Request(const RenderTargetDesc& desc)
+{
+	TargetRequest request;
+	request.Desc = desc;
+	request.FirstPass = -1;
+	request.LastPass = -1;
+	request.Slot = -1;
+	requests.push_back(request);
+	return (int)requests.size() - 1;
+}
+
+void RenderTargetAllocator::Use(int request, unsigned int pass)
+{
+	if (request < 0 || request >= (int)requests.size())
+		return;
+
+	TargetRequest& target = requests[request];
+	if (target.FirstPass < 0 || (int)pass < target.FirstPass) target.FirstPass = (int)pass;
+	if ((int)pass > target.LastPass) target.LastPass = (int)pass;
+}
+
+int RenderTargetAllocator::GetSlot(int request)
+{
+	if (request < 0 || request >= (int)requests.size())
+		return -1;
+
+	return requests[request].Slot;
+}
+
+// --------------------------------------------------------
+// Hands out slots in order of first use, so a slot whose
+// last user is done can go straight to the next request
+// that wants the same desc
+// --------------------------------------------------------
+void RenderTargetAllocator::Allocate(std::vector<unsigned int>* created, std::vector<unsigned int>* released)
+{
+	for (unsigned int s = 0; s < slots.size(); s++)
+		slots[s].BusyUntil = -1;
+
+	// Requests nobody uses don't get a slot
+	std::vector<unsigned int> order;
+	for (unsigned int r = 0; r < requests.size(); r++)
+	{
+		if (requests[r].FirstPass >= 0)
+			order.push_back(r);
+	}
+
+	std::stable_sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b) {
+		return requests[a].FirstPass < requests[b].FirstPass;
+	});
+
+	for (unsigned int i = 0; i < order.size(); i++)
+	{
+		TargetRequest& request = requests[order[i]];
+		int slot = FindSlot(request, created);
+
+		slots[slot].BusyUntil = request.LastPass;
+		slots[slot].IdleFrames = 0;
+		request.Slot = slot;
+	}
+
+	// Let go of anything that hasn't been needed in a while
+	for (unsigned int s = 0; s < slots.size(); s++)
+	{
+		if (!slots[s].Live || slots[s].BusyUntil >= 0)
+			continue;
+
+		slots[s].IdleFrames++;
+		if (slots[s].IdleFrames > maxIdleFrames)
+		{
+			slots[s].Live = false;
+			released->push_back(s);
+			stats.SlotsReleased++;
+		}
+	}
+}
+
+// --------------------------------------------------------
+// A live slot with the same desc that's free by the time
+// the request starts, or else a new one (reusing a dead
+// slot's number if there is one)
+// --------------------------------------------------------
+int RenderTargetAllocator::FindSlot(const TargetRequest& request, std::vector<unsigned int>* created)
+{
+	int freeNumber = -1;
+	for (unsigned int s = 0; s < slots.size(); s++)
+	{
+		if (!slots[s].Live)
+		{
+			if (freeNumber < 0) freeNumber = (int)s;
+			continue;
+		}
+
+		if (slots[s].Desc == request.Desc && slots[s].BusyUntil < request.FirstPass)
+		{
+			if (slots[s].BusyUntil >= 0)
+				stats.RequestsAliased++;
+			return (int)s;
+		}
+	}
+
+	if (freeNumber < 0)
+	{
+		freeNumber = (int)slots.size();
+		slots.push_back(Slot());
+	}
+
+	Slot& slot = slots[freeNumber];
+	slot.Desc = request.Desc;
+	slot.Live = true;
+	slot.IdleFrames = 0;
+	slot.BusyUntil = -1;
+
+	created->push_back((unsigned int)freeNumber);
+	stats.SlotsCreated++;
+	return freeNumber;
+}
+
+void RenderTargetAllocator::ReleaseAll(std::vector<unsigned int>* released)
+{
+	for (unsigned int s = 0; s < slots.size(); s++)
+	{
+		if (!slots[s].Live)
+			continue;
+
+		slots[s].Live = false;
+		released->push_back(s);
+		stats.SlotsReleased++;
+	}
+
+	// Handles from this frame no longer point anywhere
+	for (unsigned int r = 0; r < requests.size(); r++)
+		requests[r].Slot = -1;
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <vector>
+
+// --------------------------------------------------------
+// What a transient render target has to be.  Format and
+// bind flags are the raw DXGI_FORMAT / D3D11_BIND_FLAG
+// values, so this doesn't need any D3D headers.
+// --------------------------------------------------------
+struct RenderTargetDesc
+{
+	unsigned int Width;
+	unsigned int Height;
+	unsigned int Format;
+	unsigned int BindFlags;
+
+	bool operator==(const RenderTargetDesc& other) const
+	{
+		return Width == other.Width && Height == other.Height &&
+			Format == other.Format && BindFlags == other.BindFlags;
+	}
+};
+
+// --------------------------------------------------------
+// Allocation counters (since creation)
+// --------------------------------------------------------
+struct RenderTargetAllocatorStats
+{
+	unsigned int SlotsCreated;
+	unsigned int SlotsReleased;
+	unsigned int RequestsAliased;	// Requests that shared a slot with an earlier one in the same frame
+};
+
+// --------------------------------------------------------
+// Decides which physical textures ("slots") a frame's
+// transient render targets live in.
+//
+// Each frame, targets are requested by desc and marked with
+// the passes that use them.  Allocate() then gives every
+// request a slot with the same desc, sharing slots between
+// requests whose pass ranges don't overlap, and only asking
+// for new slots when nothing free fits.  Slots survive from
+// frame to frame, and are released once they've gone unused
+// for a few frames (or all at once by ReleaseAll(), like
+// when the window is resized).
+//
+// Only slot numbers are handed out - the owner creates and
+// releases the actual textures as told.  Nothing here
+// touches D3D, so it works (and can be tested) on any
+// platform.
+// --------------------------------------------------------
+class RenderTargetAllocator
+{
+public:
+	RenderTargetAllocator(unsigned int maxIdleFrames = 3);
+
+	// Starts a new frame's list of requests (old handles become invalid)
+	void BeginFrame();
+
+	// Adds a request and returns its handle.  Nothing is
+	// allocated until Allocate().
+	int Request(const RenderTargetDesc& desc);
+
+	// Records that a pass (by index, in execution order) uses a
+	// request.  A request lives from its first to its last use.
+	void Use(int request, unsigned int pass);
+
+	// Assigns every request a slot.  created gets slots that need
+	// a new texture, released gets slots whose texture should go.
+	void Allocate(std::vector<unsigned int>* created, std::vector<unsigned int>* released);
+
+	// Gives up every slot (released gets the live ones)
+	void ReleaseAll(std::vector<unsigned int>* released);
+
+	// Slot a request ended up in, or -1 before Allocate()
+	int GetSlot(int request);
+
+	// Slot bookkeeping for the owner
+	unsigned int GetSlotCount() { return (unsigned int)slots.size(); }
+	const RenderTargetDesc& GetSlotDesc(unsigned int slot) { return slots[slot].Desc; }
+	bool IsSlotLive(unsigned int slot) { return slots[slot].Live; }
+
+	RenderTargetAllocatorStats GetStats() { return stats; }
+
+private:
+	struct Slot
+	{
+		RenderTargetDesc Desc;
+		bool Live;
+		unsigned int IdleFrames;
+		int BusyUntil;		// Last pass using it this frame (-1 if free all frame)
+	};
+
+	struct TargetRequest
+	{
+		RenderTargetDesc Desc;
+		int FirstPass;		// -1 if never used
+		int LastPass;
+		int Slot;
+	};
+
+	unsigned int maxIdleFrames;
+	std::vector<Slot> slots;
+	std::vector<TargetRequest> requests;
+	RenderTargetAllocatorStats stats;
+
+	int FindSlot(const TargetRequest& request, std::vector<unsigned int>* created);
+};
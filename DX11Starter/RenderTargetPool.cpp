@@ -0,0 +1,139 @@
+#include "RenderTargetPool.h"
+
+RenderTargetPool::RenderTargetPool(ID3D11Device* device)
+{
+	this->device = device;
+}
+
+RenderTargetPool::~RenderTargetPool()
+{
+	for (unsigned int i = 0; i < targets.size(); i++)
+		ReleaseTarget(i);
+}
+
+void RenderTargetPool::BeginFrame()
+{
+	allocator.BeginFrame();
+}
+
+int RenderTargetPool::Request(unsigned int width, unsigned int height, DXGI_FORMAT format, unsigned int bindFlags)
+{
+	RenderTargetDesc desc;
+	desc.Width = width;
+	desc.Height = height;
+	desc.Format = (unsigned int)format;
+	desc.BindFlags = bindFlags;
+	return allocator.Request(desc);
+}
+
+void RenderTargetPool::Use(int request, unsigned int pass)
+{
+	allocator.Use(request, pass);
+}
+
+// --------------------------------------------------------
+// Lets the allocator pick slots, then makes the textures
+// match: old ones go first so their memory can be reused
+// --------------------------------------------------------
+bool RenderTargetPool::Allocate()
+{
+	std::vector<unsigned int> created;
+	std::vector<unsigned int> released;
+	allocator.Allocate(&created, &released);
+
+	for (unsigned int i = 0; i < released.size(); i++)
+		ReleaseTarget(released[i]);
+
+	bool result = true;
+	for (unsigned int i = 0; i < created.size(); i++)
+		result = CreateTarget(created[i]) && result;
+
+	return result;
+}
+
+void RenderTargetPool::ReleaseAll()
+{
+	std::vector<unsigned int> released;
+	allocator.ReleaseAll(&released);
+
+	for (unsigned int i = 0; i < released.size(); i++)
+		ReleaseTarget(released[i]);
+}
+
+ID3D11RenderTargetView* RenderTargetPool::GetRenderTargetView(int request)
+{
+	int slot = allocator.GetSlot(request);
+	return slot < 0 ? 0 : targets[slot].RTV;
+}
+
+ID3D11ShaderResourceView* RenderTargetPool::GetShaderResourceView(int request)
+{
+	int slot = allocator.GetSlot(request);
+	return slot < 0 ? 0 : targets[slot].SRV;
+}
+
+// --------------------------------------------------------
+// A single mip, non-MSAA texture with whichever views its
+// bind flags allow
+// --------------------------------------------------------
+bool RenderTargetPool::CreateTarget(unsigned int slot)
+{
+	if (targets.size() <= slot)
+	{
+		Target empty = {};
+		targets.resize(slot + 1, empty);
+	}
+
+	const RenderTargetDesc& desc = allocator.GetSlotDesc(slot);
+	Target& target = targets[slot];
+
+	D3D11_TEXTURE2D_DESC texDesc = {};
+	texDesc.Width = desc.Width;
+	texDesc.Height = desc.Height;
+	texDesc.MipLevels = 1;
+	texDesc.ArraySize = 1;
+	texDesc.Format = (DXGI_FORMAT)desc.Format;
+	texDesc.SampleDesc.Count = 1;
+	texDesc.SampleDesc.Quality = 0;
+	texDesc.Usage = D3D11_USAGE_DEFAULT;
+	texDesc.BindFlags = desc.BindFlags;
+	texDesc.CPUAccessFlags = 0;
+	texDesc.MiscFlags = 0;
+	if (device->CreateTexture2D(&texDesc, 0, &target.Texture) != S_OK)
+	{
+		target.Texture = 0;
+		return false;
+	}
+
+	if (desc.BindFlags & D3D11_BIND_RENDER_TARGET)
+	{
+		D3D11_RENDER_TARGET_VIEW_DESC rtvDesc = {};
+		rtvDesc.Format = texDesc.Format;
+		rtvDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
+		rtvDesc.Texture2D.MipSlice = 0;
+		device->CreateRenderTargetView(target.Texture, &rtvDesc, &target.RTV);
+	}
+
+	if (desc.BindFlags & D3D11_BIND_SHADER_RESOURCE)
+	{
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+		srvDesc.Format = texDesc.Format;
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+		srvDesc.Texture2D.MipLevels = 1;
+		srvDesc.Texture2D.MostDetailedMip = 0;
+		device->CreateShaderResourceView(target.Texture, &srvDesc, &target.SRV);
+	}
+
+	return true;
+}
+
+void RenderTargetPool::ReleaseTarget(unsigned int slot)
+{
+	if (slot >= targets.size())
+		return;
+
+	Target& target = targets[slot];
+	if (target.RTV) { target.RTV->Release(); target.RTV = 0; }
+	if (target.SRV) { target.SRV->Release(); target.SRV = 0; }
+	if (target.Texture) { target.Texture->Release(); target.Texture = 0; }
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <d3d11.h>
+#include <vector>
+#include "RenderTargetAllocator.h"
+
+// --------------------------------------------------------
+// Transient render targets, handed out per frame.
+//
+// Each frame: BeginFrame(), Request() what the frame needs,
+// Use() each target from the passes that draw to or read
+// from it, then Allocate() before the passes record.  Views
+// are valid from Allocate() until the next BeginFrame().
+//
+// Targets with the same size, format and bind flags whose
+// passes don't overlap share one texture, so their contents
+// are undefined at the start of their first pass - clear
+// them there.  Call ReleaseAll() when the window resizes;
+// the next frame's requests rebuild at the new size.
+//
+// D3D11 can't place different formats in the same memory,
+// so only identical targets alias.
+// --------------------------------------------------------
+class RenderTargetPool
+{
+public:
+	RenderTargetPool(ID3D11Device* device);
+	~RenderTargetPool();
+
+	void BeginFrame();
+	int Request(unsigned int width, unsigned int height, DXGI_FORMAT format, unsigned int bindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE);
+	void Use(int request, unsigned int pass);
+
+	// Creates (and releases) textures as needed.  Returns false
+	// if any texture couldn't be created.
+	bool Allocate();
+
+	void ReleaseAll();
+
+	// Views of a request's texture (null if it has no such view)
+	ID3D11RenderTargetView* GetRenderTargetView(int request);
+	ID3D11ShaderResourceView* GetShaderResourceView(int request);
+
+	RenderTargetAllocatorStats GetStats() { return allocator.GetStats(); }
+
+private:
+	struct Target
+	{
+		ID3D11Texture2D* Texture;
+		ID3D11RenderTargetView* RTV;
+		ID3D11ShaderResourceView* SRV;
+	};
+
+	ID3D11Device* device;
+	RenderTargetAllocator allocator;
+	std::vector<Target> targets;	// Indexed by the allocator's slots
+
+	bool CreateTarget(unsigned int slot);
+	void ReleaseTarget(unsigned int slot);
+};
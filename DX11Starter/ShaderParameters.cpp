@@ -0,0 +1,73 @@
+#include "ShaderParameters.h"
+#include <string.h>
+
+bool ShaderNameTable::Add(const std::string& name, int index)
+{
+	if (!names.insert(std::pair<std::string, int>(name, index)).second)
+		return false;
+
+	std::pair<std::unordered_map<unsigned int, int>::iterator, bool> result =
+		hashes.insert(std::pair<unsigned int, int>(SimpleShaderHash(name.c_str()), index));
+
+	if (!result.second)
+		result.first->second = InvalidIndex;
+
+	return true;
+}
+
+int ShaderNameTable::Find(const std::string& name) const
+{
+	std::unordered_map<std::string, int>::const_iterator result = names.find(name);
+	return result == names.end() ? InvalidIndex : result->second;
+}
+
+int ShaderNameTable::Find(unsigned int nameHash) const
+{
+	std::unordered_map<unsigned int, int>::const_iterator result = hashes.find(nameHash);
+	return result == hashes.end() ? InvalidIndex : result->second;
+}
+
+bool ShaderVariableTable::Add(const std::string& name, const SimpleShaderVariable& variable)
+{
+	if (!names.Add(name, (int)variables.size()))
+		return false;
+
+	variables.push_back(variable);
+	return true;
+}
+
+const SimpleShaderVariable* ShaderVariableTable::Find(const std::string& name, int size) const
+{
+	return Find(names.Find(name), size);
+}
+
+const SimpleShaderVariable* ShaderVariableTable::Find(int handle, int size) const
+{
+	if (handle < 0 || handle >= (int)variables.size())
+		return 0;
+
+	const SimpleShaderVariable* variable = &variables[handle];
+	if (size > 0 && variable->Size != (unsigned int)size)
+		return 0;
+
+	return variable;
+}
+
+// --------------------------------------------------------
+// Nothing to do if the data is already there (the same
+// view, projection and light data gets set over and over)
+// --------------------------------------------------------
+void ShaderVariableTable::Write(SimpleLocalBufferData* buffer, const SimpleShaderVariable& variable, const void* data, unsigned int size)
+{
+	unsigned char* dest = buffer->LocalDataBuffer + variable.ByteOffset;
+	if (memcmp(dest, data, size) == 0)
+		return;
+
+	memcpy(dest, data, size);
+
+	if (variable.ByteOffset < buffer->DirtyStart)
+		buffer->DirtyStart = variable.ByteOffset;
+	if (variable.ByteOffset + size > buffer->DirtyEnd)
+		buffer->DirtyEnd = variable.ByteOffset + size;
+	buffer->SliceDirty = true;
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// --------------------------------------------------------
+// FNV-1a hash of a variable or resource name.  It's
+// constexpr, so handles can be looked up by a hash that
+// was computed at compile time:
+//
+//   int h = vs->GetVariableHandle(SimpleShaderHash("world"));
+// --------------------------------------------------------
+constexpr unsigned int SimpleShaderHash(const char* name, unsigned int hash = 2166136261u)
+{
+	return *name == 0 ? hash : SimpleShaderHash(name + 1, (hash ^ (unsigned char)*name) * 16777619u);
+}
+
+// --------------------------------------------------------
+// Used by simple shaders to store information about
+// specific variables in constant buffers
+// --------------------------------------------------------
+struct SimpleShaderVariable
+{
+	unsigned int ByteOffset;
+	unsigned int Size;
+	unsigned int ConstantBufferIndex;
+};
+
+// --------------------------------------------------------
+// The CPU side of one shader object's constant buffer:
+// its local copy of the data, and what's changed since it
+// was last uploaded
+// --------------------------------------------------------
+struct SimpleLocalBufferData
+{
+	unsigned int Size;
+	unsigned char* LocalDataBuffer;
+
+	// Bytes of local data that have changed since the GPU copy
+	// was last updated (empty when DirtyStart >= DirtyEnd), and
+	// whether it changed since the current frame slice was taken
+	unsigned int DirtyStart;
+	unsigned int DirtyEnd;
+	bool SliceDirty;
+};
+
+// --------------------------------------------------------
+// Name -> index, by the name itself or by its
+// SimpleShaderHash().  If two names share a hash, that hash
+// is marked invalid so nobody gets the wrong index (looking
+// up by name still works).
+// --------------------------------------------------------
+class ShaderNameTable
+{
+public:
+	static const int InvalidIndex = -1;
+
+	// Returns false (and keeps the first) if name is already here
+	bool Add(const std::string& name, int index);
+
+	int Find(const std::string& name) const;
+	int Find(unsigned int nameHash) const;
+
+private:
+	std::unordered_map<std::string, int> names;
+	std::unordered_map<unsigned int, int> hashes;
+};
+
+// --------------------------------------------------------
+// A shader program's constant buffer variables.  A
+// variable's handle is its index here, so setting through
+// a handle is a bounds check and a copy, while setting by
+// name costs a string hash and a map lookup every time.
+// --------------------------------------------------------
+class ShaderVariableTable
+{
+public:
+	// Returns false (and keeps the first) if there's already
+	// a variable by that name
+	bool Add(const std::string& name, const SimpleShaderVariable& variable);
+
+	int GetHandle(const std::string& name) const { return names.Find(name); }
+	int GetHandle(unsigned int nameHash) const { return names.Find(nameHash); }
+	unsigned int GetCount() const { return (unsigned int)variables.size(); }
+
+	// Null if there's no such variable, or if size is above
+	// zero and isn't the variable's size
+	const SimpleShaderVariable* Find(const std::string& name, int size) const;
+	const SimpleShaderVariable* Find(int handle, int size) const;
+
+	// Copies data into the variable's spot in buffers[its
+	// ConstantBufferIndex].  Buffer is SimpleLocalBufferData
+	// or something built on it.  Returns false if there's no
+	// such variable or the size is wrong.
+	template<typename Buffer> bool SetData(const std::string& name, Buffer* buffers, const void* data, unsigned int size) const;
+	template<typename Buffer> bool SetData(int handle, Buffer* buffers, const void* data, unsigned int size) const;
+
+	// Writes one variable's data into its buffer, growing the
+	// dirty range (unless the data is already there)
+	static void Write(SimpleLocalBufferData* buffer, const SimpleShaderVariable& variable, const void* data, unsigned int size);
+
+private:
+	std::vector<SimpleShaderVariable> variables;
+	ShaderNameTable names;
+};
+
+template<typename Buffer>
+bool ShaderVariableTable::SetData(const std::string& name, Buffer* buffers, const void* data, unsigned int size) const
+{
+	const SimpleShaderVariable* variable = Find(name, (int)size);
+	if (!variable)
+		return false;
+
+	Write(&buffers[variable->ConstantBufferIndex], *variable, data, size);
+	return true;
+}
+
+template<typename Buffer>
+bool ShaderVariableTable::SetData(int handle, Buffer* buffers, const void* data, unsigned int size) const
+{
+	const SimpleShaderVariable* variable = Find(handle, (int)size);
+	if (!variable)
+		return false;
+
+	Write(&buffers[variable->ConstantBufferIndex], *variable, data, size);
+	return true;
+}
@@ -0,0 +1,53 @@
+#include "SharedConstants.h"
+#include "SimpleShader.h"
+
+const char* SharedConstants::PerFrameName = "perFrame";
+const char* SharedConstants::PerPassName = "perPass";
+
+SharedConstants::SharedConstants(ID3D11Device* device)
+{
+	perFrameBuffer = CreateBuffer(device, sizeof(PerFrameConstants));
+	perPassBuffer = CreateBuffer(device, sizeof(PerPassConstants));
+
+	// Shaders loaded from now on leave these buffers to us
+	ISimpleShader::AddSharedConstantBuffer(PerFrameName);
+	ISimpleShader::AddSharedConstantBuffer(PerPassName);
+}
+
+SharedConstants::~SharedConstants()
+{
+	if (perFrameBuffer) perFrameBuffer->Release();
+	if (perPassBuffer) perPassBuffer->Release();
+}
+
+// --------------------------------------------------------
+// Makes a default usage constant buffer, rounding the size
+// up to the 16 byte multiple D3D requires
+// --------------------------------------------------------
+ID3D11Buffer* SharedConstants::CreateBuffer(ID3D11Device* device, unsigned int size)
+{
+	D3D11_BUFFER_DESC desc = {};
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.ByteWidth = (size + 15) & ~15;
+	desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+
+	ID3D11Buffer* buffer = 0;
+	device->CreateBuffer(&desc, 0, &buffer);
+	return buffer;
+}
+
+void SharedConstants::UpdatePerFrame(ID3D11DeviceContext* context, const PerFrameConstants& data)
+{
+	context->UpdateSubresource(perFrameBuffer, 0, 0, &data, 0, 0);
+}
+
+void SharedConstants::BeginPass(ID3D11DeviceContext* context, const PerPassConstants& data)
+{
+	context->UpdateSubresource(perPassBuffer, 0, 0, &data, 0, 0);
+
+	// Deferred contexts start every pass with nothing bound
+	context->VSSetConstantBuffers(PerFrameRegister, 1, &perFrameBuffer);
+	context->VSSetConstantBuffers(PerPassRegister, 1, &perPassBuffer);
+	context->PSSetConstantBuffers(PerFrameRegister, 1, &perFrameBuffer);
+	context->PSSetConstantBuffers(PerPassRegister, 1, &perPassBuffer);
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <d3d11.h>
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// CPU side of the perFrame buffer in SharedConstants.hlsli
+// (must match it exactly, including 16 byte packing)
+// --------------------------------------------------------
+struct PerFrameConstants
+{
+	DirectX::XMFLOAT4X4 View;
+	DirectX::XMFLOAT4X4 Projection;
+	DirectX::XMFLOAT4X4 CausticView;
+	DirectX::XMFLOAT4X4 CausticProjection;
+	DirectX::XMFLOAT3 CameraPosition;
+	float Time;
+};
+
+// --------------------------------------------------------
+// CPU side of the perPass buffer in SharedConstants.hlsli
+// --------------------------------------------------------
+struct PerPassConstants
+{
+	DirectX::XMFLOAT2 TargetSize;
+	DirectX::XMFLOAT2 InverseTargetSize;
+};
+
+// --------------------------------------------------------
+// Owns the constant buffers every shader shares, so data
+// that's the same for every draw (camera, time, etc.) is
+// uploaded once instead of into each material's buffers.
+//
+// Per-frame data is updated on the immediate context before
+// any pass runs.  Per-pass data is updated by each pass on
+// its own context, so it lands in that pass's command list.
+// --------------------------------------------------------
+class SharedConstants
+{
+public:
+	SharedConstants(ID3D11Device* device);
+	~SharedConstants();
+
+	// Fixed registers (and names) used by every shader
+	static const unsigned int PerFrameRegister = 1;
+	static const unsigned int PerPassRegister = 2;
+	static const char* PerFrameName;
+	static const char* PerPassName;
+
+	// Once per frame, before any pass records or executes
+	void UpdatePerFrame(ID3D11DeviceContext* context, const PerFrameConstants& data);
+
+	// At the start of every pass - updates the per-pass
+	// buffer and binds both buffers to the given context
+	void BeginPass(ID3D11DeviceContext* context, const PerPassConstants& data);
+
+private:
+	ID3D11Buffer* perFrameBuffer;
+	ID3D11Buffer* perPassBuffer;
+
+	ID3D11Buffer* CreateBuffer(ID3D11Device* device, unsigned int size);
+};
@@ -0,0 +1,33 @@
+#ifndef SHARED_CONSTANTS_HLSLI
+#define SHARED_CONSTANTS_HLSLI
+
+// Constant buffers shared by every shader, split up by how often
+// they change.  SimpleShader recognizes them by name and leaves them
+// alone - the game fills and binds them itself (see SharedConstants.h,
+// which has to match these layouts exactly).
+//
+// Anything that changes per object goes in the shader's own
+// externalData buffer at register b0.
+
+// Changes once per frame
+cbuffer perFrame : register(b1)
+{
+	matrix view;
+	matrix projection;
+
+	// view and projection of the caustic light's point of origin
+	matrix causticView;
+	matrix causticProjection;
+
+	float3 CameraPosition;
+	float time;
+};
+
+// Changes once per render pass
+cbuffer perPass : register(b2)
+{
+	float2 targetSize;
+	float2 inverseTargetSize;
+};
+
+#endif
@@ -1,9 +1,31 @@
 #include "SimpleShader.h"
+#include "InputLayoutCache.h"
+#include <cstdio>
+#include <map>
 
 ///////////////////////////////////////////////////////////////////////////////
 // ------ BASE SIMPLE SHADER --------------------------------------------------
 ///////////////////////////////////////////////////////////////////////////////
 
+// Shared frame upload buffer (null means every shader uses its own buffers)
+FrameUploadBuffer* ISimpleShader::frameUpload = 0;
+
+// Names of constant buffers the game fills and binds itself
+std::unordered_set<std::string> ISimpleShader::sharedBufferNames;
+
+// Programs shared between shader objects, and totals for them
+std::unordered_map<std::wstring, SimpleShaderProgram*> ISimpleShader::programCache;
+SimpleShaderProgramStats ISimpleShader::programStats = {};
+
+// C++ cbuffer structs every shader is checked against
+std::vector<ConstantBufferLayout> ISimpleShader::registeredLayouts;
+
+// Upload counters
+std::atomic<unsigned long long> ISimpleShader::statUploads(0);
+std::atomic<unsigned long long> ISimpleShader::statUploadsSkipped(0);
+std::atomic<unsigned long long> ISimpleShader::statBytesUploaded(0);
+std::atomic<unsigned long long> ISimpleShader::statBytesSaved(0);
+
 // --------------------------------------------------------
 // Constructor accepts DirectX device & context
 // --------------------------------------------------------
@@ -11,12 +33,15 @@ ISimpleShader::ISimpleShader(ID3D11Device* device, ID3D11DeviceContext* context)
 {
 	// Save the device
 	this->device = device;
-	this->deviceContext = context;
+	this->deviceContext = 0;
+	this->deviceContext1 = 0;
+	SetDeviceContext(context);
 
 	// Set up fields
+	shaderValid = false;
+	program = 0;
 	constantBufferCount = 0;
 	constantBuffers = 0;
-	shaderBlob = 0;
 }
 
 // --------------------------------------------------------
@@ -25,40 +50,75 @@ ISimpleShader::ISimpleShader(ID3D11Device* device, ID3D11DeviceContext* context)
 ISimpleShader::~ISimpleShader()
 {
 	// Derived class destructors will call this class's CleanUp method
-	if(shaderBlob)
-		shaderBlob->Release();
 }
 
 // --------------------------------------------------------
-// Cleans up the variable table and buffers - Some things will
-// be handled by derived classes
+// Points this shader at a different context (such as a
+// deferred context used to record a single render pass)
+// --------------------------------------------------------
+void ISimpleShader::SetDeviceContext(ID3D11DeviceContext* context)
+{
+	if (context == deviceContext)
+		return;
+
+	deviceContext = context;
+
+	// Grab the 11.1 interface (if any) for binding buffer slices.
+	// The context itself holds the reference, so don't keep ours.
+	deviceContext1 = 0;
+	if (context && context->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)&deviceContext1) == S_OK)
+		deviceContext1->Release();
+	else
+		deviceContext1 = 0;
+}
+
+// --------------------------------------------------------
+// Cleans up this shader's buffers and lets go of the
+// program - Some things will be handled by derived classes
 // --------------------------------------------------------
 void ISimpleShader::CleanUp()
 {
 	// Handle constant buffers and local data buffers
 	for (unsigned int i = 0; i < constantBufferCount; i++)
 	{
-		constantBuffers[i].ConstantBuffer->Release();
+		if (constantBuffers[i].ConstantBuffer)
+			constantBuffers[i].ConstantBuffer->Release();
 		delete[] constantBuffers[i].LocalDataBuffer;
 	}
 
 	if (constantBuffers)
 	{
 		delete[] constantBuffers;
+		constantBuffers = 0;
 		constantBufferCount = 0;
 	}
 
-	for (unsigned int i = 0; i < shaderResourceViews.size(); i++)
-		delete shaderResourceViews[i];
-	
-	for (unsigned int i = 0; i < samplerStates.size(); i++)
-		delete samplerStates[i];
+	// The program goes away with its last user
+	if (program)
+	{
+		ReleaseProgram(program);
+		program = 0;
+	}
 
-	// Clean up tables
-	varTable.clear();
-	cbTable.clear();
-	samplerTable.clear();
-	textureTable.clear();
+	shaderValid = false;
+}
+
+// --------------------------------------------------------
+// Drops one reference to a program, destroying it (and
+// taking it out of the cache) when nobody is using it
+// --------------------------------------------------------
+void ISimpleShader::ReleaseProgram(SimpleShaderProgram* target)
+{
+	if (--target->RefCount > 0)
+		return;
+
+	if (target->Cached)
+		programCache.erase(target->Key);
+
+	if (target->InputLayout) target->InputLayout->Release();
+	if (target->Shader) target->Shader->Release();
+	if (target->Blob) target->Blob->Release();
+	delete target;
 }
 
 // --------------------------------------------------------
@@ -66,27 +126,130 @@ void ISimpleShader::CleanUp()
 // reflection.  This must be a separate step from the constructor since
 // we can't invoke derived class overrides in the base class constructor.
 //
+// If another shader object of the same type already loaded this file
+// (and it hasn't changed), the compiled shader, input layout and
+// reflection tables are shared with it - only the constant buffers
+// themselves are per object.
+//
 // shaderFile - A "wide string" specifying the compiled shader to load
 // 
 // Returns true if shader is loaded properly, false otherwise
 // --------------------------------------------------------
 bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 {
+	LARGE_INTEGER start, end, frequency;
+	QueryPerformanceCounter(&start);
+	programStats.Loads++;
+
+	// Loading a second time replaces everything
+	if (program)
+		CleanUp();
+
 	// Load the shader to a blob and ensure it worked
+	ID3DBlob* shaderBlob = 0;
 	HRESULT hr = D3DReadFileToBlob(shaderFile, &shaderBlob);
 	if (hr != S_OK)
 	{
 		return false;
 	}
 
-	// Create the shader - Calls an overloaded version of this abstract
-	// method in the appropriate child class
-	shaderValid = CreateShader(shaderBlob);
-	if (!shaderValid)
+	// Programs are keyed by the stage (class) and path, and
+	// only reused if the code itself is the same
+	std::string stage = typeid(*this).name();
+	std::wstring key = std::wstring(stage.begin(), stage.end()) + L"|" + shaderFile;
+	unsigned long long contentHash = ReflectionSidecar::Hash(shaderBlob->GetBufferPointer(), shaderBlob->GetBufferSize());
+
+	std::unordered_map<std::wstring, SimpleShaderProgram*>::iterator cached = programCache.find(key);
+	if (cached != programCache.end() &&
+		cached->second->ContentHash == contentHash &&
+		AdoptShader(cached->second))
 	{
-		return false;
+		// Share the existing program
+		program = cached->second;
+		program->RefCount++;
+		shaderBlob->Release();
+
+		programStats.ProgramsShared++;
+		programStats.BytesShared += program->Blob->GetBufferSize() +
+			program->Variables.GetCount() * sizeof(SimpleShaderVariable) +
+			program->ConstantBuffers.size() * sizeof(SimpleConstantBuffer) +
+			program->ShaderResourceViews.size() * sizeof(SimpleSRV) +
+			program->SamplerStates.size() * sizeof(SimpleSampler);
 	}
+	else
+	{
+		// Start a new program - CreateShader() may store stage
+		// specific things (like an input layout) in it
+		program = new SimpleShaderProgram();
+		program->RefCount = 1;
+		program->Cached = false;
+		program->Key = key;
+		program->ContentHash = contentHash;
+		program->Blob = shaderBlob;
+		program->Shader = 0;
+		program->InputLayout = 0;
+		program->PerInstanceCompatible = false;
+
+		// Create the shader - Calls an overloaded version of this abstract
+		// method in the appropriate child class
+		if (!CreateShader(shaderBlob))
+		{
+			CleanUp();
+			return false;
+		}
+
+		program->Shader = GetShaderObject();
+		program->Shader->AddRef();
+
+		// Use the reflection saved by an earlier run if it's for this
+		// exact code, otherwise reflect now and save it for next time
+		std::wstring sidecarPath = std::wstring(shaderFile) + ReflectionSidecar::Extension;
+		ShaderReflectionData reflection;
+		if (ReflectionSidecar::Read(sidecarPath, contentHash, &reflection))
+			programStats.SidecarsLoaded++;
+		else
+		{
+			ReflectShader(shaderBlob, &reflection);
+			if (ReflectionSidecar::Write(sidecarPath, contentHash, reflection))
+				programStats.SidecarsWritten++;
+		}
+
+		BuildProgramTables(program, reflection);
+		program->Reflection = reflection;
+		programStats.ProgramsCreated++;
+
+		// A C++ struct that disagrees with the shader would silently
+		// write garbage, so refuse to load instead
+		if (!VerifyConstantBufferLayouts(shaderFile))
+		{
+			CleanUp();
+			return false;
+		}
+
+		// Newer code replaces an older program under the same key (the
+		// older one lives on until the shaders using it are done)
+		if (cached != programCache.end())
+			cached->second->Cached = false;
+		programCache[key] = program;
+		program->Cached = true;
+	}
+
+	// Each shader object gets its own buffers
+	CreateConstantBuffers();
+	shaderValid = true;
+
+	QueryPerformanceCounter(&end);
+	QueryPerformanceFrequency(&frequency);
+	programStats.LoadMilliseconds += (end.QuadPart - start.QuadPart) * 1000.0 / frequency.QuadPart;
+	return true;
+}
 
+// --------------------------------------------------------
+// Pulls what we need out of the shader's reflection: its
+// constant buffers and their variables, SRVs and samplers
+// --------------------------------------------------------
+void ISimpleShader::ReflectShader(ID3DBlob* shaderBlob, ShaderReflectionData* reflection)
+{
 	// Set up shader reflection to get information about
 	// this shader and its variables,  buffers, etc.
 	ID3D11ShaderReflection* refl;
@@ -100,10 +263,6 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 	D3D11_SHADER_DESC shaderDesc;
 	refl->GetDesc(&shaderDesc);
 
-	// Create resource arrays
-	constantBufferCount = shaderDesc.ConstantBuffers;
-	constantBuffers = new SimpleConstantBuffer[constantBufferCount];
-	
 	// Handle bound resources (like shaders and samplers)
 	unsigned int resourceCount = shaderDesc.BoundResources;
 	for (unsigned int r = 0; r < resourceCount; r++)
@@ -112,37 +271,26 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		D3D11_SHADER_INPUT_BIND_DESC resourceDesc;
 		refl->GetResourceBindingDesc(r, &resourceDesc);
 
+		ReflectedResource resource;
+		resource.Name = resourceDesc.Name;
+		resource.BindIndex = resourceDesc.BindPoint;
+
 		// Check the type
 		switch (resourceDesc.Type)
 		{
 		case D3D_SIT_TEXTURE: // A texture resource
-		{
-			// Create the SRV wrapper
-			SimpleSRV* srv = new SimpleSRV();
-			srv->BindIndex = resourceDesc.BindPoint;				// Shader bind point
-			srv->Index = (unsigned int)shaderResourceViews.size();	// Raw index
-
-			textureTable.insert(std::pair<std::string, SimpleSRV*>(resourceDesc.Name, srv));
-			shaderResourceViews.push_back(srv);
-		}
+			reflection->Textures.push_back(resource);
 			break;
 
 		case D3D_SIT_SAMPLER: // A sampler resource
-		{
-			// Create the sampler wrapper
-			SimpleSampler* samp = new SimpleSampler();
-			samp->BindIndex = resourceDesc.BindPoint;			// Shader bind point
-			samp->Index = (unsigned int)samplerStates.size();	// Raw index
-
-			samplerTable.insert(std::pair<std::string, SimpleSampler*>(resourceDesc.Name, samp));
-			samplerStates.push_back(samp);
-		}
+			reflection->Samplers.push_back(resource);
 			break;
 		}
 	}
 
 	// Loop through all constant buffers
-	for (unsigned int b = 0; b < constantBufferCount; b++)
+	reflection->ConstantBuffers.resize(shaderDesc.ConstantBuffers);
+	for (unsigned int b = 0; b < shaderDesc.ConstantBuffers; b++)
 	{
 		// Get this buffer
 		ID3D11ShaderReflectionConstantBuffer* cb =
@@ -156,27 +304,12 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		// we know exactly how it's bound in the shader
 		D3D11_SHADER_INPUT_BIND_DESC bindDesc;
 		refl->GetResourceBindingDescByName(bufferDesc.Name, &bindDesc);
-		
-		// Set up the buffer and put its pointer in the table
-		constantBuffers[b].BindIndex = bindDesc.BindPoint;
-		constantBuffers[b].Name = bufferDesc.Name;
-		cbTable.insert(std::pair<std::string, SimpleConstantBuffer*>(bufferDesc.Name, &constantBuffers[b]));
-
-		// Create this constant buffer
-		D3D11_BUFFER_DESC newBuffDesc;
-		newBuffDesc.Usage = D3D11_USAGE_DEFAULT;
-		newBuffDesc.ByteWidth = bufferDesc.Size;
-		newBuffDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-		newBuffDesc.CPUAccessFlags = 0;
-		newBuffDesc.MiscFlags = 0;
-		newBuffDesc.StructureByteStride = 0;
-		device->CreateBuffer(&newBuffDesc, 0, &constantBuffers[b].ConstantBuffer);
-
-		// Set up the data buffer for this constant buffer
-		constantBuffers[b].Size = bufferDesc.Size;
-		constantBuffers[b].LocalDataBuffer = new unsigned char[bufferDesc.Size];
-		ZeroMemory(constantBuffers[b].LocalDataBuffer, bufferDesc.Size);
 
+		ReflectedConstantBuffer& buffer = reflection->ConstantBuffers[b];
+		buffer.Name = bufferDesc.Name;
+		buffer.Size = bufferDesc.Size;
+		buffer.BindIndex = bindDesc.BindPoint;
+		
 		// Loop through all variables in this buffer
 		for (unsigned int v = 0; v < bufferDesc.Variables; v++)
 		{
@@ -187,70 +320,303 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 			// Get the description of the variable and its type
 			D3D11_SHADER_VARIABLE_DESC varDesc;
 			var->GetDesc(&varDesc);
+			D3D11_SHADER_TYPE_DESC typeDesc;
+			var->GetType()->GetDesc(&typeDesc);
+
+			ReflectedVariable variable;
+			variable.Name = varDesc.Name;
+			variable.TypeName = typeDesc.Name ? typeDesc.Name : "";
+			variable.Elements = typeDesc.Elements;
+			variable.ByteOffset = varDesc.StartOffset;
+			variable.Size = varDesc.Size;
+			buffer.Variables.push_back(variable);
+		}
+	}
+
+	// All set
+	refl->Release();
+}
+
+// --------------------------------------------------------
+// Builds a program's lookup tables from its reflection
+// --------------------------------------------------------
+void ISimpleShader::BuildProgramTables(SimpleShaderProgram* target, const ShaderReflectionData& reflection)
+{
+	// SRVs and samplers
+	for (unsigned int r = 0; r < reflection.Textures.size(); r++)
+	{
+		// Create the SRV wrapper
+		SimpleSRV srv;
+		srv.BindIndex = reflection.Textures[r].BindIndex;	// Shader bind point
+		srv.Index = r;										// Raw index
+
+		target->TextureTable.Add(reflection.Textures[r].Name, (int)srv.Index);
+		target->ShaderResourceViews.push_back(srv);
+	}
+
+	for (unsigned int r = 0; r < reflection.Samplers.size(); r++)
+	{
+		// Create the sampler wrapper
+		SimpleSampler samp;
+		samp.BindIndex = reflection.Samplers[r].BindIndex;	// Shader bind point
+		samp.Index = r;										// Raw index
+
+		target->SamplerTable.Add(reflection.Samplers[r].Name, (int)samp.Index);
+		target->SamplerStates.push_back(samp);
+	}
+
+	// Constant buffers and their variables
+	target->ConstantBuffers.resize(reflection.ConstantBuffers.size());
+	for (unsigned int b = 0; b < reflection.ConstantBuffers.size(); b++)
+	{
+		const ReflectedConstantBuffer& buffer = reflection.ConstantBuffers[b];
+
+		// Set up the buffer and put its index in the table
+		SimpleConstantBuffer& layout = target->ConstantBuffers[b];
+		layout.BindIndex = buffer.BindIndex;
+		layout.Name = buffer.Name;
+		layout.Size = buffer.Size;
+		target->CBTable.Add(buffer.Name, (int)b);
 
+		// Shared buffers are someone else's job - just remember they exist
+		layout.Shared = sharedBufferNames.count(buffer.Name) > 0;
+		if (layout.Shared)
+			continue;
+
+		for (unsigned int v = 0; v < buffer.Variables.size(); v++)
+		{
 			// Create the variable struct
 			SimpleShaderVariable varStruct;
 			varStruct.ConstantBufferIndex = b;
-			varStruct.ByteOffset = varDesc.StartOffset;
-			varStruct.Size = varDesc.Size;
-			
-			// Get a string version
-			std::string varName(varDesc.Name);
+			varStruct.ByteOffset = buffer.Variables[v].ByteOffset;
+			varStruct.Size = buffer.Variables[v].Size;
 
 			// Add this variable to the table and the constant buffer
-			varTable.insert(std::pair<std::string, SimpleShaderVariable>(varName, varStruct));
-			constantBuffers[b].Variables.push_back(varStruct);
+			// (its index in the variable table is its handle)
+			target->Variables.Add(buffer.Variables[v].Name, varStruct);
+			layout.Variables.push_back(varStruct);
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Adds C++ cbuffer structs to check shaders against as
+// they load
+// --------------------------------------------------------
+void ISimpleShader::RegisterConstantBufferLayouts(const ConstantBufferLayout* layouts, unsigned int count)
+{
+	registeredLayouts.insert(registeredLayouts.end(), layouts, layouts + count);
+}
+
+// --------------------------------------------------------
+// Checks every registered struct for this file against the
+// program's reflection, printing what's wrong if any don't
+// match.  Files are matched by name (ignoring directories).
+// --------------------------------------------------------
+bool ISimpleShader::VerifyConstantBufferLayouts(LPCWSTR shaderFile)
+{
+	std::wstring path = shaderFile;
+	size_t slash = path.find_last_of(L"/\\");
+	std::wstring fileName = (slash == std::wstring::npos) ? path : path.substr(slash + 1);
+
+	bool valid = true;
+	for (unsigned int i = 0; i < registeredLayouts.size(); i++)
+	{
+		const ConstantBufferLayout& layout = registeredLayouts[i];
+		if (fileName != layout.ShaderFile)
+			continue;
+
+		std::string mismatch;
+		int handle = GetConstantBufferHandle(layout.BufferName);
+		if (handle == InvalidHandle)
+			mismatch = "the shader has no buffer by that name";
+		else if (MatchesLayout(handle, layout.Fields, layout.FieldCount, layout.Size, &mismatch))
+			continue;
+
+		char message[512];
+		sprintf_s(message, "\nERROR: cbuffer %s in %ls doesn't match its C++ struct (%s) - regenerate ConstantBuffers.h\n",
+			layout.BufferName, layout.ShaderFile, mismatch.c_str());
+		printf("%s", message);
+		OutputDebugStringA(message);
+		valid = false;
+	}
+	return valid;
+}
+
+// --------------------------------------------------------
+// Compares a buffer's reflected variables to a struct's
+// fields, optionally describing the first difference
+// --------------------------------------------------------
+bool ISimpleShader::MatchesLayout(int bufferHandle, const ConstantBufferField* fields, unsigned int fieldCount, unsigned int size, std::string* mismatch)
+{
+	const ReflectedConstantBuffer& buffer = program->Reflection.ConstantBuffers[bufferHandle];
+	char details[256];
+
+	if (buffer.Size != size)
+	{
+		if (mismatch)
+		{
+			sprintf_s(details, "buffer is %u bytes, struct is %u", buffer.Size, size);
+			*mismatch = details;
 		}
+		return false;
 	}
 
-	// All set
-	refl->Release();
+	if (buffer.Variables.size() != fieldCount)
+	{
+		if (mismatch)
+		{
+			sprintf_s(details, "buffer has %u variables, struct has %u", (unsigned int)buffer.Variables.size(), fieldCount);
+			*mismatch = details;
+		}
+		return false;
+	}
+
+	for (unsigned int f = 0; f < fieldCount; f++)
+	{
+		const ReflectedVariable& var = buffer.Variables[f];
+		if (var.Name != fields[f].Name || var.ByteOffset != fields[f].ByteOffset || var.Size != fields[f].Size)
+		{
+			if (mismatch)
+			{
+				sprintf_s(details, "%s at %u (%u bytes) vs. %s at %u (%u bytes)",
+					var.Name.c_str(), var.ByteOffset, var.Size,
+					fields[f].Name, fields[f].ByteOffset, fields[f].Size);
+				*mismatch = details;
+			}
+			return false;
+		}
+	}
 	return true;
 }
 
 // --------------------------------------------------------
-// Helper for looking up a variable by name and also
-// verifying that it is the requested size
-// 
-// name - the name of the variable to look for
-// size - the size of the variable (for verification), or -1 to bypass
+// Generates C++ structs for every loaded shader's own
+// cbuffers, in file name order
 // --------------------------------------------------------
-SimpleShaderVariable* ISimpleShader::FindVariable(std::string name, int size)
+std::string ISimpleShader::GenerateConstantBufferHeader()
 {
-	// Look for the key
-	std::unordered_map<std::string, SimpleShaderVariable>::iterator result =
-		varTable.find(name);
+	std::map<std::string, GeneratorShader> shaders;
+	for (std::unordered_map<std::wstring, SimpleShaderProgram*>::iterator it = programCache.begin(); it != programCache.end(); ++it)
+	{
+		SimpleShaderProgram* cached = it->second;
 
-	// Did we find the key?
-	if (result == varTable.end())
-		return 0;
+		// Key is "stage|path" - we just want the file name
+		std::wstring path = cached->Key.substr(cached->Key.find(L'|') + 1);
+		size_t slash = path.find_last_of(L"/\\");
+		std::wstring wideName = (slash == std::wstring::npos) ? path : path.substr(slash + 1);
+		std::string fileName(wideName.begin(), wideName.end());
 
-	// Grab the result from the iterator
-	SimpleShaderVariable* var = &(result->second);
+		GeneratorShader shader;
+		shader.ShaderFile = fileName;
+		for (unsigned int b = 0; b < cached->ConstantBuffers.size(); b++)
+		{
+			if (!cached->ConstantBuffers[b].Shared)
+				shader.Reflection.ConstantBuffers.push_back(cached->Reflection.ConstantBuffers[b]);
+		}
 
-	// Is the data size correct ?
-	if (size > 0 && var->Size != size)
-		return 0;
+		if (!shader.Reflection.ConstantBuffers.empty())
+			shaders[fileName] = shader;
+	}
 
-	// Success
-	return var;
+	std::vector<GeneratorShader> ordered;
+	for (std::map<std::string, GeneratorShader>::iterator it = shaders.begin(); it != shaders.end(); ++it)
+		ordered.push_back(it->second);
+
+	return ConstantBufferGenerator::GenerateHeader(ordered);
 }
 
 // --------------------------------------------------------
-// Helper for looking up a constant buffer by name
+// Creates this shader object's own GPU and local copies of
+// each (non-shared) constant buffer in the program
 // --------------------------------------------------------
-SimpleConstantBuffer* ISimpleShader::FindConstantBuffer(std::string name)
+void ISimpleShader::CreateConstantBuffers()
 {
-	// Look for the key
-	std::unordered_map<std::string, SimpleConstantBuffer*>::iterator result =
-		cbTable.find(name);
+	constantBufferCount = (unsigned int)program->ConstantBuffers.size();
+	constantBuffers = new SimpleConstantBufferData[constantBufferCount];
 
-	// Did we find the key?
-	if (result == cbTable.end())
-		return 0;
+	for (unsigned int b = 0; b < constantBufferCount; b++)
+	{
+		const SimpleConstantBuffer& layout = program->ConstantBuffers[b];
+		SimpleConstantBufferData& data = constantBuffers[b];
+
+		data.Size = layout.Size;
+		data.BindIndex = layout.BindIndex;
+		data.Shared = layout.Shared;
+		data.ConstantBuffer = 0;
+		data.LocalDataBuffer = 0;
+		data.UploadFrame = (unsigned long long)-1;
+		data.UploadOffset = 0;
+		data.DirtyStart = 0;
+		data.DirtyEnd = 0;
+		data.SliceDirty = false;
+
+		// Shared buffers are filled and bound by the game
+		if (layout.Shared)
+			continue;
 
-	// Success
-	return result->second;
+		// Create this constant buffer
+		D3D11_BUFFER_DESC newBuffDesc;
+		newBuffDesc.Usage = D3D11_USAGE_DEFAULT;
+		newBuffDesc.ByteWidth = layout.Size;
+		newBuffDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		newBuffDesc.CPUAccessFlags = 0;
+		newBuffDesc.MiscFlags = 0;
+		newBuffDesc.StructureByteStride = 0;
+		device->CreateBuffer(&newBuffDesc, 0, &data.ConstantBuffer);
+
+		// Set up the data buffer for this constant buffer
+		data.LocalDataBuffer = new unsigned char[layout.Size];
+		ZeroMemory(data.LocalDataBuffer, layout.Size);
+
+		// The GPU copy starts out undefined, so it's all dirty
+		data.DirtyEnd = layout.Size;
+		data.SliceDirty = true;
+	}
+}
+
+// --------------------------------------------------------
+// Looks up handles for variables, SRVs and samplers, by
+// name or by SimpleShaderHash() of the name.  Do this once
+// (after loading) and keep the handle around.
+// --------------------------------------------------------
+int ISimpleShader::GetVariableHandle(std::string name)
+{
+	return program ? program->Variables.GetHandle(name) : InvalidHandle;
+}
+
+int ISimpleShader::GetVariableHandle(unsigned int nameHash)
+{
+	return program ? program->Variables.GetHandle(nameHash) : InvalidHandle;
+}
+
+int ISimpleShader::GetShaderResourceViewHandle(std::string name)
+{
+	return program ? program->TextureTable.Find(name) : InvalidHandle;
+}
+
+int ISimpleShader::GetShaderResourceViewHandle(unsigned int nameHash)
+{
+	return program ? program->TextureTable.Find(nameHash) : InvalidHandle;
+}
+
+int ISimpleShader::GetSamplerHandle(std::string name)
+{
+	return program ? program->SamplerTable.Find(name) : InvalidHandle;
+}
+
+int ISimpleShader::GetSamplerHandle(unsigned int nameHash)
+{
+	return program ? program->SamplerTable.Find(nameHash) : InvalidHandle;
+}
+
+// --------------------------------------------------------
+// Helper for looking up a constant buffer's index by name
+// (or -1 if there's no such buffer)
+// --------------------------------------------------------
+int ISimpleShader::FindConstantBufferIndex(std::string name)
+{
+	return program ? program->CBTable.Find(name) : -1;
 }
 
 // --------------------------------------------------------
@@ -277,12 +643,112 @@ void ISimpleShader::CopyAllBufferData()
 	if (!shaderValid) return;
 
 	// Loop through the constant buffers and copy all data
+	for (unsigned int i = 0; i < constantBufferCount; i++)
+		if (!constantBuffers[i].Shared)
+			UploadConstantBuffer(&constantBuffers[i]);
+
+	// Slices move every time we copy, so rebind
+	if (frameUpload)
+		BindConstantBuffers();
+}
+
+// --------------------------------------------------------
+// Sends one buffer's local data to the GPU, either through
+// a slice of the shared frame upload buffer or (if there
+// isn't one, or it's full) with a regular UpdateSubresource.
+//
+// Buffers whose data hasn't changed since the last upload
+// are skipped - either their slice from earlier this frame
+// is reused, or their own buffer already has the data.
+// --------------------------------------------------------
+void ISimpleShader::UploadConstantBuffer(SimpleConstantBufferData* cb)
+{
+	if (frameUpload && deviceContext1)
+	{
+		// Still have an up to date slice from this frame?
+		if (!cb->SliceDirty && frameUpload->IsCurrentFrame(cb->UploadFrame))
+		{
+			statUploadsSkipped++;
+			statBytesSaved += cb->Size;
+			return;
+		}
+
+		if (frameUpload->Allocate(cb->LocalDataBuffer, cb->Size, &cb->UploadOffset))
+		{
+			cb->UploadFrame = frameUpload->GetFrameIndex();
+			cb->SliceDirty = false;
+			statUploads++;
+			statBytesUploaded += cb->Size;
+			return;
+		}
+	}
+
+	// Falling back to our own buffer, which may already be current
+	cb->UploadFrame = (unsigned long long)-1;
+	if (cb->DirtyStart >= cb->DirtyEnd)
+	{
+		statUploadsSkipped++;
+		statBytesSaved += cb->Size;
+		return;
+	}
+
+	// Copy the entire local data buffer (partial constant buffer
+	// updates aren't allowed on 11.0, so the dirty range is only
+	// used to decide IF we upload)
+	deviceContext->UpdateSubresource(
+		cb->ConstantBuffer, 0, 0,
+		cb->LocalDataBuffer, 0, 0);
+
+	cb->DirtyStart = cb->Size;
+	cb->DirtyEnd = 0;
+	statUploads++;
+	statBytesUploaded += cb->Size;
+}
+
+// --------------------------------------------------------
+// Gets (or resets) the upload counters for all shaders
+// --------------------------------------------------------
+SimpleShaderUploadStats ISimpleShader::GetUploadStats()
+{
+	SimpleShaderUploadStats stats;
+	stats.Uploads = statUploads;
+	stats.UploadsSkipped = statUploadsSkipped;
+	stats.BytesUploaded = statBytesUploaded;
+	stats.BytesSaved = statBytesSaved;
+	return stats;
+}
+
+void ISimpleShader::ResetUploadStats()
+{
+	statUploads = 0;
+	statUploadsSkipped = 0;
+	statBytesUploaded = 0;
+	statBytesSaved = 0;
+}
+
+// --------------------------------------------------------
+// Binds each constant buffer (or its slice of the frame
+// upload buffer) to this shader's stage
+// --------------------------------------------------------
+void ISimpleShader::BindConstantBuffers()
+{
 	for (unsigned int i = 0; i < constantBufferCount; i++)
 	{
-		// Copy the entire local data buffer
-		deviceContext->UpdateSubresource(
-			constantBuffers[i].ConstantBuffer, 0, 0,
-			constantBuffers[i].LocalDataBuffer, 0, 0);
+		SimpleConstantBufferData* cb = &constantBuffers[i];
+		if (cb->Shared)
+			continue;
+
+		if (frameUpload && deviceContext1 && frameUpload->IsCurrentFrame(cb->UploadFrame))
+		{
+			// Offsets and sizes are in 16-byte constants, in multiples of 16 constants
+			UINT firstConstant = cb->UploadOffset / 16;
+			UINT numConstants = ((cb->Size + FrameUploadBuffer::SliceAlignment - 1) / FrameUploadBuffer::SliceAlignment) * 16;
+			SetConstantBuffer(cb->BindIndex, frameUpload->GetBuffer(), &firstConstant, &numConstants);
+		}
+		else
+		{
+			SetConstantBuffer(cb->BindIndex, cb->ConstantBuffer, 0, 0);
+		}
 	}
 }
 
@@ -307,13 +773,13 @@ void ISimpleShader::CopyBufferData(unsigned int index)
 		return;
 
 	// Check for the buffer
-	SimpleConstantBuffer* cb = &this->constantBuffers[index];
-	if (!cb) return;
+	SimpleConstantBufferData* cb = &this->constantBuffers[index];
+	if (!cb || cb->Shared) return;
 
 	// Copy the data and get out
-	deviceContext->UpdateSubresource(
-		cb->ConstantBuffer, 0, 0, 
-		cb->LocalDataBuffer, 0, 0);
+	UploadConstantBuffer(cb);
+	if (frameUpload)
+		BindConstantBuffers();
 }
 
 // --------------------------------------------------------
@@ -329,13 +795,16 @@ void ISimpleShader::CopyBufferData(std::string bufferName)
 	if (!shaderValid) return;
 
 	// Check for the buffer
-	SimpleConstantBuffer* cb = this->FindConstantBuffer(bufferName);
-	if (!cb) return;
+	int index = this->FindConstantBufferIndex(bufferName);
+	if (index < 0) return;
+
+	SimpleConstantBufferData* cb = &this->constantBuffers[index];
+	if (cb->Shared) return;
 
 	// Copy the data and get out
-	deviceContext->UpdateSubresource(
-		cb->ConstantBuffer, 0, 0, 
-		cb->LocalDataBuffer, 0, 0);
+	UploadConstantBuffer(cb);
+	if (frameUpload)
+		BindConstantBuffers();
 }
 
 
@@ -351,18 +820,62 @@ void ISimpleShader::CopyBufferData(std::string bufferName)
 // --------------------------------------------------------
 bool ISimpleShader::SetData(std::string name, const void* data, unsigned int size)
 {
-	// Look for the variable and verify
-	SimpleShaderVariable* var = FindVariable(name, size);
-	if (var == 0)
+	// Look for the variable, verify and copy
+	return program && program->Variables.SetData(name, constantBuffers, data, size);
+}
+
+// --------------------------------------------------------
+// Sets a variable by handle with arbitrary data of the specified size
+//
+// handle - The handle from GetVariableHandle()
+// data - The data to set in the buffer
+// size - The size of the data (this must match the variable's size)
+//
+// Returns true if data is copied, false if the handle is
+// invalid or sizes don't match
+// --------------------------------------------------------
+bool ISimpleShader::SetData(int handle, const void* data, unsigned int size)
+{
+	// Validate the handle and the size, then copy
+	return program && program->Variables.SetData(handle, constantBuffers, data, size);
+}
+
+// --------------------------------------------------------
+// Looks up a constant buffer's handle (its index) by name
+// --------------------------------------------------------
+int ISimpleShader::GetConstantBufferHandle(std::string bufferName)
+{
+	int index = FindConstantBufferIndex(bufferName);
+	return index < 0 ? InvalidHandle : index;
+}
+
+// --------------------------------------------------------
+// Replaces a whole constant buffer's local data in one go
+//
+// bufferHandle - The handle from GetConstantBufferHandle()
+// data - The new contents of the buffer
+// size - Must be the buffer's exact size
+//
+// Returns true if data is copied, false if the handle is
+// invalid or the size doesn't match
+// --------------------------------------------------------
+bool ISimpleShader::SetConstantBufferData(int bufferHandle, const void* data, unsigned int size)
+{
+	if (bufferHandle < 0 || bufferHandle >= (int)constantBufferCount)
+		return false;
+
+	SimpleConstantBufferData* cb = &constantBuffers[bufferHandle];
+	if (cb->Shared || cb->Size != size)
 		return false;
 
-	// Set the data in the local data buffer
-	memcpy(
-		constantBuffers[var->ConstantBufferIndex].LocalDataBuffer + var->ByteOffset,
-		data,
-		size);
+	// Same skip-if-unchanged rule as single variables
+	if (memcmp(cb->LocalDataBuffer, data, size) == 0)
+		return true;
 
-	// Success
+	memcpy(cb->LocalDataBuffer, data, size);
+	cb->DirtyStart = 0;
+	cb->DirtyEnd = size;
+	cb->SliceDirty = true;
 	return true;
 }
 
@@ -446,12 +959,65 @@ bool ISimpleShader::SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 dat
 	return this->SetData(name, &data, sizeof(float) * 16);
 }
 
+// --------------------------------------------------------
+// Handle versions of the typed setters above
+// --------------------------------------------------------
+bool ISimpleShader::SetInt(int handle, int data)
+{
+	return this->SetData(handle, (void*)(&data), sizeof(int));
+}
+
+bool ISimpleShader::SetFloat(int handle, float data)
+{
+	return this->SetData(handle, (void*)(&data), sizeof(float));
+}
+
+bool ISimpleShader::SetFloat2(int handle, const float data[2])
+{
+	return this->SetData(handle, (void*)data, sizeof(float) * 2);
+}
+
+bool ISimpleShader::SetFloat2(int handle, const DirectX::XMFLOAT2 data)
+{
+	return this->SetData(handle, &data, sizeof(float) * 2);
+}
+
+bool ISimpleShader::SetFloat3(int handle, const float data[3])
+{
+	return this->SetData(handle, (void*)data, sizeof(float) * 3);
+}
+
+bool ISimpleShader::SetFloat3(int handle, const DirectX::XMFLOAT3 data)
+{
+	return this->SetData(handle, &data, sizeof(float) * 3);
+}
+
+bool ISimpleShader::SetFloat4(int handle, const float data[4])
+{
+	return this->SetData(handle, (void*)data, sizeof(float) * 4);
+}
+
+bool ISimpleShader::SetFloat4(int handle, const DirectX::XMFLOAT4 data)
+{
+	return this->SetData(handle, &data, sizeof(float) * 4);
+}
+
+bool ISimpleShader::SetMatrix4x4(int handle, const float data[16])
+{
+	return this->SetData(handle, (void*)data, sizeof(float) * 16);
+}
+
+bool ISimpleShader::SetMatrix4x4(int handle, const DirectX::XMFLOAT4X4 data)
+{
+	return this->SetData(handle, &data, sizeof(float) * 16);
+}
+
 // --------------------------------------------------------
 // Gets info about a shader variable, if it exists
 // --------------------------------------------------------
 const SimpleShaderVariable* ISimpleShader::GetVariableInfo(std::string name)
 {
-	return FindVariable(name, -1);
+	return program ? program->Variables.Find(name, -1) : 0;
 }
 
 // --------------------------------------------------------
@@ -461,16 +1027,16 @@ const SimpleShaderVariable* ISimpleShader::GetVariableInfo(std::string name)
 // --------------------------------------------------------
 const SimpleSRV* ISimpleShader::GetShaderResourceViewInfo(std::string name)
 {
-	// Look for the key
-	std::unordered_map<std::string, SimpleSRV*>::iterator result =
-		textureTable.find(name);
+	if (!program)
+		return 0;
 
-	// Did we find the key?
-	if (result == textureTable.end())
+	// Look for the key
+	int index = program->TextureTable.Find(name);
+	if (index < 0)
 		return 0;
 
 	// Success
-	return result->second;
+	return &program->ShaderResourceViews[index];
 }
 
 
@@ -482,10 +1048,10 @@ const SimpleSRV* ISimpleShader::GetShaderResourceViewInfo(std::string name)
 const SimpleSRV* ISimpleShader::GetShaderResourceViewInfo(unsigned int index)
 {
 	// Valid index?
-	if (index >= shaderResourceViews.size()) return 0;
+	if (!program || index >= program->ShaderResourceViews.size()) return 0;
 
 	// Grab the bind index
-	return shaderResourceViews[index];
+	return &program->ShaderResourceViews[index];
 }
 
 
@@ -496,16 +1062,16 @@ const SimpleSRV* ISimpleShader::GetShaderResourceViewInfo(unsigned int index)
 // --------------------------------------------------------
 const SimpleSampler* ISimpleShader::GetSamplerInfo(std::string name)
 {
-	// Look for the key
-	std::unordered_map<std::string, SimpleSampler*>::iterator result =
-		samplerTable.find(name);
+	if (!program)
+		return 0;
 
-	// Did we find the key?
-	if (result == samplerTable.end())
+	// Look for the key
+	int index = program->SamplerTable.Find(name);
+	if (index < 0)
 		return 0;
 
 	// Success
-	return result->second;
+	return &program->SamplerStates[index];
 }
 
 // --------------------------------------------------------
@@ -516,10 +1082,10 @@ const SimpleSampler* ISimpleShader::GetSamplerInfo(std::string name)
 const SimpleSampler* ISimpleShader::GetSamplerInfo(unsigned int index)
 {
 	// Valid index?
-	if (index >= samplerStates.size()) return 0;
+	if (!program || index >= program->SamplerStates.size()) return 0;
 
 	// Grab the bind index
-	return samplerStates[index];
+	return &program->SamplerStates[index];
 }
 
 
@@ -549,7 +1115,8 @@ unsigned int ISimpleShader::GetBufferSize(unsigned int index)
 // --------------------------------------------------------
 const SimpleConstantBuffer * ISimpleShader::GetBufferInfo(std::string name)
 {
-	return FindConstantBuffer(name);
+	int index = FindConstantBufferIndex(name);
+	return index < 0 ? 0 : &program->ConstantBuffers[index];
 }
 
 // --------------------------------------------------------
@@ -563,7 +1130,7 @@ const SimpleConstantBuffer * ISimpleShader::GetBufferInfo(unsigned int index)
 	if (index >= constantBufferCount) return 0;
 
 	// Return the specific buffer
-	return &constantBuffers[index];
+	return &program->ConstantBuffers[index];
 }
 
 
@@ -631,10 +1198,6 @@ void SimpleVertexShader::CleanUp()
 // --------------------------------------------------------
 bool SimpleVertexShader::CreateShader(ID3DBlob* shaderBlob)
 {
-	// Clean up first, in the event this method is
-	// called more than once on the same object
-	this->CleanUp();
-
 	// Create the shader from the blob
 	HRESULT result = device->CreateVertexShader(
 		shaderBlob->GetBufferPointer(),
@@ -651,11 +1214,61 @@ bool SimpleVertexShader::CreateShader(ID3DBlob* shaderBlob)
 	if (inputLayout)
 		return true;
 
-	// Vertex shader was created successfully, so we now use the
-	// shader code to re-reflect and create an input layout that 
-	// matches what the vertex shader expects.  Code adapted from:
-	// https://takinginitiative.wordpress.com/2011/12/11/directx-1011-basic-shader-reflection-automatic-input-layout-creation/
+	// Build one, and let other shaders loading this file have it too
+	if (!CreateInputLayout(shaderBlob))
+		return false;
+
+	program->InputLayout = inputLayout;
+	program->PerInstanceCompatible = perInstanceCompatible;
+	if (inputLayout)
+		inputLayout->AddRef();
+	return true;
+}
+
+// --------------------------------------------------------
+// Takes the shader (and input layout, unless we were given
+// a custom one) from a program another shader loaded
+//
+// Returns false if the program can't be used
+// --------------------------------------------------------
+bool SimpleVertexShader::AdoptShader(SimpleShaderProgram* source)
+{
+	if (source->Shader->QueryInterface(__uuidof(ID3D11VertexShader), (void**)&shader) != S_OK)
+		return false;
+
+	// Custom layouts come from the constructor
+	if (inputLayout)
+		return true;
+
+	// The first shader may have had a custom layout, in
+	// which case the first one without builds the shared one
+	if (!source->InputLayout)
+	{
+		if (!CreateInputLayout(source->Blob))
+			return false;
+
+		source->InputLayout = inputLayout;
+		source->PerInstanceCompatible = perInstanceCompatible;
+		if (inputLayout)
+			inputLayout->AddRef();
+		return true;
+	}
+
+	inputLayout = source->InputLayout;
+	inputLayout->AddRef();
+	perInstanceCompatible = source->PerInstanceCompatible;
+	return true;
+}
 
+// --------------------------------------------------------
+// Creates an input layout matching the vertex shader's inputs
+//
+// shaderBlob - The shader's compiled code
+//
+// Returns true if the layout was created, false otherwise
+// --------------------------------------------------------
+bool SimpleVertexShader::CreateInputLayout(ID3DBlob* shaderBlob)
+{
 	// Reflect shader info
 	ID3D11ShaderReflection* refl;
 	D3DReflect(
@@ -668,81 +1281,42 @@ bool SimpleVertexShader::CreateShader(ID3DBlob* shaderBlob)
 	D3D11_SHADER_DESC shaderDesc;
 	refl->GetDesc(&shaderDesc);
 
-	// Read input layout description from shader info
-	std::vector<D3D11_INPUT_ELEMENT_DESC> inputLayoutDesc;
-	for (unsigned int i = 0; i< shaderDesc.InputParameters; i++)
+	// Read the input signature and turn it into input elements
+	std::vector<SignatureParameter> parameters(shaderDesc.InputParameters);
+	for (unsigned int i = 0; i < shaderDesc.InputParameters; i++)
 	{
 		D3D11_SIGNATURE_PARAMETER_DESC paramDesc;
 		refl->GetInputParameterDesc(i, &paramDesc);
 
-		// Check the semantic name for "_PER_INSTANCE"
-		std::string perInstanceStr = "_PER_INSTANCE";
-		std::string sem = paramDesc.SemanticName;
-		int lenDiff = (int)sem.size() - (int)perInstanceStr.size();
-		bool isPerInstance = 
-			lenDiff >= 0 &&
-			sem.compare(lenDiff, perInstanceStr.size(), perInstanceStr) == 0;
-
-		// Fill out input element desc
-		D3D11_INPUT_ELEMENT_DESC elementDesc;
-		elementDesc.SemanticName = paramDesc.SemanticName;
-		elementDesc.SemanticIndex = paramDesc.SemanticIndex;
-		elementDesc.InputSlot = 0;
-		elementDesc.AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
-		elementDesc.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-		elementDesc.InstanceDataStepRate = 0;
-
-		// Replace anything affected by "per instance" data
-		if (isPerInstance)
-		{
-			elementDesc.InputSlot = 1; // Assume per instance data comes from another input slot!
-			elementDesc.InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
-			elementDesc.InstanceDataStepRate = 1;
-
-			perInstanceCompatible = true;
-		}
+		parameters[i].SemanticName = paramDesc.SemanticName;
+		parameters[i].SemanticIndex = paramDesc.SemanticIndex;
+		parameters[i].Mask = paramDesc.Mask;
+		parameters[i].ComponentType = (SignatureComponentType)paramDesc.ComponentType;
+		parameters[i].SystemValue = paramDesc.SystemValueType != D3D_NAME_UNDEFINED;
+	}
 
-		// Determine DXGI format
-		if (paramDesc.Mask == 1)
-		{
-			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32_UINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32_SINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32_FLOAT;
-		}
-		else if (paramDesc.Mask <= 3)
-		{
-			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32G32_UINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32G32_SINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32G32_FLOAT;
-		}
-		else if (paramDesc.Mask <= 7)
-		{
-			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32_UINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32_SINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32G32B32_FLOAT;
-		}
-		else if (paramDesc.Mask <= 15)
-		{
-			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32A32_UINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32A32_SINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-		}
+	std::vector<InputElement> inputLayoutDesc;
+	perInstanceCompatible = InputSignature::BuildElements(parameters, &inputLayoutDesc);
 
-		// Save element desc
-		inputLayoutDesc.push_back(elementDesc);
+	// Shaders that only read system values (like SV_VertexID) don't need a layout
+	if (inputLayoutDesc.empty())
+	{
+		refl->Release();
+		return true;
 	}
 
-	// Try to create Input Layout
-	HRESULT hr = device->CreateInputLayout(
+	// Shaders with the same vertex signature all share one layout
+	inputLayout = InputLayoutCache::GetInputLayout(
+		device,
 		&inputLayoutDesc[0], 
 		(unsigned int)inputLayoutDesc.size(), 
 		shaderBlob->GetBufferPointer(), 
-		shaderBlob->GetBufferSize(),
-		&inputLayout);
+		shaderBlob->GetBufferSize());
 
-	// All done, clean up
+	// All done, clean up (the elements point at reflection strings,
+	// so this has to wait until the layout exists)
 	refl->Release();
-	return true;
+	return inputLayout != 0;
 }
 
 // --------------------------------------------------------
@@ -759,13 +1333,19 @@ void SimpleVertexShader::SetShaderAndCBs()
 	deviceContext->VSSetShader(shader, 0, 0);
 
 	// Set the constant buffers
-	for (unsigned int i = 0; i < constantBufferCount; i++)
-	{
-		deviceContext->VSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			&constantBuffers[i].ConstantBuffer);
-	}
+	BindConstantBuffers();
+}
+
+// --------------------------------------------------------
+// Binds a single constant buffer (or a slice of one) to
+// the vertex shader stage
+// --------------------------------------------------------
+void SimpleVertexShader::SetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer, const UINT* firstConstant, const UINT* numConstants)
+{
+	if (firstConstant && deviceContext1)
+		deviceContext1->VSSetConstantBuffers1(slot, 1, &buffer, firstConstant, numConstants);
+	else
+		deviceContext->VSSetConstantBuffers(slot, 1, &buffer);
 }
 
 // --------------------------------------------------------
@@ -812,6 +1392,30 @@ bool SimpleVertexShader::SetSamplerState(std::string name, ID3D11SamplerState* s
 	return true;
 }
 
+// --------------------------------------------------------
+// Handle versions of SetShaderResourceView/SetSamplerState
+// for the vertex shader stage
+// --------------------------------------------------------
+bool SimpleVertexShader::SetShaderResourceView(int handle, ID3D11ShaderResourceView* srv)
+{
+	const SimpleSRV* srvInfo = GetShaderResourceViewInfo((unsigned int)handle);
+	if (handle < 0 || srvInfo == 0)
+		return false;
+
+	deviceContext->VSSetShaderResources(srvInfo->BindIndex, 1, &srv);
+	return true;
+}
+
+bool SimpleVertexShader::SetSamplerState(int handle, ID3D11SamplerState* samplerState)
+{
+	const SimpleSampler* sampInfo = GetSamplerInfo((unsigned int)handle);
+	if (handle < 0 || sampInfo == 0)
+		return false;
+
+	deviceContext->VSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
+	return true;
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // ------ SIMPLE PIXEL SHADER -------------------------------------------------
@@ -852,10 +1456,6 @@ void SimplePixelShader::CleanUp()
 // --------------------------------------------------------
 bool SimplePixelShader::CreateShader(ID3DBlob* shaderBlob)
 {
-	// Clean up first, in the event this method is
-	// called more than once on the same object
-	this->CleanUp();
-
 	// Create the shader from the blob
 	HRESULT result = device->CreatePixelShader(
 		shaderBlob->GetBufferPointer(),
@@ -867,6 +1467,14 @@ bool SimplePixelShader::CreateShader(ID3DBlob* shaderBlob)
 	return (result == S_OK);
 }
 
+// --------------------------------------------------------
+// Takes the pixel shader from a program another shader loaded
+// --------------------------------------------------------
+bool SimplePixelShader::AdoptShader(SimpleShaderProgram* source)
+{
+	return source->Shader->QueryInterface(__uuidof(ID3D11PixelShader), (void**)&shader) == S_OK;
+}
+
 // --------------------------------------------------------
 // Sets the pixel shader and constant buffers for
 // future DirectX drawing
@@ -880,13 +1488,19 @@ void SimplePixelShader::SetShaderAndCBs()
 	deviceContext->PSSetShader(shader, 0, 0);
 
 	// Set the constant buffers
-	for (unsigned int i = 0; i < constantBufferCount; i++)
-	{
-		deviceContext->PSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			&constantBuffers[i].ConstantBuffer);
-	}
+	BindConstantBuffers();
+}
+
+// --------------------------------------------------------
+// Binds a single constant buffer (or a slice of one) to
+// the pixel shader stage
+// --------------------------------------------------------
+void SimplePixelShader::SetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer, const UINT* firstConstant, const UINT* numConstants)
+{
+	if (firstConstant && deviceContext1)
+		deviceContext1->PSSetConstantBuffers1(slot, 1, &buffer, firstConstant, numConstants);
+	else
+		deviceContext->PSSetConstantBuffers(slot, 1, &buffer);
 }
 
 // --------------------------------------------------------
@@ -933,6 +1547,30 @@ bool SimplePixelShader::SetSamplerState(std::string name, ID3D11SamplerState* sa
 	return true;
 }
 
+// --------------------------------------------------------
+// Handle versions of SetShaderResourceView/SetSamplerState
+// for the pixel shader stage
+// --------------------------------------------------------
+bool SimplePixelShader::SetShaderResourceView(int handle, ID3D11ShaderResourceView* srv)
+{
+	const SimpleSRV* srvInfo = GetShaderResourceViewInfo((unsigned int)handle);
+	if (handle < 0 || srvInfo == 0)
+		return false;
+
+	deviceContext->PSSetShaderResources(srvInfo->BindIndex, 1, &srv);
+	return true;
+}
+
+bool SimplePixelShader::SetSamplerState(int handle, ID3D11SamplerState* samplerState)
+{
+	const SimpleSampler* sampInfo = GetSamplerInfo((unsigned int)handle);
+	if (handle < 0 || sampInfo == 0)
+		return false;
+
+	deviceContext->PSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
+	return true;
+}
+
 
 
 
@@ -975,10 +1613,6 @@ void SimpleDomainShader::CleanUp()
 // --------------------------------------------------------
 bool SimpleDomainShader::CreateShader(ID3DBlob* shaderBlob)
 {
-	// Clean up first, in the event this method is
-	// called more than once on the same object
-	this->CleanUp();
-
 	// Create the shader from the blob
 	HRESULT result = device->CreateDomainShader(
 		shaderBlob->GetBufferPointer(),
@@ -990,6 +1624,14 @@ bool SimpleDomainShader::CreateShader(ID3DBlob* shaderBlob)
 	return (result == S_OK);
 }
 
+// --------------------------------------------------------
+// Takes the domain shader from a program another shader loaded
+// --------------------------------------------------------
+bool SimpleDomainShader::AdoptShader(SimpleShaderProgram* source)
+{
+	return source->Shader->QueryInterface(__uuidof(ID3D11DomainShader), (void**)&shader) == S_OK;
+}
+
 // --------------------------------------------------------
 // Sets the domain shader and constant buffers for
 // future DirectX drawing
@@ -1003,13 +1645,19 @@ void SimpleDomainShader::SetShaderAndCBs()
 	deviceContext->DSSetShader(shader, 0, 0);
 
 	// Set the constant buffers
-	for (unsigned int i = 0; i < constantBufferCount; i++)
-	{
-		deviceContext->DSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			&constantBuffers[i].ConstantBuffer);
-	}
+	BindConstantBuffers();
+}
+
+// --------------------------------------------------------
+// Binds a single constant buffer (or a slice of one) to
+// the domain shader stage
+// --------------------------------------------------------
+void SimpleDomainShader::SetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer, const UINT* firstConstant, const UINT* numConstants)
+{
+	if (firstConstant && deviceContext1)
+		deviceContext1->DSSetConstantBuffers1(slot, 1, &buffer, firstConstant, numConstants);
+	else
+		deviceContext->DSSetConstantBuffers(slot, 1, &buffer);
 }
 
 // --------------------------------------------------------
@@ -1056,6 +1704,30 @@ bool SimpleDomainShader::SetSamplerState(std::string name, ID3D11SamplerState* s
 	return true;
 }
 
+// --------------------------------------------------------
+// Handle versions of SetShaderResourceView/SetSamplerState
+// for the domain shader stage
+// --------------------------------------------------------
+bool SimpleDomainShader::SetShaderResourceView(int handle, ID3D11ShaderResourceView* srv)
+{
+	const SimpleSRV* srvInfo = GetShaderResourceViewInfo((unsigned int)handle);
+	if (handle < 0 || srvInfo == 0)
+		return false;
+
+	deviceContext->DSSetShaderResources(srvInfo->BindIndex, 1, &srv);
+	return true;
+}
+
+bool SimpleDomainShader::SetSamplerState(int handle, ID3D11SamplerState* samplerState)
+{
+	const SimpleSampler* sampInfo = GetSamplerInfo((unsigned int)handle);
+	if (handle < 0 || sampInfo == 0)
+		return false;
+
+	deviceContext->DSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
+	return true;
+}
+
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1097,10 +1769,6 @@ void SimpleHullShader::CleanUp()
 // --------------------------------------------------------
 bool SimpleHullShader::CreateShader(ID3DBlob* shaderBlob)
 {
-	// Clean up first, in the event this method is
-	// called more than once on the same object
-	this->CleanUp();
-
 	// Create the shader from the blob
 	HRESULT result = device->CreateHullShader(
 		shaderBlob->GetBufferPointer(),
@@ -1112,6 +1780,14 @@ bool SimpleHullShader::CreateShader(ID3DBlob* shaderBlob)
 	return (result == S_OK);
 }
 
+// --------------------------------------------------------
+// Takes the hull shader from a program another shader loaded
+// --------------------------------------------------------
+bool SimpleHullShader::AdoptShader(SimpleShaderProgram* source)
+{
+	return source->Shader->QueryInterface(__uuidof(ID3D11HullShader), (void**)&shader) == S_OK;
+}
+
 // --------------------------------------------------------
 // Sets the hull shader and constant buffers for
 // future DirectX drawing
@@ -1124,14 +1800,20 @@ void SimpleHullShader::SetShaderAndCBs()
 	// Set the shader
 	deviceContext->HSSetShader(shader, 0, 0);
 
-	// Set the constant buffers?
-	for (unsigned int i = 0; i < constantBufferCount; i++)
-	{
-		deviceContext->HSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			&constantBuffers[i].ConstantBuffer);
-	}
+	// Set the constant buffers
+	BindConstantBuffers();
+}
+
+// --------------------------------------------------------
+// Binds a single constant buffer (or a slice of one) to
+// the hull shader stage
+// --------------------------------------------------------
+void SimpleHullShader::SetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer, const UINT* firstConstant, const UINT* numConstants)
+{
+	if (firstConstant && deviceContext1)
+		deviceContext1->HSSetConstantBuffers1(slot, 1, &buffer, firstConstant, numConstants);
+	else
+		deviceContext->HSSetConstantBuffers(slot, 1, &buffer);
 }
 
 // --------------------------------------------------------
@@ -1178,6 +1860,30 @@ bool SimpleHullShader::SetSamplerState(std::string name, ID3D11SamplerState* sam
 	return true;
 }
 
+// --------------------------------------------------------
+// Handle versions of SetShaderResourceView/SetSamplerState
+// for the hull shader stage
+// --------------------------------------------------------
+bool SimpleHullShader::SetShaderResourceView(int handle, ID3D11ShaderResourceView* srv)
+{
+	const SimpleSRV* srvInfo = GetShaderResourceViewInfo((unsigned int)handle);
+	if (handle < 0 || srvInfo == 0)
+		return false;
+
+	deviceContext->HSSetShaderResources(srvInfo->BindIndex, 1, &srv);
+	return true;
+}
+
+bool SimpleHullShader::SetSamplerState(int handle, ID3D11SamplerState* samplerState)
+{
+	const SimpleSampler* sampInfo = GetSamplerInfo((unsigned int)handle);
+	if (handle < 0 || sampInfo == 0)
+		return false;
+
+	deviceContext->HSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
+	return true;
+}
+
 
 
 
@@ -1222,10 +1928,6 @@ void SimpleGeometryShader::CleanUp()
 // --------------------------------------------------------
 bool SimpleGeometryShader::CreateShader(ID3DBlob* shaderBlob)
 {
-	// Clean up first, in the event this method is
-	// called more than once on the same object
-	this->CleanUp();
-
 	// Using stream out?
 	if (useStreamOut)
 		return this->CreateShaderWithStreamOut(shaderBlob);
@@ -1251,10 +1953,6 @@ bool SimpleGeometryShader::CreateShader(ID3DBlob* shaderBlob)
 // --------------------------------------------------------
 bool SimpleGeometryShader::CreateShaderWithStreamOut(ID3DBlob* shaderBlob)
 {
-	// Clean up first, in the event this method is
-	// called more than once on the same object
-	this->CleanUp();
-
 	// Reflect shader info
 	ID3D11ShaderReflection* refl;
 	D3DReflect(
@@ -1368,14 +2066,20 @@ void SimpleGeometryShader::SetShaderAndCBs()
 	// Set the shader
 	deviceContext->GSSetShader(shader, 0, 0);
 
-	// Set the constant buffers?
-	for (unsigned int i = 0; i < constantBufferCount; i++)
-	{
-		deviceContext->GSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			&constantBuffers[i].ConstantBuffer);
-	}
+	// Set the constant buffers
+	BindConstantBuffers();
+}
+
+// --------------------------------------------------------
+// Binds a single constant buffer (or a slice of one) to
+// the geometry shader stage
+// --------------------------------------------------------
+void SimpleGeometryShader::SetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer, const UINT* firstConstant, const UINT* numConstants)
+{
+	if (firstConstant && deviceContext1)
+		deviceContext1->GSSetConstantBuffers1(slot, 1, &buffer, firstConstant, numConstants);
+	else
+		deviceContext->GSSetConstantBuffers(slot, 1, &buffer);
 }
 
 // --------------------------------------------------------
@@ -1422,6 +2126,30 @@ bool SimpleGeometryShader::SetSamplerState(std::string name, ID3D11SamplerState*
 	return true;
 }
 
+// --------------------------------------------------------
+// Handle versions of SetShaderResourceView/SetSamplerState
+// for the geometry shader stage
+// --------------------------------------------------------
+bool SimpleGeometryShader::SetShaderResourceView(int handle, ID3D11ShaderResourceView* srv)
+{
+	const SimpleSRV* srvInfo = GetShaderResourceViewInfo((unsigned int)handle);
+	if (handle < 0 || srvInfo == 0)
+		return false;
+
+	deviceContext->GSSetShaderResources(srvInfo->BindIndex, 1, &srv);
+	return true;
+}
+
+bool SimpleGeometryShader::SetSamplerState(int handle, ID3D11SamplerState* samplerState)
+{
+	const SimpleSampler* sampInfo = GetSamplerInfo((unsigned int)handle);
+	if (handle < 0 || sampInfo == 0)
+		return false;
+
+	deviceContext->GSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
+	return true;
+}
+
 // --------------------------------------------------------
 // Calculates the number of components specified by a parameter description mask
 //
@@ -1482,10 +2210,6 @@ void SimpleComputeShader::CleanUp()
 // --------------------------------------------------------
 bool SimpleComputeShader::CreateShader(ID3DBlob* shaderBlob)
 {
-	// Clean up first, in the event this method is
-	// called more than once on the same object
-	this->CleanUp();
-
 	// Create the shader from the blob
 	HRESULT result = device->CreateComputeShader(
 		shaderBlob->GetBufferPointer(),
@@ -1553,14 +2277,20 @@ void SimpleComputeShader::SetShaderAndCBs()
 	// Set the shader
 	deviceContext->CSSetShader(shader, 0, 0);
 
-	// Set the constant buffers?
-	for (unsigned int i = 0; i < constantBufferCount; i++)
-	{
-		deviceContext->CSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			&constantBuffers[i].ConstantBuffer);
-	}
+	// Set the constant buffers
+	BindConstantBuffers();
+}
+
+// --------------------------------------------------------
+// Binds a single constant buffer (or a slice of one) to
+// the compute shader stage
+// --------------------------------------------------------
+void SimpleComputeShader::SetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer, const UINT* firstConstant, const UINT* numConstants)
+{
+	if (firstConstant && deviceContext1)
+		deviceContext1->CSSetConstantBuffers1(slot, 1, &buffer, firstConstant, numConstants);
+	else
+		deviceContext->CSSetConstantBuffers(slot, 1, &buffer);
 }
 
 // --------------------------------------------------------
@@ -1660,6 +2390,30 @@ bool SimpleComputeShader::SetSamplerState(std::string name, ID3D11SamplerState*
 	return true;
 }
 
+// --------------------------------------------------------
+// Handle versions of SetShaderResourceView/SetSamplerState
+// for the compute shader stage
+// --------------------------------------------------------
+bool SimpleComputeShader::SetShaderResourceView(int handle, ID3D11ShaderResourceView* srv)
+{
+	const SimpleSRV* srvInfo = GetShaderResourceViewInfo((unsigned int)handle);
+	if (handle < 0 || srvInfo == 0)
+		return false;
+
+	deviceContext->CSSetShaderResources(srvInfo->BindIndex, 1, &srv);
+	return true;
+}
+
+bool SimpleComputeShader::SetSamplerState(int handle, ID3D11SamplerState* samplerState)
+{
+	const SimpleSampler* sampInfo = GetSamplerInfo((unsigned int)handle);
+	if (handle < 0 || sampInfo == 0)
+		return false;
+
+	deviceContext->CSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
+	return true;
+}
+
 // --------------------------------------------------------
 // Sets an unordered access view in the Compute shader stage
 //
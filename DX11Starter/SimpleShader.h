@@ -3,37 +3,52 @@
 #pragma comment(lib, "d3dcompiler.lib")
 
 #include <d3d11.h>
+#include <d3d11_1.h>
 #include <d3dcompiler.h>
 #include <DirectXMath.h>
 
+#include <atomic>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <string>
+#include <typeinfo>
+
+#include "FrameUploadBuffer.h"
+#include "ShaderParameters.h"
+#include "ReflectionSidecar.h"
+#include "ConstantBufferGenerator.h"
 
 // --------------------------------------------------------
-// Used by simple shaders to store information about
-// specific variables in constant buffers
+// Contains information about a specific
+// constant buffer in a shader (shared by every
+// shader object that loads the same file)
 // --------------------------------------------------------
-struct SimpleShaderVariable
+struct SimpleConstantBuffer
 {
-	unsigned int ByteOffset;
+	std::string Name;
 	unsigned int Size;
-	unsigned int ConstantBufferIndex;
+	unsigned int BindIndex;
+	bool Shared;	// Filled and bound by someone else (no buffer or variables here)
+	std::vector<SimpleShaderVariable> Variables;
 };
 
 // --------------------------------------------------------
-// Contains information about a specific
-// constant buffer in a shader, as well as
-// the local data buffer for it
+// One shader object's own copy of a constant buffer: the
+// GPU buffer, on top of the local data buffer for it
 // --------------------------------------------------------
-struct SimpleConstantBuffer
+struct SimpleConstantBufferData : SimpleLocalBufferData
 {
-	std::string Name;
-	unsigned int Size;
+	// Copied from the layout so uploads and binds don't have to look it up
 	unsigned int BindIndex;
+	bool Shared;
+
 	ID3D11Buffer* ConstantBuffer;
-	unsigned char* LocalDataBuffer;
-	std::vector<SimpleShaderVariable> Variables;
+
+	// Slice of the shared frame upload buffer holding this
+	// buffer's data, if it was uploaded that way this frame
+	unsigned long long UploadFrame;
+	unsigned int UploadOffset;
 };
 
 // --------------------------------------------------------
@@ -54,6 +69,62 @@ struct SimpleSampler
 	unsigned int BindIndex; // The register of the Sampler
 };
 
+// --------------------------------------------------------
+// Everything about a loaded shader file that's the same
+// for every material using it: the compiled code, the D3D
+// shader object, the input layout and the reflection
+// tables.  Shader objects that load the same file (with
+// the same contents) share one program, reference counted.
+// --------------------------------------------------------
+struct SimpleShaderProgram
+{
+	unsigned int RefCount;
+	bool Cached;					// Still in the program cache?
+	std::wstring Key;				// Stage + file path
+	unsigned long long ContentHash;	// Hash of the compiled code
+
+	ID3DBlob* Blob;
+	ID3D11DeviceChild* Shader;		// The stage's shader object
+	ID3D11InputLayout* InputLayout;	// Vertex shaders only (may be null)
+	bool PerInstanceCompatible;		// Vertex shaders only
+
+	// Reflection data (raw, then as lookup tables)
+	ShaderReflectionData Reflection;
+	std::vector<SimpleConstantBuffer> ConstantBuffers;
+	std::vector<SimpleSRV> ShaderResourceViews;
+	std::vector<SimpleSampler> SamplerStates;
+	ShaderVariableTable Variables;	// Indexed by handle
+	ShaderNameTable CBTable;
+	ShaderNameTable TextureTable;
+	ShaderNameTable SamplerTable;
+};
+
+// --------------------------------------------------------
+// Totals for the program cache, to see what sharing saves
+// --------------------------------------------------------
+struct SimpleShaderProgramStats
+{
+	unsigned int Loads;				// LoadShaderFile calls
+	unsigned int ProgramsCreated;	// Shaders actually created and reflected
+	unsigned int ProgramsShared;	// Loads that reused an existing program
+	unsigned int SidecarsLoaded;	// Programs reflected from a .refl file
+	unsigned int SidecarsWritten;	// .refl files (re)written after reflecting
+	unsigned long long BytesShared;	// Bytecode + reflection we didn't duplicate
+	double LoadMilliseconds;		// Total time spent in LoadShaderFile
+};
+
+// --------------------------------------------------------
+// Running totals of constant buffer uploads, across all
+// shaders, so we can see what dirty tracking saves us
+// --------------------------------------------------------
+struct SimpleShaderUploadStats
+{
+	unsigned long long Uploads;
+	unsigned long long UploadsSkipped;
+	unsigned long long BytesUploaded;
+	unsigned long long BytesSaved;
+};
+
 // --------------------------------------------------------
 // Base abstract class for simplifying shader handling
 // --------------------------------------------------------
@@ -70,12 +141,52 @@ public:
 	// Simple helpers
 	bool IsShaderValid() { return shaderValid; }
 
+	// Redirects all future commands (including constant buffer
+	// updates) to another context, such as a deferred context
+	void SetDeviceContext(ID3D11DeviceContext* context);
+
+	// Shared per-frame buffer that all shaders sub-allocate their
+	// constant data from (pass null to use per-shader buffers)
+	static void SetFrameUploadBuffer(FrameUploadBuffer* upload) { frameUpload = upload; }
+
+	// Constant buffers with these names (like per-frame camera data) are
+	// owned by the game, so shaders never create, upload or bind them.
+	// Register names before loading any shaders that use them.
+	static void AddSharedConstantBuffer(std::string name) { sharedBufferNames.insert(name); }
+
+	// C++ structs that mirror cbuffers (see ConstantBuffers.h).  Every
+	// shader loaded afterwards is checked against these, and fails to
+	// load (with an error on the console) if a struct doesn't match.
+	static void RegisterConstantBufferLayouts(const ConstantBufferLayout* layouts, unsigned int count);
+
+	// Writes C++ structs for the cbuffers of every shader loaded so
+	// far (minus shared buffers) - the source of ConstantBuffers.h
+	static std::string GenerateConstantBufferHeader();
+
+	// Upload counters (shared by all shaders)
+	static SimpleShaderUploadStats GetUploadStats();
+	static void ResetUploadStats();
+
+	// Program cache totals (shared by all shaders)
+	static SimpleShaderProgramStats GetProgramStats() { return programStats; }
+
 	// Activating the shader and copying data
 	void SetShader();
 	void CopyAllBufferData();
 	void CopyBufferData(unsigned int index);
 	void CopyBufferData(std::string bufferName);
 
+	// Handles for variables, SRVs and samplers.  Look them up once, then
+	// set through the handle with no string building or hashing.
+	// Returns InvalidHandle if this shader has nothing by that name.
+	static const int InvalidHandle = -1;
+	int GetVariableHandle(std::string name);
+	int GetVariableHandle(unsigned int nameHash);
+	int GetShaderResourceViewHandle(std::string name);
+	int GetShaderResourceViewHandle(unsigned int nameHash);
+	int GetSamplerHandle(std::string name);
+	int GetSamplerHandle(unsigned int nameHash);
+
 	// Sets arbitrary shader data
 	bool SetData(std::string name, const void* data, unsigned int size);
 
@@ -90,20 +201,44 @@ public:
 	bool SetMatrix4x4(std::string name, const float data[16]);
 	bool SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 data);
 
+	// Same as above, through a handle from GetVariableHandle()
+	bool SetData(int handle, const void* data, unsigned int size);
+
+	// Whole constant buffers at once, from a struct that mirrors the
+	// cbuffer.  The template version of GetConstantBufferHandle() only
+	// returns a handle if T's layout matches the shader's exactly.
+	int GetConstantBufferHandle(std::string bufferName);
+	template<typename T> int GetConstantBufferHandle();
+	bool SetConstantBufferData(int bufferHandle, const void* data, unsigned int size);
+	template<typename T> bool SetConstantBufferData(int bufferHandle, const T& data) { return SetConstantBufferData(bufferHandle, &data, sizeof(T)); }
+
+	bool SetInt(int handle, int data);
+	bool SetFloat(int handle, float data);
+	bool SetFloat2(int handle, const float data[2]);
+	bool SetFloat2(int handle, const DirectX::XMFLOAT2 data);
+	bool SetFloat3(int handle, const float data[3]);
+	bool SetFloat3(int handle, const DirectX::XMFLOAT3 data);
+	bool SetFloat4(int handle, const float data[4]);
+	bool SetFloat4(int handle, const DirectX::XMFLOAT4 data);
+	bool SetMatrix4x4(int handle, const float data[16]);
+	bool SetMatrix4x4(int handle, const DirectX::XMFLOAT4X4 data);
+
 	// Setting shader resources
 	virtual bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv) = 0;
 	virtual bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState) = 0;
+	virtual bool SetShaderResourceView(int handle, ID3D11ShaderResourceView* srv) = 0;
+	virtual bool SetSamplerState(int handle, ID3D11SamplerState* samplerState) = 0;
 
 	// Getting data about variables and resources
 	const SimpleShaderVariable* GetVariableInfo(std::string name);
 	
 	const SimpleSRV* GetShaderResourceViewInfo(std::string name);
 	const SimpleSRV* GetShaderResourceViewInfo(unsigned int index);
-	size_t GetShaderResourceViewCount() { return textureTable.size(); }
+	size_t GetShaderResourceViewCount() { return program ? program->ShaderResourceViews.size() : 0; }
 	
 	const SimpleSampler* GetSamplerInfo(std::string name);
 	const SimpleSampler* GetSamplerInfo(unsigned int index);
-	size_t GetSamplerCount() { return samplerTable.size(); }
+	size_t GetSamplerCount() { return program ? program->SamplerStates.size() : 0; }
 
 	// Get data about constant buffers
 	unsigned int GetBufferCount();
@@ -112,38 +247,86 @@ public:
 	const SimpleConstantBuffer* GetBufferInfo(unsigned int index);
 	
 	// Misc getters
-	ID3DBlob* GetShaderBlob() { return shaderBlob; }
+	ID3DBlob* GetShaderBlob() { return program ? program->Blob : 0; }
 
 protected:
 	
 	bool shaderValid;
-	ID3DBlob* shaderBlob;
 	ID3D11Device* device;
 	ID3D11DeviceContext* deviceContext;
+	ID3D11DeviceContext1* deviceContext1; // Same context, for binding buffer slices (may be null)
+
+	static FrameUploadBuffer* frameUpload;
+	static std::unordered_set<std::string> sharedBufferNames;
+
+	// Programs by stage + path, so each file is only created and reflected once
+	static std::unordered_map<std::wstring, SimpleShaderProgram*> programCache;
+	static SimpleShaderProgramStats programStats;
+
+	// Shaders may be recording on several threads at once
+	static std::atomic<unsigned long long> statUploads;
+	static std::atomic<unsigned long long> statUploadsSkipped;
+	static std::atomic<unsigned long long> statBytesUploaded;
+	static std::atomic<unsigned long long> statBytesSaved;
 
-	// Resource counts
+	// The shared program (code, shader object, reflection)
+	SimpleShaderProgram* program;
+
+	// This shader's own constant buffers (same order as the program's)
 	unsigned int constantBufferCount;
-	
-	// Maps for variables and buffers
-	SimpleConstantBuffer*		constantBuffers; // For index-based lookup
-	std::vector<SimpleSRV*>		shaderResourceViews;
-	std::vector<SimpleSampler*>	samplerStates;
-	std::unordered_map<std::string, SimpleConstantBuffer*> cbTable;
-	std::unordered_map<std::string, SimpleShaderVariable> varTable;
-	std::unordered_map<std::string, SimpleSRV*> textureTable;
-	std::unordered_map<std::string, SimpleSampler*> samplerTable;
+	SimpleConstantBufferData* constantBuffers;
 
 	// Pure virtual functions for dealing with shader types
 	virtual bool CreateShader(ID3DBlob* shaderBlob) = 0;
 	virtual void SetShaderAndCBs() = 0;
 
+	// The shader object CreateShader() made, so it can be shared
+	virtual ID3D11DeviceChild* GetShaderObject() = 0;
+
+	// Takes the shader object from a program that's already loaded.
+	// Stages that can't share (compute, stream out) return false and
+	// get their own program instead.
+	virtual bool AdoptShader(SimpleShaderProgram* source) { return false; }
+
+	// Binds one constant buffer to this shader's stage.  firstConstant and
+	// numConstants are only used (and only non-null) when binding a slice.
+	virtual void SetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer, const UINT* firstConstant, const UINT* numConstants) = 0;
+
+	// Constant buffer helpers shared by all stages
+	void UploadConstantBuffer(SimpleConstantBufferData* cb);
+	void BindConstantBuffers();
+
+	// Program helpers
+	static void ReflectShader(ID3DBlob* shaderBlob, ShaderReflectionData* reflection);
+	void BuildProgramTables(SimpleShaderProgram* target, const ShaderReflectionData& reflection);
+	void CreateConstantBuffers();
+	static void ReleaseProgram(SimpleShaderProgram* target);
+
+	// Layout checks against registered C++ structs
+	static std::vector<ConstantBufferLayout> registeredLayouts;
+	bool VerifyConstantBufferLayouts(LPCWSTR shaderFile);
+	bool MatchesLayout(int bufferHandle, const ConstantBufferField* fields, unsigned int fieldCount, unsigned int size, std::string* mismatch);
+
 	virtual void CleanUp();
 
-	// Helpers for finding data by name
-	SimpleShaderVariable* FindVariable(std::string name, int size);
-	SimpleConstantBuffer* FindConstantBuffer(std::string name);
+	// Helper for finding buffers by name
+	int FindConstantBufferIndex(std::string name);
 };
 
+// --------------------------------------------------------
+// Handle to a constant buffer laid out exactly like T
+// (a struct from ConstantBuffers.h), or InvalidHandle
+// --------------------------------------------------------
+template<typename T>
+int ISimpleShader::GetConstantBufferHandle()
+{
+	int handle = GetConstantBufferHandle(T::BufferName());
+	if (handle == InvalidHandle || !MatchesLayout(handle, T::Fields(), T::FieldCount, sizeof(T), 0))
+		return InvalidHandle;
+
+	return handle;
+}
+
 // --------------------------------------------------------
 // Derived class for VERTEX shaders ///////////////////////
 // --------------------------------------------------------
@@ -159,6 +342,8 @@ public:
 
 	bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv);
 	bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState);
+	bool SetShaderResourceView(int handle, ID3D11ShaderResourceView* srv);
+	bool SetSamplerState(int handle, ID3D11SamplerState* samplerState);
 
 protected:
 	bool perInstanceCompatible;
@@ -166,6 +351,10 @@ protected:
 	ID3D11VertexShader* shader;
 	bool CreateShader(ID3DBlob* shaderBlob);
 	void SetShaderAndCBs();
+	ID3D11DeviceChild* GetShaderObject() { return shader; }
+	bool AdoptShader(SimpleShaderProgram* source);
+	bool CreateInputLayout(ID3DBlob* shaderBlob);
+	void SetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer, const UINT* firstConstant, const UINT* numConstants);
 	void CleanUp();
 };
 
@@ -182,11 +371,16 @@ public:
 
 	bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv);
 	bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState);
+	bool SetShaderResourceView(int handle, ID3D11ShaderResourceView* srv);
+	bool SetSamplerState(int handle, ID3D11SamplerState* samplerState);
 
 protected:
 	ID3D11PixelShader* shader;
 	bool CreateShader(ID3DBlob* shaderBlob);
 	void SetShaderAndCBs();
+	ID3D11DeviceChild* GetShaderObject() { return shader; }
+	bool AdoptShader(SimpleShaderProgram* source);
+	void SetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer, const UINT* firstConstant, const UINT* numConstants);
 	void CleanUp();
 };
 
@@ -202,11 +396,16 @@ public:
 
 	bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv);
 	bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState);
+	bool SetShaderResourceView(int handle, ID3D11ShaderResourceView* srv);
+	bool SetSamplerState(int handle, ID3D11SamplerState* samplerState);
 
 protected:
 	ID3D11DomainShader* shader;
 	bool CreateShader(ID3DBlob* shaderBlob);
 	void SetShaderAndCBs();
+	ID3D11DeviceChild* GetShaderObject() { return shader; }
+	bool AdoptShader(SimpleShaderProgram* source);
+	void SetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer, const UINT* firstConstant, const UINT* numConstants);
 	void CleanUp();
 };
 
@@ -222,11 +421,16 @@ public:
 
 	bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv);
 	bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState);
+	bool SetShaderResourceView(int handle, ID3D11ShaderResourceView* srv);
+	bool SetSamplerState(int handle, ID3D11SamplerState* samplerState);
 
 protected:
 	ID3D11HullShader* shader;
 	bool CreateShader(ID3DBlob* shaderBlob);
 	void SetShaderAndCBs();
+	ID3D11DeviceChild* GetShaderObject() { return shader; }
+	bool AdoptShader(SimpleShaderProgram* source);
+	void SetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer, const UINT* firstConstant, const UINT* numConstants);
 	void CleanUp();
 };
 
@@ -242,6 +446,8 @@ public:
 
 	bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv);
 	bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState);
+	bool SetShaderResourceView(int handle, ID3D11ShaderResourceView* srv);
+	bool SetSamplerState(int handle, ID3D11SamplerState* samplerState);
 
 	bool CreateCompatibleStreamOutBuffer(ID3D11Buffer** buffer, int vertexCount);
 
@@ -259,6 +465,8 @@ protected:
 	bool CreateShader(ID3DBlob* shaderBlob);
 	bool CreateShaderWithStreamOut(ID3DBlob* shaderBlob);
 	void SetShaderAndCBs();
+	ID3D11DeviceChild* GetShaderObject() { return shader; }
+	void SetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer, const UINT* firstConstant, const UINT* numConstants);
 	void CleanUp();
 
 	// Helpers
@@ -281,6 +489,8 @@ public:
 
 	bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv);
 	bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState);
+	bool SetShaderResourceView(int handle, ID3D11ShaderResourceView* srv);
+	bool SetSamplerState(int handle, ID3D11SamplerState* samplerState);
 	bool SetUnorderedAccessView(std::string name, ID3D11UnorderedAccessView* uav, unsigned int appendConsumeOffset = -1);
 
 	int GetUnorderedAccessViewIndex(std::string name);
@@ -296,5 +506,7 @@ protected:
 
 	bool CreateShader(ID3DBlob* shaderBlob);
 	void SetShaderAndCBs();
+	ID3D11DeviceChild* GetShaderObject() { return shader; }
+	void SetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer, const UINT* firstConstant, const UINT* numConstants);
 	void CleanUp();
 };
\ No newline at end of file
@@ -1,10 +1,4 @@
-
-// Constant Buffer for external (C++) data
-cbuffer externalData : register(b0)
-{
-	matrix view;
-	matrix projection;
-};
+#include "SharedConstants.hlsli"
 
 // Struct representing a single vertex worth of data
 struct VertexShaderInput
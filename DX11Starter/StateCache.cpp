@@ -0,0 +1,241 @@
+#include "StateCache.h"
+#include <cstring>
+
+// --------------------------------------------------------
+// 64 bit FNV-1a over a (normalized) desc
+// --------------------------------------------------------
+static unsigned long long HashDesc(const void* data, size_t size)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	unsigned long long hash = 14695981039346656037ull;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+StateCache::StateCache(ID3D11Device* device)
+{
+	this->device = device;
+}
+
+StateCache::~StateCache()
+{
+	ReleaseAll(blendStates);
+	ReleaseAll(depthStencilStates);
+	ReleaseAll(rasterizerStates);
+	ReleaseAll(samplerStates);
+}
+
+template<typename Desc, typename State>
+void StateCache::ReleaseAll(StateTable<Desc, State>& table)
+{
+	for (unsigned int i = 0; i < table.States.size(); i++)
+		table.States[i]->Release();
+
+	table.States.clear();
+	table.Descs.clear();
+	table.Lookup.clear();
+}
+
+// --------------------------------------------------------
+// Looks for an identical desc in the table, creating (and
+// remembering) the state if there isn't one
+// --------------------------------------------------------
+template<typename Desc, typename State>
+State* StateCache::FindOrCreate(StateTable<Desc, State>& table, const Desc& desc, unsigned int* id)
+{
+	Desc normalized = Normalize(desc);
+	unsigned long long hash = HashDesc(&normalized, sizeof(Desc));
+
+	// Already made?
+	std::pair<std::unordered_multimap<unsigned long long, unsigned int>::iterator,
+		std::unordered_multimap<unsigned long long, unsigned int>::iterator> range = table.Lookup.equal_range(hash);
+	for (std::unordered_multimap<unsigned long long, unsigned int>::iterator it = range.first; it != range.second; ++it)
+	{
+		if (memcmp(&table.Descs[it->second], &normalized, sizeof(Desc)) == 0)
+		{
+			if (id) *id = it->second + 1;
+			return table.States[it->second];
+		}
+	}
+
+	// Ids have to fit in their 16 bits of the key
+	if (table.States.size() >= 0xFFFF)
+		return 0;
+
+	State* state = 0;
+	if (CreateState(normalized, &state) != S_OK)
+		return 0;
+
+	unsigned int index = (unsigned int)table.States.size();
+	table.Descs.push_back(normalized);
+	table.States.push_back(state);
+	table.Lookup.insert(std::pair<unsigned long long, unsigned int>(hash, index));
+
+	if (id) *id = index + 1;
+	return state;
+}
+
+// --------------------------------------------------------
+// Public getters for each kind of state
+// --------------------------------------------------------
+ID3D11BlendState* StateCache::GetBlendState(const D3D11_BLEND_DESC& desc, unsigned int* id)
+{
+	return FindOrCreate(blendStates, desc, id);
+}
+
+ID3D11DepthStencilState* StateCache::GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc, unsigned int* id)
+{
+	return FindOrCreate(depthStencilStates, desc, id);
+}
+
+ID3D11RasterizerState* StateCache::GetRasterizerState(const D3D11_RASTERIZER_DESC& desc, unsigned int* id)
+{
+	return FindOrCreate(rasterizerStates, desc, id);
+}
+
+ID3D11SamplerState* StateCache::GetSamplerState(const D3D11_SAMPLER_DESC& desc)
+{
+	return FindOrCreate(samplerStates, desc, 0);
+}
+
+unsigned int StateCache::GetStateCount()
+{
+	return (unsigned int)(
+		blendStates.States.size() +
+		depthStencilStates.States.size() +
+		rasterizerStates.States.size() +
+		samplerStates.States.size());
+}
+
+// --------------------------------------------------------
+// Builds a bundle (and its key) from up to three descs
+// --------------------------------------------------------
+RenderState StateCache::GetRenderState(const D3D11_BLEND_DESC* blend, const D3D11_DEPTH_STENCIL_DESC* depthStencil, const D3D11_RASTERIZER_DESC* rasterizer)
+{
+	RenderState state = GetDefaultState();
+	unsigned int blendId = 0;
+	unsigned int depthStencilId = 0;
+	unsigned int rasterizerId = 0;
+
+	if (blend) state.Blend = GetBlendState(*blend, &blendId);
+	if (depthStencil) state.DepthStencil = GetDepthStencilState(*depthStencil, &depthStencilId);
+	if (rasterizer) state.Rasterizer = GetRasterizerState(*rasterizer, &rasterizerId);
+
+	state.Key = MakeKey(blendId, depthStencilId, rasterizerId);
+	return state;
+}
+
+RenderState StateCache::GetDefaultState()
+{
+	RenderState state;
+	state.Blend = 0;
+	state.DepthStencil = 0;
+	state.Rasterizer = 0;
+	state.Key = 0;
+	return state;
+}
+
+unsigned long long StateCache::MakeKey(unsigned int blendId, unsigned int depthStencilId, unsigned int rasterizerId)
+{
+	return
+		((unsigned long long)(blendId & 0xFFFF) << 32) |
+		((unsigned long long)(depthStencilId & 0xFFFF) << 16) |
+		(unsigned long long)(rasterizerId & 0xFFFF);
+}
+
+// --------------------------------------------------------
+// Sets a bundle's states on a context
+// --------------------------------------------------------
+void StateCache::Apply(ID3D11DeviceContext* context, const RenderState& state, const float blendFactor[4])
+{
+	context->OMSetBlendState(state.Blend, blendFactor, 0xFFFFFFFF);
+	context->OMSetDepthStencilState(state.DepthStencil, 0);
+	context->RSSetState(state.Rasterizer);
+}
+
+void StateCache::Apply(ID3D11DeviceContext* context, const RenderState& state, unsigned long long* currentKey, const float blendFactor[4])
+{
+	if (*currentKey == state.Key)
+		return;
+
+	Apply(context, state, blendFactor);
+	*currentKey = state.Key;
+}
+
+// --------------------------------------------------------
+// Zeroes any padding by building a fresh copy field by
+// field (blend and depth-stencil descs have UINT8 members
+// followed by padding)
+// --------------------------------------------------------
+D3D11_BLEND_DESC StateCache::Normalize(const D3D11_BLEND_DESC& desc)
+{
+	D3D11_BLEND_DESC result;
+	memset(&result, 0, sizeof(result));
+	result.AlphaToCoverageEnable = desc.AlphaToCoverageEnable;
+	result.IndependentBlendEnable = desc.IndependentBlendEnable;
+
+	for (unsigned int i = 0; i < 8; i++)
+	{
+		result.RenderTarget[i].BlendEnable = desc.RenderTarget[i].BlendEnable;
+		result.RenderTarget[i].SrcBlend = desc.RenderTarget[i].SrcBlend;
+		result.RenderTarget[i].DestBlend = desc.RenderTarget[i].DestBlend;
+		result.RenderTarget[i].BlendOp = desc.RenderTarget[i].BlendOp;
+		result.RenderTarget[i].SrcBlendAlpha = desc.RenderTarget[i].SrcBlendAlpha;
+		result.RenderTarget[i].DestBlendAlpha = desc.RenderTarget[i].DestBlendAlpha;
+		result.RenderTarget[i].BlendOpAlpha = desc.RenderTarget[i].BlendOpAlpha;
+		result.RenderTarget[i].RenderTargetWriteMask = desc.RenderTarget[i].RenderTargetWriteMask;
+	}
+	return result;
+}
+
+D3D11_DEPTH_STENCIL_DESC StateCache::Normalize(const D3D11_DEPTH_STENCIL_DESC& desc)
+{
+	D3D11_DEPTH_STENCIL_DESC result;
+	memset(&result, 0, sizeof(result));
+	result.DepthEnable = desc.DepthEnable;
+	result.DepthWriteMask = desc.DepthWriteMask;
+	result.DepthFunc = desc.DepthFunc;
+	result.StencilEnable = desc.StencilEnable;
+	result.StencilReadMask = desc.StencilReadMask;
+	result.StencilWriteMask = desc.StencilWriteMask;
+	result.FrontFace = desc.FrontFace;
+	result.BackFace = desc.BackFace;
+	return result;
+}
+
+D3D11_RASTERIZER_DESC StateCache::Normalize(const D3D11_RASTERIZER_DESC& desc)
+{
+	return desc;	// No padding
+}
+
+D3D11_SAMPLER_DESC StateCache::Normalize(const D3D11_SAMPLER_DESC& desc)
+{
+	return desc;	// No padding
+}
+
+// --------------------------------------------------------
+// Device calls for each kind of state
+// --------------------------------------------------------
+HRESULT StateCache::CreateState(const D3D11_BLEND_DESC& desc, ID3D11BlendState** state)
+{
+	return device->CreateBlendState(&desc, state);
+}
+
+HRESULT StateCache::CreateState(const D3D11_DEPTH_STENCIL_DESC& desc, ID3D11DepthStencilState** state)
+{
+	return device->CreateDepthStencilState(&desc, state);
+}
+
+HRESULT StateCache::CreateState(const D3D11_RASTERIZER_DESC& desc, ID3D11RasterizerState** state)
+{
+	return device->CreateRasterizerState(&desc, state);
+}
+
+HRESULT StateCache::CreateState(const D3D11_SAMPLER_DESC& desc, ID3D11SamplerState** state)
+{
+	return device->CreateSamplerState(&desc, state);
+}
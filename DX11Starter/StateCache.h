@@ -0,0 +1,95 @@
+#pragma once
+#include <d3d11.h>
+#include <unordered_map>
+#include <vector>
+
+// --------------------------------------------------------
+// A blend, depth-stencil and rasterizer state bundle, plus
+// a 64 bit key identifying it.  Two bundles with the same
+// key are the same objects, so draws can be sorted and
+// redundant state changes skipped by comparing keys.
+//
+// Key layout (each id is 16 bits, 0 = D3D's default state):
+//   bits 32-47 blend, 16-31 depth-stencil, 0-15 rasterizer
+// --------------------------------------------------------
+struct RenderState
+{
+	ID3D11BlendState* Blend;
+	ID3D11DepthStencilState* DepthStencil;
+	ID3D11RasterizerState* Rasterizer;
+	unsigned long long Key;
+};
+
+// --------------------------------------------------------
+// Creates each distinct pipeline state object once.
+//
+// States are looked up by a hash of their full description
+// (then compared in full), so asking twice for the same desc
+// returns the same object.  The cache owns every state it
+// hands out - callers just borrow the pointers, and nothing
+// needs to be released until the cache itself is deleted.
+// --------------------------------------------------------
+class StateCache
+{
+public:
+	StateCache(ID3D11Device* device);
+	~StateCache();
+
+	// Individual states (null if creation fails).  id, if given,
+	// gets the state's 16 bit id for building keys.
+	ID3D11BlendState* GetBlendState(const D3D11_BLEND_DESC& desc, unsigned int* id = 0);
+	ID3D11DepthStencilState* GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc, unsigned int* id = 0);
+	ID3D11RasterizerState* GetRasterizerState(const D3D11_RASTERIZER_DESC& desc, unsigned int* id = 0);
+	ID3D11SamplerState* GetSamplerState(const D3D11_SAMPLER_DESC& desc);
+
+	// A full bundle - any null desc means D3D's default for that state
+	RenderState GetRenderState(const D3D11_BLEND_DESC* blend, const D3D11_DEPTH_STENCIL_DESC* depthStencil, const D3D11_RASTERIZER_DESC* rasterizer);
+	static RenderState GetDefaultState();
+
+	// Sets a bundle on a context.  The second version skips the
+	// calls if currentKey says the bundle is already set (and
+	// updates it otherwise).
+	static void Apply(ID3D11DeviceContext* context, const RenderState& state, const float blendFactor[4] = 0);
+	static void Apply(ID3D11DeviceContext* context, const RenderState& state, unsigned long long* currentKey, const float blendFactor[4] = 0);
+
+	static unsigned long long MakeKey(unsigned int blendId, unsigned int depthStencilId, unsigned int rasterizerId);
+
+	// Number of distinct objects created so far
+	unsigned int GetStateCount();
+
+private:
+	// Descs and states of one kind, where a state's id is its
+	// index + 1 (so 0 can mean "default")
+	template<typename Desc, typename State>
+	struct StateTable
+	{
+		std::unordered_multimap<unsigned long long, unsigned int> Lookup;
+		std::vector<Desc> Descs;
+		std::vector<State*> States;
+	};
+
+	ID3D11Device* device;
+
+	StateTable<D3D11_BLEND_DESC, ID3D11BlendState> blendStates;
+	StateTable<D3D11_DEPTH_STENCIL_DESC, ID3D11DepthStencilState> depthStencilStates;
+	StateTable<D3D11_RASTERIZER_DESC, ID3D11RasterizerState> rasterizerStates;
+	StateTable<D3D11_SAMPLER_DESC, ID3D11SamplerState> samplerStates;
+
+	// Copies of descs with any padding zeroed, so they can be
+	// hashed and compared as raw bytes
+	static D3D11_BLEND_DESC Normalize(const D3D11_BLEND_DESC& desc);
+	static D3D11_DEPTH_STENCIL_DESC Normalize(const D3D11_DEPTH_STENCIL_DESC& desc);
+	static D3D11_RASTERIZER_DESC Normalize(const D3D11_RASTERIZER_DESC& desc);
+	static D3D11_SAMPLER_DESC Normalize(const D3D11_SAMPLER_DESC& desc);
+
+	HRESULT CreateState(const D3D11_BLEND_DESC& desc, ID3D11BlendState** state);
+	HRESULT CreateState(const D3D11_DEPTH_STENCIL_DESC& desc, ID3D11DepthStencilState** state);
+	HRESULT CreateState(const D3D11_RASTERIZER_DESC& desc, ID3D11RasterizerState** state);
+	HRESULT CreateState(const D3D11_SAMPLER_DESC& desc, ID3D11SamplerState** state);
+
+	template<typename Desc, typename State>
+	State* FindOrCreate(StateTable<Desc, State>& table, const Desc& desc, unsigned int* id);
+
+	template<typename Desc, typename State>
+	static void ReleaseAll(StateTable<Desc, State>& table);
+};
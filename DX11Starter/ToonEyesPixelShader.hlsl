@@ -1,3 +1,4 @@
+#include "SharedConstants.hlsli"
 
 // Struct representing the data we expect to receive from earlier pipeline stages
 // - Should match the output of our corresponding vertex shader
@@ -38,8 +39,6 @@ cbuffer externalData : register(b0) {
 	DirectionalLight dLight1;
 	//DirectionalLight dLight2;
 	//PointLight pLight1;
-	float3 CameraPosition;
-	float Time;
 };
 
 Texture2D DiffuseTexture : register(t0);
@@ -103,9 +102,9 @@ float4 main(VertexToPixel input) : SV_TARGET
 	float2 projectionTexCoord;
 	float2 projectionTexCoord2;
 	float speed = .1f;
-	projectionTexCoord.x = (input.viewPos.x / input.viewPos.w / 2.0f + .5f) + (Time*speed);
-	projectionTexCoord.y = (input.viewPos.y / input.viewPos.w / 2.0f + .5f) + (Time*speed);
-	projectionTexCoord2.x = (-input.viewPos.x / input.viewPos.w / 2.0f + .5f) + (Time*speed);
+	projectionTexCoord.x = (input.viewPos.x / input.viewPos.w / 2.0f + .5f) + (time*speed);
+	projectionTexCoord.y = (input.viewPos.y / input.viewPos.w / 2.0f + .5f) + (time*speed);
+	projectionTexCoord2.x = (-input.viewPos.x / input.viewPos.w / 2.0f + .5f) + (time*speed);
 	projectionTexCoord2.y = (-input.viewPos.y / input.viewPos.w / 2.0f + .5f) + (0 * speed);
 	//check if coordinates are within the projection (in 0 to 1 range)
 	//http://www.rastertek.com/dx11tut43.html tutorial i'm using 
@@ -0,0 +1,152 @@
+#include "UploadRing.h"
+
+UploadRing::UploadRing(unsigned int capacity, unsigned int alignment, unsigned int maxFramesInFlight)
+{
+	this->alignment = alignment;
+	this->capacity = capacity & ~(alignment - 1);
+	this->maxFramesInFlight = maxFramesInFlight;
+
+	frames = new FrameRecord[maxFramesInFlight];
+	firstFrame = 0;
+	framesInFlight = 0;
+
+	head = 0;
+	tail = 0;
+
+	frameOpen = false;
+	currentFrame = 0;
+	windowStart = 0;
+	windowEnd = 0;
+	windowUsed = 0;
+}
+
+UploadRing::~UploadRing()
+{
+	delete[] frames;
+}
+
+// --------------------------------------------------------
+// Opens a frame by picking the largest contiguous free
+// window in the ring.  Allocations never wrap mid-frame, so
+// the GPU side only ever sees a single contiguous range.
+// --------------------------------------------------------
+bool UploadRing::BeginFrame(unsigned long long frameIndex)
+{
+	if (frameOpen || framesInFlight == maxFramesInFlight)
+		return false;
+
+	if (framesInFlight == 0 || GetBytesInFlight() == 0)
+	{
+		// Nothing in use, so the whole ring is free
+		head = 0;
+		tail = 0;
+		windowStart = 0;
+		windowEnd = capacity;
+	}
+	else if (head > tail)
+	{
+		// Free space is [head, capacity) plus [0, tail) - use the bigger piece
+		if (capacity - head >= tail)
+		{
+			windowStart = head;
+			windowEnd = capacity;
+		}
+		else
+		{
+			windowStart = 0;
+			windowEnd = tail;
+		}
+	}
+	else
+	{
+		// Already wrapped, so free space is just [head, tail)
+		windowStart = head;
+		windowEnd = tail;
+	}
+
+	currentFrame = frameIndex;
+	windowUsed = 0;
+	frameOpen = true;
+	return true;
+}
+
+bool UploadRing::Allocate(unsigned int size, unsigned int* offset)
+{
+	if (!frameOpen)
+		return false;
+
+	unsigned int aligned = AlignSize(size);
+	unsigned int windowSize = windowEnd - windowStart;
+
+	// Bump the shared pointer, and back out if we went past the end
+	unsigned int start = windowUsed.fetch_add(aligned);
+	if (start + aligned > windowSize || start + aligned < start)
+	{
+		windowUsed.fetch_sub(aligned);
+		return false;
+	}
+
+	*offset = windowStart + start;
+	return true;
+}
+
+void UploadRing::EndFrame()
+{
+	if (!frameOpen)
+		return;
+
+	unsigned int used = windowUsed;
+	if (used > windowEnd - windowStart)
+		used = windowEnd - windowStart;
+
+	// A frame that used nothing still counts as in flight
+	// (so frame indices keep retiring in order), but it
+	// doesn't move the head
+	FrameRecord& record = frames[(firstFrame + framesInFlight) % maxFramesInFlight];
+	record.FrameIndex = currentFrame;
+	record.Start = used > 0 ? windowStart : head;
+	record.End = used > 0 ? windowStart + used : head;
+
+	if (framesInFlight == 0)
+		tail = record.Start;
+
+	head = record.End;
+	framesInFlight++;
+	frameOpen = false;
+}
+
+void UploadRing::RetireFrame(unsigned long long frameIndex)
+{
+	while (framesInFlight > 0 && frames[firstFrame].FrameIndex <= frameIndex)
+	{
+		// Everything up to the end of this frame is free again
+		tail = frames[firstFrame].End;
+		firstFrame = (firstFrame + 1) % maxFramesInFlight;
+		framesInFlight--;
+
+		if (framesInFlight > 0)
+			tail = frames[firstFrame].Start;
+	}
+}
+
+unsigned long long UploadRing::GetOldestFrameInFlight()
+{
+	return framesInFlight > 0 ? frames[firstFrame].FrameIndex : currentFrame;
+}
+
+unsigned int UploadRing::GetFrameBytesUsed()
+{
+	unsigned int used = windowUsed;
+	return used < windowEnd - windowStart ? used : windowEnd - windowStart;
+}
+
+unsigned int UploadRing::GetBytesInFlight()
+{
+	unsigned int total = 0;
+	for (unsigned int i = 0; i < framesInFlight; i++)
+	{
+		FrameRecord& record = frames[(firstFrame + i) % maxFramesInFlight];
+		total += record.End - record.Start;
+	}
+	return total;
+}
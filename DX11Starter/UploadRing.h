@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+
+// --------------------------------------------------------
+// Bookkeeping for a ring buffer that is sub-allocated once
+// per frame and freed once the GPU is done with that frame.
+//
+// This class only hands out offsets - it never touches any
+// memory or graphics API - so it can be used (and tested)
+// on its own.
+//
+// Frames are opened with BeginFrame() and closed with
+// EndFrame().  While a frame is open, Allocate() can be
+// called from any thread.  Each closed frame keeps its slice
+// of the ring until RetireFrame() says the GPU finished it.
+// --------------------------------------------------------
+class UploadRing
+{
+public:
+	// capacity         - total bytes in the ring
+	// alignment        - every allocation starts on a multiple of this (power of 2)
+	// maxFramesInFlight - how many closed-but-not-retired frames we allow
+	UploadRing(unsigned int capacity, unsigned int alignment, unsigned int maxFramesInFlight);
+	~UploadRing();
+
+	// Opens a new frame.  Returns false (and opens nothing) if the
+	// maximum number of frames is already in flight.
+	bool BeginFrame(unsigned long long frameIndex);
+
+	// Reserves size bytes in the open frame.  Thread safe.
+	// Returns false if the frame's window is out of space.
+	bool Allocate(unsigned int size, unsigned int* offset);
+
+	// Closes the open frame so it can be retired later
+	void EndFrame();
+
+	// Frees every closed frame with an index <= frameIndex
+	void RetireFrame(unsigned long long frameIndex);
+
+	// Getters
+	bool IsFrameOpen() { return frameOpen; }
+	unsigned long long GetCurrentFrame() { return currentFrame; }
+	unsigned long long GetOldestFrameInFlight();
+	unsigned int GetFramesInFlight() { return framesInFlight; }
+	unsigned int GetCapacity() { return capacity; }
+	unsigned int GetAlignment() { return alignment; }
+	unsigned int GetWindowStart() { return windowStart; }
+	unsigned int GetWindowSize() { return windowEnd - windowStart; }
+	unsigned int GetFrameBytesUsed();
+	unsigned int GetBytesInFlight();
+
+	// Rounds size up to the ring's alignment
+	unsigned int AlignSize(unsigned int size) { return (size + alignment - 1) & ~(alignment - 1); }
+
+private:
+	struct FrameRecord
+	{
+		unsigned long long FrameIndex;
+		unsigned int Start;	// First byte this frame may have used
+		unsigned int End;	// One past the last byte this frame used
+	};
+
+	unsigned int capacity;
+	unsigned int alignment;
+
+	// Oldest-first queue of closed frames
+	FrameRecord* frames;
+	unsigned int maxFramesInFlight;
+	unsigned int firstFrame;
+	unsigned int framesInFlight;
+
+	// head - where the next frame starts; tail - start of the oldest frame in flight
+	unsigned int head;
+	unsigned int tail;
+
+	// The open frame's contiguous window and its bump pointer
+	bool frameOpen;
+	unsigned long long currentFrame;
+	unsigned int windowStart;
+	unsigned int windowEnd;
+	std::atomic<unsigned int> windowUsed;
+};
@@ -1,3 +1,4 @@
+#include "SharedConstants.hlsli"
 
 // Constant Buffer
 // - Allows us to define a buffer of individual variables 
@@ -8,13 +9,7 @@
 cbuffer externalData : register(b0)
 {
 	matrix world;
-	matrix view;
-	matrix projection;
 	float4 color;
-
-	//additional matrices for caustic light projection texturing - represent view and projection of the point of origin
-	matrix causticView;
-	matrix causticProjection;
 };
 
 // Struct representing a single vertex worth of data
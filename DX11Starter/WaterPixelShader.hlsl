@@ -1,3 +1,5 @@
+#include "SharedConstants.hlsli"
+
 struct VertexToPixel
 {
 	float4 position		: SV_POSITION;
@@ -17,8 +19,6 @@ struct DirectionalLight
 
 cbuffer externalData : register(b0) {
 	DirectionalLight dLight1;
-	float3 CameraPosition;
-	float time;
 };
 
 Texture2D DiffuseTexture : register(t0);
@@ -1,10 +1,9 @@
+#include "SharedConstants.hlsli"
+
 cbuffer externalData : register(b0)
 {
 	matrix world;
-	matrix view;
-	matrix projection;
 	float4 color;
-	float time;
 };
 
 struct VertexShaderInput
@@ -0,0 +1,109 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(unsigned int threadCount)
+{
+	currentJob = 0;
+	jobCount = 0;
+	nextJob = 0;
+	jobsFinished = 0;
+	batchId = 0;
+	workersBusy = 0;
+	shuttingDown = false;
+
+	for (unsigned int i = 0; i < threadCount; i++)
+		threads.push_back(std::thread(&WorkerPool::WorkerLoop, this));
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		shuttingDown = true;
+	}
+	wakeCondition.notify_all();
+
+	for (unsigned int i = 0; i < threads.size(); i++)
+		threads[i].join();
+}
+
+unsigned int WorkerPool::DefaultThreadCount()
+{
+	unsigned int hardware = std::thread::hardware_concurrency();
+	return hardware > 1 ? hardware - 1 : 0;
+}
+
+// --------------------------------------------------------
+// Runs job(i) for each i in [0, count).  The caller takes
+// jobs too, so this works (serially) with zero workers.
+// --------------------------------------------------------
+void WorkerPool::ParallelFor(unsigned int count, const std::function<void(unsigned int)>& job)
+{
+	if (count == 0)
+		return;
+
+	// Nothing to gain from waking threads for a single job
+	if (threads.empty() || count == 1)
+	{
+		for (unsigned int i = 0; i < count; i++)
+			job(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		currentJob = &job;
+		jobCount = count;
+		nextJob = 0;
+		jobsFinished = 0;
+		batchId++;
+	}
+	wakeCondition.notify_all();
+
+	// Help out on this thread
+	RunJobs();
+
+	// Wait for every job to finish AND every worker to leave this batch,
+	// since the job reference is only valid for the duration of this call
+	std::unique_lock<std::mutex> lock(mutex);
+	doneCondition.wait(lock, [this]() { return jobsFinished == jobCount && workersBusy == 0; });
+	currentJob = 0;
+	jobCount = 0;
+}
+
+void WorkerPool::RunJobs()
+{
+	while (true)
+	{
+		unsigned int index = nextJob.fetch_add(1);
+		if (index >= jobCount)
+			return;
+
+		(*currentJob)(index);
+		jobsFinished.fetch_add(1);
+	}
+}
+
+void WorkerPool::WorkerLoop()
+{
+	unsigned int lastBatch = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeCondition.wait(lock, [&]() { return shuttingDown || (batchId != lastBatch && currentJob != 0); });
+			if (shuttingDown)
+				return;
+
+			lastBatch = batchId;
+			workersBusy++;
+		}
+
+		RunJobs();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			workersBusy--;
+		}
+		doneCondition.notify_all();
+	}
+}
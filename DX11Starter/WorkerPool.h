@@ -0,0 +1,49 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// --------------------------------------------------------
+// A small pool of persistent worker threads.
+//
+// Work is handed out as a range of job indices [0, count),
+// and the calling thread helps out until every job is done.
+// Which thread runs which index is not deterministic, so
+// jobs should only ever write to their own index's slot.
+// --------------------------------------------------------
+class WorkerPool
+{
+public:
+	// threadCount - number of extra threads to spawn (0 = run everything on the caller)
+	WorkerPool(unsigned int threadCount);
+	~WorkerPool();
+
+	// Runs job(index) for every index in [0, count) and blocks until all are finished
+	void ParallelFor(unsigned int count, const std::function<void(unsigned int)>& job);
+
+	unsigned int GetThreadCount() { return (unsigned int)threads.size(); }
+
+	// Suggested worker count for this machine (hardware threads minus the main thread)
+	static unsigned int DefaultThreadCount();
+
+private:
+	void WorkerLoop();
+	void RunJobs();
+
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable wakeCondition;
+	std::condition_variable doneCondition;
+
+	// Current batch of work
+	const std::function<void(unsigned int)>* currentJob;
+	unsigned int jobCount;
+	std::atomic<unsigned int> nextJob;
+	std::atomic<unsigned int> jobsFinished;
+	unsigned int batchId;
+	unsigned int workersBusy;
+	bool shuttingDown;
+};
@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ParticleBenchmark.h"
+#include "RecordingBenchmark.h"
+#include "ShaderBenchmark.h"
+
+// --------------------------------------------------------
+// headless_benchmark [--suite name] [--frames count] [--output path]
+//
+// Writes JSON lines to the output file, or to stdout if no
+// path is given.  Exits non-zero on bad arguments or if the
+// results couldn't be written.
+// --------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	const char* suite = 0;
+	const char* path = 0;
+	int frames = 600;
+
+	for (int a = 1; a < argc; a++)
+	{
+		if (strcmp(argv[a], "--suite") == 0 && a + 1 < argc)
+			suite = argv[++a];
+		else if (strcmp(argv[a], "--frames") == 0 && a + 1 < argc)
+			frames = atoi(argv[++a]);
+		else if (strcmp(argv[a], "--output") == 0 && a + 1 < argc)
+			path = argv[++a];
+		else
+		{
+			fprintf(stderr, "usage: %s [--suite name] [--frames count] [--output path]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if (frames <= 0)
+	{
+		fprintf(stderr, "--frames must be at least 1\n");
+		return 2;
+	}
+
+	FILE* output = stdout;
+	if (path)
+	{
+		output = fopen(path, "w");
+		if (!output)
+		{
+			fprintf(stderr, "can't open %s\n", path);
+			return 1;
+		}
+	}
+
+	// Everything, or just the named suite
+	ParticleBenchmark particles(frames);
+	RecordingBenchmark recording(frames);
+	ShaderBenchmark shaders(frames);
+	bool written;
+	if (suite && strcmp(suite, "recording") == 0)
+		written = recording.Run(output);
+	else if (suite && ShaderBenchmark::HasSuite(suite))
+		written = shaders.Run(output, suite);
+	else if (suite)
+		written = particles.Run(output, suite);
+	else
+		written = particles.Run(output) && recording.Run(output) && shaders.Run(output);
+
+	if (output != stdout)
+		fclose(output);
+
+	if (!written && suite)
+		fprintf(stderr, "suite %s failed or doesn't exist\n", suite);
+	else if (!written)
+		fprintf(stderr, "writing results failed\n");
+
+	return written ? 0 : 1;
+}
@@ -0,0 +1,31 @@
+#include "BenchmarkTiming.h"
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+
+double BenchmarkNow()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+BenchmarkTiming SummarizeTimes(std::vector<double>& samples)
+{
+	BenchmarkTiming timing;
+	timing.P50 = Percentile(samples, 0.50);
+	timing.P99 = Percentile(samples, 0.99);
+	return timing;
+}
+
+double Percentile(std::vector<double>& samples, double fraction)
+{
+	if (samples.empty())
+		return 0;
+
+	std::sort(samples.begin(), samples.end());
+	size_t rank = (size_t)ceil(fraction * samples.size());
+	if (rank < 1)
+		rank = 1;
+	if (rank > samples.size())
+		rank = samples.size();
+	return samples[rank - 1];
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <vector>
+
+// --------------------------------------------------------
+// p50 and p99 of a set of per-frame times, in seconds
+// --------------------------------------------------------
+struct BenchmarkTiming
+{
+	double P50;
+	double P99;
+};
+
+// Seconds on a steady clock
+double BenchmarkNow();
+
+// Nearest rank percentiles - sorts the samples in place
+BenchmarkTiming SummarizeTimes(std::vector<double>& samples);
+double Percentile(std::vector<double>& samples, double fraction);
@@ -0,0 +1,769 @@
+#include "ParticleBenchmark.h"
+#include <math.h>
+#include <string.h>
+#include "ParticleBatcher.h"
+#include "ParticleBudget.h"
+#include "ParticleCurves.h"
+#include "ParticleRandom.h"
+#include "ParticleSorter.h"
+
+// --------------------------------------------------------
+// Emitters here are the same ballistic, curve-colored kind
+// the game uses, so they take the general update kernel
+// --------------------------------------------------------
+static const ParticleScenario scenarios[] = {
+	// Name					Emitters	Max		Per second	Lifetime	Mode
+	{ "many_small",			512,		100,	50.0f,		2.0f,		EMITTER_SIMULATED },
+	{ "one_huge",			1,			262144,	65536.0f,	4.0f,		EMITTER_SIMULATED },
+	{ "one_huge_analytic",	1,			262144,	65536.0f,	4.0f,		EMITTER_ANALYTIC },
+	{ "high_spawn",			16,			4096,	16000.0f,	0.25f,		EMITTER_SIMULATED },
+};
+
+static const double microseconds = 1000000.0;
+
+// --------------------------------------------------------
+// The particle layout and update Emitter had before its
+// state moved into streams - kept here only to measure
+// against
+// --------------------------------------------------------
+struct ReferenceParticle
+{
+	XMFLOAT3 Position;
+	XMFLOAT4 Color;
+	XMFLOAT3 StartVelocity;
+	float Size;
+	float Age;
+};
+
+struct ReferenceEmitter
+{
+	std::vector<ReferenceParticle> Particles;
+	float Lifetime;
+	float StartSize;
+	float EndSize;
+	XMFLOAT4 StartColor;
+	XMFLOAT4 EndColor;
+	XMFLOAT3 Position;
+	XMFLOAT3 Acceleration;
+};
+
+// One particle at a time, branching on age.  Instead of
+// retiring, a particle that dies starts over, so the live
+// count holds steady like an emitter's does.
+static void UpdateReference(ReferenceEmitter* emitter, float dt)
+{
+	XMVECTOR startColor = XMLoadFloat4(&emitter->StartColor);
+	XMVECTOR endColor = XMLoadFloat4(&emitter->EndColor);
+	XMVECTOR startPos = XMLoadFloat3(&emitter->Position);
+	XMVECTOR accel = XMLoadFloat3(&emitter->Acceleration);
+
+	for (unsigned int i = 0; i < emitter->Particles.size(); i++)
+	{
+		ReferenceParticle& particle = emitter->Particles[i];
+		particle.Age += dt;
+		if (particle.Age >= emitter->Lifetime)
+		{
+			particle.Age -= emitter->Lifetime;
+			continue;
+		}
+
+		float agePercent = particle.Age / emitter->Lifetime;
+		XMStoreFloat4(&particle.Color, XMVectorLerp(startColor, endColor, agePercent));
+		particle.Size = emitter->StartSize + agePercent * (emitter->EndSize - emitter->StartSize);
+
+		XMVECTOR startVel = XMLoadFloat3(&particle.StartVelocity);
+		float t = particle.Age;
+		XMStoreFloat3(&particle.Position, accel * t * t / 2.0f + startVel * t + startPos);
+	}
+}
+
+ParticleBenchmark::ParticleBenchmark(int frames, float dt)
+{
+	this->frames = frames;
+	this->dt = dt;
+}
+
+ParticleBenchmark::~ParticleBenchmark()
+{
+	DeleteEmitters();
+}
+
+const ParticleScenario* ParticleBenchmark::GetScenarios(int* count)
+{
+	*count = sizeof(scenarios) / sizeof(scenarios[0]);
+	return scenarios;
+}
+
+bool ParticleBenchmark::Run(FILE* output, const char* suite)
+{
+	bool all = suite == 0;
+	bool known = false;
+	bool written = true;
+
+	if (all || strcmp(suite, "emitter") == 0) { known = true; written = written && RunEmitters(output); }
+	if (all || strcmp(suite, "soa") == 0) { known = true; written = written && RunSoa(output); }
+	if (all || strcmp(suite, "threads") == 0) { known = true; written = written && RunThreads(output); }
+	if (all || strcmp(suite, "packing") == 0) { known = true; written = written && RunPacking(output); }
+	if (all || strcmp(suite, "sorter") == 0) { known = true; written = written && RunSorter(output); }
+	if (all || strcmp(suite, "budget") == 0) { known = true; written = written && RunBudget(output); }
+	if (all || strcmp(suite, "curves") == 0) { known = true; written = written && RunCurves(output); }
+	if (all || strcmp(suite, "policies") == 0) { known = true; written = written && RunPolicies(output); }
+
+	return known && written;
+}
+
+bool ParticleBenchmark::RunEmitters(FILE* output)
+{
+	int count = 0;
+	const ParticleScenario* list = GetScenarios(&count);
+	for (int s = 0; s < count; s++)
+	{
+		if (!RunScenario(list[s], output))
+			return false;
+	}
+	return true;
+}
+
+bool ParticleBenchmark::RunScenario(const ParticleScenario& scenario, FILE* output)
+{
+	CreateEmitters(scenario);
+
+	updateTimes.clear();
+	writeTimes.clear();
+	double totalParticles = 0;
+	double totalWritten = 0;
+	double totalTime = 0;
+
+	for (int f = 0; f < frames; f++)
+	{
+		double start = BenchmarkNow();
+		for (unsigned int e = 0; e < emitters.size(); e++)
+			emitters[e]->Update(dt);
+		double updated = BenchmarkNow();
+
+		unsigned int written = 0;
+		for (unsigned int e = 0; e < emitters.size(); e++)
+			written += (unsigned int)emitters[e]->WriteParticles(&instances[written]);
+		double end = BenchmarkNow();
+
+		updateTimes.push_back(updated - start);
+		writeTimes.push_back(end - updated);
+		totalParticles += written;
+		totalWritten += (double)written * sizeof(ParticleInstance);
+		totalTime += end - start;
+	}
+
+	DeleteEmitters();
+
+	BenchmarkTiming update = SummarizeTimes(updateTimes);
+	BenchmarkTiming write = SummarizeTimes(writeTimes);
+	int result = fprintf(output,
+		"{\"suite\":\"emitter\",\"scenario\":\"%s\",\"mode\":\"%s\",\"emitters\":%d,\"frames\":%d,"
+		"\"live_per_frame\":%.1f,\"particles_per_second\":%.0f,\"bytes_per_frame\":%.0f,"
+		"\"update_p50_us\":%.2f,\"update_p99_us\":%.2f,\"write_p50_us\":%.2f,\"write_p99_us\":%.2f}\n",
+		scenario.Name,
+		scenario.Mode == EMITTER_ANALYTIC ? "analytic" : "simulated",
+		scenario.Emitters,
+		frames,
+		totalParticles / frames,
+		totalTime > 0 ? totalParticles / totalTime : 0.0,
+		totalWritten / frames,
+		update.P50 * microseconds, update.P99 * microseconds,
+		write.P50 * microseconds, write.P99 * microseconds);
+
+	return result > 0 && fflush(output) == 0;
+}
+
+// --------------------------------------------------------
+// A million particles each way, with the same settings,
+// starting from the same spread of ages.  The emitter's
+// ring is filled in one go rather than by running it for a
+// lifetime first.
+// --------------------------------------------------------
+bool ParticleBenchmark::RunSoa(FILE* output)
+{
+	static const int count = 1 << 20;
+	static const float lifetime = 4.0f;
+
+	XMFLOAT4 startColor(1, 0.1f, 0.1f, 0.2f);
+	XMFLOAT4 endColor(1, 0.6f, 0.1f, 0);
+	XMFLOAT3 velocity(-2, 2, 0);
+	XMFLOAT3 position(2, 0, 0);
+	XMFLOAT3 acceleration(0, -1, 0);
+
+	Emitter* emitter = new Emitter(count, count / lifetime, lifetime, 0.1f, 2.0f,
+		startColor, endColor, velocity, position, acceleration, EMITTER_SIMULATED, 1);
+	emitter->SpawnParticles(count, 0);
+
+	ReferenceEmitter reference;
+	reference.Lifetime = lifetime;
+	reference.StartSize = 0.1f;
+	reference.EndSize = 2.0f;
+	reference.StartColor = startColor;
+	reference.EndColor = endColor;
+	reference.Position = position;
+	reference.Acceleration = acceleration;
+	reference.Particles.resize(count);
+
+	ParticleRandom random(1);
+	std::vector<float> jitter(count * 3);
+	random.Fill(&jitter[0], (int)jitter.size(), -0.2f, 0.2f);
+	for (int i = 0; i < count; i++)
+	{
+		ReferenceParticle& particle = reference.Particles[i];
+		particle.Age = lifetime * (count - 1 - i) / count;
+		particle.StartVelocity = XMFLOAT3(velocity.x + jitter[i * 3], velocity.y + jitter[i * 3 + 1], velocity.z + jitter[i * 3 + 2]);
+		particle.Position = position;
+		particle.Color = startColor;
+		particle.Size = 0.1f;
+	}
+
+	for (int layout = 0; layout < 2; layout++)
+	{
+		updateTimes.clear();
+		for (int f = 0; f < frames; f++)
+		{
+			double start = BenchmarkNow();
+			if (layout == 0)
+				UpdateReference(&reference, dt);
+			else
+				emitter->Update(dt);
+			updateTimes.push_back(BenchmarkNow() - start);
+		}
+
+		int live = layout == 0 ? count : emitter->GetLivingCount();
+		BenchmarkTiming update = SummarizeTimes(updateTimes);
+		int result = fprintf(output,
+			"{\"suite\":\"soa\",\"scenario\":\"%s\",\"particles\":%d,\"frames\":%d,"
+			"\"ns_per_particle\":%.3f,\"update_p50_us\":%.2f,\"update_p99_us\":%.2f}\n",
+			layout == 0 ? "aos_reference" : "soa_emitter",
+			live,
+			frames,
+			live > 0 ? update.P50 * 1.0e9 / live : 0.0,
+			update.P50 * microseconds, update.P99 * microseconds);
+
+		if (result <= 0 || fflush(output) != 0)
+		{
+			delete emitter;
+			return false;
+		}
+	}
+
+	delete emitter;
+	return true;
+}
+
+// --------------------------------------------------------
+// No workers, then 1, 3, 7... up to what the machine has
+// (and at least a few, to show the overhead on small ones).
+// Every worker count starts from the same steady state.
+// --------------------------------------------------------
+bool ParticleBenchmark::RunThreads(FILE* output)
+{
+	static const ParticleScenario huge = { "threads", 1, 262144, 65536.0f, 4.0f, EMITTER_SIMULATED };
+	static const ParticleScenario small = { "threads", 256, 100, 50.0f, 2.0f, EMITTER_SIMULATED };
+
+	std::vector<unsigned int> workerCounts;
+	unsigned int most = WorkerPool::DefaultThreadCount();
+	if (most < 3)
+		most = 3;
+	for (unsigned int w = 0; w <= most; w = w * 2 + 1)
+		workerCounts.push_back(w);
+
+	double baseline = 0;
+	for (unsigned int w = 0; w < workerCounts.size(); w++)
+	{
+		CreateEmitters(huge);
+		CreateEmitters(small);
+
+		WorkerPool workers(workerCounts[w]);
+		updateTimes.clear();
+		double totalParticles = 0;
+		for (int f = 0; f < frames; f++)
+		{
+			double start = BenchmarkNow();
+			UpdateOnWorkers(&workers);
+			updateTimes.push_back(BenchmarkNow() - start);
+
+			for (unsigned int e = 0; e < emitters.size(); e++)
+				totalParticles += emitters[e]->GetLivingCount();
+		}
+		DeleteEmitters();
+
+		BenchmarkTiming update = SummarizeTimes(updateTimes);
+		if (w == 0)
+			baseline = update.P50;
+
+		int result = fprintf(output,
+			"{\"suite\":\"threads\",\"scenario\":\"%u_workers\",\"workers\":%u,\"emitters\":%d,\"frames\":%d,"
+			"\"live_per_frame\":%.1f,\"speedup\":%.2f,\"update_p50_us\":%.2f,\"update_p99_us\":%.2f}\n",
+			workerCounts[w],
+			workerCounts[w],
+			huge.Emitters + small.Emitters,
+			frames,
+			totalParticles / frames,
+			update.P50 > 0 ? baseline / update.P50 : 0.0,
+			update.P50 * microseconds, update.P99 * microseconds);
+
+		if (result <= 0 || fflush(output) != 0)
+			return false;
+	}
+	return true;
+}
+
+// --------------------------------------------------------
+// The same steps as ParticleSystem::Update(): every chunk of
+// every emitter as one job, then each emitter's ring and
+// spawning as another
+// --------------------------------------------------------
+void ParticleBenchmark::UpdateOnWorkers(WorkerPool* workers)
+{
+	jobs.clear();
+	for (unsigned int e = 0; e < emitters.size(); e++)
+	{
+		emitters[e]->BeginUpdate(dt);
+
+		int chunks = emitters[e]->GetChunkCount();
+		for (int c = 0; c < chunks; c++)
+		{
+			ChunkJob job = { e, c, 0 };
+			jobs.push_back(job);
+		}
+	}
+
+	workers->ParallelFor((unsigned int)jobs.size(), [this](unsigned int j) {
+		jobs[j].Deaths = emitters[jobs[j].Emitter]->UpdateChunk(jobs[j].Chunk);
+	});
+
+	emitterDeaths.assign(emitters.size(), 0);
+	for (unsigned int j = 0; j < jobs.size(); j++)
+		emitterDeaths[jobs[j].Emitter] += jobs[j].Deaths;
+
+	workers->ParallelFor((unsigned int)emitters.size(), [this](unsigned int e) {
+		emitters[e]->EndUpdate(emitterDeaths[e]);
+	});
+}
+
+// --------------------------------------------------------
+// Emitters added round-robin over eight groups (a texture
+// and blend state each, in the game), so every group's
+// emitters are scattered through the order they were added
+// in.  Only Pack() is timed; the emitters update in between.
+// --------------------------------------------------------
+bool ParticleBenchmark::RunPacking(FILE* output)
+{
+	static const int emitterCounts[] = { 256, 1024 };
+	static const unsigned int groups = 8;
+
+	std::vector<double> packTimes;
+	for (unsigned int c = 0; c < sizeof(emitterCounts) / sizeof(emitterCounts[0]); c++)
+	{
+		ParticleScenario scenario = { "packing", emitterCounts[c], 128, 50.0f, 2.0f, EMITTER_SIMULATED };
+		CreateEmitters(scenario);
+
+		ParticleBatcher batcher;
+		for (unsigned int e = 0; e < emitters.size(); e++)
+			batcher.Add(emitters[e], e % groups);
+
+		packTimes.clear();
+		double totalPacked = 0;
+		for (int f = 0; f < frames; f++)
+		{
+			for (unsigned int e = 0; e < emitters.size(); e++)
+				emitters[e]->Update(dt);
+
+			double start = BenchmarkNow();
+			unsigned int packed = batcher.Pack(&instances[0]);
+			packTimes.push_back(BenchmarkNow() - start);
+			totalPacked += packed;
+		}
+
+		unsigned int batches = (unsigned int)batcher.GetBatches().size();
+		DeleteEmitters();
+
+		BenchmarkTiming pack = SummarizeTimes(packTimes);
+		double packedPerFrame = totalPacked / frames;
+		int result = fprintf(output,
+			"{\"suite\":\"packing\",\"scenario\":\"%d_emitters\",\"emitters\":%d,\"groups\":%u,"
+			"\"batches\":%u,\"frames\":%d,\"packed_per_frame\":%.1f,\"ns_per_particle\":%.3f,"
+			"\"pack_p50_us\":%.2f,\"pack_p99_us\":%.2f}\n",
+			emitterCounts[c],
+			emitterCounts[c],
+			groups,
+			batches,
+			frames,
+			packedPerFrame,
+			packedPerFrame > 0 ? pack.P50 * 1.0e9 / packedPerFrame : 0.0,
+			pack.P50 * microseconds, pack.P99 * microseconds);
+
+		if (result <= 0 || fflush(output) != 0)
+			return false;
+	}
+	return true;
+}
+
+// --------------------------------------------------------
+// Sorts the same scattered cloud every frame from a slowly
+// turning view, so no frame starts out already in order.
+//
+// Each count is also timed as a plain copy of its particles
+// - the least any sort writing them out could cost - so
+// results from different machines can be compared, and
+// checked against the target of 100k+ in under 1 ms.
+// --------------------------------------------------------
+bool ParticleBenchmark::RunSorter(FILE* output)
+{
+	static const unsigned int counts[] = { 100000, 250000 };
+	static const double targetSeconds = 0.001;
+
+	ParticleRandom random(1);
+	ParticleSorter sorter;
+	std::vector<ParticleInstance> source;
+	std::vector<ParticleInstance> destination;
+	std::vector<double> sortTimes;
+
+	for (unsigned int c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+	{
+		unsigned int count = counts[c];
+		source.resize(count);
+		destination.resize(count);
+
+		std::vector<float> coordinates(count * 3);
+		random.Fill(&coordinates[0], (int)coordinates.size(), -50.0f, 50.0f);
+		for (unsigned int i = 0; i < count; i++)
+		{
+			source[i].Position = XMFLOAT3(coordinates[i * 3], coordinates[i * 3 + 1], coordinates[i * 3 + 2]);
+			source[i].Size = 1;
+			source[i].Color = XMFLOAT4(1, 1, 1, 1);
+		}
+
+		sortTimes.clear();
+		for (int f = 0; f < frames; f++)
+		{
+			double start = BenchmarkNow();
+			memcpy(&destination[0], &source[0], sizeof(ParticleInstance) * count);
+			sortTimes.push_back(BenchmarkNow() - start);
+		}
+		BenchmarkTiming copy = SummarizeTimes(sortTimes);
+
+		for (int wide = 0; wide < 2; wide++)
+		{
+			sortTimes.clear();
+			for (int f = 0; f < frames; f++)
+			{
+				float angle = f * 0.01f;
+				XMFLOAT4 depthPlane(sinf(angle), 0, cosf(angle), 100.0f);
+
+				double start = BenchmarkNow();
+				sorter.SortBackToFront(&source[0], &destination[0], count, depthPlane, wide != 0);
+				sortTimes.push_back(BenchmarkNow() - start);
+			}
+
+			BenchmarkTiming sort = SummarizeTimes(sortTimes);
+			int result = fprintf(output,
+				"{\"suite\":\"sorter\",\"scenario\":\"%uk_%s\",\"particles\":%u,\"frames\":%d,"
+				"\"particles_per_second\":%.0f,\"sort_p50_us\":%.2f,\"sort_p99_us\":%.2f,"
+				"\"copy_p50_us\":%.2f,\"target_us\":%.0f,\"within_target\":%s}\n",
+				count / 1000, wide ? "32bit" : "16bit",
+				count,
+				frames,
+				sort.P50 > 0 ? count / sort.P50 : 0.0,
+				sort.P50 * microseconds, sort.P99 * microseconds,
+				copy.P50 * microseconds,
+				targetSeconds * microseconds,
+				sort.P50 < targetSeconds ? "true" : "false");
+
+			if (result <= 0 || fflush(output) != 0)
+				return false;
+		}
+	}
+	return true;
+}
+
+// --------------------------------------------------------
+// Many emitters over four priorities, squeezed by a time
+// target, with live counts and measured cost moving every
+// frame the way they would in a game
+// --------------------------------------------------------
+bool ParticleBenchmark::RunBudget(FILE* output)
+{
+	static const unsigned int emitterCounts[] = { 64, 1024 };
+
+	ParticleRandom random(2);
+	std::vector<double> rebalanceTimes;
+
+	for (unsigned int c = 0; c < sizeof(emitterCounts) / sizeof(emitterCounts[0]); c++)
+	{
+		unsigned int count = emitterCounts[c];
+
+		ParticleBudget budget;
+		budget.SetTimeTarget(0.002);
+		for (unsigned int e = 0; e < count; e++)
+			budget.Add(256 + (e % 7) * 128, (float)(e % 4));
+
+		std::vector<unsigned int> liveCounts(count);
+		rebalanceTimes.clear();
+
+		for (int f = 0; f < frames; f++)
+		{
+			random.Fill(&liveCounts[0], (int)count);
+			unsigned int total = 0;
+			for (unsigned int e = 0; e < count; e++)
+			{
+				liveCounts[e] = liveCounts[e] % (budget.GetLimit((int)e) + 1);
+				total += liveCounts[e];
+			}
+
+			// 20ns a particle, give or take
+			budget.AddCost(total * (20.0e-9 + (f % 5) * 2.0e-9));
+
+			double start = BenchmarkNow();
+			budget.Rebalance(&liveCounts[0]);
+			rebalanceTimes.push_back(BenchmarkNow() - start);
+		}
+
+		BenchmarkTiming rebalance = SummarizeTimes(rebalanceTimes);
+		int result = fprintf(output,
+			"{\"suite\":\"budget\",\"scenario\":\"%u_emitters\",\"emitters\":%u,\"frames\":%d,"
+			"\"allowance\":%u,\"rebalance_p50_us\":%.2f,\"rebalance_p99_us\":%.2f}\n",
+			count,
+			count,
+			frames,
+			budget.GetAllowance(),
+			rebalance.P50 * microseconds, rebalance.P99 * microseconds);
+
+		if (result <= 0 || fflush(output) != 0)
+			return false;
+	}
+	return true;
+}
+
+// --------------------------------------------------------
+// A fire-like set of curves: color through three keys, a
+// fade in and out, growing then holding, and slowing down
+// --------------------------------------------------------
+static const ParticleColorKey curveColors[] = {
+	{ 0.0f, XMFLOAT4(1, 0.9f, 0.4f, 1) },
+	{ 0.4f, XMFLOAT4(1, 0.4f, 0.1f, 1) },
+	{ 1.0f, XMFLOAT4(0.2f, 0.2f, 0.2f, 1) },
+};
+static const ParticleCurveKey curveAlpha[] = { { 0.0f, 0 }, { 0.1f, 1 }, { 0.7f, 0.8f }, { 1.0f, 0 } };
+static const ParticleCurveKey curveSizes[] = { { 0.0f, 0.1f }, { 0.3f, 1.5f }, { 1.0f, 2.0f } };
+static const ParticleCurveKey curveSpeeds[] = { { 0.0f, 1.5f }, { 0.5f, 0.5f }, { 1.0f, 0.2f } };
+
+#define COUNT_OF(a) (int)(sizeof(a) / sizeof(a[0]))
+
+// The same walk over the keys ParticleCurves does when it
+// bakes, done per particle instead
+static float EvaluateKeys(const ParticleCurveKey* keys, int count, float age)
+{
+	if (age <= keys[0].Age)
+		return keys[0].Value;
+
+	for (int k = 1; k < count; k++)
+	{
+		if (age <= keys[k].Age)
+		{
+			float span = keys[k].Age - keys[k - 1].Age;
+			float t = span > 0 ? (age - keys[k - 1].Age) / span : 1.0f;
+			return keys[k - 1].Value + (keys[k].Value - keys[k - 1].Value) * t;
+		}
+	}
+	return keys[count - 1].Value;
+}
+
+static XMFLOAT4 EvaluateKeys(const ParticleColorKey* keys, int count, float age)
+{
+	if (age <= keys[0].Age)
+		return keys[0].Color;
+
+	for (int k = 1; k < count; k++)
+	{
+		if (age <= keys[k].Age)
+		{
+			float span = keys[k].Age - keys[k - 1].Age;
+			float t = span > 0 ? (age - keys[k - 1].Age) / span : 1.0f;
+
+			XMFLOAT4 color;
+			XMStoreFloat4(&color, XMVectorLerp(XMLoadFloat4(&keys[k - 1].Color), XMLoadFloat4(&keys[k].Color), t));
+			return color;
+		}
+	}
+	return keys[count - 1].Color;
+}
+
+// --------------------------------------------------------
+// Bake() once per frame (what SetCurves costs), then a
+// batch of particle ages sampled from the baked table
+// against evaluating every key list for each of them.
+// Speed is left out of the per-key side, since without the
+// table Travel has no closed form to evaluate at all.
+// --------------------------------------------------------
+bool ParticleBenchmark::RunCurves(FILE* output)
+{
+	static const int sampleCount = 65536;
+
+	ParticleCurves curves;
+	curves.SetColor(curveColors, COUNT_OF(curveColors));
+	curves.SetAlpha(curveAlpha, COUNT_OF(curveAlpha));
+	curves.SetSize(curveSizes, COUNT_OF(curveSizes));
+	curves.SetSpeed(curveSpeeds, COUNT_OF(curveSpeeds));
+
+	std::vector<float> ages(sampleCount);
+	ParticleRandom random(3);
+	random.Fill(&ages[0], sampleCount, 0, 1);
+
+	std::vector<double> bakeTimes;
+	std::vector<double> sampleTimes;
+	std::vector<double> keyTimes;
+
+	// Summed so neither loop can be thrown away, and so the
+	// table's error against the keys shows up
+	float sampledTotal = 0;
+	float keyedTotal = 0;
+
+	for (int f = 0; f < frames; f++)
+	{
+		double start = BenchmarkNow();
+		curves.Bake(2.0f + (f % 4) * 0.25f);
+		bakeTimes.push_back(BenchmarkNow() - start);
+
+		start = BenchmarkNow();
+		for (int i = 0; i < sampleCount; i++)
+		{
+			ParticleCurveSample sample = curves.Sample(ages[i]);
+			sampledTotal += sample.Color.x + sample.Color.w + sample.Size;
+		}
+		sampleTimes.push_back(BenchmarkNow() - start);
+
+		start = BenchmarkNow();
+		for (int i = 0; i < sampleCount; i++)
+		{
+			XMFLOAT4 color = EvaluateKeys(curveColors, COUNT_OF(curveColors), ages[i]);
+			color.w *= EvaluateKeys(curveAlpha, COUNT_OF(curveAlpha), ages[i]);
+			float size = EvaluateKeys(curveSizes, COUNT_OF(curveSizes), ages[i]);
+			keyedTotal += color.x + color.w + size;
+		}
+		keyTimes.push_back(BenchmarkNow() - start);
+	}
+
+	BenchmarkTiming bake = SummarizeTimes(bakeTimes);
+	BenchmarkTiming sample = SummarizeTimes(sampleTimes);
+	BenchmarkTiming keys = SummarizeTimes(keyTimes);
+	double nanoseconds = 1000000000.0 / sampleCount;
+	int result = fprintf(output,
+		"{\"suite\":\"curves\",\"scenario\":\"fire_curves\",\"resolution\":%d,\"samples\":%d,\"frames\":%d,"
+		"\"bake_p50_us\":%.2f,\"bake_p99_us\":%.2f,\"sample_p50_ns\":%.2f,\"keys_p50_ns\":%.2f,"
+		"\"table_error\":%.4f}\n",
+		ParticleCurves::Resolution,
+		sampleCount,
+		frames,
+		bake.P50 * microseconds, bake.P99 * microseconds,
+		sample.P50 * nanoseconds,
+		keys.P50 * nanoseconds,
+		fabs(sampledTotal - keyedTotal) / (keyedTotal > 0 ? keyedTotal : 1));
+
+	return result > 0 && fflush(output) == 0;
+}
+
+// --------------------------------------------------------
+// The same emitter set up to take each of the four update
+// kernels - with or without acceleration, with curves that
+// change or don't - filled to a steady state first, the
+// way RunSoa() does.  ballistic_curve is the general kernel
+// every emitter used before they were specialized.
+// --------------------------------------------------------
+bool ParticleBenchmark::RunPolicies(FILE* output)
+{
+	static const int count = 1 << 18;
+	static const float lifetime = 4.0f;
+	static const char* names[4] = { "drift_fixed", "drift_curve", "ballistic_fixed", "ballistic_curve" };
+
+	double generalNs = 0;
+	for (int k = 3; k >= 0; k--)
+	{
+		bool accelerates = k >= 2;
+		bool animated = (k & 1) != 0;
+
+		Emitter* emitter = new Emitter(count, count / lifetime, lifetime,
+			0.1f, animated ? 2.0f : 0.1f,
+			XMFLOAT4(1, 0.1f, 0.1f, 0.2f),
+			animated ? XMFLOAT4(1, 0.6f, 0.1f, 0) : XMFLOAT4(1, 0.1f, 0.1f, 0.2f),
+			XMFLOAT3(-2, 2, 0),
+			XMFLOAT3(2, 0, 0),
+			XMFLOAT3(0, accelerates ? -1.0f : 0.0f, 0),
+			EMITTER_SIMULATED, 1);
+		emitter->SpawnParticles(count, 0);
+
+		updateTimes.clear();
+		for (int f = 0; f < frames; f++)
+		{
+			double start = BenchmarkNow();
+			emitter->Update(dt);
+			updateTimes.push_back(BenchmarkNow() - start);
+		}
+
+		int live = emitter->GetLivingCount();
+		delete emitter;
+
+		BenchmarkTiming update = SummarizeTimes(updateTimes);
+		double ns = live > 0 ? update.P50 * 1.0e9 / live : 0.0;
+		if (k == 3)
+			generalNs = ns;
+
+		int result = fprintf(output,
+			"{\"suite\":\"policies\",\"scenario\":\"%s\",\"particles\":%d,\"frames\":%d,"
+			"\"ns_per_particle\":%.3f,\"speedup\":%.2f,\"update_p50_us\":%.2f,\"update_p99_us\":%.2f}\n",
+			names[k],
+			live,
+			frames,
+			ns,
+			ns > 0 ? generalNs / ns : 0.0,
+			update.P50 * microseconds, update.P99 * microseconds);
+
+		if (result <= 0 || fflush(output) != 0)
+			return false;
+	}
+	return true;
+}
+
+// --------------------------------------------------------
+// Makes the scenario's emitters and fills them up to a
+// steady state (a lifetime and a frame)
+// --------------------------------------------------------
+void ParticleBenchmark::CreateEmitters(const ParticleScenario& scenario)
+{
+	unsigned int capacity = 0;
+	for (int e = 0; e < scenario.Emitters; e++)
+	{
+		emitters.push_back(new Emitter(
+			scenario.MaxParticles,
+			scenario.ParticlesPerSecond,
+			scenario.Lifetime,
+			0.1f,
+			2.0f,
+			XMFLOAT4(1, 0.1f, 0.1f, 0.2f),
+			XMFLOAT4(1, 0.6f, 0.1f, 0),
+			XMFLOAT3(-2, 2, 0),
+			XMFLOAT3(2, 0, 0),
+			XMFLOAT3(0, -1, 0),
+			scenario.Mode,
+			(unsigned int)e + 1));
+		capacity += (unsigned int)scenario.MaxParticles;
+	}
+	instances.resize(capacity);
+
+	int warmup = (int)(scenario.Lifetime / dt) + 2;
+	for (int f = 0; f < warmup; f++)
+	{
+		for (unsigned int e = 0; e < emitters.size(); e++)
+			emitters[e]->Update(dt);
+	}
+}
+
+void ParticleBenchmark::DeleteEmitters()
+{
+	for (unsigned int e = 0; e < emitters.size(); e++)
+		delete emitters[e];
+	emitters.clear();
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <stdio.h>
+#include <vector>
+#include "BenchmarkTiming.h"
+#include "Emitter.h"
+#include "WorkerPool.h"
+
+// --------------------------------------------------------
+// What one emitter scenario sets up: count identical
+// emitters with these settings
+// --------------------------------------------------------
+struct ParticleScenario
+{
+	const char* Name;
+	int Emitters;
+	int MaxParticles;
+	float ParticlesPerSecond;
+	float Lifetime;
+	EmitterMode Mode;
+};
+
+// --------------------------------------------------------
+// Measures what particles cost on the CPU, with no window
+// or device, one suite at a time:
+//
+//  emitter - each scenario's emitters are run to a steady
+//    state, then every frame's Update() (simulation) and
+//    WriteParticles() (building the instance data) are
+//    timed separately, on one thread
+//  soa - one simulated emitter of a million particles
+//    against the array-of-structs, one-at-a-time update the
+//    emitters used to have, over the same particles
+//  threads - one huge emitter and many small ones updated
+//    the way ParticleSystem fans them out (chunks over a
+//    WorkerPool, then each emitter finished off), against
+//    the number of workers
+//  packing - ParticleBatcher::Pack() over hundreds of
+//    emitters spread across draw groups
+//  sorter - back-to-front sorts of particle batches, with
+//    both key widths
+//  budget - Rebalance() over many emitters of mixed
+//    priority
+//  curves - baking a set of particle curves, and sampling
+//    the baked table against walking the keys per particle
+//  policies - one emitter through each specialized update
+//    kernel, against the general ballistic, curved one
+//
+// Every result is one JSON object on its own line, tagged
+// with its suite and scenario, so runs can be diffed or
+// collected between builds.  Times are in microseconds.
+//
+// Only uses the D3D-free particle code, so it builds
+// anywhere the emitters do.
+// --------------------------------------------------------
+class ParticleBenchmark
+{
+public:
+	ParticleBenchmark(int frames = 600, float dt = 1.0f / 60.0f);
+	~ParticleBenchmark();
+
+	// Runs one suite by name, or all of them if suite is null.
+	// Returns false for an unknown suite or if anything failed
+	// to write.
+	bool Run(FILE* output, const char* suite = 0);
+
+	bool RunEmitters(FILE* output);
+	bool RunSoa(FILE* output);
+	bool RunThreads(FILE* output);
+	bool RunPacking(FILE* output);
+	bool RunSorter(FILE* output);
+	bool RunBudget(FILE* output);
+	bool RunCurves(FILE* output);
+	bool RunPolicies(FILE* output);
+
+	// The built-in emitter scenarios: many small emitters, one
+	// huge one (both modes) and high spawn rates
+	static const ParticleScenario* GetScenarios(int* count);
+
+private:
+	int frames;
+	float dt;
+
+	std::vector<Emitter*> emitters;
+	std::vector<ParticleInstance> instances;
+	std::vector<double> updateTimes;	// Seconds, one per measured frame
+	std::vector<double> writeTimes;
+
+	struct ChunkJob
+	{
+		unsigned int Emitter;
+		int Chunk;
+		int Deaths;
+	};
+	std::vector<ChunkJob> jobs;
+	std::vector<int> emitterDeaths;
+
+	bool RunScenario(const ParticleScenario& scenario, FILE* output);
+	void CreateEmitters(const ParticleScenario& scenario);
+	void UpdateOnWorkers(WorkerPool* workers);
+	void DeleteEmitters();
+};
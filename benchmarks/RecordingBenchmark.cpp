@@ -0,0 +1,132 @@
+#include "RecordingBenchmark.h"
+#include <math.h>
+#include <string.h>
+
+// The passes Game::Draw records (debug, scene, sky, water,
+// particles, blur, refraction)
+static const unsigned int passCount = 7;
+
+static const unsigned int entityCounts[] = { 64, 512, 4096 };
+
+static const double microseconds = 1000000.0;
+
+RecordingBenchmark::RecordingBenchmark(int frames)
+{
+	this->frames = frames;
+}
+
+bool RecordingBenchmark::Run(FILE* output)
+{
+	// No workers, then 1, 3, 7... up to what the machine has
+	// (and at least a few, to show the overhead on small ones)
+	std::vector<unsigned int> workerCounts;
+	unsigned int most = WorkerPool::DefaultThreadCount();
+	if (most < 3)
+		most = 3;
+	for (unsigned int w = 0; w <= most; w = w * 2 + 1)
+		workerCounts.push_back(w);
+
+	std::vector<double> frameTimes;
+	std::vector<RecordedDraw> reference;
+
+	for (unsigned int c = 0; c < sizeof(entityCounts) / sizeof(entityCounts[0]); c++)
+	{
+		unsigned int entities = entityCounts[c];
+
+		for (unsigned int w = 0; w < workerCounts.size(); w++)
+		{
+			WorkerPool workers(workerCounts[w]);
+
+			frameTimes.clear();
+			for (int f = 0; f < frames; f++)
+			{
+				double start = BenchmarkNow();
+				RecordFrame(&workers, passCount, entities, (unsigned int)f);
+				frameTimes.push_back(BenchmarkNow() - start);
+			}
+
+			// Same frame, same commands, however many threads
+			RecordFrame(&workers, passCount, entities, 0);
+			if (w == 0)
+				reference = merged;
+			bool deterministic = reference.size() == merged.size() &&
+				memcmp(&reference[0], &merged[0], sizeof(RecordedDraw) * merged.size()) == 0;
+
+			BenchmarkTiming frame = SummarizeTimes(frameTimes);
+			int result = fprintf(output,
+				"{\"suite\":\"recording\",\"scenario\":\"%u_entities_%u_workers\",\"passes\":%u,"
+				"\"entities_per_pass\":%u,\"workers\":%u,\"frames\":%d,\"deterministic\":%s,"
+				"\"frame_p50_us\":%.2f,\"frame_p99_us\":%.2f}\n",
+				entities, workerCounts[w],
+				passCount,
+				entities,
+				workerCounts[w],
+				frames,
+				deterministic ? "true" : "false",
+				frame.P50 * microseconds, frame.P99 * microseconds);
+
+			if (result <= 0 || fflush(output) != 0)
+				return false;
+		}
+	}
+	return true;
+}
+
+// --------------------------------------------------------
+// Through the same PassRecorder CommandRecorder uses: one
+// pass per list on the workers, then the lists appended in
+// pass order
+// --------------------------------------------------------
+void RecordingBenchmark::RecordFrame(WorkerPool* workers, unsigned int passes, unsigned int entitiesPerPass, unsigned int frame)
+{
+	for (unsigned int p = 0; p < passes; p++)
+	{
+		recorder.AddPass([entitiesPerPass, frame](unsigned int pass, std::vector<RecordedDraw>* draws) {
+			RecordPass(draws, pass, entitiesPerPass, frame);
+		});
+	}
+	recorder.Record(workers);
+
+	merged.clear();
+	recorder.Execute([this](unsigned int /*pass*/, std::vector<RecordedDraw>* draws) {
+		merged.insert(merged.end(), draws->begin(), draws->end());
+	});
+}
+
+// --------------------------------------------------------
+// Scale, roll/pitch/yaw and translation into a transposed
+// world matrix, like GameEntity::CalculateWorldMatrix()
+// --------------------------------------------------------
+void RecordingBenchmark::RecordPass(std::vector<RecordedDraw>* draws, unsigned int pass, unsigned int entities, unsigned int frame)
+{
+	draws->resize(entities);
+
+	for (unsigned int e = 0; e < entities; e++)
+	{
+		float seed = (float)(pass * entities + e);
+		float pitch = seed * 0.01f + frame * 0.001f;
+		float yaw = seed * 0.02f;
+		float roll = seed * 0.03f;
+		float scale = 1.0f + (e % 3) * 0.5f;
+
+		float cp = cosf(pitch), sp = sinf(pitch);
+		float cy = cosf(yaw), sy = sinf(yaw);
+		float cr = cosf(roll), sr = sinf(roll);
+
+		// Rows of scale * rotation * translation
+		float m[16] = {
+			scale * (cr * cy + sr * sp * sy), scale * (sr * cp), scale * (sr * sp * cy - cr * sy), 0,
+			scale * (cr * sp * sy - sr * cy), scale * (cr * cp), scale * (sr * sy + cr * sp * cy), 0,
+			scale * (cp * sy), scale * (-sp), scale * (cp * cy), 0,
+			seed, (float)pass, (float)frame, 1 };
+
+		RecordedDraw& draw = (*draws)[e];
+		draw.Entity = e;
+		draw.Material = (pass + e) % 5;
+		for (int row = 0; row < 4; row++)
+		{
+			for (int column = 0; column < 4; column++)
+				draw.World[column * 4 + row] = m[row * 4 + column];
+		}
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <stdio.h>
+#include <vector>
+#include "BenchmarkTiming.h"
+#include "PassRecorder.h"
+#include "WorkerPool.h"
+
+// --------------------------------------------------------
+// One draw as a pass would record it: which entity, its
+// world matrix (built the way GameEntity builds it) and a
+// material to bind
+// --------------------------------------------------------
+struct RecordedDraw
+{
+	unsigned int Entity;
+	unsigned int Material;
+	float World[16];
+};
+
+// --------------------------------------------------------
+// Frame time against worker count for the way Game::Draw
+// records its passes - a PassRecorder, like the one inside
+// CommandRecorder, records every pass on a WorkerPool
+// thread into a list of its own, and the lists are merged
+// in pass order on the caller.
+//
+// Deferred contexts need a device, so each pass records
+// into a plain list of draws instead of a command list,
+// with the CPU work a pass does per entity (world matrix
+// and constant data) but no driver calls.  That's the part threading can speed
+// up; the cost of ExecuteCommandList isn't measured.
+//
+// Every configuration also checks that the merged list is
+// byte-for-byte the same as with no workers at all.
+// --------------------------------------------------------
+class RecordingBenchmark
+{
+public:
+	RecordingBenchmark(int frames = 600);
+
+	// Returns false if anything failed to write
+	bool Run(FILE* output);
+
+private:
+	int frames;
+
+	PassRecorder<std::vector<RecordedDraw> > recorder;
+	std::vector<RecordedDraw> merged;
+
+	void RecordFrame(WorkerPool* workers, unsigned int passes, unsigned int entitiesPerPass, unsigned int frame);
+	static void RecordPass(std::vector<RecordedDraw>* draws, unsigned int pass, unsigned int entities, unsigned int frame);
+};
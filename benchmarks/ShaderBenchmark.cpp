@@ -0,0 +1,315 @@
+#include "ShaderBenchmark.h"
+#include <string.h>
+#include "ReflectionSidecar.h"
+#include "ShaderParameters.h"
+
+static const char* suites[] = { "handles", "sidecar" };
+
+static const double microseconds = 1000000.0;
+
+// --------------------------------------------------------
+// What a lit, textured entity sets before each draw: its
+// vertex shader's matrices and color, and its pixel
+// shader's camera, time and lights
+// --------------------------------------------------------
+struct EntityVariable
+{
+	const char* Name;
+	unsigned int Buffer;
+	unsigned int ByteOffset;
+	unsigned int Size;
+};
+
+static const EntityVariable entityVariables[] = {
+	{ "world",			0,	0,		64 },
+	{ "view",			0,	64,		64 },
+	{ "projection",		0,	128,	64 },
+	{ "color",			0,	192,	16 },
+	{ "time",			0,	208,	4 },
+	{ "dLight1",		1,	0,		48 },
+	{ "dLight2",		1,	48,		48 },
+	{ "pLight",			1,	96,		48 },
+	{ "CameraPosition",	1,	144,	12 },
+	{ "time",			1,	156,	4 },
+};
+
+static const unsigned int entityVariableCount = sizeof(entityVariables) / sizeof(entityVariables[0]);
+static const unsigned int bufferSizes[2] = { 224, 160 };
+
+// --------------------------------------------------------
+// Reflection as D3DReflect reports it for VertexShader.hlsl
+// and PixelShader.hlsl: their own externalData buffers, the
+// shared perFrame and perPass buffers (SharedConstants.hlsli)
+// and the pixel shader's textures and sampler
+// --------------------------------------------------------
+static void AddSharedBuffers(ShaderReflectionData* reflection)
+{
+	ReflectedConstantBuffer perFrame;
+	perFrame.Name = "perFrame";
+	perFrame.Size = 272;
+	perFrame.BindIndex = 1;
+	ReflectedVariable frameVariables[] = {
+		{ "view", "float4x4", 0, 0, 64 },
+		{ "projection", "float4x4", 0, 64, 64 },
+		{ "causticView", "float4x4", 0, 128, 64 },
+		{ "causticProjection", "float4x4", 0, 192, 64 },
+		{ "CameraPosition", "float3", 0, 256, 12 },
+		{ "time", "float", 0, 268, 4 } };
+	perFrame.Variables.assign(frameVariables, frameVariables + 6);
+	reflection->ConstantBuffers.push_back(perFrame);
+
+	ReflectedConstantBuffer perPass;
+	perPass.Name = "perPass";
+	perPass.Size = 16;
+	perPass.BindIndex = 2;
+	ReflectedVariable passVariables[] = {
+		{ "targetSize", "float2", 0, 0, 8 },
+		{ "inverseTargetSize", "float2", 0, 8, 8 } };
+	perPass.Variables.assign(passVariables, passVariables + 2);
+	reflection->ConstantBuffers.push_back(perPass);
+}
+
+static ShaderReflectionData MakeVertexShaderReflection()
+{
+	ShaderReflectionData reflection;
+
+	ReflectedConstantBuffer external;
+	external.Name = "externalData";
+	external.Size = 80;
+	external.BindIndex = 0;
+	ReflectedVariable variables[] = {
+		{ "world", "float4x4", 0, 0, 64 },
+		{ "color", "float4", 0, 64, 16 } };
+	external.Variables.assign(variables, variables + 2);
+	reflection.ConstantBuffers.push_back(external);
+
+	AddSharedBuffers(&reflection);
+	return reflection;
+}
+
+static ShaderReflectionData MakePixelShaderReflection()
+{
+	ShaderReflectionData reflection;
+
+	ReflectedConstantBuffer external;
+	external.Name = "externalData";
+	external.Size = 48;
+	external.BindIndex = 0;
+	ReflectedVariable light = { "dLight1", "DirectionalLight", 0, 0, 44 };
+	external.Variables.push_back(light);
+	reflection.ConstantBuffers.push_back(external);
+
+	AddSharedBuffers(&reflection);
+
+	const char* textures[] = { "DiffuseTexture", "NormalTexture", "AlphaTexture", "SkyTexture", "ProjectionTexture" };
+	for (unsigned int t = 0; t < 5; t++)
+	{
+		ReflectedResource texture = { textures[t], t };
+		reflection.Textures.push_back(texture);
+	}
+
+	ReflectedResource sampler = { "Sampler", 0 };
+	reflection.Samplers.push_back(sampler);
+	return reflection;
+}
+
+ShaderBenchmark::ShaderBenchmark(int frames)
+{
+	this->frames = frames;
+}
+
+bool ShaderBenchmark::Run(FILE* output, const char* suite)
+{
+	bool all = suite == 0;
+	bool written = true;
+
+	if (all || strcmp(suite, "handles") == 0) { written = written && RunHandles(output); }
+	if (all || strcmp(suite, "sidecar") == 0) { written = written && RunSidecar(output); }
+
+	return (all || HasSuite(suite)) && written;
+}
+
+bool ShaderBenchmark::HasSuite(const char* suite)
+{
+	for (unsigned int s = 0; s < sizeof(suites) / sizeof(suites[0]); s++)
+	{
+		if (strcmp(suite, suites[s]) == 0)
+			return true;
+	}
+	return false;
+}
+
+// --------------------------------------------------------
+// Every entity sets all ten variables, through the same
+// ShaderVariableTable SimpleShader uses, once by name and
+// once by handle.  Only the world matrix and color change
+// between entities, so most sets are the skipped, already
+// there kind - as they are in the game.
+// --------------------------------------------------------
+bool ShaderBenchmark::RunHandles(FILE* output)
+{
+	static const unsigned int entityCounts[] = { 64, 1024 };
+
+	// The vertex shader's table, then the pixel shader's, each
+	// with one buffer
+	ShaderVariableTable tables[2];
+	for (unsigned int v = 0; v < entityVariableCount; v++)
+	{
+		const EntityVariable& entity = entityVariables[v];
+		SimpleShaderVariable variable = { entity.ByteOffset, entity.Size, 0 };
+		tables[entity.Buffer].Add(entity.Name, variable);
+	}
+
+	int handles[entityVariableCount];
+	for (unsigned int v = 0; v < entityVariableCount; v++)
+		handles[v] = tables[entityVariables[v].Buffer].GetHandle(SimpleShaderHash(entityVariables[v].Name));
+
+	std::vector<unsigned char> local[2];
+	SimpleLocalBufferData buffers[2];
+	for (int b = 0; b < 2; b++)
+	{
+		local[b].assign(bufferSizes[b], 0);
+		SimpleLocalBufferData buffer = { bufferSizes[b], &local[b][0], bufferSizes[b], 0, false };
+		buffers[b] = buffer;
+	}
+
+	float data[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+	unsigned int failures = 0;
+
+	for (unsigned int c = 0; c < sizeof(entityCounts) / sizeof(entityCounts[0]); c++)
+	{
+		unsigned int entities = entityCounts[c];
+
+		nameTimes.clear();
+		handleTimes.clear();
+		for (int f = 0; f < frames; f++)
+		{
+			double start = BenchmarkNow();
+			for (unsigned int e = 0; e < entities; e++)
+			{
+				data[12] = (float)e;
+				for (unsigned int v = 0; v < entityVariableCount; v++)
+				{
+					const EntityVariable& entity = entityVariables[v];
+					if (!tables[entity.Buffer].SetData(entity.Name, &buffers[entity.Buffer], data, entity.Size))
+						failures++;
+				}
+			}
+			nameTimes.push_back(BenchmarkNow() - start);
+
+			start = BenchmarkNow();
+			for (unsigned int e = 0; e < entities; e++)
+			{
+				data[12] = (float)e;
+				for (unsigned int v = 0; v < entityVariableCount; v++)
+				{
+					const EntityVariable& entity = entityVariables[v];
+					if (!tables[entity.Buffer].SetData(handles[v], &buffers[entity.Buffer], data, entity.Size))
+						failures++;
+				}
+			}
+			handleTimes.push_back(BenchmarkNow() - start);
+		}
+
+		BenchmarkTiming byName = SummarizeTimes(nameTimes);
+		BenchmarkTiming byHandle = SummarizeTimes(handleTimes);
+		double sets = (double)entities * entityVariableCount;
+		int result = fprintf(output,
+			"{\"suite\":\"handles\",\"scenario\":\"%u_entities\",\"entities\":%u,\"variables_per_entity\":%u,"
+			"\"frames\":%d,\"failed_sets\":%u,\"name_ns_per_set\":%.2f,\"handle_ns_per_set\":%.2f,"
+			"\"name_p50_us\":%.2f,\"name_p99_us\":%.2f,\"handle_p50_us\":%.2f,\"handle_p99_us\":%.2f}\n",
+			entities,
+			entities,
+			entityVariableCount,
+			frames,
+			failures,
+			byName.P50 * 1.0e9 / sets,
+			byHandle.P50 * 1.0e9 / sets,
+			byName.P50 * microseconds, byName.P99 * microseconds,
+			byHandle.P50 * microseconds, byHandle.P99 * microseconds);
+
+		if (result <= 0 || fflush(output) != 0)
+			return false;
+	}
+	return true;
+}
+
+// --------------------------------------------------------
+// One parse is a few microseconds, so each sample times a
+// batch of them.  Read() goes through a real file in the
+// working directory (removed afterwards), so it includes
+// opening and mapping it - what LoadShaderFile pays.
+// --------------------------------------------------------
+bool ShaderBenchmark::RunSidecar(FILE* output)
+{
+	static const int batch = 64;
+	static const unsigned long long contentHash = 0x5EEDC0DE12345678ull;
+	static const wchar_t* path = L"shader_benchmark.cso.refl";
+	static const char* narrowPath = "shader_benchmark.cso.refl";
+
+	const char* names[2] = { "vertex_shader", "pixel_shader" };
+	ShaderReflectionData reflections[2] = { MakeVertexShaderReflection(), MakePixelShaderReflection() };
+
+	for (int r = 0; r < 2; r++)
+	{
+		std::vector<unsigned char> data;
+		ReflectionSidecar::Serialize(contentHash, reflections[r], &data);
+		if (!ReflectionSidecar::Write(path, contentHash, reflections[r]))
+			return false;
+
+		unsigned int failures = 0;
+		unsigned int variables = 0;
+		parseTimes.clear();
+		readTimes.clear();
+
+		for (int f = 0; f < frames; f++)
+		{
+			double start = BenchmarkNow();
+			for (int i = 0; i < batch; i++)
+			{
+				ShaderReflectionData parsed;
+				if (!ReflectionSidecar::Parse(&data[0], data.size(), contentHash, &parsed))
+					failures++;
+			}
+			parseTimes.push_back((BenchmarkNow() - start) / batch);
+
+			start = BenchmarkNow();
+			for (int i = 0; i < batch; i++)
+			{
+				ShaderReflectionData parsed;
+				if (!ReflectionSidecar::Read(path, contentHash, &parsed))
+					failures++;
+				variables = 0;
+				for (unsigned int c = 0; c < parsed.ConstantBuffers.size(); c++)
+					variables += (unsigned int)parsed.ConstantBuffers[c].Variables.size();
+			}
+			readTimes.push_back((BenchmarkNow() - start) / batch);
+		}
+
+		BenchmarkTiming parse = SummarizeTimes(parseTimes);
+		BenchmarkTiming read = SummarizeTimes(readTimes);
+		int result = fprintf(output,
+			"{\"suite\":\"sidecar\",\"scenario\":\"%s\",\"bytes\":%u,\"constant_buffers\":%u,\"variables\":%u,"
+			"\"textures\":%u,\"samplers\":%u,\"frames\":%d,\"failures\":%u,"
+			"\"parse_p50_us\":%.3f,\"parse_p99_us\":%.3f,\"read_p50_us\":%.3f,\"read_p99_us\":%.3f}\n",
+			names[r],
+			(unsigned int)data.size(),
+			(unsigned int)reflections[r].ConstantBuffers.size(),
+			variables,
+			(unsigned int)reflections[r].Textures.size(),
+			(unsigned int)reflections[r].Samplers.size(),
+			frames,
+			failures,
+			parse.P50 * microseconds, parse.P99 * microseconds,
+			read.P50 * microseconds, read.P99 * microseconds);
+
+		if (result <= 0 || fflush(output) != 0)
+		{
+			remove(narrowPath);
+			return false;
+		}
+	}
+
+	remove(narrowPath);
+	return true;
+}
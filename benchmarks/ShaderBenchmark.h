@@ -0,0 +1,40 @@
+#pragma once
+#include <stdio.h>
+#include <vector>
+#include "BenchmarkTiming.h"
+
+// --------------------------------------------------------
+// Measures the D3D-free parts of SimpleShader, one suite at
+// a time:
+//
+//  handles - the variables an entity sets each draw, set
+//    by name (a string and a map lookup per call, the way
+//    SetData(std::string, ...) works) against set through
+//    handles resolved once up front
+//  sidecar - ReflectionSidecar parsing the reflection of
+//    the game's main vertex and pixel shaders, in memory
+//    and through Read() (mapping a file, then parsing)
+//
+// Results are JSON lines, like ParticleBenchmark's.
+// --------------------------------------------------------
+class ShaderBenchmark
+{
+public:
+	ShaderBenchmark(int frames = 600);
+
+	// Runs one suite by name, or all of them if suite is null.
+	// Returns false for an unknown suite or if anything failed
+	// to write.
+	bool Run(FILE* output, const char* suite = 0);
+	static bool HasSuite(const char* suite);
+
+	bool RunHandles(FILE* output);
+	bool RunSidecar(FILE* output);
+
+private:
+	int frames;
+	std::vector<double> parseTimes;
+	std::vector<double> readTimes;
+	std::vector<double> nameTimes;	// Seconds, one per measured frame
+	std::vector<double> handleTimes;
+};
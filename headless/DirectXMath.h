@@ -0,0 +1,144 @@
+#pragma once
+#include <string.h>
+
+// --------------------------------------------------------
+// A plain scalar stand-in for the parts of DirectXMath the
+// D3D-free code uses, so it builds on platforms without the
+// real library.  The CMake build only uses this when it
+// isn't pointed at upstream DirectXMath (see
+// DIRECTXMATH_INCLUDE_DIR), so anything timed through it
+// says nothing about the SIMD build.
+//
+// Same names, types and results as the real thing - four
+// lanes, with comparisons producing all-ones masks.
+// --------------------------------------------------------
+namespace DirectX
+{
+	struct XMFLOAT3
+	{
+		float x, y, z;
+		XMFLOAT3() {}
+		XMFLOAT3(float x, float y, float z) : x(x), y(y), z(z) {}
+	};
+
+	struct XMFLOAT4
+	{
+		float x, y, z, w;
+		XMFLOAT4() {}
+		XMFLOAT4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+	};
+
+	struct XMUINT4
+	{
+		unsigned int x, y, z, w;
+	};
+
+	struct XMVECTOR
+	{
+		union
+		{
+			float f[4];
+			unsigned int u[4];
+		};
+	};
+
+	typedef const XMVECTOR& FXMVECTOR;
+	typedef const XMVECTOR& GXMVECTOR;
+	typedef const XMVECTOR& HXMVECTOR;
+
+	// ----------------------------------------------------
+	// Loads, stores and setup
+	// ----------------------------------------------------
+	inline XMVECTOR XMVectorSet(float x, float y, float z, float w)
+	{
+		XMVECTOR v;
+		v.f[0] = x; v.f[1] = y; v.f[2] = z; v.f[3] = w;
+		return v;
+	}
+
+	inline XMVECTOR XMVectorReplicate(float value) { return XMVectorSet(value, value, value, value); }
+
+	inline XMVECTOR XMVectorSelectControl(unsigned int x, unsigned int y, unsigned int z, unsigned int w)
+	{
+		XMVECTOR v;
+		v.u[0] = x ? 0xFFFFFFFFu : 0; v.u[1] = y ? 0xFFFFFFFFu : 0;
+		v.u[2] = z ? 0xFFFFFFFFu : 0; v.u[3] = w ? 0xFFFFFFFFu : 0;
+		return v;
+	}
+
+	inline XMVECTOR XMLoadFloat3(const XMFLOAT3* source) { return XMVectorSet(source->x, source->y, source->z, 0); }
+	inline XMVECTOR XMLoadFloat4(const XMFLOAT4* source) { return XMVectorSet(source->x, source->y, source->z, source->w); }
+
+	inline void XMStoreFloat3(XMFLOAT3* destination, FXMVECTOR v)
+	{
+		destination->x = v.f[0]; destination->y = v.f[1]; destination->z = v.f[2];
+	}
+
+	inline void XMStoreFloat4(XMFLOAT4* destination, FXMVECTOR v)
+	{
+		destination->x = v.f[0]; destination->y = v.f[1]; destination->z = v.f[2]; destination->w = v.f[3];
+	}
+
+	inline void XMStoreUInt4(XMUINT4* destination, FXMVECTOR v) { memcpy(destination, v.u, sizeof(v.u)); }
+
+	// ----------------------------------------------------
+	// Lane-wise arithmetic, comparisons and masks
+	// ----------------------------------------------------
+#define HEADLESS_LANEWISE(name, expression) \
+	inline XMVECTOR name(FXMVECTOR a, FXMVECTOR b) \
+	{ \
+		XMVECTOR r; \
+		for (int i = 0; i < 4; i++) { expression; } \
+		return r; \
+	}
+
+	HEADLESS_LANEWISE(XMVectorAdd, r.f[i] = a.f[i] + b.f[i])
+	HEADLESS_LANEWISE(XMVectorSubtract, r.f[i] = a.f[i] - b.f[i])
+	HEADLESS_LANEWISE(XMVectorMultiply, r.f[i] = a.f[i] * b.f[i])
+	HEADLESS_LANEWISE(XMVectorLess, r.u[i] = a.f[i] < b.f[i] ? 0xFFFFFFFFu : 0)
+	HEADLESS_LANEWISE(XMVectorGreaterOrEqual, r.u[i] = a.f[i] >= b.f[i] ? 0xFFFFFFFFu : 0)
+	HEADLESS_LANEWISE(XMVectorAndInt, r.u[i] = a.u[i] & b.u[i])
+	HEADLESS_LANEWISE(XMVectorAndCInt, r.u[i] = a.u[i] & ~b.u[i])
+
+#undef HEADLESS_LANEWISE
+
+	inline XMVECTOR XMVectorMultiplyAdd(FXMVECTOR a, FXMVECTOR b, FXMVECTOR c)
+	{
+		XMVECTOR r;
+		for (int i = 0; i < 4; i++)
+			r.f[i] = a.f[i] * b.f[i] + c.f[i];
+		return r;
+	}
+
+	inline XMVECTOR XMVectorScale(FXMVECTOR v, float scale)
+	{
+		XMVECTOR r;
+		for (int i = 0; i < 4; i++)
+			r.f[i] = v.f[i] * scale;
+		return r;
+	}
+
+	inline XMVECTOR XMVectorLerp(FXMVECTOR a, FXMVECTOR b, float t)
+	{
+		XMVECTOR r;
+		for (int i = 0; i < 4; i++)
+			r.f[i] = a.f[i] + (b.f[i] - a.f[i]) * t;
+		return r;
+	}
+
+	// Bits of a where control is clear, of b where it's set
+	inline XMVECTOR XMVectorSelect(FXMVECTOR a, FXMVECTOR b, FXMVECTOR control)
+	{
+		XMVECTOR r;
+		for (int i = 0; i < 4; i++)
+			r.u[i] = (a.u[i] & ~control.u[i]) | (b.u[i] & control.u[i]);
+		return r;
+	}
+
+	inline XMVECTOR operator+(FXMVECTOR a, FXMVECTOR b) { return XMVectorAdd(a, b); }
+	inline XMVECTOR operator*(FXMVECTOR v, float scale) { return XMVectorScale(v, scale); }
+	inline XMVECTOR operator/(FXMVECTOR v, float divisor)
+	{
+		return XMVectorSet(v.f[0] / divisor, v.f[1] / divisor, v.f[2] / divisor, v.f[3] / divisor);
+	}
+}
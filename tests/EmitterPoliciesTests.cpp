@@ -0,0 +1,162 @@
+#include "TestRunner.h"
+#include "Emitter.h"
+#include "EmitterPolicies.h"
+#include "ParticleRandom.h"
+
+// --------------------------------------------------------
+// Each policy against the same sum done one lane at a time
+// --------------------------------------------------------
+TEST(EmitterPolicies, BallisticMotionMatchesScalar)
+{
+	ParticleRandom random(5);
+	for (int trial = 0; trial < 64; trial++)
+	{
+		XMFLOAT4 constants;
+		XMStoreFloat4(&constants, random.NextFloat4(-10, 10));
+		float accel = constants.x;
+		float origin = constants.y;
+		XMVECTOR age = random.NextFloat4(0, 4);
+		XMVECTOR velocity = random.NextFloat4(-5, 5);
+		XMVECTOR travel = random.NextFloat4(-4, 4);
+
+		XMFLOAT4 ages, velocities, travels, positions;
+		XMStoreFloat4(&ages, age);
+		XMStoreFloat4(&velocities, velocity);
+		XMStoreFloat4(&travels, travel);
+		XMStoreFloat4(&positions, BallisticMotion::Position(XMVectorReplicate(accel * 0.5f), age, velocity, travel, XMVectorReplicate(origin)));
+
+		const float* a = &ages.x;
+		const float* v = &velocities.x;
+		const float* t = &travels.x;
+		const float* p = &positions.x;
+		for (int lane = 0; lane < 4; lane++)
+			CHECK_NEAR(p[lane], origin + v[lane] * t[lane] + accel * a[lane] * a[lane] / 2, 1e-4);
+	}
+}
+
+TEST(EmitterPolicies, DriftMotionIgnoresAcceleration)
+{
+	XMVECTOR age = XMVectorSet(0, 0.5f, 1, 2);
+	XMVECTOR velocity = XMVectorSet(1, -2, 3, 0.25f);
+	XMVECTOR travel = XMVectorSet(0, 1, 1.5f, 4);
+
+	XMFLOAT4 positions;
+	XMStoreFloat4(&positions, DriftMotion::Position(XMVectorReplicate(100), age, velocity, travel, XMVectorReplicate(2)));
+	CHECK(positions.x == 2);
+	CHECK(positions.y == 0);
+	CHECK(positions.z == 6.5f);
+	CHECK(positions.w == 3);
+}
+
+TEST(EmitterPolicies, CurveAppearanceWritesOnlyLivingLanes)
+{
+	ParticleCurveKey speed[2] = { { 0, 2 }, { 1, 0 } };
+	ParticleCurves curves = ParticleCurves::MakeLinear(XMFLOAT4(1, 0, 0, 1), XMFLOAT4(0, 0, 1, 0), 0.5f, 3);
+	curves.SetSpeed(speed, 2);
+	curves.Bake(2);
+
+	float channels[4][4];
+	float sizes[4];
+	for (int lane = 0; lane < 4; lane++)
+	{
+		for (int c = 0; c < 4; c++)
+			channels[c][lane] = -1;
+		sizes[lane] = -1;
+	}
+	float* const colors[4] = { channels[0], channels[1], channels[2], channels[3] };
+
+	float agePercents[4] = { 0, 0.3f, 0.77f, 1 };
+	XMVECTOR agePercent = XMLoadFloat4((const XMFLOAT4*)agePercents);
+	XMVECTOR living = XMVectorSelectControl(1, 0, 1, 1);
+
+	XMFLOAT4 travels;
+	XMStoreFloat4(&travels, CurveAppearance::Apply(curves, agePercent, XMVectorScale(agePercent, 2), living, colors, sizes));
+	const float* travel = &travels.x;
+
+	for (int lane = 0; lane < 4; lane++)
+	{
+		ParticleCurveSample sample = curves.Sample(agePercents[lane]);
+		CHECK(travel[lane] == sample.Travel);
+
+		if (lane == 1)
+		{
+			// Dead lanes keep whatever they had
+			CHECK(channels[0][lane] == -1 && channels[3][lane] == -1);
+			CHECK(sizes[lane] == -1);
+			continue;
+		}
+
+		CHECK(channels[0][lane] == sample.Color.x);
+		CHECK(channels[1][lane] == sample.Color.y);
+		CHECK(channels[2][lane] == sample.Color.z);
+		CHECK(channels[3][lane] == sample.Color.w);
+		CHECK(sizes[lane] == sample.Size);
+	}
+}
+
+TEST(EmitterPolicies, FixedAppearanceTravelsAtConstantSpeed)
+{
+	ParticleCurveKey speed[1] = { { 0, 1.5f } };
+	ParticleCurves curves;
+	curves.SetSpeed(speed, 1);
+	curves.Bake(2);
+
+	float channels[4][4] = {};
+	float sizes[4] = { 7, 7, 7, 7 };
+	float* const colors[4] = { channels[0], channels[1], channels[2], channels[3] };
+
+	XMVECTOR age = XMVectorSet(0, 0.5f, 1, 2);
+	XMFLOAT4 travels;
+	XMStoreFloat4(&travels, FixedAppearance::Apply(curves, XMVectorScale(age, 0.5f), age, XMVectorSelectControl(1, 1, 1, 1), colors, sizes));
+
+	CHECK(travels.x == 0);
+	CHECK(travels.y == 0.75f);
+	CHECK(travels.z == 1.5f);
+	CHECK(travels.w == 3);
+
+	// Spawned color and size are left alone
+	CHECK(sizes[0] == 7 && sizes[3] == 7);
+	CHECK(channels[0][0] == 0 && channels[3][3] == 0);
+}
+
+// --------------------------------------------------------
+// Same seed, same velocities - one emitter's curves never
+// change, the other's color fades, so they take the fixed
+// and the curve kernel.  Positions should only differ by
+// float rounding, with and without acceleration.
+// --------------------------------------------------------
+TEST(EmitterPolicies, SpecializedKernelsMatchCurveKernel)
+{
+	for (int accelerates = 0; accelerates < 2; accelerates++)
+	{
+		XMFLOAT3 acceleration(0, accelerates ? -9.8f : 0, 0);
+		Emitter* fixed = new Emitter(256, 100, 2, 1, 1, XMFLOAT4(1, 1, 1, 1), XMFLOAT4(1, 1, 1, 1),
+			XMFLOAT3(1, 4, 0), XMFLOAT3(0, 1, 0), acceleration, EMITTER_SIMULATED, 3);
+		Emitter* fading = new Emitter(256, 100, 2, 1, 1, XMFLOAT4(1, 1, 1, 1), XMFLOAT4(1, 1, 1, 0),
+			XMFLOAT3(1, 4, 0), XMFLOAT3(0, 1, 0), acceleration, EMITTER_SIMULATED, 3);
+
+		for (int frame = 0; frame < 150; frame++)
+		{
+			fixed->Update(1.0f / 60.0f);
+			fading->Update(1.0f / 60.0f);
+		}
+
+		ParticleInstance a[256], b[256];
+		int count = fixed->WriteParticles(a);
+		CHECK(count > 150);
+		CHECK(count == fading->WriteParticles(b));
+		delete fixed;
+		delete fading;
+
+		bool faded = false;
+		for (int i = 0; i < count; i++)
+		{
+			CHECK_NEAR(a[i].Position.x, b[i].Position.x, 1e-4);
+			CHECK_NEAR(a[i].Position.y, b[i].Position.y, 1e-4);
+			CHECK_NEAR(a[i].Position.z, b[i].Position.z, 1e-4);
+			CHECK(a[i].Size == 1 && a[i].Color.w == 1);
+			faded = faded || b[i].Color.w < 0.9f;
+		}
+		CHECK(faded);
+	}
+}
@@ -0,0 +1,366 @@
+#include <string.h>
+#include "TestRunner.h"
+#include "Emitter.h"
+#include "WorkerPool.h"
+
+// --------------------------------------------------------
+// A still emitter whose size is its particles' age, so a
+// written instance shows how old it is
+// --------------------------------------------------------
+static Emitter* MakeAgeEmitter(int maxParticles, float particlesPerSecond, float lifetime, EmitterMode mode)
+{
+	return new Emitter(
+		maxParticles,
+		particlesPerSecond,
+		lifetime,
+		0,
+		lifetime,
+		XMFLOAT4(1, 1, 1, 1),
+		XMFLOAT4(1, 1, 1, 1),
+		XMFLOAT3(0, 0, 0),
+		XMFLOAT3(0, 0, 0),
+		XMFLOAT3(0, 0, 0),
+		mode,
+		1);
+}
+
+TEST(Emitter, LiveLimitKeepsTheNewestSpawns)
+{
+	for (int m = 0; m < 2; m++)
+	{
+		Emitter* emitter = MakeAgeEmitter(100, 10, 10, m == 0 ? EMITTER_SIMULATED : EMITTER_ANALYTIC);
+		emitter->SetBudget(1, 2);
+
+		// Ten are due, 0.05 to 0.95 seconds old - only the two
+		// youngest fit
+		emitter->Update(1.05f);
+		ParticleInstance instances[100];
+		int written = emitter->WriteParticles(instances);
+		delete emitter;
+
+		CHECK(written == 2);
+		CHECK_NEAR(instances[0].Size, 0.15, 1e-4);
+		CHECK_NEAR(instances[1].Size, 0.05, 1e-4);
+	}
+}
+
+TEST(Emitter, DroppedSpawnsAreNotOwedLater)
+{
+	Emitter* emitter = MakeAgeEmitter(100, 10, 10, EMITTER_SIMULATED);
+	emitter->SetBudget(1, 2);
+	emitter->Update(1.05f);
+
+	// Lifting the limit only lets new emissions in, one per
+	// tenth of a second
+	emitter->SetBudget(1, 100);
+	emitter->Update(0.1f);
+	int living = emitter->GetLivingCount();
+	delete emitter;
+
+	CHECK(living == 3);
+}
+
+// --------------------------------------------------------
+// Runs long enough to wrap the ring many times, checking
+// every frame that what's alive is in spawn order and none
+// of it is past its lifetime
+// --------------------------------------------------------
+TEST(Emitter, RingStaysInSpawnOrder)
+{
+	for (int m = 0; m < 2; m++)
+	{
+		Emitter* emitter = MakeAgeEmitter(10, 20, 0.4f, m == 0 ? EMITTER_SIMULATED : EMITTER_ANALYTIC);
+		ParticleInstance instances[10];
+		bool inOrder = true;
+		int mostAlive = 0;
+
+		for (int frame = 0; frame < 300 && inOrder; frame++)
+		{
+			emitter->Update(1.0f / 60.0f);
+			int written = emitter->WriteParticles(instances);
+			if (written > mostAlive)
+				mostAlive = written;
+
+			for (int i = 0; i < written; i++)
+			{
+				if (instances[i].Size < 0 || instances[i].Size >= 0.4f)
+					inOrder = false;
+				if (i > 0 && instances[i].Size >= instances[i - 1].Size)
+					inOrder = false;
+			}
+		}
+		delete emitter;
+
+		CHECK(inOrder);
+		// A lifetime's worth (rounding can let one more in right
+		// at the boundary) and never more than the ring holds
+		CHECK(mostAlive >= 8 && mostAlive <= 9);
+	}
+}
+
+// --------------------------------------------------------
+// Positions are the closed form, give or take each
+// particle's velocity jitter over its age
+// --------------------------------------------------------
+TEST(Emitter, PositionsFollowTheirAges)
+{
+	for (int m = 0; m < 2; m++)
+	{
+		Emitter* emitter = new Emitter(64, 30, 2, 0, 2,
+			XMFLOAT4(1, 1, 1, 1), XMFLOAT4(1, 1, 1, 1),
+			XMFLOAT3(1, 2, 0), XMFLOAT3(5, 0, -3), XMFLOAT3(0, -4, 0),
+			m == 0 ? EMITTER_SIMULATED : EMITTER_ANALYTIC, 7);
+
+		for (int frame = 0; frame < 200; frame++)
+			emitter->Update(1.0f / 60.0f);
+
+		ParticleInstance instances[64];
+		int written = emitter->WriteParticles(instances);
+		delete emitter;
+		CHECK(written > 50);
+
+		for (int i = 0; i < written; i++)
+		{
+			double t = instances[i].Size;
+			double slack = 0.2 * t + 1e-4;
+			CHECK_NEAR(instances[i].Position.x, 5 + 1 * t, slack);
+			CHECK_NEAR(instances[i].Position.y, 2 * t - 2 * t * t, slack);
+			CHECK_NEAR(instances[i].Position.z, -3, slack);
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Three hours of frames.  Analytic ages are the emitter's
+// time minus a spawn time, so they'd come apart as those
+// times grow unless the emitter keeps them small.
+// --------------------------------------------------------
+TEST(Emitter, AnalyticAgesHoldUpOverHours)
+{
+	Emitter* emitter = MakeAgeEmitter(16, 10, 1, EMITTER_ANALYTIC);
+	// (Half an emission off the hour, so no particle sits right
+	// on the end of its life)
+	for (int frame = 0; frame < 3 * 60 * 60 * 60 + 3; frame++)
+		emitter->Update(1.0f / 60.0f);
+
+	ParticleInstance instances[16];
+	int written = emitter->WriteParticles(instances);
+	delete emitter;
+
+	CHECK(written == 10);
+	for (int i = 1; i < written; i++)
+		CHECK_NEAR(instances[i - 1].Size - instances[i].Size, 0.1, 1e-4);
+}
+
+// --------------------------------------------------------
+// Update() in pieces - chunks spread over threads, or run
+// backwards - has to land on exactly what Update() does,
+// however the ring wraps
+// --------------------------------------------------------
+TEST(Emitter, ChunkedUpdateMatchesUpdate)
+{
+	WorkerPool workers(3);
+
+	for (int m = 0; m < 2; m++)
+	{
+		EmitterMode mode = m == 0 ? EMITTER_SIMULATED : EMITTER_ANALYTIC;
+		Emitter* whole = new Emitter(5000, 4000, 1, 0.1f, 2, XMFLOAT4(1, 0, 0, 1), XMFLOAT4(0, 0, 1, 0),
+			XMFLOAT3(1, 2, 0), XMFLOAT3(0, 0, 0), XMFLOAT3(0, -1, 0), mode, 5);
+		Emitter* threaded = new Emitter(5000, 4000, 1, 0.1f, 2, XMFLOAT4(1, 0, 0, 1), XMFLOAT4(0, 0, 1, 0),
+			XMFLOAT3(1, 2, 0), XMFLOAT3(0, 0, 0), XMFLOAT3(0, -1, 0), mode, 5);
+		Emitter* backwards = new Emitter(5000, 4000, 1, 0.1f, 2, XMFLOAT4(1, 0, 0, 1), XMFLOAT4(0, 0, 1, 0),
+			XMFLOAT3(1, 2, 0), XMFLOAT3(0, 0, 0), XMFLOAT3(0, -1, 0), mode, 5);
+
+		std::vector<int> deaths;
+		std::vector<ParticleInstance> expected(5000), actual(5000);
+		bool same = true;
+
+		for (int frame = 0; frame < 150 && same; frame++)
+		{
+			float dt = (frame % 3 + 1) / 60.0f;
+			whole->Update(dt);
+
+			threaded->BeginUpdate(dt);
+			deaths.assign(threaded->GetChunkCount(), 0);
+			workers.ParallelFor((unsigned int)deaths.size(), [&](unsigned int c) {
+				deaths[c] = threaded->UpdateChunk((int)c);
+			});
+			int total = 0;
+			for (unsigned int c = 0; c < deaths.size(); c++)
+				total += deaths[c];
+			threaded->EndUpdate(total);
+
+			backwards->BeginUpdate(dt);
+			total = 0;
+			for (int c = backwards->GetChunkCount() - 1; c >= 0; c--)
+				total += backwards->UpdateChunk(c);
+			backwards->EndUpdate(total);
+
+			int count = whole->WriteParticles(&expected[0]);
+			same = same && threaded->WriteParticles(&actual[0]) == count &&
+				memcmp(&expected[0], &actual[0], sizeof(ParticleInstance) * count) == 0;
+			same = same && backwards->WriteParticles(&actual[0]) == count &&
+				memcmp(&expected[0], &actual[0], sizeof(ParticleInstance) * count) == 0;
+		}
+
+		// (Analytic emitters have nothing to step, so no chunks -
+		// they're only checked for spawning the same)
+		bool spread = mode == EMITTER_ANALYTIC || whole->GetChunkCount() > 1;
+		delete whole;
+		delete threaded;
+		delete backwards;
+
+		CHECK(spread);
+		CHECK(same);
+	}
+}
+
+TEST(Emitter, SameSeedSameParticles)
+{
+	std::vector<ParticleInstance> runs[3];
+	unsigned int seeds[3] = { 11, 11, 12 };
+	for (int r = 0; r < 3; r++)
+	{
+		Emitter* emitter = new Emitter(500, 200, 2, 0.1f, 1, XMFLOAT4(1, 1, 1, 1), XMFLOAT4(0, 0, 0, 0),
+			XMFLOAT3(0, 3, 0), XMFLOAT3(0, 0, 0), XMFLOAT3(0, -9.8f, 0), EMITTER_SIMULATED, seeds[r]);
+		for (int frame = 0; frame < 100; frame++)
+			emitter->Update(1.0f / 60.0f);
+
+		runs[r].resize(500);
+		runs[r].resize(emitter->WriteParticles(&runs[r][0]));
+		delete emitter;
+	}
+
+	CHECK(!runs[0].empty());
+	CHECK(runs[0].size() == runs[1].size());
+	CHECK(memcmp(&runs[0][0], &runs[1][0], sizeof(ParticleInstance) * runs[0].size()) == 0);
+	CHECK(memcmp(&runs[0][0], &runs[2][0], sizeof(ParticleInstance) * runs[0].size()) != 0);
+}
+
+// --------------------------------------------------------
+// Sleeping for a while and then updating once has to land
+// where updating every frame does.  Velocities come from
+// the random stream, which the two use up differently, so
+// only ages (the size here) are compared, newest first.
+// --------------------------------------------------------
+TEST(Emitter, SleepThenUpdateMatchesEveryFrame)
+{
+	const int sleeps[3] = { 10, 150, 1000 };
+	for (int m = 0; m < 2; m++)
+	{
+		for (int s = 0; s < 3; s++)
+		{
+			EmitterMode mode = m == 0 ? EMITTER_SIMULATED : EMITTER_ANALYTIC;
+			Emitter* awake = MakeAgeEmitter(64, 17, 1, mode);
+			Emitter* sleeper = MakeAgeEmitter(64, 17, 1, mode);
+
+			for (int frame = 0; frame < 30; frame++)
+			{
+				awake->Update(1.0f / 60.0f);
+				sleeper->Update(1.0f / 60.0f);
+			}
+			for (int frame = 0; frame < sleeps[s]; frame++)
+			{
+				awake->Update(1.0f / 60.0f);
+				sleeper->Sleep(1.0f / 60.0f);
+			}
+			awake->Update(1.0f / 60.0f);
+			sleeper->Update(1.0f / 60.0f);
+
+			ParticleInstance expected[64], actual[64];
+			int expectedCount = awake->WriteParticles(expected);
+			int actualCount = sleeper->WriteParticles(actual);
+			float slept = sleeper->GetSleptTime();
+			delete awake;
+			delete sleeper;
+
+			// One particle right on the end of its life can go
+			// either way
+			CHECK(slept == 0);
+			CHECK(actualCount >= expectedCount - 1 && actualCount <= expectedCount + 1);
+
+			int shared = actualCount < expectedCount ? actualCount : expectedCount;
+			for (int i = 1; i <= shared; i++)
+				CHECK_NEAR(actual[actualCount - i].Size, expected[expectedCount - i].Size, 1e-3);
+		}
+	}
+}
+
+// --------------------------------------------------------
+// GetBounds() is what gets culled against, so no particle
+// can ever be outside it - checked every frame, for longer
+// than a lifetime, with jitter, acceleration and curves
+// that travel further than the linear default
+// --------------------------------------------------------
+TEST(Emitter, ParticlesStayInsideTheirBounds)
+{
+	for (int m = 0; m < 2; m++)
+	{
+		Emitter* emitter = new Emitter(256, 60, 2, 0.1f, 0.5f,
+			XMFLOAT4(1, 1, 1, 1), XMFLOAT4(1, 1, 1, 0),
+			XMFLOAT3(2, 5, -1), XMFLOAT3(3, 1, 4), XMFLOAT3(0, -9.8f, 1),
+			m == 0 ? EMITTER_SIMULATED : EMITTER_ANALYTIC, 3);
+
+		ParticleCurves curves;
+		ParticleCurveKey speed[3] = { { 0, 1 }, { 0.5f, 2 }, { 1, 0.5f } };
+		curves.SetSpeed(speed, 3);
+		emitter->SetCurves(curves);
+
+		XMFLOAT3 min, max;
+		emitter->GetBounds(&min, &max);
+
+		ParticleInstance instances[256];
+		int outside = 0;
+		int mostAlive = 0;
+		for (int frame = 0; frame < 300; frame++)
+		{
+			emitter->Update(1.0f / 60.0f);
+			int written = emitter->WriteParticles(instances);
+			if (written > mostAlive)
+				mostAlive = written;
+
+			for (int i = 0; i < written; i++)
+			{
+				const XMFLOAT3& p = instances[i].Position;
+				const float e = 1e-4f;
+				if (p.x < min.x - e || p.y < min.y - e || p.z < min.z - e ||
+					p.x > max.x + e || p.y > max.y + e || p.z > max.z + e)
+					outside++;
+			}
+		}
+		delete emitter;
+
+		CHECK(mostAlive > 100);
+		CHECK(outside == 0);
+	}
+}
+
+// --------------------------------------------------------
+// However long an emitter sleeps, it only owes what could
+// still be alive - a lifetime's worth - and carries no
+// backlog into the frames after
+// --------------------------------------------------------
+TEST(Emitter, LongSleepOwesOneLifetime)
+{
+	for (int m = 0; m < 2; m++)
+	{
+		Emitter* emitter = MakeAgeEmitter(1000, 20, 1, m == 0 ? EMITTER_SIMULATED : EMITTER_ANALYTIC);
+		emitter->Update(1.0f / 60.0f);
+		emitter->Sleep(100000.0f);
+		emitter->Update(1.0f / 60.0f);
+
+		ParticleInstance instances[1000];
+		int afterSleep = emitter->WriteParticles(instances);
+		bool allYoung = true;
+		for (int i = 0; i < afterSleep; i++)
+			allYoung = allYoung && instances[i].Size >= 0 && instances[i].Size < 1;
+
+		emitter->Update(1.0f / 60.0f);
+		int nextFrame = emitter->GetLivingCount();
+		delete emitter;
+
+		CHECK(allYoung);
+		CHECK(afterSleep >= 19 && afterSleep <= 21);
+		CHECK(nextFrame >= 19 && nextFrame <= 21);
+	}
+}
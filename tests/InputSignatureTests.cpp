@@ -0,0 +1,141 @@
+#include <string.h>
+#include "TestRunner.h"
+#include "InputSignature.h"
+
+static SignatureParameter MakeParameter(const char* name, unsigned int mask, SignatureComponentType type)
+{
+	SignatureParameter parameter;
+	parameter.SemanticName = name;
+	parameter.SemanticIndex = 0;
+	parameter.Mask = mask;
+	parameter.ComponentType = type;
+	parameter.SystemValue = false;
+	return parameter;
+}
+
+TEST(InputSignature, MaskAndTypePickTheFormat)
+{
+	// One row per component count (masks x, xy, xyz, xyzw)
+	const unsigned int masks[] = { 1, 3, 7, 15 };
+	const InputElementFormat floats[] = { INPUT_FORMAT_R32_FLOAT, INPUT_FORMAT_R32G32_FLOAT, INPUT_FORMAT_R32G32B32_FLOAT, INPUT_FORMAT_R32G32B32A32_FLOAT };
+	const InputElementFormat uints[] = { INPUT_FORMAT_R32_UINT, INPUT_FORMAT_R32G32_UINT, INPUT_FORMAT_R32G32B32_UINT, INPUT_FORMAT_R32G32B32A32_UINT };
+	const InputElementFormat sints[] = { INPUT_FORMAT_R32_SINT, INPUT_FORMAT_R32G32_SINT, INPUT_FORMAT_R32G32B32_SINT, INPUT_FORMAT_R32G32B32A32_SINT };
+
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		CHECK(InputSignature::GetElementFormat(MakeParameter("TEXCOORD", masks[i], SIGNATURE_COMPONENT_FLOAT32)) == floats[i]);
+		CHECK(InputSignature::GetElementFormat(MakeParameter("TEXCOORD", masks[i], SIGNATURE_COMPONENT_UINT32)) == uints[i]);
+		CHECK(InputSignature::GetElementFormat(MakeParameter("TEXCOORD", masks[i], SIGNATURE_COMPONENT_SINT32)) == sints[i]);
+	}
+
+	// Nothing sensible to pick for these
+	CHECK(InputSignature::GetElementFormat(MakeParameter("TEXCOORD", 3, SIGNATURE_COMPONENT_UNKNOWN)) == INPUT_FORMAT_UNKNOWN);
+	CHECK(InputSignature::GetElementFormat(MakeParameter("TEXCOORD", 16, SIGNATURE_COMPONENT_FLOAT32)) == INPUT_FORMAT_UNKNOWN);
+}
+
+TEST(InputSignature, SystemValuesSkippedAndPerInstanceMoved)
+{
+	std::vector<SignatureParameter> parameters;
+	parameters.push_back(MakeParameter("POSITION", 7, SIGNATURE_COMPONENT_FLOAT32));
+	parameters.push_back(MakeParameter("SV_VertexID", 1, SIGNATURE_COMPONENT_UINT32));
+	parameters.back().SystemValue = true;
+	parameters.push_back(MakeParameter("WORLD_PER_INSTANCE", 15, SIGNATURE_COMPONENT_FLOAT32));
+
+	std::vector<InputElement> elements;
+	CHECK(InputSignature::BuildElements(parameters, &elements));
+	CHECK(elements.size() == 2);
+
+	CHECK(strcmp(elements[0].SemanticName, "POSITION") == 0);
+	CHECK(elements[0].InputSlot == 0);
+	CHECK(elements[0].AlignedByteOffset == InputAppendAligned);
+	CHECK(!elements[0].PerInstance);
+	CHECK(elements[0].InstanceDataStepRate == 0);
+
+	CHECK(strcmp(elements[1].SemanticName, "WORLD_PER_INSTANCE") == 0);
+	CHECK(elements[1].Format == INPUT_FORMAT_R32G32B32A32_FLOAT);
+	CHECK(elements[1].InputSlot == 1);
+	CHECK(elements[1].PerInstance);
+	CHECK(elements[1].InstanceDataStepRate == 1);
+
+	// Without the suffix nothing is per instance
+	parameters.pop_back();
+	CHECK(!InputSignature::BuildElements(parameters, &elements));
+	CHECK(elements.size() == 1);
+}
+
+TEST(InputSignature, HashAndDedupGoByNameContent)
+{
+	// Same text in different buffers, as two shaders' reflection
+	// data would have it
+	char positionA[] = "POSITION";
+	char positionB[] = "POSITION";
+	char normal[] = "NORMAL";
+
+	std::vector<SignatureParameter> parameters;
+	parameters.push_back(MakeParameter(positionA, 7, SIGNATURE_COMPONENT_FLOAT32));
+	std::vector<InputElement> a;
+	InputSignature::BuildElements(parameters, &a);
+
+	parameters[0].SemanticName = positionB;
+	std::vector<InputElement> b;
+	InputSignature::BuildElements(parameters, &b);
+
+	parameters[0].SemanticName = normal;
+	std::vector<InputElement> c;
+	InputSignature::BuildElements(parameters, &c);
+
+	unsigned long long hashA = InputSignature::Hash(&a[0], 1);
+	CHECK(hashA == InputSignature::Hash(&b[0], 1));
+	CHECK(hashA != InputSignature::Hash(&c[0], 1));
+
+	// Any other field changes the hash too
+	b[0].SemanticIndex = 1;
+	CHECK(hashA != InputSignature::Hash(&b[0], 1));
+	b[0].SemanticIndex = 0;
+
+	InputLayoutTable<int> table;
+	const void* device = &table;
+	table.Add(device, hashA, &a[0], 1, 7);
+
+	// The table keeps its own copy of the name
+	positionA[0] = 'X';
+	CHECK(table.Find(device, hashA, &b[0], 1) == 7);
+	CHECK(table.Find(device, InputSignature::Hash(&c[0], 1), &c[0], 1) == 0);
+
+	// Layouts belong to the device they were made on
+	CHECK(table.Find(&hashA, hashA, &b[0], 1) == 0);
+}
+
+TEST(InputSignature, SharedHashFallsBackToFullCompare)
+{
+	std::vector<SignatureParameter> parameters;
+	parameters.push_back(MakeParameter("POSITION", 7, SIGNATURE_COMPONENT_FLOAT32));
+	parameters.push_back(MakeParameter("TEXCOORD", 3, SIGNATURE_COMPONENT_FLOAT32));
+	std::vector<InputElement> a;
+	InputSignature::BuildElements(parameters, &a);
+
+	parameters[1].Mask = 7;
+	std::vector<InputElement> b;
+	InputSignature::BuildElements(parameters, &b);
+
+	// Pretend both arrays hash the same
+	const unsigned long long hash = 42;
+	InputLayoutTable<int> table;
+	const void* device = &table;
+
+	CHECK(table.Find(device, hash, &a[0], 2) == 0);
+	table.Add(device, hash, &a[0], 2, 1);
+
+	// Same hash, different elements - must miss, not hand back a's layout
+	CHECK(table.Find(device, hash, &b[0], 2) == 0);
+	table.Add(device, hash, &b[0], 2, 2);
+
+	CHECK(table.Find(device, hash, &a[0], 2) == 1);
+	CHECK(table.Find(device, hash, &b[0], 2) == 2);
+	CHECK(table.Find(device, hash, &a[0], 1) == 0);
+	CHECK(table.GetCount() == 2);
+
+	table.Clear();
+	CHECK(table.GetCount() == 0);
+	CHECK(table.Find(device, hash, &a[0], 2) == 0);
+}
@@ -0,0 +1,104 @@
+#include "TestRunner.h"
+#include "ParticleBatcher.h"
+
+// --------------------------------------------------------
+// An emitter holding count still particles, all drawn at
+// size id, so packed instances show whose they are
+// --------------------------------------------------------
+static Emitter* MakeTaggedEmitter(float id, int maxParticles, int count)
+{
+	Emitter* emitter = new Emitter(
+		maxParticles, 10, 100, id, id,
+		XMFLOAT4(1, 1, 1, 1), XMFLOAT4(1, 1, 1, 1),
+		XMFLOAT3(0, 0, 0), XMFLOAT3(0, 0, 0), XMFLOAT3(0, 0, 0));
+	emitter->SpawnParticles(count, 0);
+	return emitter;
+}
+
+TEST(ParticleBatcher, GroupsPackIntoOneBatchEach)
+{
+	Emitter* emitters[4] = {
+		MakeTaggedEmitter(1, 8, 3),
+		MakeTaggedEmitter(2, 8, 5),
+		MakeTaggedEmitter(3, 8, 2),
+		MakeTaggedEmitter(4, 8, 4) };
+
+	// Interleaved groups, added out of order
+	ParticleBatcher batcher;
+	int handles[4] = {
+		batcher.Add(emitters[0], 7),
+		batcher.Add(emitters[1], 2),
+		batcher.Add(emitters[2], 7),
+		batcher.Add(emitters[3], 2) };
+	CHECK(batcher.GetCapacity() == 32);
+
+	ParticleInstance instances[32];
+	unsigned int packed = batcher.Pack(instances);
+	const std::vector<ParticleBatch>& batches = batcher.GetBatches();
+
+	bool handlesKept = true;
+	for (int e = 0; e < 4; e++)
+		handlesKept = handlesKept && batcher.GetEmitter(handles[e]) == emitters[e];
+	for (int e = 0; e < 4; e++)
+		delete emitters[e];
+
+	CHECK(handlesKept);
+	CHECK(packed == 14);
+	CHECK(batches.size() == 2);
+	CHECK(batches[0].Group == 2 && batches[0].Start == 0 && batches[0].Count == 9);
+	CHECK(batches[1].Group == 7 && batches[1].Start == 9 && batches[1].Count == 5);
+
+	// Within a group, emitters stay in the order they were added
+	float expected[14] = { 2, 2, 2, 2, 2, 4, 4, 4, 4, 1, 1, 1, 3, 3 };
+	for (int i = 0; i < 14; i++)
+		CHECK(instances[i].Size == expected[i]);
+}
+
+TEST(ParticleBatcher, DisabledAndEmptyEmittersAreSkipped)
+{
+	Emitter* emitters[4] = {
+		MakeTaggedEmitter(1, 8, 3),
+		MakeTaggedEmitter(2, 8, 0),
+		MakeTaggedEmitter(3, 8, 2),
+		MakeTaggedEmitter(4, 8, 6) };
+
+	ParticleBatcher batcher;
+	batcher.Add(emitters[0], 0);
+	batcher.Add(emitters[1], 1);
+	int middle = batcher.Add(emitters[2], 0);
+	int last = batcher.Add(emitters[3], 2);
+
+	batcher.SetEnabled(last, false);
+	batcher.SetEnabled(middle, false);
+	batcher.SetEnabled(middle, true);
+	CHECK(!batcher.IsEnabled(last));
+	CHECK(batcher.IsEnabled(middle));
+	CHECK(!batcher.IsEnabled(99));
+
+	ParticleInstance instances[32];
+	unsigned int packed = batcher.Pack(instances);
+	const std::vector<ParticleBatch>& batches = batcher.GetBatches();
+	for (int e = 0; e < 4; e++)
+		delete emitters[e];
+
+	// Group 1 has nothing alive and group 2 is disabled, so
+	// neither gets a batch
+	CHECK(packed == 5);
+	CHECK(batches.size() == 1);
+	CHECK(batches[0].Group == 0 && batches[0].Count == 5);
+}
+
+TEST(ParticleBatcher, NothingAliveMeansNoBatches)
+{
+	Emitter* emitter = MakeTaggedEmitter(1, 8, 0);
+	ParticleBatcher batcher;
+	batcher.Add(emitter, 0);
+
+	ParticleInstance instances[8];
+	unsigned int packed = batcher.Pack(instances);
+	bool empty = batcher.GetBatches().empty();
+	delete emitter;
+
+	CHECK(packed == 0);
+	CHECK(empty);
+}
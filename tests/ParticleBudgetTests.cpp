@@ -0,0 +1,127 @@
+#include "TestRunner.h"
+#include "ParticleBudget.h"
+
+TEST(ParticleBudget, NoTargetsGiveFullCapacity)
+{
+	ParticleBudget budget;
+	int a = budget.Add(100, 1.0f);
+	int b = budget.Add(300, 2.0f);
+
+	unsigned int live[] = { 100, 300 };
+	budget.Rebalance(live);
+	CHECK(budget.GetAllowance() == 400);
+	CHECK(budget.GetLimit(a) == 100);
+	CHECK(budget.GetLimit(b) == 300);
+	CHECK(budget.GetRateScale(a) == 1.0f);
+}
+
+TEST(ParticleBudget, HigherPrioritiesAreServedFirst)
+{
+	ParticleBudget budget;
+	int low = budget.Add(100, 1.0f);
+	int high = budget.Add(100, 2.0f);
+	budget.SetParticleTarget(150);
+
+	unsigned int live[] = { 0, 0 };
+	budget.Rebalance(live);
+	CHECK(budget.GetLimit(high) == 100);
+	CHECK(budget.GetLimit(low) == 50);
+	CHECK_NEAR(budget.GetRateScale(low), 0.5, 1e-6);
+
+	// Swapping priorities swaps who gets squeezed
+	budget.SetPriority(low, 3.0f);
+	budget.Rebalance(live);
+	CHECK(budget.GetLimit(low) == 100);
+	CHECK(budget.GetLimit(high) == 50);
+}
+
+TEST(ParticleBudget, TiesSplitByCapacity)
+{
+	ParticleBudget budget;
+	int first = budget.Add(100);
+	int second = budget.Add(300);
+	int top = budget.Add(50, 5.0f);
+	budget.SetParticleTarget(250);
+
+	unsigned int live[] = { 0, 0, 0 };
+	budget.Rebalance(live);
+	CHECK(budget.GetLimit(top) == 50);
+	CHECK(budget.GetLimit(first) == 50);
+	CHECK(budget.GetLimit(second) == 150);
+}
+
+// --------------------------------------------------------
+// Time targets, with the clock moved by hand so the cost
+// per particle is exact
+// --------------------------------------------------------
+TEST(ParticleBudget, TimeTargetUsesMeasuredCost)
+{
+	// Powers of two all the way, so every step is exact
+	double fakeTime = 64.0;
+	ParticleBudget budget([&fakeTime]() { return fakeTime; });
+	int high = budget.Add(1024, 2.0f);
+	int low = budget.Add(1024, 1.0f);
+	budget.SetTimeTarget(1.0 / 2048);
+
+	// Nothing measured yet, so nothing to cut
+	unsigned int live[] = { 512, 512 };
+	budget.Rebalance(live);
+	CHECK(budget.GetAllowance() == 2048);
+
+	// 1024 particles took 1/1024 of a second, so the target
+	// buys 512 of them - all for the high priority
+	double start = budget.Now();
+	fakeTime += 1.0 / 1024;
+	budget.AddCost(budget.Now() - start);
+	budget.Rebalance(live);
+
+	CHECK(budget.GetLastFrameCost() == 1.0 / 1024);
+	CHECK(budget.GetAllowance() == 512);
+	CHECK(budget.GetLimit(high) == 512);
+	CHECK(budget.GetLimit(low) == 0);
+	CHECK(budget.GetRateScale(low) == 0.0f);
+	CHECK(budget.GetLoad(high) == 1.0 / 2048);
+}
+
+TEST(ParticleBudget, OneSlowFrameOnlyNudgesTheCost)
+{
+	double fakeTime = 0;
+	ParticleBudget budget([&fakeTime]() { return fakeTime; });
+	budget.Add(1000);
+	budget.SetTimeTarget(0.0005);
+
+	unsigned int live[] = { 1000 };
+	budget.AddCost(0.001);
+	budget.Rebalance(live);
+	CHECK(budget.GetAllowance() == 500);
+
+	// Twice as slow moves the cost a tenth of the way there:
+	// 1.1us a particle, so 454 fit
+	budget.AddCost(0.002);
+	budget.Rebalance(live);
+	CHECK(budget.GetAllowance() == 454);
+}
+
+TEST(ParticleBudget, ParticleTargetCapsTimeTarget)
+{
+	ParticleBudget budget;
+	int handle = budget.Add(1000);
+	budget.SetTimeTarget(1.0);
+	budget.SetParticleTarget(10);
+
+	unsigned int live[] = { 1000 };
+	budget.AddCost(0.001);
+	budget.Rebalance(live);
+	CHECK(budget.GetAllowance() == 10);
+	CHECK(budget.GetLimit(handle) == 10);
+}
+
+TEST(ParticleBudget, BadHandlesReadAsZero)
+{
+	ParticleBudget budget;
+	budget.Add(10);
+	CHECK(budget.GetLimit(-1) == 0);
+	CHECK(budget.GetLimit(1) == 0);
+	CHECK(budget.GetRateScale(7) == 0.0f);
+	CHECK(budget.GetLoad(-3) == 0.0);
+}
@@ -0,0 +1,119 @@
+#include "TestRunner.h"
+#include "ParticleCurves.h"
+
+using namespace DirectX;
+
+TEST(ParticleCurves, DefaultsAreFlat)
+{
+	ParticleCurves curves;
+	CHECK(curves.IsConstant());
+	CHECK(curves.GetConstantSpeed() == 1.0f);
+
+	ParticleCurveSample sample = curves.Sample(0.3f);
+	CHECK(sample.Color.x == 1 && sample.Color.y == 1 && sample.Color.z == 1 && sample.Color.w == 1);
+	CHECK(sample.Size == 1);
+	CHECK(curves.GetMaxSize() == 1);
+}
+
+TEST(ParticleCurves, LinearEndpointsAreExact)
+{
+	ParticleCurves curves = ParticleCurves::MakeLinear(XMFLOAT4(1, 0.5f, 0, 1), XMFLOAT4(0, 0.5f, 1, 0), 0.1f, 2.0f);
+	curves.Bake(4);
+	CHECK(!curves.IsConstant());
+
+	ParticleCurveSample start = curves.Sample(0);
+	CHECK(start.Color.x == 1 && start.Color.y == 0.5f && start.Color.z == 0 && start.Color.w == 1);
+	CHECK(start.Size == 0.1f);
+	CHECK(start.Travel == 0);
+
+	ParticleCurveSample end = curves.Sample(1);
+	CHECK(end.Color.x == 0 && end.Color.y == 0.5f && end.Color.z == 1 && end.Color.w == 0);
+	CHECK(end.Size == 2.0f);
+
+	ParticleCurveSample middle = curves.Sample(0.5f);
+	CHECK_NEAR(middle.Color.x, 0.5, 1e-6);
+	CHECK_NEAR(middle.Size, 1.05, 1e-6);
+
+	// Ages outside [0, 1] are clamped
+	CHECK(curves.Sample(-3).Size == start.Size);
+	CHECK(curves.Sample(7).Size == end.Size);
+}
+
+TEST(ParticleCurves, KeysHoldFlatOutsideTheirRange)
+{
+	ParticleCurveKey sizes[2] = { { 0.25f, 1 }, { 0.75f, 3 } };
+	ParticleCurves curves;
+	curves.SetSize(sizes, 2);
+	curves.Bake(1);
+
+	CHECK(curves.Sample(0).Size == 1);
+	CHECK_NEAR(curves.Sample(0.2f).Size, 1, 1e-6);
+	CHECK_NEAR(curves.Sample(0.5f).Size, 2, 0.02);
+	CHECK(curves.Sample(1).Size == 3);
+	CHECK(curves.GetMaxSize() == 3);
+}
+
+TEST(ParticleCurves, AlphaScalesColorAlpha)
+{
+	ParticleColorKey colors[1] = { { 0, XMFLOAT4(1, 1, 1, 0.5f) } };
+	ParticleCurveKey alpha[2] = { { 0, 1 }, { 1, 0 } };
+	ParticleCurves curves;
+	curves.SetColor(colors, 1);
+	curves.SetAlpha(alpha, 2);
+	curves.Bake(1);
+
+	CHECK(curves.Sample(0).Color.w == 0.5f);
+	CHECK(curves.Sample(1).Color.w == 0);
+	CHECK(curves.Sample(1).Color.x == 1);
+}
+
+// --------------------------------------------------------
+// Travel is the integral of speed over seconds lived
+// --------------------------------------------------------
+TEST(ParticleCurves, ConstantSpeedTravelsItsAge)
+{
+	ParticleCurves curves;
+	curves.Bake(3);
+
+	CHECK_NEAR(curves.Sample(1).Travel, 3, 1e-5);
+	CHECK_NEAR(curves.Sample(0.5f).Travel, 1.5, 1e-5);
+	CHECK_NEAR(curves.GetMaxTravel(), 3, 1e-5);
+	CHECK(curves.GetMinTravel() == 0);
+
+	ParticleCurveKey half[1] = { { 0, 0.5f } };
+	curves.SetSpeed(half, 1);
+	curves.Bake(3);
+	CHECK(curves.IsConstant());
+	CHECK(curves.GetConstantSpeed() == 0.5f);
+	CHECK_NEAR(curves.Sample(1).Travel, 1.5, 1e-5);
+}
+
+TEST(ParticleCurves, LinearSpeedTravelIsQuadratic)
+{
+	// Speed 2 down to 0 over a 2 second life: travel at age
+	// fraction u is 2uT - u^2 T
+	ParticleCurveKey speed[2] = { { 0, 2 }, { 1, 0 } };
+	ParticleCurves curves;
+	curves.SetSpeed(speed, 2);
+	curves.Bake(2);
+
+	for (int i = 0; i <= 20; i++)
+	{
+		float u = i / 20.0f;
+		CHECK_NEAR(curves.Sample(u).Travel, 2 * u * 2 - u * u * 2, 1e-3);
+	}
+	CHECK_NEAR(curves.GetMaxTravel(), 2, 1e-5);
+}
+
+TEST(ParticleCurves, ReversingSpeedSetsMinTravel)
+{
+	// Forward for the first half, back twice as far after
+	ParticleCurveKey speed[4] = { { 0, 1 }, { 0.5f, 1 }, { 0.5f, -3 }, { 1, -3 } };
+	ParticleCurves curves;
+	curves.SetSpeed(speed, 4);
+	curves.Bake(2);
+
+	CHECK(curves.GetMaxTravel() > 0.9f && curves.GetMaxTravel() < 1.1f);
+	CHECK_NEAR(curves.GetMinTravel(), curves.Sample(1).Travel, 1e-6);
+	CHECK(curves.GetMinTravel() < -1.5f);
+}
@@ -0,0 +1,150 @@
+#include <vector>
+#include "TestRunner.h"
+#include "ParticleRandom.h"
+
+// --------------------------------------------------------
+// One lane of the generator done the slow way: splitmix32
+// seeding, then scalar xoshiro128+
+// --------------------------------------------------------
+struct ReferenceLane
+{
+	unsigned int s[4];
+
+	ReferenceLane(unsigned int seed, int lane)
+	{
+		unsigned int mix = seed + 0x9e3779b9u * 4u * (unsigned int)lane;
+		for (int word = 0; word < 4; word++)
+		{
+			mix += 0x9e3779b9u;
+			unsigned int z = mix;
+			z = (z ^ (z >> 16)) * 0x85ebca6bu;
+			z = (z ^ (z >> 13)) * 0xc2b2ae35u;
+			s[word] = z ^ (z >> 16);
+		}
+	}
+
+	unsigned int Next()
+	{
+		unsigned int result = s[0] + s[3];
+		unsigned int t = s[1] << 9;
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = (s[3] << 11) | (s[3] >> 21);
+		return result;
+	}
+};
+
+TEST(ParticleRandom, LanesMatchScalarXoshiro)
+{
+	ParticleRandom random(1234);
+	ReferenceLane lanes[4] = { ReferenceLane(1234, 0), ReferenceLane(1234, 1), ReferenceLane(1234, 2), ReferenceLane(1234, 3) };
+
+	for (int step = 0; step < 1000; step++)
+	{
+		unsigned int values[4];
+		random.Next(values);
+		for (int lane = 0; lane < 4; lane++)
+			CHECK(values[lane] == lanes[lane].Next());
+	}
+}
+
+TEST(ParticleRandom, SameSeedSameStream)
+{
+	ParticleRandom first(42);
+	ParticleRandom second(42);
+	std::vector<unsigned int> a(10000), b(10000);
+	first.Fill(&a[0], (int)a.size());
+	second.Fill(&b[0], (int)b.size());
+	CHECK(a == b);
+
+	// Seed() starts over
+	first.Seed(42);
+	first.Fill(&b[0], (int)b.size());
+	CHECK(a == b);
+
+	// ...and a different seed doesn't
+	second.Seed(43);
+	second.Fill(&b[0], (int)b.size());
+	unsigned int matching = 0;
+	for (unsigned int i = 0; i < a.size(); i++)
+		matching += a[i] == b[i];
+	CHECK(matching < 5);
+}
+
+// --------------------------------------------------------
+// Lanes are separate streams, so nothing one lane produces
+// should predict another
+// --------------------------------------------------------
+TEST(ParticleRandom, LanesAreIndependent)
+{
+	static const int steps = 100000;
+	ParticleRandom random(7);
+	std::vector<double> lanes[4];
+	for (int step = 0; step < steps; step++)
+	{
+		unsigned int values[4];
+		random.Next(values);
+		for (int lane = 0; lane < 4; lane++)
+			lanes[lane].push_back((values[lane] >> 8) / 16777216.0);
+	}
+
+	for (int a = 0; a < 4; a++)
+	{
+		for (int b = a + 1; b < 4; b++)
+		{
+			// Pearson correlation, which for independent uniform
+			// streams this long stays within a percent or so of 0
+			double sumA = 0, sumB = 0, sumAB = 0, sumAA = 0, sumBB = 0;
+			unsigned int same = 0;
+			for (int i = 0; i < steps; i++)
+			{
+				double x = lanes[a][i], y = lanes[b][i];
+				sumA += x; sumB += y; sumAB += x * y; sumAA += x * x; sumBB += y * y;
+				same += x == y;
+			}
+			double covariance = sumAB / steps - (sumA / steps) * (sumB / steps);
+			double varianceA = sumAA / steps - (sumA / steps) * (sumA / steps);
+			double varianceB = sumBB / steps - (sumB / steps) * (sumB / steps);
+			CHECK_NEAR(covariance / sqrt(varianceA * varianceB), 0, 0.02);
+			CHECK(same < 5);
+		}
+	}
+}
+
+TEST(ParticleRandom, FloatsStayInRange)
+{
+	ParticleRandom random(99);
+	std::vector<float> values(40000);
+	random.Fill(&values[0], (int)values.size(), -0.2f, 0.2f);
+
+	double sum = 0;
+	for (unsigned int i = 0; i < values.size(); i++)
+	{
+		CHECK(values[i] >= -0.2f && values[i] < 0.2f);
+		sum += values[i];
+	}
+	CHECK_NEAR(sum / values.size(), 0, 0.005);
+}
+
+TEST(ParticleRandom, PartialBlocksUseAllFourLanes)
+{
+	ParticleRandom partial(5);
+	ParticleRandom whole(5);
+
+	float three[3];
+	float four[4];
+	partial.Fill(three, 3, 0, 1);
+	whole.Fill(four, 4, 0, 1);
+	for (int i = 0; i < 3; i++)
+		CHECK(three[i] == four[i]);
+
+	// Both are on the second block now
+	unsigned int a[4], b[4];
+	partial.Next(a);
+	whole.Next(b);
+	for (int lane = 0; lane < 4; lane++)
+		CHECK(a[lane] == b[lane]);
+}
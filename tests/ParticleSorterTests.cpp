@@ -0,0 +1,121 @@
+#include <vector>
+#include "TestRunner.h"
+#include "ParticleRandom.h"
+#include "ParticleSorter.h"
+
+// --------------------------------------------------------
+// A cloud with each particle's original index in its size,
+// so a sorted copy can be traced back
+// --------------------------------------------------------
+static std::vector<ParticleInstance> MakeCloud(unsigned int count, unsigned int seed, float extent)
+{
+	ParticleRandom random(seed);
+	std::vector<float> coordinates(count * 3);
+	random.Fill(&coordinates[0], (int)coordinates.size(), -extent, extent);
+
+	std::vector<ParticleInstance> cloud(count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		cloud[i].Position = XMFLOAT3(coordinates[i * 3], coordinates[i * 3 + 1], coordinates[i * 3 + 2]);
+		cloud[i].Size = (float)i;
+		cloud[i].Color = XMFLOAT4(1, 1, 1, 1);
+	}
+	return cloud;
+}
+
+static float Depth(const ParticleInstance& particle, const XMFLOAT4& plane)
+{
+	return plane.x * particle.Position.x + plane.y * particle.Position.y + plane.z * particle.Position.z + plane.w;
+}
+
+// Every particle exactly once
+static bool IsPermutation(const std::vector<ParticleInstance>& sorted)
+{
+	std::vector<bool> seen(sorted.size(), false);
+	for (unsigned int i = 0; i < sorted.size(); i++)
+	{
+		unsigned int index = (unsigned int)sorted[i].Size;
+		if (index >= sorted.size() || seen[index])
+			return false;
+		seen[index] = true;
+	}
+	return true;
+}
+
+TEST(ParticleSorter, WideKeysSortExactlyBackToFront)
+{
+	// Straddling the view plane, so depths are both signs
+	std::vector<ParticleInstance> cloud = MakeCloud(20000, 1, 50);
+	std::vector<ParticleInstance> sorted(cloud.size());
+	XMFLOAT4 plane(0.6f, 0, 0.8f, 10);
+
+	ParticleSorter sorter;
+	sorter.SortBackToFront(&cloud[0], &sorted[0], (unsigned int)cloud.size(), plane, true);
+
+	CHECK(IsPermutation(sorted));
+	for (unsigned int i = 1; i < sorted.size(); i++)
+		CHECK(Depth(sorted[i - 1], plane) >= Depth(sorted[i], plane));
+}
+
+TEST(ParticleSorter, NarrowKeysSortWithinTheirPrecision)
+{
+	std::vector<ParticleInstance> cloud = MakeCloud(20000, 2, 50);
+	std::vector<ParticleInstance> sorted(cloud.size());
+	XMFLOAT4 plane(0, 1, 0, 100);
+
+	ParticleSorter sorter;
+	sorter.SortBackToFront(&cloud[0], &sorted[0], (unsigned int)cloud.size(), plane);
+	CHECK(IsPermutation(sorted));
+
+	// Out of order by no more than one key step of the range
+	float nearest = Depth(cloud[0], plane);
+	float farthest = nearest;
+	for (unsigned int i = 1; i < cloud.size(); i++)
+	{
+		float depth = Depth(cloud[i], plane);
+		if (depth < nearest) nearest = depth;
+		if (depth > farthest) farthest = depth;
+	}
+
+	float step = (farthest - nearest) / 65535.0f;
+	for (unsigned int i = 1; i < sorted.size(); i++)
+		CHECK(Depth(sorted[i - 1], plane) >= Depth(sorted[i], plane) - step);
+}
+
+TEST(ParticleSorter, EqualDepthsKeepTheirOrder)
+{
+	// Everything on one plane - every pass is skipped
+	std::vector<ParticleInstance> cloud = MakeCloud(1000, 3, 5);
+	for (unsigned int i = 0; i < cloud.size(); i++)
+		cloud[i].Position.z = 2;
+
+	std::vector<ParticleInstance> sorted(cloud.size());
+	ParticleSorter sorter;
+	for (int wide = 0; wide < 2; wide++)
+	{
+		sorter.SortBackToFront(&cloud[0], &sorted[0], (unsigned int)cloud.size(), XMFLOAT4(0, 0, 1, 0), wide != 0);
+		for (unsigned int i = 0; i < sorted.size(); i++)
+			CHECK(sorted[i].Size == (float)i);
+	}
+}
+
+TEST(ParticleSorter, ReusesScratchAcrossCounts)
+{
+	ParticleSorter sorter;
+	XMFLOAT4 plane(1, 0, 0, 0);
+	unsigned int counts[] = { 5000, 17, 1, 3000 };
+
+	for (unsigned int c = 0; c < 4; c++)
+	{
+		std::vector<ParticleInstance> cloud = MakeCloud(counts[c], 10 + c, 20);
+		std::vector<ParticleInstance> sorted(counts[c]);
+		sorter.SortBackToFront(&cloud[0], &sorted[0], counts[c], plane, true);
+
+		CHECK(IsPermutation(sorted));
+		for (unsigned int i = 1; i < sorted.size(); i++)
+			CHECK(sorted[i - 1].Position.x >= sorted[i].Position.x);
+	}
+
+	// Nothing to sort is fine too
+	sorter.SortBackToFront(0, 0, 0, plane);
+}
@@ -0,0 +1,101 @@
+#include <vector>
+#include "TestRunner.h"
+#include "PassRecorder.h"
+#include "WorkerPool.h"
+
+// Each pass writes its own index a few times over, so the
+// merged list shows which pass went where
+static void AddPasses(PassRecorder<std::vector<unsigned int> >* recorder, unsigned int passes, unsigned int length)
+{
+	for (unsigned int p = 0; p < passes; p++)
+	{
+		recorder->AddPass([length](unsigned int pass, std::vector<unsigned int>* list) {
+			list->clear();
+			for (unsigned int i = 0; i < length; i++)
+				list->push_back(pass * 1000 + i);
+		});
+	}
+}
+
+static std::vector<unsigned int> Merge(PassRecorder<std::vector<unsigned int> >* recorder)
+{
+	std::vector<unsigned int> merged;
+	recorder->Execute([&merged](unsigned int /*pass*/, std::vector<unsigned int>* list) {
+		merged.insert(merged.end(), list->begin(), list->end());
+	});
+	return merged;
+}
+
+TEST(PassRecorder, ExecutesInPassOrder)
+{
+	PassRecorder<std::vector<unsigned int> > recorder;
+	AddPasses(&recorder, 5, 3);
+	CHECK(recorder.GetPassCount() == 5);
+
+	recorder.Record(0);
+	std::vector<unsigned int> merged = Merge(&recorder);
+
+	CHECK(merged.size() == 15);
+	for (unsigned int i = 0; i < merged.size(); i++)
+		CHECK(merged[i] == (i / 3) * 1000 + i % 3);
+}
+
+TEST(PassRecorder, WorkersGiveTheSameStream)
+{
+	PassRecorder<std::vector<unsigned int> > serial;
+	AddPasses(&serial, 16, 200);
+	serial.Record(0);
+	std::vector<unsigned int> expected = Merge(&serial);
+
+	WorkerPool workers(3);
+	PassRecorder<std::vector<unsigned int> > recorder;
+	for (int frame = 0; frame < 50; frame++)
+	{
+		AddPasses(&recorder, 16, 200);
+		recorder.Record(&workers);
+		CHECK(Merge(&recorder) == expected);
+	}
+}
+
+TEST(PassRecorder, ExecuteClearsPassesButKeepsLists)
+{
+	PassRecorder<std::vector<unsigned int> > recorder;
+	AddPasses(&recorder, 4, 100);
+	recorder.Record(0);
+	Merge(&recorder);
+
+	CHECK(recorder.GetPassCount() == 0);
+	CHECK(recorder.GetListCount() == 4);
+	CHECK(recorder.GetList(3)->capacity() >= 100);
+
+	// A smaller frame reuses the first slots, and leaves the
+	// rest alone
+	AddPasses(&recorder, 2, 1);
+	recorder.Record(0);
+	CHECK(Merge(&recorder).size() == 2);
+	CHECK(recorder.GetListCount() == 4);
+	CHECK(recorder.GetList(3)->size() == 100);
+}
+
+TEST(PassRecorder, EveryPassRecordsOnce)
+{
+	WorkerPool workers(3);
+	PassRecorder<int> recorder;
+	for (int p = 0; p < 33; p++)
+		recorder.AddPass([](unsigned int /*pass*/, int* list) { (*list)++; });
+	recorder.Record(&workers);
+
+	std::vector<unsigned int> order;
+	std::vector<int> records;
+	recorder.Execute([&order, &records](unsigned int pass, int* list) {
+		order.push_back(pass);
+		records.push_back(*list);
+	});
+
+	CHECK(order.size() == 33);
+	for (unsigned int p = 0; p < order.size(); p++)
+	{
+		CHECK(order[p] == p);
+		CHECK(records[p] == 1);
+	}
+}
@@ -0,0 +1,170 @@
+#include "TestRunner.h"
+#include "ReflectionSidecar.h"
+
+static const unsigned long long shaderHash = 0x0123456789ABCDEFull;
+
+// --------------------------------------------------------
+// Roughly what a lit pixel shader reflects as
+// --------------------------------------------------------
+static ShaderReflectionData MakeReflection()
+{
+	ShaderReflectionData reflection;
+
+	ReflectedConstantBuffer perFrame;
+	perFrame.Name = "externalData";
+	perFrame.Size = 96;
+	perFrame.BindIndex = 0;
+	ReflectedVariable light = { "dLight1", "DirectionalLight", 0, 0, 44 };
+	ReflectedVariable colors = { "colors", "float4", 3, 48, 48 };
+	perFrame.Variables.push_back(light);
+	perFrame.Variables.push_back(colors);
+	reflection.ConstantBuffers.push_back(perFrame);
+
+	ReflectedConstantBuffer empty;
+	empty.Name = "unused";
+	empty.Size = 16;
+	empty.BindIndex = 3;
+	reflection.ConstantBuffers.push_back(empty);
+
+	ReflectedResource diffuse = { "DiffuseTexture", 0 };
+	ReflectedResource normals = { "NormalMap", 1 };
+	ReflectedResource sampler = { "Sampler", 0 };
+	reflection.Textures.push_back(diffuse);
+	reflection.Textures.push_back(normals);
+	reflection.Samplers.push_back(sampler);
+	return reflection;
+}
+
+static bool SameReflection(const ShaderReflectionData& a, const ShaderReflectionData& b)
+{
+	if (a.ConstantBuffers.size() != b.ConstantBuffers.size() ||
+		a.Textures.size() != b.Textures.size() ||
+		a.Samplers.size() != b.Samplers.size())
+		return false;
+
+	for (unsigned int c = 0; c < a.ConstantBuffers.size(); c++)
+	{
+		const ReflectedConstantBuffer& x = a.ConstantBuffers[c];
+		const ReflectedConstantBuffer& y = b.ConstantBuffers[c];
+		if (x.Name != y.Name || x.Size != y.Size || x.BindIndex != y.BindIndex || x.Variables.size() != y.Variables.size())
+			return false;
+
+		for (unsigned int v = 0; v < x.Variables.size(); v++)
+		{
+			const ReflectedVariable& p = x.Variables[v];
+			const ReflectedVariable& q = y.Variables[v];
+			if (p.Name != q.Name || p.TypeName != q.TypeName || p.Elements != q.Elements ||
+				p.ByteOffset != q.ByteOffset || p.Size != q.Size)
+				return false;
+		}
+	}
+
+	for (unsigned int t = 0; t < a.Textures.size(); t++)
+	{
+		if (a.Textures[t].Name != b.Textures[t].Name || a.Textures[t].BindIndex != b.Textures[t].BindIndex)
+			return false;
+	}
+	for (unsigned int s = 0; s < a.Samplers.size(); s++)
+	{
+		if (a.Samplers[s].Name != b.Samplers[s].Name || a.Samplers[s].BindIndex != b.Samplers[s].BindIndex)
+			return false;
+	}
+	return true;
+}
+
+TEST(ReflectionSidecar, SerializeParseRoundTrip)
+{
+	ShaderReflectionData original = MakeReflection();
+	std::vector<unsigned char> data;
+	ReflectionSidecar::Serialize(shaderHash, original, &data);
+
+	ShaderReflectionData parsed;
+	CHECK(ReflectionSidecar::Parse(&data[0], data.size(), shaderHash, &parsed));
+	CHECK(SameReflection(original, parsed));
+}
+
+TEST(ReflectionSidecar, EmptyReflectionRoundTrips)
+{
+	ShaderReflectionData original;
+	std::vector<unsigned char> data;
+	ReflectionSidecar::Serialize(shaderHash, original, &data);
+
+	ShaderReflectionData parsed = MakeReflection();
+	CHECK(ReflectionSidecar::Parse(&data[0], data.size(), shaderHash, &parsed));
+	CHECK(SameReflection(original, parsed));
+}
+
+TEST(ReflectionSidecar, RejectsStaleHash)
+{
+	std::vector<unsigned char> data;
+	ReflectionSidecar::Serialize(shaderHash, MakeReflection(), &data);
+
+	// A rejected parse leaves what was there alone
+	ShaderReflectionData parsed;
+	CHECK(!ReflectionSidecar::Parse(&data[0], data.size(), shaderHash + 1, &parsed));
+	CHECK(parsed.ConstantBuffers.empty());
+}
+
+TEST(ReflectionSidecar, RejectsEveryTruncation)
+{
+	std::vector<unsigned char> data;
+	ReflectionSidecar::Serialize(shaderHash, MakeReflection(), &data);
+
+	ShaderReflectionData parsed;
+	for (size_t size = 0; size < data.size(); size++)
+		CHECK(!ReflectionSidecar::Parse(&data[0], size, shaderHash, &parsed));
+
+	// ...and anything tacked on the end
+	data.push_back(0);
+	CHECK(!ReflectionSidecar::Parse(&data[0], data.size(), shaderHash, &parsed));
+}
+
+TEST(ReflectionSidecar, RejectsWrongMagicAndVersion)
+{
+	std::vector<unsigned char> data;
+	ReflectionSidecar::Serialize(shaderHash, MakeReflection(), &data);
+
+	ShaderReflectionData parsed;
+	std::vector<unsigned char> damaged = data;
+	damaged[0] ^= 0xFF;
+	CHECK(!ReflectionSidecar::Parse(&damaged[0], damaged.size(), shaderHash, &parsed));
+
+	damaged = data;
+	damaged[4] ^= 0xFF;
+	CHECK(!ReflectionSidecar::Parse(&damaged[0], damaged.size(), shaderHash, &parsed));
+}
+
+TEST(ReflectionSidecar, RejectsUnterminatedStrings)
+{
+	std::vector<unsigned char> data;
+	ReflectionSidecar::Serialize(shaderHash, MakeReflection(), &data);
+
+	ShaderReflectionData parsed;
+	data.back() = 'x';
+	CHECK(!ReflectionSidecar::Parse(&data[0], data.size(), shaderHash, &parsed));
+}
+
+TEST(ReflectionSidecar, WriteReadRoundTrip)
+{
+	const std::wstring path = L"ReflectionSidecarTest.cso.refl";
+	ShaderReflectionData original = MakeReflection();
+	CHECK(ReflectionSidecar::Write(path, shaderHash, original));
+
+	ShaderReflectionData read;
+	bool matched = ReflectionSidecar::Read(path, shaderHash, &read);
+	bool stale = ReflectionSidecar::Read(path, shaderHash ^ 1, &read);
+	remove("ReflectionSidecarTest.cso.refl");
+
+	CHECK(matched);
+	CHECK(!stale);
+	CHECK(SameReflection(original, read));
+	CHECK(!ReflectionSidecar::Read(path, shaderHash, &read));
+}
+
+TEST(ReflectionSidecar, HashIsFnv1a)
+{
+	// Published FNV-1a 64 test vectors
+	CHECK(ReflectionSidecar::Hash("", 0) == 0xcbf29ce484222325ull);
+	CHECK(ReflectionSidecar::Hash("a", 1) == 0xaf63dc4c8601ec8cull);
+	CHECK(ReflectionSidecar::Hash("foobar", 6) == 0x85944171f73967e8ull);
+}
@@ -0,0 +1,151 @@
+#include "TestRunner.h"
+#include "RenderGraph.h"
+
+static const RenderTargetDesc colorDesc = { 1280, 720, 28, 0x20 | 0x8 };
+
+TEST(RenderGraph, PassesNothingReadsAreCulled)
+{
+	RenderGraph graph;
+	int backBuffer = graph.ImportResource("back buffer");
+	int scene = graph.CreateResource("scene", colorDesc);
+	int debug = graph.CreateResource("debug", colorDesc);
+	graph.MarkOutput(backBuffer);
+
+	int draw = graph.AddPass("scene");
+	graph.Write(draw, scene);
+	int unused = graph.AddPass("debug view");
+	graph.Write(unused, debug);
+	int blur = graph.AddPass("blur");
+	graph.Read(blur, scene);
+	graph.Write(blur, backBuffer);
+	graph.Compile();
+
+	CHECK(graph.GetOrder().size() == 2);
+	CHECK(graph.GetOrder()[0] == (unsigned int)draw);
+	CHECK(graph.GetOrder()[1] == (unsigned int)blur);
+	CHECK(graph.GetCulledCount() == 1);
+	CHECK(!graph.GetPass(unused).Live);
+	CHECK(graph.GetResource(debug).FirstUse == -1);
+}
+
+TEST(RenderGraph, SideEffectPassesSurvive)
+{
+	RenderGraph graph;
+	int backBuffer = graph.ImportResource("back buffer");
+	int readback = graph.CreateResource("readback", colorDesc);
+	graph.MarkOutput(backBuffer);
+
+	// Nothing reads what these write, but the copy out has
+	// to happen, and so does what it copies from
+	int draw = graph.AddPass("draw readback");
+	graph.Write(draw, readback);
+	int copy = graph.AddPass("copy to CPU", true);
+	graph.Read(copy, readback);
+	int present = graph.AddPass("present");
+	graph.Write(present, backBuffer);
+	graph.Compile();
+
+	CHECK(graph.GetCulledCount() == 0);
+	CHECK(graph.GetPass(copy).Live);
+	CHECK(graph.GetPass(draw).Live);
+	CHECK(graph.GetOrder().size() == 3);
+}
+
+TEST(RenderGraph, NoOutputsCullsEverything)
+{
+	RenderGraph graph;
+	int scene = graph.CreateResource("scene", colorDesc);
+	int draw = graph.AddPass("scene");
+	graph.Write(draw, scene);
+	graph.Compile();
+
+	CHECK(graph.GetOrder().empty());
+	CHECK(graph.GetCulledCount() == 1);
+}
+
+TEST(RenderGraph, WritesDependOnEarlierWrites)
+{
+	// Particles draw on top of the scene, so the scene pass
+	// is needed even though only particles touch the output
+	RenderGraph graph;
+	int backBuffer = graph.ImportResource("back buffer");
+	graph.MarkOutput(backBuffer);
+
+	int scene = graph.AddPass("scene");
+	graph.Write(scene, backBuffer);
+	int particles = graph.AddPass("particles");
+	graph.Write(particles, backBuffer);
+	graph.Compile();
+
+	CHECK(graph.GetCulledCount() == 0);
+	CHECK(graph.GetPass(particles).Dependencies.size() == 1);
+	CHECK(graph.GetPass(particles).Dependencies[0] == scene);
+}
+
+TEST(RenderGraph, LifetimesAreCompiledPositions)
+{
+	RenderGraph graph;
+	int backBuffer = graph.ImportResource("back buffer");
+	int scene = graph.CreateResource("scene", colorDesc);
+	int blurred = graph.CreateResource("blurred", colorDesc);
+	int unusedTarget = graph.CreateResource("unused", colorDesc);
+	graph.MarkOutput(backBuffer);
+
+	int unused = graph.AddPass("unused");
+	graph.Write(unused, unusedTarget);
+	int draw = graph.AddPass("scene");
+	graph.Write(draw, scene);
+	int blur = graph.AddPass("blur");
+	graph.Read(blur, scene);
+	graph.Write(blur, blurred);
+	int composite = graph.AddPass("composite");
+	graph.Read(composite, blurred);
+	graph.Write(composite, backBuffer);
+	graph.Compile();
+
+	// The culled pass at the front doesn't take a position
+	CHECK(graph.GetResource(scene).FirstUse == 0);
+	CHECK(graph.GetResource(scene).LastUse == 1);
+	CHECK(graph.GetResource(blurred).FirstUse == 1);
+	CHECK(graph.GetResource(blurred).LastUse == 2);
+	CHECK(graph.GetResource(backBuffer).FirstUse == 2);
+	CHECK(graph.GetResource(unusedTarget).LastUse == -1);
+}
+
+TEST(RenderGraph, TransientReadsAreUnbound)
+{
+	RenderGraph graph;
+	int backBuffer = graph.ImportResource("back buffer");
+	int sky = graph.ImportResource("sky");
+	int scene = graph.CreateResource("scene", colorDesc);
+	graph.MarkOutput(backBuffer);
+
+	int draw = graph.AddPass("scene");
+	graph.Read(draw, sky);
+	graph.Write(draw, scene);
+	int blur = graph.AddPass("blur");
+	graph.Read(blur, scene);
+	graph.Write(blur, backBuffer);
+	graph.Compile();
+
+	// An imported texture nothing writes can stay bound; a
+	// pooled one can't
+	CHECK(!graph.GetPass(draw).UnbindReads);
+	CHECK(graph.GetPass(blur).UnbindReads);
+}
+
+TEST(RenderGraph, ResetForgetsEverything)
+{
+	RenderGraph graph;
+	int backBuffer = graph.ImportResource("back buffer");
+	graph.MarkOutput(backBuffer);
+	graph.Write(graph.AddPass("present"), backBuffer);
+	graph.Compile();
+
+	graph.Reset();
+	graph.Compile();
+	CHECK(graph.GetPassCount() == 0);
+	CHECK(graph.GetResourceCount() == 0);
+	CHECK(graph.GetOrder().empty());
+	CHECK(graph.GetCulledCount() == 0);
+}
@@ -0,0 +1,160 @@
+#include "TestRunner.h"
+#include "RenderTargetAllocator.h"
+
+// DXGI_FORMAT_R8G8B8A8_UNORM and R16G16B16A16_FLOAT, bound as
+// render target and shader resource
+static const RenderTargetDesc colorDesc = { 1280, 720, 28, 0x20 | 0x8 };
+static const RenderTargetDesc hdrDesc = { 1280, 720, 10, 0x20 | 0x8 };
+
+TEST(RenderTargetAllocator, NonOverlappingLifetimesShareASlot)
+{
+	RenderTargetAllocator allocator;
+	std::vector<unsigned int> created, released;
+
+	allocator.BeginFrame();
+	int first = allocator.Request(colorDesc);
+	int second = allocator.Request(colorDesc);
+	allocator.Use(first, 0);
+	allocator.Use(first, 1);
+	allocator.Use(second, 2);
+	allocator.Use(second, 3);
+	allocator.Allocate(&created, &released);
+
+	CHECK(allocator.GetSlot(first) == allocator.GetSlot(second));
+	CHECK(created.size() == 1);
+	CHECK(released.empty());
+	CHECK(allocator.GetStats().RequestsAliased == 1);
+}
+
+TEST(RenderTargetAllocator, OverlappingLifetimesGetTheirOwnSlots)
+{
+	RenderTargetAllocator allocator;
+	std::vector<unsigned int> created, released;
+
+	allocator.BeginFrame();
+	int first = allocator.Request(colorDesc);
+	int second = allocator.Request(colorDesc);
+	allocator.Use(first, 0);
+	allocator.Use(first, 2);
+	allocator.Use(second, 1);
+	allocator.Allocate(&created, &released);
+
+	CHECK(allocator.GetSlot(first) != allocator.GetSlot(second));
+	CHECK(created.size() == 2);
+	CHECK(allocator.GetStats().RequestsAliased == 0);
+}
+
+TEST(RenderTargetAllocator, SharedPassIsAnOverlap)
+{
+	// The pass reading one is writing the other
+	RenderTargetAllocator allocator;
+	std::vector<unsigned int> created, released;
+
+	allocator.BeginFrame();
+	int scene = allocator.Request(colorDesc);
+	int blurred = allocator.Request(colorDesc);
+	allocator.Use(scene, 0);
+	allocator.Use(scene, 1);
+	allocator.Use(blurred, 1);
+	allocator.Allocate(&created, &released);
+
+	CHECK(allocator.GetSlot(scene) != allocator.GetSlot(blurred));
+}
+
+TEST(RenderTargetAllocator, DifferentDescsNeverShare)
+{
+	RenderTargetAllocator allocator;
+	std::vector<unsigned int> created, released;
+
+	allocator.BeginFrame();
+	int color = allocator.Request(colorDesc);
+	int hdr = allocator.Request(hdrDesc);
+	allocator.Use(color, 0);
+	allocator.Use(hdr, 1);
+	allocator.Allocate(&created, &released);
+
+	CHECK(allocator.GetSlot(color) != allocator.GetSlot(hdr));
+	CHECK(allocator.GetSlotDesc(allocator.GetSlot(hdr)) == hdrDesc);
+	CHECK(created.size() == 2);
+}
+
+TEST(RenderTargetAllocator, UnusedRequestsGetNoSlot)
+{
+	RenderTargetAllocator allocator;
+	std::vector<unsigned int> created, released;
+
+	allocator.BeginFrame();
+	int unused = allocator.Request(colorDesc);
+	CHECK(allocator.GetSlot(unused) == -1);
+	allocator.Allocate(&created, &released);
+
+	CHECK(allocator.GetSlot(unused) == -1);
+	CHECK(created.empty());
+}
+
+TEST(RenderTargetAllocator, SlotsCarryOverBetweenFrames)
+{
+	RenderTargetAllocator allocator;
+	std::vector<unsigned int> created, released;
+
+	for (int frame = 0; frame < 3; frame++)
+	{
+		created.clear();
+		allocator.BeginFrame();
+		int scene = allocator.Request(colorDesc);
+		allocator.Use(scene, 0);
+		allocator.Allocate(&created, &released);
+
+		CHECK(allocator.GetSlot(scene) == 0);
+		CHECK(created.size() == (frame == 0 ? 1u : 0u));
+	}
+	CHECK(allocator.GetStats().SlotsCreated == 1);
+}
+
+TEST(RenderTargetAllocator, IdleSlotsAreReleasedAndReused)
+{
+	RenderTargetAllocator allocator(2);
+	std::vector<unsigned int> created, released;
+
+	allocator.BeginFrame();
+	allocator.Use(allocator.Request(colorDesc), 0);
+	allocator.Allocate(&created, &released);
+
+	// Two idle frames are allowed, the third lets it go
+	for (int frame = 0; frame < 3; frame++)
+	{
+		allocator.BeginFrame();
+		allocator.Allocate(&created, &released);
+		CHECK(released.size() == (frame < 2 ? 0u : 1u));
+	}
+	CHECK(!allocator.IsSlotLive(0));
+
+	// The next new target takes the dead slot's number
+	created.clear();
+	allocator.BeginFrame();
+	int hdr = allocator.Request(hdrDesc);
+	allocator.Use(hdr, 0);
+	allocator.Allocate(&created, &released);
+	CHECK(allocator.GetSlot(hdr) == 0);
+	CHECK(allocator.GetSlotCount() == 1);
+	CHECK(created.size() == 1);
+}
+
+TEST(RenderTargetAllocator, ReleaseAllDropsEverything)
+{
+	RenderTargetAllocator allocator;
+	std::vector<unsigned int> created, released;
+
+	allocator.BeginFrame();
+	int color = allocator.Request(colorDesc);
+	int hdr = allocator.Request(hdrDesc);
+	allocator.Use(color, 0);
+	allocator.Use(hdr, 0);
+	allocator.Allocate(&created, &released);
+
+	allocator.ReleaseAll(&released);
+	CHECK(released.size() == 2);
+	CHECK(allocator.GetSlot(color) == -1);
+	CHECK(!allocator.IsSlotLive(0) && !allocator.IsSlotLive(1));
+	CHECK(allocator.GetStats().SlotsReleased == 2);
+}
@@ -0,0 +1,83 @@
+#include <string.h>
+#include "TestRunner.h"
+#include "ShaderParameters.h"
+
+TEST(ShaderParameters, NamesAndHashesFindTheSameIndex)
+{
+	ShaderNameTable table;
+	CHECK(table.Add("DiffuseTexture", 0));
+	CHECK(table.Add("NormalTexture", 1));
+
+	CHECK(table.Find(std::string("NormalTexture")) == 1);
+	CHECK(table.Find(SimpleShaderHash("NormalTexture")) == 1);
+	CHECK(table.Find(SimpleShaderHash("DiffuseTexture")) == 0);
+	CHECK(table.Find(std::string("SkyTexture")) == ShaderNameTable::InvalidIndex);
+	CHECK(table.Find(SimpleShaderHash("SkyTexture")) == ShaderNameTable::InvalidIndex);
+
+	// The first of a name wins
+	CHECK(!table.Add("DiffuseTexture", 5));
+	CHECK(table.Find(std::string("DiffuseTexture")) == 0);
+	CHECK(table.Find(SimpleShaderHash("DiffuseTexture")) == 0);
+}
+
+TEST(ShaderParameters, SharedHashIsInvalid)
+{
+	// Two names with the same FNV-1a hash
+	CHECK(SimpleShaderHash("costarring") == SimpleShaderHash("liquid"));
+
+	ShaderNameTable table;
+	CHECK(table.Add("costarring", 0));
+	CHECK(table.Add("liquid", 1));
+
+	CHECK(table.Find(SimpleShaderHash("liquid")) == ShaderNameTable::InvalidIndex);
+	CHECK(table.Find(std::string("costarring")) == 0);
+	CHECK(table.Find(std::string("liquid")) == 1);
+}
+
+TEST(ShaderParameters, SetDataChecksSizeAndTracksDirtyBytes)
+{
+	SimpleShaderVariable world = { 0, 64, 0 };
+	SimpleShaderVariable color = { 64, 16, 0 };
+	SimpleShaderVariable light = { 0, 44, 1 };
+
+	ShaderVariableTable table;
+	CHECK(table.Add("world", world));
+	CHECK(table.Add("color", color));
+	CHECK(table.Add("dLight1", light));
+	CHECK(table.GetCount() == 3);
+
+	unsigned char first[80] = {};
+	unsigned char second[48] = {};
+	SimpleLocalBufferData buffers[2] = {
+		{ 80, first, 80, 0, false },
+		{ 48, second, 48, 0, false } };
+
+	float rgba[4] = { 1, 0.5f, 0.25f, 1 };
+	CHECK(!table.SetData("color", buffers, rgba, 12));
+	CHECK(!table.SetData("colour", buffers, rgba, 16));
+	CHECK(table.SetData("color", buffers, rgba, 16));
+
+	CHECK(memcmp(first + 64, rgba, 16) == 0);
+	CHECK(buffers[0].DirtyStart == 64 && buffers[0].DirtyEnd == 80);
+	CHECK(buffers[0].SliceDirty);
+	CHECK(!buffers[1].SliceDirty);
+
+	// Same data again changes nothing
+	buffers[0].DirtyStart = 80;
+	buffers[0].DirtyEnd = 0;
+	buffers[0].SliceDirty = false;
+	int handle = table.GetHandle(SimpleShaderHash("color"));
+	CHECK(handle == 1);
+	CHECK(table.SetData(handle, buffers, rgba, 16));
+	CHECK(!buffers[0].SliceDirty);
+	CHECK(buffers[0].DirtyStart == 80);
+
+	// Handles go to the variable's own buffer
+	float direction[11] = { 0, 0, 0, 0, 1, 1, 1, 1, 0, -1, 0 };
+	CHECK(table.SetData(table.GetHandle(std::string("dLight1")), buffers, direction, 44));
+	CHECK(memcmp(second, direction, 44) == 0);
+	CHECK(buffers[1].DirtyStart == 0 && buffers[1].DirtyEnd == 44);
+
+	CHECK(!table.SetData(3, buffers, rgba, 16));
+	CHECK(!table.SetData(-1, buffers, rgba, 16));
+}
@@ -0,0 +1,42 @@
+#include <string.h>
+#include "TestRunner.h"
+
+std::vector<TestCase>& RegisteredTests()
+{
+	static std::vector<TestCase> tests;
+	return tests;
+}
+
+// --------------------------------------------------------
+// unit_tests [suite]
+// --------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	const char* suite = argc > 1 ? argv[1] : 0;
+
+	int run = 0;
+	int failures = 0;
+	std::vector<TestCase>& tests = RegisteredTests();
+	for (unsigned int t = 0; t < tests.size(); t++)
+	{
+		if (suite && strcmp(suite, tests[t].Suite) != 0)
+			continue;
+
+		bool failed = false;
+		tests[t].Run(&failed);
+		printf("%s %s.%s\n", failed ? "FAIL" : "  ok", tests[t].Suite, tests[t].Name);
+
+		run++;
+		if (failed)
+			failures++;
+	}
+
+	if (run == 0)
+	{
+		printf("no tests matched\n");
+		return 1;
+	}
+
+	printf("%d of %d passed\n", run - failures, run);
+	return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+// --------------------------------------------------------
+// A minimal assert-based test runner.
+//
+// TEST(Suite, Name) defines and registers a test; CHECK()
+// fails the test (and returns from it) the first time its
+// condition is false.  unit_tests runs every test, or just
+// one suite if given its name, and exits non-zero if any
+// failed.
+// --------------------------------------------------------
+struct TestCase
+{
+	const char* Suite;
+	const char* Name;
+	void (*Run)(bool* failed);
+};
+
+std::vector<TestCase>& RegisteredTests();
+
+struct TestRegistration
+{
+	TestRegistration(const char* suite, const char* name, void (*run)(bool* failed))
+	{
+		TestCase test = { suite, name, run };
+		RegisteredTests().push_back(test);
+	}
+};
+
+#define TEST(suite, name) \
+	static void suite##_##name(bool* testFailed); \
+	static TestRegistration suite##_##name##_registration(#suite, #name, suite##_##name); \
+	static void suite##_##name(bool* testFailed)
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) \
+		{ \
+			printf("  %s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+			*testFailed = true; \
+			return; \
+		} \
+	} while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+	do { \
+		double checkActual = (actual); \
+		double checkExpected = (expected); \
+		if (!(fabs(checkActual - checkExpected) <= (tolerance))) \
+		{ \
+			printf("  %s:%d: CHECK_NEAR(%s, %s) failed: %g vs %g\n", __FILE__, __LINE__, #actual, #expected, checkActual, checkExpected); \
+			*testFailed = true; \
+			return; \
+		} \
+	} while (0)
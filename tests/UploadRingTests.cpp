@@ -0,0 +1,184 @@
+#include <deque>
+#include "TestRunner.h"
+#include "UploadRing.h"
+
+TEST(UploadRing, AllocationsAreAlignedInsideTheWindow)
+{
+	UploadRing ring(4096, 256, 3);
+	CHECK(ring.BeginFrame(0));
+
+	unsigned int first = 1, second = 1;
+	CHECK(ring.Allocate(10, &first));
+	CHECK(ring.Allocate(300, &second));
+	CHECK(first == 0);
+	CHECK(second == 256);
+	CHECK(ring.GetFrameBytesUsed() == 768);
+}
+
+TEST(UploadRing, FullWindowRejectsWithoutUsingSpace)
+{
+	UploadRing ring(1024, 256, 3);
+	CHECK(ring.BeginFrame(0));
+
+	unsigned int offset = 0;
+	CHECK(ring.Allocate(768, &offset));
+	CHECK(!ring.Allocate(512, &offset));
+	CHECK(ring.GetFrameBytesUsed() == 768);
+
+	// What's left still fits
+	CHECK(ring.Allocate(256, &offset));
+	CHECK(offset == 768);
+}
+
+TEST(UploadRing, AllocateNeedsAnOpenFrame)
+{
+	UploadRing ring(1024, 256, 3);
+	unsigned int offset = 0;
+	CHECK(!ring.Allocate(16, &offset));
+
+	CHECK(ring.BeginFrame(0));
+	ring.EndFrame();
+	CHECK(!ring.Allocate(16, &offset));
+}
+
+TEST(UploadRing, WindowWrapsToTheFront)
+{
+	UploadRing ring(1024, 256, 3);
+	unsigned int offset = 0;
+
+	// Frame 0 takes [0, 512), frame 1 takes [512, 768)
+	CHECK(ring.BeginFrame(0));
+	CHECK(ring.Allocate(512, &offset));
+	ring.EndFrame();
+	CHECK(ring.BeginFrame(1));
+	CHECK(ring.Allocate(256, &offset));
+	CHECK(offset == 512);
+	ring.EndFrame();
+
+	// With frame 0 done, [0, 512) is bigger than [768, 1024)
+	ring.RetireFrame(0);
+	CHECK(ring.BeginFrame(2));
+	CHECK(ring.GetWindowStart() == 0);
+	CHECK(ring.GetWindowSize() == 512);
+	CHECK(ring.Allocate(512, &offset));
+	CHECK(offset == 0);
+
+	// ...and can't reach into frame 1, still in flight
+	CHECK(!ring.Allocate(1, &offset));
+}
+
+TEST(UploadRing, FramesInFlightAreLimited)
+{
+	UploadRing ring(4096, 256, 2);
+	CHECK(ring.BeginFrame(0));
+	ring.EndFrame();
+	CHECK(ring.BeginFrame(1));
+	ring.EndFrame();
+
+	CHECK(ring.GetFramesInFlight() == 2);
+	CHECK(!ring.BeginFrame(2));
+	CHECK(!ring.IsFrameOpen());
+
+	ring.RetireFrame(0);
+	CHECK(ring.BeginFrame(2));
+}
+
+TEST(UploadRing, RetiresOldestFirst)
+{
+	UploadRing ring(4096, 256, 4);
+	unsigned int offset = 0;
+	for (unsigned long long f = 0; f < 3; f++)
+	{
+		CHECK(ring.BeginFrame(f));
+		CHECK(ring.Allocate(256, &offset));
+		ring.EndFrame();
+	}
+
+	// Retiring an index frees it and everything older, nothing newer
+	ring.RetireFrame(1);
+	CHECK(ring.GetFramesInFlight() == 1);
+	CHECK(ring.GetOldestFrameInFlight() == 2);
+	CHECK(ring.GetBytesInFlight() == 256);
+
+	// Already retired - nothing happens
+	ring.RetireFrame(0);
+	CHECK(ring.GetFramesInFlight() == 1);
+
+	ring.RetireFrame(2);
+	CHECK(ring.GetFramesInFlight() == 0);
+	CHECK(ring.GetBytesInFlight() == 0);
+}
+
+TEST(UploadRing, EmptyFramesStillRetireInOrder)
+{
+	UploadRing ring(1024, 256, 3);
+	CHECK(ring.BeginFrame(0));
+	ring.EndFrame();
+	CHECK(ring.GetFramesInFlight() == 1);
+	CHECK(ring.GetBytesInFlight() == 0);
+
+	ring.RetireFrame(0);
+	CHECK(ring.GetFramesInFlight() == 0);
+}
+
+// --------------------------------------------------------
+// Random sizes and random retirement, checking that nothing
+// handed out ever overlaps anything still in flight
+// --------------------------------------------------------
+TEST(UploadRing, NeverOverlapsFramesInFlight)
+{
+	struct Slice
+	{
+		unsigned long long Frame;
+		unsigned int Offset;
+		unsigned int Size;
+	};
+
+	UploadRing ring(1 << 16, 256, 3);
+	std::deque<Slice> live;
+	unsigned int random = 12345;
+	unsigned long long frame = 0;
+
+	for (int step = 0; step < 20000; step++)
+	{
+		if (!ring.BeginFrame(frame))
+		{
+			unsigned long long oldest = ring.GetOldestFrameInFlight();
+			ring.RetireFrame(oldest);
+			while (!live.empty() && live.front().Frame <= oldest)
+				live.pop_front();
+			continue;
+		}
+
+		random = random * 1664525u + 1013904223u;
+		unsigned int allocations = (random >> 8) % 40;
+		for (unsigned int a = 0; a < allocations; a++)
+		{
+			random = random * 1664525u + 1013904223u;
+			unsigned int size = 1 + (random >> 8) % 1500;
+			unsigned int offset = 0;
+			if (!ring.Allocate(size, &offset))
+				continue;
+
+			CHECK(offset % 256 == 0);
+			CHECK(offset + size <= ring.GetCapacity());
+			for (unsigned int s = 0; s < live.size(); s++)
+				CHECK(offset + size <= live[s].Offset || live[s].Offset + live[s].Size <= offset);
+
+			Slice slice = { frame, offset, size };
+			live.push_back(slice);
+		}
+
+		ring.EndFrame();
+		frame++;
+
+		random = random * 1664525u + 1013904223u;
+		if ((random >> 8) % 3 == 0 && ring.GetFramesInFlight() > 0)
+		{
+			unsigned long long oldest = ring.GetOldestFrameInFlight();
+			ring.RetireFrame(oldest);
+			while (!live.empty() && live.front().Frame <= oldest)
+				live.pop_front();
+		}
+	}
+}